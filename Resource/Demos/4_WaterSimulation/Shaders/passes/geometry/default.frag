@@ -13,6 +13,10 @@ in vec4 FragPosLightSpace;
 uniform sampler2D tex0;
 uniform sampler2D tex1;
 
+// LOD cross-fade: keep the fragment only if its dither value d satisfies
+// lodDither.x <= d < 1.0 - lodDither.y. Zero keeps everything.
+uniform vec2 lodDither;
+
 uniform vec3 camPos;
 
 struct MaterialData {
@@ -53,6 +57,10 @@ uniform int enablePointShadows;
 uniform float shadowBias;
 uniform float pointShadowFarPlane;
 uniform sampler2D dirShadowMap;
+#define MAX_SHADOW_CASCADES 4
+uniform int shadowCascadeCount;
+uniform mat4 cascadeMatrices[MAX_SHADOW_CASCADES];
+uniform vec4 cascadeRects[MAX_SHADOW_CASCADES];
 uniform samplerCube pointShadowMap0;
 uniform samplerCube pointShadowMap1;
 uniform samplerCube pointShadowMap2;
@@ -87,26 +95,40 @@ vec3 CalcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir) {
     return (diffuse + specular) * light.intensity;
 }
 
-float DirShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir)
+float DirShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir)
 {
     if (enableShadows == 0) return 0.0;
     
-    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
-    projCoords = projCoords * 0.5 + 0.5;
-
-    if(projCoords.z > 1.0)
+    // Use the sharpest cascade that fully contains the PCF footprint
+    vec2 texelSize = 1.0 / textureSize(dirShadowMap, 0);
+    vec3 projCoords = vec3(0.0);
+    int cascade = -1;
+    for(int i = 0; i < MAX_SHADOW_CASCADES; ++i)
+    {
+        if (i >= shadowCascadeCount) break;
+        vec4 lightSpace = cascadeMatrices[i] * vec4(fragPos, 1.0);
+        projCoords = lightSpace.xyz / lightSpace.w * 0.5 + 0.5;
+        vec2 margin = 2.0 * texelSize / cascadeRects[i].zw;
+        if (all(greaterThan(projCoords.xy, margin)) &&
+            all(lessThan(projCoords.xy, 1.0 - margin)) && projCoords.z <= 1.0)
+        {
+            cascade = i;
+            break;
+        }
+    }
+    if (cascade < 0)
         return 0.0;
 
+    vec2 uv = cascadeRects[cascade].xy + projCoords.xy * cascadeRects[cascade].zw;
     float currentDepth = projCoords.z;
     float bias = max(shadowBias * (1.0 - dot(normal, lightDir)), shadowBias * 0.1);  
     
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(dirShadowMap, 0);
     for(int x = -1; x <= 1; ++x)
     {
         for(int y = -1; y <= 1; ++y)
         {
-            float pcfDepth = texture(dirShadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
+            float pcfDepth = texture(dirShadowMap, uv + vec2(x, y) * texelSize).r; 
             shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;        
         }    
     }
@@ -156,8 +178,17 @@ float PointShadowCalculation(vec3 fragPos, vec3 lightPos, int index)
     return shadow;
 }
 
+bool LODDitherDiscard()
+{
+    float d = fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+    return d < lodDither.x || d >= 1.0 - lodDither.y;
+}
+
 void main()
 {
+    if (LODDitherDiscard()) {
+        discard;
+    }
     vec3 normal = normalize(Normal);
     vec3 viewDirection = normalize(camPos - crntPos);
 
@@ -170,7 +201,7 @@ void main()
 
     if (sunLight.intensity > 0.0) {
         vec3 sunBase = CalcDirLight(sunLight, normal, viewDirection);
-        float shadow = DirShadowCalculation(FragPosLightSpace, normal, normalize(sunLight.direction));
+        float shadow = DirShadowCalculation(crntPos, normal, normalize(sunLight.direction));
         totalLighting += sunBase * (1.0 - shadow);
     }
     if (moonLight.intensity > 0.0) {
@@ -16,6 +16,9 @@ uniform sampler2D tex1;
 uniform bool debugZPrepass;
 uniform bool debugVRS;
 uniform int vrsMode;
+// LOD cross-fade: keep the fragment only if its dither value d satisfies
+// lodDither.x <= d < 1.0 - lodDither.y. Zero keeps everything.
+uniform vec2 lodDither;
 
 // Camera
 uniform vec3 camPos;
@@ -40,17 +43,17 @@ struct PointLightData {
     vec4 colorAndIntensity;
 };
 
-struct ClusterData {
-    int count;
-    int lightIndices[64];
+layout(std430, binding = 0) readonly buffer LightBuffer {
+    PointLightData lights[];
 };
 
-layout(std140, binding = 0) buffer LightBuffer {
-    PointLightData lights[];
+// x = offset into lightIndices, y = light count
+layout(std430, binding = 1) readonly buffer ClusterGrid {
+    uvec2 clusterRanges[];
 };
 
-layout(std140, binding = 1) buffer ClusterBuffer {
-    ClusterData clusters[];
+layout(std430, binding = 2) readonly buffer LightIndexList {
+    uint lightIndices[];
 };
 
 // Directional Light
@@ -67,6 +70,10 @@ uniform DirectionalLight moonLight;
 uniform int enableShadows;
 uniform float shadowBias;
 uniform sampler2D dirShadowMap;
+#define MAX_SHADOW_CASCADES 4
+uniform int shadowCascadeCount;
+uniform mat4 cascadeMatrices[MAX_SHADOW_CASCADES];
+uniform vec4 cascadeRects[MAX_SHADOW_CASCADES];
 
 const int CLUSTER_X = 16;
 const int CLUSTER_Y = 9;
@@ -101,20 +108,32 @@ vec3 CalcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir) {
     return (diffuse + specular) * light.intensity;
 }
 
-float DirShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir) {
-    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
-    projCoords = projCoords * 0.5 + 0.5;
-    if(projCoords.z > 1.0) return 0.0;
-    
-    float closestDepth = texture(dirShadowMap, projCoords.xy).r;
+float DirShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir) {
+    // Use the sharpest cascade that fully contains the PCF footprint
+    vec2 texelSize = 1.0 / textureSize(dirShadowMap, 0);
+    vec3 projCoords = vec3(0.0);
+    int cascade = -1;
+    for(int i = 0; i < MAX_SHADOW_CASCADES; ++i) {
+        if (i >= shadowCascadeCount) break;
+        vec4 lightSpace = cascadeMatrices[i] * vec4(fragPos, 1.0);
+        projCoords = lightSpace.xyz / lightSpace.w * 0.5 + 0.5;
+        vec2 margin = 2.0 * texelSize / cascadeRects[i].zw;
+        if (all(greaterThan(projCoords.xy, margin)) &&
+            all(lessThan(projCoords.xy, 1.0 - margin)) && projCoords.z <= 1.0) {
+            cascade = i;
+            break;
+        }
+    }
+    if (cascade < 0) return 0.0;
+
+    vec2 uv = cascadeRects[cascade].xy + projCoords.xy * cascadeRects[cascade].zw;
     float currentDepth = projCoords.z;
     
     // PCF
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(dirShadowMap, 0);
     for(int x = -1; x <= 1; ++x) {
         for(int y = -1; y <= 1; ++y) {
-            float pcfDepth = texture(dirShadowMap, projCoords.xy + vec2(x, y) * texelSize).r;
+            float pcfDepth = texture(dirShadowMap, uv + vec2(x, y) * texelSize).r;
             shadow += currentDepth - shadowBias > pcfDepth ? 1.0 : 0.0;
         }
     }
@@ -149,7 +168,15 @@ vec3 CalcPointLightStruct(PointLightData light, vec3 normal, vec3 fragPos, vec3
     return (diffuse + specular) * attenuation * intensity;
 }
 
+bool LODDitherDiscard() {
+    float d = fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+    return d < lodDither.x || d >= 1.0 - lodDither.y;
+}
+
 void main() {
+    if (LODDitherDiscard()) {
+        discard;
+    }
     vec3 normal = normalize(Normal);
     vec3 viewDir = normalize(camPos - crntPos);
     vec3 result = vec3(0.0);
@@ -160,7 +187,7 @@ void main() {
     
     float shadow = 0.0;
     if (enableShadows == 1) {
-        shadow = DirShadowCalculation(FragPosLightSpace, normal, normalize(sunLight.direction));
+        shadow = DirShadowCalculation(crntPos, normal, normalize(sunLight.direction));
     }
     
     result += sunResult * (1.0 - shadow) + moonResult;
@@ -170,7 +197,7 @@ void main() {
     
     // Clustered Point Lights Loop
     vec2 fragCoord = gl_FragCoord.xy;
-    float zLinear = gl_FragCoord.z / gl_FragCoord.w;
+    float zLinear = 1.0 / gl_FragCoord.w;
     
     int clusterX = int(fragCoord.x / screenSize.x * CLUSTER_X);
     int clusterY = int(fragCoord.y / screenSize.y * CLUSTER_Y);
@@ -185,7 +212,7 @@ void main() {
     
     int clusterIndex = clusterX + (clusterY * CLUSTER_X) + (clusterZ * CLUSTER_X * CLUSTER_Y);
     
-    ClusterData cluster = clusters[clusterIndex];
+    uvec2 clusterRange = clusterRanges[clusterIndex];
     
     bool skipExpensive = false;
     if (vrsMode == 1) {
@@ -197,8 +224,8 @@ void main() {
     }
 
     if (!skipExpensive || debugVRS) {
-        for (int i = 0; i < cluster.count; ++i) {
-            int lightIdx = cluster.lightIndices[i];
+        for (uint i = 0u; i < clusterRange.y; ++i) {
+            uint lightIdx = lightIndices[clusterRange.x + i];
             result += CalcPointLightStruct(lights[lightIdx], normal, crntPos, viewDir);
         }
     }
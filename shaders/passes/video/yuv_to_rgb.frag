@@ -0,0 +1,33 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 texCoords;
+
+uniform sampler2D planeY;
+uniform sampler2D planeU;
+uniform sampler2D planeV;
+uniform bool bt709;
+uniform bool fullRange;
+
+void main()
+{
+    float y = texture(planeY, texCoords).r;
+    float u = texture(planeU, texCoords).r - 0.5;
+    float v = texture(planeV, texCoords).r - 0.5;
+
+    // Expand limited (16-235 / 16-240) range to full range
+    if (!fullRange) {
+        y = (y - 16.0 / 255.0) * (255.0 / 219.0);
+        u *= 255.0 / 224.0;
+        v *= 255.0 / 224.0;
+    }
+
+    vec3 rgb;
+    if (bt709)
+        rgb = vec3(y + 1.5748 * v, y - 0.1873 * u - 0.4681 * v, y + 1.8556 * u);
+    else
+        rgb = vec3(y + 1.402 * v, y - 0.344136 * u - 0.714136 * v, y + 1.772 * u);
+
+    FragColor = vec4(clamp(rgb, 0.0, 1.0), 1.0);
+}
@@ -1,16 +1,67 @@
 #ifndef AUDIO_ENGINE_H
 #define AUDIO_ENGINE_H
 
+#include "../Core/MemoryTracker.h"
 #include "../Scene/Scene.h"
+#include <cstdint>
 #include <glm/glm.hpp>
+#include <string>
+#include <vector>
 
 struct ma_engine;
 struct ma_sound;
+struct AcousticObstacle;
+
+enum class AudioChannelLayout {
+  Auto = 0,
+  Stereo = 2,
+  Surround51 = 6,
+  Surround71 = 8
+};
+
+// Applied by Init() and Restart(). Zero means "let the device decide".
+struct AudioDeviceConfig {
+  std::string deviceName; // Empty for the system default.
+  AudioChannelLayout layout = AudioChannelLayout::Auto;
+  int sampleRate = 0;
+  int periodFrames = 0;
+  int periods = 0;
+  bool lowLatency = true;
+  // Mixes into miniaudio's null backend, which consumes audio in real time
+  // without a sound card.
+  bool headless = false;
+};
+
+struct AudioMixStats {
+  std::string backend;
+  std::string device;
+  int sampleRate = 0;
+  int channels = 0;
+  int periodFrames = 0;
+  int periods = 0;
+  float periodMs = 0.0f;
+  float callbackAvgMs = 0.0f;
+  float callbackMaxMs = 0.0f;
+  uint64_t xruns = 0;
+  int realVoices = 0;
+  int virtualVoices = 0;
+};
+
+struct AudioCacheStats {
+  int assets = 0;
+  int decoded = 0;
+  int streamed = 0;
+  int pooledSounds = 0;
+  int activeSounds = 0;
+};
 
 class AudioEngine {
 public:
   static void Init();
   static void Shutdown();
+  // Re-opens the device with s_DeviceConfig. Voices playing in the scene are
+  // stopped first and picked up again by the next Update().
+  static void Restart(Scene *scene);
   static void Update(Scene *scene, const glm::vec3 &listenerPos,
                      const glm::vec3 &listenerDir, const glm::vec3 &listenerUp,
                      float deltaTime);
@@ -18,9 +69,28 @@ public:
   static void PlayObjectAudio(GameObject &obj);
   static void StopObjectAudio(GameObject &obj);
 
+  // Frees decoded clips and pooled sounds. Sounds still playing keep their
+  // data until they stop.
+  static void ClearSoundCache();
+  static AudioCacheStats GetCacheStats();
+  // Decoded clips and sound instances.
+  static MemoryTagStats GetMemoryStats();
+  static float GetAcousticRaysPerSecond();
+  static AudioMixStats GetMixStats();
+  static std::vector<std::string> GetPlaybackDevices();
+
+  static AudioDeviceConfig s_DeviceConfig;
+
   
   static int s_MaxRealVoices;
   static bool s_CullWhenInaudible;
+  // Clips longer than this are streamed from disk instead of decoded once.
+  static float s_StreamThresholdSeconds;
+  // Occlusion and reverb are traced on a worker at this rate and smoothed
+  // in between. A voice's reverb probe is only re-traced once it has moved
+  // further than the threshold.
+  static float s_AcousticUpdateRate;
+  static float s_ReverbProbeMoveThreshold;
 
 private:
   static ma_engine *s_Engine;
@@ -28,10 +98,13 @@ private:
 
   static glm::vec3 s_PrevListenerPos;
 
-  static float ComputeOcclusion(Scene *scene, const glm::vec3 &sourcePos,
+  static void AcousticWorker();
+  static float ComputeOcclusion(const std::vector<AcousticObstacle> &obstacles,
+                                const glm::vec3 &sourcePos,
                                 const glm::vec3 &listenerPos, int sourceIndex);
-  static float ComputeReverb(Scene *scene, const glm::vec3 &sourcePos,
-                             float &outEchoDelay, float &outEchoDecay);
+  static float ComputeReverb(const std::vector<AcousticObstacle> &obstacles,
+                             const glm::vec3 &sourcePos, float &outEchoDelay,
+                             float &outEchoDecay);
   static float ComputeDopplerPitch(const glm::vec3 &sourcePos,
                                    const glm::vec3 &prevSourcePos,
                                    const glm::vec3 &listenerPos,
@@ -0,0 +1,158 @@
+#include "AudioStream.h"
+#include "../../include/miniaudio/miniaudio.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// Drift tolerated between audio and the media clock before correcting.
+static constexpr double AUDIO_SYNC_THRESHOLD = 0.08;
+// The clock is only set once per rendered frame; between updates it is
+// extrapolated in real time, but never by more than this.
+static constexpr double AUDIO_CLOCK_EXTRAPOLATION = 0.1;
+// Oldest data is dropped past this, e.g. while the voice is culled.
+static constexpr double AUDIO_MAX_BUFFERED_SECONDS = 2.0;
+
+struct AudioStreamSource {
+  ma_data_source_base base;
+  AudioStream *stream;
+};
+
+static ma_result OnStreamRead(ma_data_source *pDataSource, void *pFramesOut,
+                              ma_uint64 frameCount, ma_uint64 *pFramesRead) {
+  AudioStreamSource *source = (AudioStreamSource *)pDataSource;
+  source->stream->Read((float *)pFramesOut, frameCount);
+  if (pFramesRead)
+    *pFramesRead = frameCount;
+  return MA_SUCCESS;
+}
+
+static ma_result OnStreamSeek(ma_data_source *, ma_uint64) {
+  return MA_SUCCESS;
+}
+
+static ma_result OnStreamGetDataFormat(ma_data_source *pDataSource,
+                                       ma_format *pFormat,
+                                       ma_uint32 *pChannels,
+                                       ma_uint32 *pSampleRate,
+                                       ma_channel *pChannelMap,
+                                       size_t channelMapCap) {
+  AudioStreamSource *source = (AudioStreamSource *)pDataSource;
+  *pFormat = ma_format_f32;
+  *pChannels = source->stream->GetChannels();
+  *pSampleRate = source->stream->GetSampleRate();
+  ma_channel_map_init_standard(ma_standard_channel_map_default, pChannelMap,
+                               channelMapCap, *pChannels);
+  return MA_SUCCESS;
+}
+
+static ma_result OnStreamGetCursor(ma_data_source *pDataSource,
+                                   ma_uint64 *pCursor) {
+  *pCursor = ((AudioStreamSource *)pDataSource)->stream->GetCursor();
+  return MA_SUCCESS;
+}
+
+static ma_result OnStreamGetLength(ma_data_source *, ma_uint64 *pLength) {
+  *pLength = 0;
+  return MA_NOT_IMPLEMENTED;
+}
+
+static ma_data_source_vtable s_AudioStreamVTable = {
+    OnStreamRead,      OnStreamSeek,      OnStreamGetDataFormat,
+    OnStreamGetCursor, OnStreamGetLength, NULL,
+    0};
+
+static int64_t SteadyNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+AudioStream::AudioStream(int channels, int sampleRate)
+    : m_Channels(channels), m_SampleRate(sampleRate),
+      m_MaxBufferedFrames(
+          (size_t)(sampleRate * AUDIO_MAX_BUFFERED_SECONDS)) {
+  AudioStreamSource *source = new AudioStreamSource();
+  ma_data_source_config config = ma_data_source_config_init();
+  config.vtable = &s_AudioStreamVTable;
+  ma_data_source_init(&config, &source->base);
+  source->stream = this;
+  m_Source = source;
+  m_ClockStamp = SteadyNow();
+}
+
+AudioStream::~AudioStream() {
+  AudioStreamSource *source = (AudioStreamSource *)m_Source;
+  ma_data_source_uninit(&source->base);
+  delete source;
+}
+
+void AudioStream::Push(const float *samples, int frameCount, double pts) {
+  if (frameCount <= 0)
+    return;
+
+  Chunk chunk;
+  chunk.pts = pts;
+  chunk.samples.assign(samples, samples + (size_t)frameCount * m_Channels);
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Chunks.push_back(std::move(chunk));
+  m_BufferedFrames += frameCount;
+  while (m_BufferedFrames > m_MaxBufferedFrames && m_Chunks.size() > 1) {
+    size_t frames = m_Chunks.front().samples.size() / m_Channels;
+    m_BufferedFrames -= frames - m_ReadOffset;
+    m_ReadOffset = 0;
+    m_Chunks.pop_front();
+  }
+}
+
+void AudioStream::SetClock(double seconds) {
+  m_Clock = seconds;
+  m_ClockStamp = SteadyNow();
+}
+
+double AudioStream::CurrentClock() const {
+  double elapsed = (SteadyNow() - m_ClockStamp) * 1e-9;
+  return m_Clock + std::clamp(elapsed, 0.0, AUDIO_CLOCK_EXTRAPOLATION);
+}
+
+void AudioStream::Read(float *out, uint64_t frameCount) {
+  uint64_t written = 0;
+  std::unique_lock<std::mutex> lock(m_Mutex, std::try_to_lock);
+  if (lock.owns_lock()) {
+    double clock = CurrentClock();
+    while (written < frameCount && !m_Chunks.empty()) {
+      Chunk &chunk = m_Chunks.front();
+      size_t chunkFrames = chunk.samples.size() / m_Channels;
+      double t = chunk.pts + (double)m_ReadOffset / m_SampleRate;
+
+      size_t frames;
+      if (t < clock - AUDIO_SYNC_THRESHOLD) {
+        // Behind the picture: drop audio until caught up.
+        frames = std::max<size_t>((size_t)((clock - t) * m_SampleRate), 1);
+        frames = std::min(frames, chunkFrames - m_ReadOffset);
+      } else if (t > clock + AUDIO_SYNC_THRESHOLD) {
+        // Ahead of the picture: hold back and play silence meanwhile.
+        break;
+      } else {
+        frames = std::min<size_t>(chunkFrames - m_ReadOffset,
+                                  frameCount - written);
+        memcpy(out + written * m_Channels,
+               chunk.samples.data() + m_ReadOffset * m_Channels,
+               frames * m_Channels * sizeof(float));
+        written += frames;
+      }
+
+      m_ReadOffset += frames;
+      m_BufferedFrames -= frames;
+      if (m_ReadOffset >= chunkFrames) {
+        m_ReadOffset = 0;
+        m_Chunks.pop_front();
+      }
+    }
+  }
+
+  if (written < frameCount)
+    memset(out + written * m_Channels, 0,
+           (frameCount - written) * m_Channels * sizeof(float));
+  m_Cursor += frameCount;
+}
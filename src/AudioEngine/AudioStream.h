@@ -0,0 +1,58 @@
+#ifndef AUDIO_STREAM_H
+#define AUDIO_STREAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Interleaved float PCM pushed by a decoder thread and pulled by the audio
+// device through a miniaudio data source. Playback follows an external media
+// clock: when the audio drifts too far from it, samples are skipped or
+// silence is inserted rather than letting picture and sound run apart.
+class AudioStream {
+public:
+  AudioStream(int channels, int sampleRate);
+  ~AudioStream();
+
+  AudioStream(const AudioStream &) = delete;
+  AudioStream &operator=(const AudioStream &) = delete;
+
+  // pts is the media time of the first frame, in seconds.
+  void Push(const float *samples, int frameCount, double pts);
+  void SetClock(double seconds);
+
+  // Device thread. Never blocks; missing data is written as silence.
+  void Read(float *out, uint64_t frameCount);
+
+  // ma_data_source *, for ma_sound_init_from_data_source.
+  void *GetDataSource() const { return m_Source; }
+  int GetChannels() const { return m_Channels; }
+  int GetSampleRate() const { return m_SampleRate; }
+  uint64_t GetCursor() const { return m_Cursor; }
+
+private:
+  struct Chunk {
+    double pts;
+    std::vector<float> samples;
+  };
+
+  double CurrentClock() const;
+
+  int m_Channels;
+  int m_SampleRate;
+  void *m_Source = nullptr;
+
+  std::mutex m_Mutex;
+  std::deque<Chunk> m_Chunks;
+  size_t m_ReadOffset = 0;
+  size_t m_BufferedFrames = 0;
+  size_t m_MaxBufferedFrames;
+
+  std::atomic<double> m_Clock{0.0};
+  std::atomic<int64_t> m_ClockStamp{0};
+  std::atomic<uint64_t> m_Cursor{0};
+};
+
+#endif
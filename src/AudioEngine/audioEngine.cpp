@@ -2,32 +2,368 @@
 #include "AudioEngine.h"
 #include "../../include/miniaudio/miniaudio.h"
 #include "../Core/Logger.h"
+#include "../Tools/Profiler/Profiler.h"
+#include "../Tools/Profiler/PerfCounters.h"
+#include "AudioStream.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstring>
 #include <filesystem>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 ma_engine *AudioEngine::s_Engine = nullptr;
 bool AudioEngine::s_Initialized = false;
 glm::vec3 AudioEngine::s_PrevListenerPos = glm::vec3(0.0f);
 int AudioEngine::s_MaxRealVoices = 32;
 bool AudioEngine::s_CullWhenInaudible = true;
+float AudioEngine::s_StreamThresholdSeconds = 10.0f;
+float AudioEngine::s_AcousticUpdateRate = 15.0f;
+float AudioEngine::s_ReverbProbeMoveThreshold = 1.0f;
+AudioDeviceConfig AudioEngine::s_DeviceConfig;
 
 static constexpr float SPEED_OF_SOUND = 343.0f;
 
+static constexpr size_t MAX_POOLED_SOUNDS_PER_ASSET = 16;
+
+// One entry per audio file. Short clips are decoded once into a buffer that
+// the resource manager shares between all their sounds; long ones are
+// streamed. Stopped sounds are pooled so a voice restarting only costs a
+// seek.
+struct SoundAsset {
+  bool valid = false;
+  bool streamed = false;
+  // PCM the resource manager holds for a decoded clip.
+  size_t decodedBytes = 0;
+  std::vector<ma_sound *> pool;
+};
+
+struct ActiveSound {
+  SoundAsset *asset = nullptr;
+  // Streams stay alive while a sound reads from them, even if the owner
+  // (e.g. a video player) has already let go.
+  std::shared_ptr<AudioStream> stream;
+};
+
+static std::unordered_map<std::string, SoundAsset> s_SoundAssets;
+static std::unordered_map<ma_sound *, ActiveSound> s_ActiveSounds;
+
+static constexpr int OCCLUSION_RAYS = 5;
+static constexpr int REVERB_RAYS = 14;
+// Caps how many reverb probes one job traces, so a crowd of voices moving at
+// once is caught up over a few jobs instead of a single long one.
+static constexpr int MAX_REVERB_PROBES_PER_JOB = 4;
+static constexpr float ACOUSTIC_SMOOTHING_RATE = 8.0f;
+
+// World bounds of an acoustic obstacle, captured on the main thread so the
+// worker never reads the scene.
+struct AcousticObstacle {
+  glm::vec3 min;
+  glm::vec3 max;
+  float hardness;
+  float absorption;
+  int index;
+};
+
+struct AcousticVoice {
+  int index = -1;
+  glm::vec3 position = glm::vec3(0.0f);
+  bool occlusion = false;
+  bool reverb = false;
+  bool probe = false;
+  float occlusionFactor = 0.0f;
+  float reverbMix = 0.0f;
+  float echoDelay = 0.0f;
+  float echoDecay = 0.0f;
+};
+
+struct ReverbProbe {
+  glm::vec3 position;
+  float reverbMix;
+  float echoDelay;
+  float echoDecay;
+};
+
+struct AcousticJob {
+  std::vector<AcousticObstacle> obstacles;
+  std::vector<AcousticVoice> voices;
+  glm::vec3 listenerPos = glm::vec3(0.0f);
+  uint64_t generation = 0;
+};
+
+static std::thread s_AcousticThread;
+static std::mutex s_AcousticMutex;
+static std::condition_variable s_AcousticCv;
+static bool s_AcousticStop = false;
+static bool s_AcousticQueued = false;
+static bool s_AcousticDone = false;
+// While busy the job belongs to the worker; the main thread only touches it
+// again after picking up the result.
+static bool s_AcousticBusy = false;
+static AcousticJob s_AcousticJob;
+static uint64_t s_AcousticGeneration = 0;
+static Scene *s_AcousticScene = nullptr;
+static float s_AcousticTimer = 0.0f;
+static std::unordered_map<int, float> s_OcclusionTargets;
+static std::unordered_map<int, ReverbProbe> s_ReverbProbes;
+static std::atomic<uint64_t> s_AcousticRays{0};
+static float s_AcousticRaysPerSecond = 0.0f;
+
+// The engine mixes from our own device so the callback can be timed and the
+// period size controlled.
+static ma_context *s_AudioContext = nullptr;
+static ma_device *s_AudioDevice = nullptr;
+
+// Written by the audio thread, drained by Update() once per stats window.
+static std::atomic<uint64_t> s_CallbackCount{0};
+static std::atomic<uint64_t> s_CallbackNs{0};
+static std::atomic<uint64_t> s_CallbackMaxNs{0};
+static std::atomic<uint64_t> s_CallbackLastStartNs{0};
+static std::atomic<uint64_t> s_Xruns{0};
+static AudioMixStats s_MixStats;
+static float s_AudioStatsWindow = 0.0f;
+
+static void AudioDataCallback(ma_device *device, void *output,
+                              const void *input, ma_uint32 frameCount) {
+  (void)input;
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+  ma_engine_read_pcm_frames((ma_engine *)device->pUserData, output,
+                            frameCount, NULL);
+  auto end = Clock::now();
+
+  uint64_t startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         start.time_since_epoch())
+                         .count();
+  uint64_t ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+          .count();
+  uint64_t periodNs = (uint64_t)frameCount * 1000000000ull /
+                      std::max<ma_uint32>(device->sampleRate, 1);
+
+  s_CallbackCount++;
+  s_CallbackNs += ns;
+  uint64_t maxNs = s_CallbackMaxNs.load();
+  while (ns > maxNs && !s_CallbackMaxNs.compare_exchange_weak(maxNs, ns)) {
+  }
+
+  // Mixing slower than real time, or a callback arriving more than a whole
+  // period late, means the device has run out of audio.
+  uint64_t lastStart = s_CallbackLastStartNs.exchange(startNs);
+  if (ns > periodNs || (lastStart && startNs - lastStart > periodNs * 2))
+    s_Xruns++;
+}
+
+static ma_uint32 DetectChannels(ma_context *context, const ma_device_id *id) {
+  ma_device_info info;
+  if (ma_context_get_device_info(context, ma_device_type_playback, id,
+                                 &info) != MA_SUCCESS)
+    return 2;
+  ma_uint32 native = 0;
+  for (ma_uint32 i = 0; i < info.nativeDataFormatCount; i++)
+    native = std::max(native, info.nativeDataFormats[i].channels);
+  if (native >= 8)
+    return 8;
+  if (native >= 6)
+    return 6;
+  return native == 1 ? 1 : 2;
+}
+
+static void CloseAudioDevice() {
+  if (s_AudioDevice) {
+    ma_device_uninit(s_AudioDevice);
+    delete s_AudioDevice;
+    s_AudioDevice = nullptr;
+  }
+  if (s_AudioContext) {
+    ma_context_uninit(s_AudioContext);
+    delete s_AudioContext;
+    s_AudioContext = nullptr;
+  }
+}
+
+static bool OpenAudioDevice(const AudioDeviceConfig &config, ma_engine *engine,
+                            bool nullBackend) {
+  ma_backend nullBackends[] = {ma_backend_null};
+  s_AudioContext = new ma_context();
+  if (ma_context_init(nullBackend ? nullBackends : NULL, nullBackend ? 1 : 0,
+                      NULL, s_AudioContext) != MA_SUCCESS) {
+    delete s_AudioContext;
+    s_AudioContext = nullptr;
+    return false;
+  }
+
+  ma_device_id deviceId;
+  const ma_device_id *pDeviceId = NULL;
+  if (!config.deviceName.empty() && !nullBackend) {
+    ma_device_info *infos = NULL;
+    ma_uint32 count = 0;
+    if (ma_context_get_devices(s_AudioContext, &infos, &count, NULL, NULL) ==
+        MA_SUCCESS) {
+      for (ma_uint32 i = 0; i < count; i++) {
+        if (std::strstr(infos[i].name, config.deviceName.c_str())) {
+          deviceId = infos[i].id;
+          pDeviceId = &deviceId;
+          break;
+        }
+      }
+    }
+    if (!pDeviceId)
+      Logger::AddLog("[AudioEngine] Device '%s' not found, using default.",
+                     config.deviceName.c_str());
+  }
+
+  ma_uint32 channels = (ma_uint32)config.layout;
+  if (config.layout == AudioChannelLayout::Auto)
+    channels = DetectChannels(s_AudioContext, pDeviceId);
+
+  ma_device_config deviceConfig =
+      ma_device_config_init(ma_device_type_playback);
+  deviceConfig.playback.pDeviceID = pDeviceId;
+  deviceConfig.playback.format = ma_format_f32;
+  deviceConfig.playback.channels = channels;
+  deviceConfig.sampleRate = (ma_uint32)std::max(config.sampleRate, 0);
+  deviceConfig.periodSizeInFrames = (ma_uint32)std::max(config.periodFrames, 0);
+  deviceConfig.periods = (ma_uint32)std::max(config.periods, 0);
+  deviceConfig.performanceProfile = config.lowLatency
+                                        ? ma_performance_profile_low_latency
+                                        : ma_performance_profile_conservative;
+  deviceConfig.dataCallback = AudioDataCallback;
+  deviceConfig.pUserData = engine;
+  deviceConfig.noPreSilencedOutputBuffer = MA_TRUE;
+  deviceConfig.noClip = MA_TRUE;
+
+  s_AudioDevice = new ma_device();
+  if (ma_device_init(s_AudioContext, &deviceConfig, s_AudioDevice) !=
+      MA_SUCCESS) {
+    delete s_AudioDevice;
+    s_AudioDevice = nullptr;
+    CloseAudioDevice();
+    return false;
+  }
+  return true;
+}
+
+static void SnapshotObstacles(Scene *scene,
+                              std::vector<AcousticObstacle> &out) {
+  out.clear();
+  auto &objects = scene->GetObjects();
+  for (int i = 0; i < (int)objects.size(); i++) {
+    if (!objects[i].isActive)
+      continue;
+    if (!objects[i].acousticMaterial.isAcousticObstacle)
+      continue;
+    if (objects[i].meshType == MeshType::None)
+      continue;
+
+    glm::mat4 globalT = scene->GetGlobalTransform(i);
+    glm::vec3 globalPos = glm::vec3(globalT[3]);
+    glm::vec3 globalScale(glm::length(glm::vec3(globalT[0])),
+                          glm::length(glm::vec3(globalT[1])),
+                          glm::length(glm::vec3(globalT[2])));
+    glm::mat3 rotMat = glm::mat3(globalT);
+    rotMat[0] /= globalScale.x;
+    rotMat[1] /= globalScale.y;
+    rotMat[2] /= globalScale.z;
+
+    AABB worldAABB = PhysicsEngine::GetTransformedAABB(
+        objects[i].collider, globalPos, glm::quat_cast(rotMat), globalScale);
+    out.push_back({worldAABB.min, worldAABB.max,
+                   objects[i].acousticMaterial.hardness,
+                   objects[i].acousticMaterial.absorption, i});
+  }
+}
+
+static SoundAsset *GetSoundAsset(ma_engine *engine, const std::string &path) {
+  auto it = s_SoundAssets.find(path);
+  if (it != s_SoundAssets.end())
+    return it->second.valid ? &it->second : nullptr;
+
+  // Failures are remembered too, so a missing file is not probed per frame.
+  SoundAsset &asset = s_SoundAssets[path];
+  if (!std::filesystem::exists(path))
+    return nullptr;
+
+  ma_decoder decoder;
+  if (ma_decoder_init_file(path.c_str(), NULL, &decoder) != MA_SUCCESS) {
+    Logger::AddLog("[AudioEngine] Failed to load sound: %s", path.c_str());
+    return nullptr;
+  }
+  ma_uint64 frames = 0;
+  float seconds = 0.0f;
+  if (ma_decoder_get_length_in_pcm_frames(&decoder, &frames) == MA_SUCCESS &&
+      decoder.outputSampleRate > 0)
+    seconds = (float)frames / decoder.outputSampleRate;
+  // Decoded clips are stored as f32 at the engine's rate.
+  size_t decodedBytes = (size_t)(seconds * ma_engine_get_sample_rate(engine)) *
+                        decoder.outputChannels * sizeof(float);
+  ma_decoder_uninit(&decoder);
+
+  asset.streamed =
+      seconds <= 0.0f || seconds > AudioEngine::s_StreamThresholdSeconds;
+  if (!asset.streamed &&
+      ma_resource_manager_register_file(
+          ma_engine_get_resource_manager(engine), path.c_str(),
+          MA_RESOURCE_MANAGER_DATA_SOURCE_FLAG_DECODE) != MA_SUCCESS)
+    asset.streamed = true;
+  if (!asset.streamed)
+    asset.decodedBytes = decodedBytes;
+  asset.valid = true;
+  return &asset;
+}
+
 void AudioEngine::Init() {
   if (s_Initialized)
     return;
 
   s_Engine = new ma_engine();
-  ma_result result = ma_engine_init(NULL, s_Engine);
-  if (result != MA_SUCCESS) {
+  bool opened =
+      OpenAudioDevice(s_DeviceConfig, s_Engine, s_DeviceConfig.headless);
+  if (!opened && !s_DeviceConfig.headless) {
+    Logger::AddLog("[AudioEngine] No playback device, using null backend.");
+    opened = OpenAudioDevice(s_DeviceConfig, s_Engine, true);
+  }
+
+  ma_engine_config engineConfig = ma_engine_config_init();
+  engineConfig.pContext = s_AudioContext;
+  engineConfig.pDevice = s_AudioDevice;
+  if (!opened || ma_engine_init(&engineConfig, s_Engine) != MA_SUCCESS) {
     Logger::AddLog("[AudioEngine] Failed to initialize audio engine.");
+    CloseAudioDevice();
     delete s_Engine;
     s_Engine = nullptr;
     return;
   }
 
+  s_CallbackCount = 0;
+  s_CallbackNs = 0;
+  s_CallbackMaxNs = 0;
+  s_CallbackLastStartNs = 0;
+  s_Xruns = 0;
+  s_MixStats = {};
+  s_MixStats.backend = ma_get_backend_name(s_AudioContext->backend);
+  s_MixStats.device = s_AudioDevice->playback.name;
+  s_MixStats.sampleRate = (int)s_AudioDevice->sampleRate;
+  s_MixStats.channels = (int)s_AudioDevice->playback.channels;
+  s_MixStats.periodFrames =
+      (int)s_AudioDevice->playback.internalPeriodSizeInFrames;
+  s_MixStats.periods = (int)s_AudioDevice->playback.internalPeriods;
+  if (s_MixStats.sampleRate > 0)
+    s_MixStats.periodMs =
+        1000.0f * s_MixStats.periodFrames / s_MixStats.sampleRate;
+  Logger::AddLog("[AudioEngine] %s: %s, %d Hz, %d ch, %d x %d frames",
+                 s_MixStats.backend.c_str(), s_MixStats.device.c_str(),
+                 s_MixStats.sampleRate, s_MixStats.channels,
+                 s_MixStats.periods, s_MixStats.periodFrames);
+
+  s_AcousticStop = false;
+  s_AcousticThread = std::thread(AcousticWorker);
+
   s_Initialized = true;
   Logger::AddLog("[AudioEngine] Initialized with physics-based audio.");
 }
@@ -36,12 +372,70 @@ void AudioEngine::Shutdown() {
   if (!s_Initialized)
     return;
 
+  {
+    std::lock_guard<std::mutex> lock(s_AcousticMutex);
+    s_AcousticStop = true;
+  }
+  s_AcousticCv.notify_all();
+  if (s_AcousticThread.joinable())
+    s_AcousticThread.join();
+  s_AcousticQueued = false;
+  s_AcousticDone = false;
+  s_AcousticBusy = false;
+  s_AcousticScene = nullptr;
+  s_OcclusionTargets.clear();
+  s_ReverbProbes.clear();
+
+  ClearSoundCache();
+  // The device belongs to us, so stop it before the engine it reads from
+  // goes away.
+  ma_device_stop(s_AudioDevice);
   ma_engine_uninit(s_Engine);
+  CloseAudioDevice();
   delete s_Engine;
   s_Engine = nullptr;
   s_Initialized = false;
 }
 
+void AudioEngine::Restart(Scene *scene) {
+  if (scene) {
+    for (auto &obj : scene->GetObjects()) {
+      if (!obj.audio.pSource)
+        continue;
+      bool playing = obj.audio.playing;
+      StopObjectAudio(obj);
+      obj.audio.playing = playing;
+    }
+  }
+  Shutdown();
+  Init();
+}
+
+std::vector<std::string> AudioEngine::GetPlaybackDevices() {
+  std::vector<std::string> names;
+  ma_context tempContext;
+  ma_context *context = s_AudioContext;
+  if (!context) {
+    if (ma_context_init(NULL, 0, NULL, &tempContext) != MA_SUCCESS)
+      return names;
+    context = &tempContext;
+  }
+
+  ma_device_info *infos = NULL;
+  ma_uint32 count = 0;
+  if (ma_context_get_devices(context, &infos, &count, NULL, NULL) ==
+      MA_SUCCESS) {
+    for (ma_uint32 i = 0; i < count; i++)
+      names.push_back(infos[i].name);
+  }
+
+  if (context == &tempContext)
+    ma_context_uninit(&tempContext);
+  return names;
+}
+
+AudioMixStats AudioEngine::GetMixStats() { return s_MixStats; }
+
 bool AudioEngine::RayIntersectsAABB(const glm::vec3 &rayOrigin,
                                     const glm::vec3 &rayDir,
                                     const glm::vec3 &boxMin,
@@ -72,9 +466,43 @@ bool AudioEngine::RayIntersectsAABB(const glm::vec3 &rayOrigin,
   return true;
 }
 
-float AudioEngine::ComputeOcclusion(Scene *scene, const glm::vec3 &sourcePos,
-                                    const glm::vec3 &listenerPos,
-                                    int sourceIndex) {
+void AudioEngine::AcousticWorker() {
+  PROFILE_THREAD("Acoustics");
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(s_AcousticMutex);
+      s_AcousticCv.wait(lock,
+                        [] { return s_AcousticStop || s_AcousticQueued; });
+      if (s_AcousticStop)
+        return;
+      s_AcousticQueued = false;
+    }
+
+    PROFILE_SCOPE("AcousticTrace");
+    AcousticJob &job = s_AcousticJob;
+    uint64_t rays = 0;
+    for (auto &voice : job.voices) {
+      if (voice.occlusion) {
+        voice.occlusionFactor = ComputeOcclusion(
+            job.obstacles, voice.position, job.listenerPos, voice.index);
+        rays += OCCLUSION_RAYS;
+      }
+      if (voice.probe) {
+        voice.reverbMix = ComputeReverb(job.obstacles, voice.position,
+                                        voice.echoDelay, voice.echoDecay);
+        rays += REVERB_RAYS;
+      }
+    }
+    s_AcousticRays += rays;
+
+    std::lock_guard<std::mutex> lock(s_AcousticMutex);
+    s_AcousticDone = true;
+  }
+}
+
+float AudioEngine::ComputeOcclusion(
+    const std::vector<AcousticObstacle> &obstacles, const glm::vec3 &sourcePos,
+    const glm::vec3 &listenerPos, int sourceIndex) {
   if (glm::length(listenerPos - sourcePos) < 0.001f)
     return 0.0f;
 
@@ -93,44 +521,24 @@ float AudioEngine::ComputeOcclusion(Scene *scene, const glm::vec3 &sourcePos,
                                listenerPos - right * listenerRadius};
 
   float totalOcclusion = 0.0f;
-  auto &objects = scene->GetObjects();
 
-  for (int r = 0; r < 5; r++) {
+  for (int r = 0; r < OCCLUSION_RAYS; r++) {
     glm::vec3 dir = targetPoints[r] - sourcePos;
     float totalDist = glm::length(dir);
     dir /= totalDist;
 
     float rayOcclusion = 0.0f;
 
-    for (int i = 0; i < (int)objects.size(); i++) {
-      if (i == sourceIndex)
+    for (const auto &obstacle : obstacles) {
+      if (obstacle.index == sourceIndex)
         continue;
-      if (!objects[i].isActive)
-        continue;
-      if (!objects[i].acousticMaterial.isAcousticObstacle)
-        continue;
-      if (objects[i].meshType == MeshType::None)
-        continue;
-
-      glm::mat4 globalT = scene->GetGlobalTransform(i);
-      glm::vec3 globalPos = glm::vec3(globalT[3]);
-      glm::vec3 globalScale(glm::length(glm::vec3(globalT[0])),
-                            glm::length(glm::vec3(globalT[1])),
-                            glm::length(glm::vec3(globalT[2])));
-      glm::mat3 rotMat = glm::mat3(globalT);
-      rotMat[0] /= globalScale.x;
-      rotMat[1] /= globalScale.y;
-      rotMat[2] /= globalScale.z;
-
-      AABB worldAABB = PhysicsEngine::GetTransformedAABB(
-          objects[i].collider, globalPos, glm::quat_cast(rotMat), globalScale);
 
       float tHit;
-      if (RayIntersectsAABB(sourcePos, dir, worldAABB.min, worldAABB.max,
+      if (RayIntersectsAABB(sourcePos, dir, obstacle.min, obstacle.max,
                             tHit)) {
         if (tHit < totalDist) {
-          float blockAmount = objects[i].acousticMaterial.hardness * 0.4f +
-                              objects[i].acousticMaterial.absorption * 1.5f;
+          float blockAmount =
+              obstacle.hardness * 0.4f + obstacle.absorption * 1.5f;
           rayOcclusion += 0.2f + blockAmount;
         }
       }
@@ -138,10 +546,11 @@ float AudioEngine::ComputeOcclusion(Scene *scene, const glm::vec3 &sourcePos,
     totalOcclusion += std::min(rayOcclusion, 1.0f);
   }
 
-  return std::min(totalOcclusion / 5.0f, 1.0f);
+  return std::min(totalOcclusion / (float)OCCLUSION_RAYS, 1.0f);
 }
 
-float AudioEngine::ComputeReverb(Scene *scene, const glm::vec3 &sourcePos,
+float AudioEngine::ComputeReverb(const std::vector<AcousticObstacle> &obstacles,
+                                 const glm::vec3 &sourcePos,
                                  float &outEchoDelay, float &outEchoDecay) {
 
   static const glm::vec3 rayDirs[] = {{1, 0, 0},
@@ -158,11 +567,9 @@ float AudioEngine::ComputeReverb(Scene *scene, const glm::vec3 &sourcePos,
                                       {-0.577f, 0.577f, -0.577f},
                                       {0.577f, -0.577f, -0.577f},
                                       {-0.577f, -0.577f, -0.577f}};
-  static const int numRays = 14;
+  static const int numRays = REVERB_RAYS;
   static const float maxRayDist = 50.0f;
 
-  auto &objects = scene->GetObjects();
-
   float totalDistSum = 0.0f;
   float totalHardness = 0.0f;
   int hitCount = 0;
@@ -171,24 +578,13 @@ float AudioEngine::ComputeReverb(Scene *scene, const glm::vec3 &sourcePos,
     float closestHit = maxRayDist;
     float closestHardness = 0.0f;
 
-    for (int i = 0; i < (int)objects.size(); i++) {
-      if (!objects[i].isActive)
-        continue;
-      if (objects[i].meshType == MeshType::None)
-        continue;
-      if (!objects[i].acousticMaterial.isAcousticObstacle)
-        continue;
-
-      AABB worldAABB = PhysicsEngine::GetTransformedAABB(
-          objects[i].collider, objects[i].position, objects[i].rotation,
-          objects[i].scale);
-
+    for (const auto &obstacle : obstacles) {
       float tHit;
-      if (RayIntersectsAABB(sourcePos, rayDirs[r], worldAABB.min, worldAABB.max,
+      if (RayIntersectsAABB(sourcePos, rayDirs[r], obstacle.min, obstacle.max,
                             tHit)) {
         if (tHit < closestHit && tHit > 0.01f) {
           closestHit = tHit;
-          closestHardness = objects[i].acousticMaterial.hardness;
+          closestHardness = obstacle.hardness;
         }
       }
     }
@@ -267,7 +663,36 @@ void AudioEngine::Update(Scene *scene, const glm::vec3 &listenerPos,
   ma_engine_listener_set_world_up(s_Engine, 0, listenerUp.x, listenerUp.y,
                                   listenerUp.z);
 
+  if (scene != s_AcousticScene) {
+    s_AcousticScene = scene;
+    s_AcousticGeneration++;
+    s_OcclusionTargets.clear();
+    s_ReverbProbes.clear();
+  }
+
+  bool jobFinished = false;
+  {
+    std::lock_guard<std::mutex> lock(s_AcousticMutex);
+    if (s_AcousticDone) {
+      s_AcousticDone = false;
+      s_AcousticBusy = false;
+      jobFinished = true;
+    }
+  }
+  if (jobFinished && s_AcousticJob.generation == s_AcousticGeneration) {
+    s_OcclusionTargets.clear();
+    for (const auto &voice : s_AcousticJob.voices) {
+      if (voice.occlusion)
+        s_OcclusionTargets[voice.index] = voice.occlusionFactor;
+      if (voice.probe)
+        s_ReverbProbes[voice.index] = {voice.position, voice.reverbMix,
+                                       voice.echoDelay, voice.echoDecay};
+    }
+  }
+
   auto &objects = scene->GetObjects();
+  std::vector<AcousticVoice> acousticVoices;
+  float smoothing = 1.0f - std::exp(-deltaTime * ACOUSTIC_SMOOTHING_RATE);
 
   
   struct AudioPriority {
@@ -280,7 +705,7 @@ void AudioEngine::Update(Scene *scene, const glm::vec3 &listenerPos,
   for (int idx = 0; idx < (int)objects.size(); idx++) {
     auto &obj = objects[idx];
 
-    if (!obj.hasAudio || obj.audio.filePath.empty()) {
+    if (!obj.hasAudio || (obj.audio.filePath.empty() && !obj.audio.stream)) {
       if (obj.audio.pSource)
         StopObjectAudio(obj);
       continue;
@@ -357,23 +782,40 @@ void AudioEngine::Update(Scene *scene, const glm::vec3 &listenerPos,
                                            deltaTime, obj.audio.dopplerFactor);
       }
 
+      bool directional = obj.audio.type == AudioType::Directional;
+      if (directional &&
+          (obj.audio.enableOcclusion || obj.audio.enableReverb)) {
+        AcousticVoice voice;
+        voice.index = idx;
+        voice.position = worldPos;
+        voice.occlusion = obj.audio.enableOcclusion;
+        voice.reverb = obj.audio.enableReverb;
+        acousticVoices.push_back(voice);
+      }
+
       float occlusionVolMult = 1.0f;
       float occlusionPitchMult = 1.0f;
-      if (obj.audio.enableOcclusion &&
-          obj.audio.type == AudioType::Directional) {
-        obj.audio.occlusionFactor =
-            ComputeOcclusion(scene, worldPos, listenerPos, idx);
+      if (obj.audio.enableOcclusion && directional) {
+        auto target = s_OcclusionTargets.find(idx);
+        if (target != s_OcclusionTargets.end())
+          obj.audio.occlusionFactor +=
+              (target->second - obj.audio.occlusionFactor) * smoothing;
         occlusionVolMult = std::max(0.0f, 1.0f - obj.audio.occlusionFactor);
         occlusionPitchMult =
             std::max(0.5f, 1.0f - (obj.audio.occlusionFactor * 0.5f));
       }
 
-      if (obj.audio.enableReverb && obj.audio.type == AudioType::Directional) {
-        float echoDelay, echoDecay;
-        obj.audio.reverbMix =
-            ComputeReverb(scene, worldPos, echoDelay, echoDecay);
-        obj.audio.echoDelay = echoDelay;
-        obj.audio.echoDecay = echoDecay;
+      if (obj.audio.enableReverb && directional) {
+        auto probe = s_ReverbProbes.find(idx);
+        if (probe != s_ReverbProbes.end()) {
+          const ReverbProbe &p = probe->second;
+          obj.audio.reverbMix +=
+              (p.reverbMix - obj.audio.reverbMix) * smoothing;
+          obj.audio.echoDelay +=
+              (p.echoDelay - obj.audio.echoDelay) * smoothing;
+          obj.audio.echoDecay +=
+              (p.echoDecay - obj.audio.echoDecay) * smoothing;
+        }
         float reverbBoost = 1.0f + obj.audio.reverbMix * 0.3f;
         occlusionVolMult *= reverbBoost;
       }
@@ -389,33 +831,117 @@ void AudioEngine::Update(Scene *scene, const glm::vec3 &listenerPos,
     obj.prevPosition = worldPos;
   }
 
+  s_AcousticTimer += deltaTime;
+  float interval = 1.0f / std::max(s_AcousticUpdateRate, 1.0f);
+  if (!s_AcousticBusy && s_AcousticTimer >= interval) {
+    s_AcousticTimer = 0.0f;
+
+    for (auto it = s_ReverbProbes.begin(); it != s_ReverbProbes.end();) {
+      bool used = std::any_of(acousticVoices.begin(), acousticVoices.end(),
+                              [&](const AcousticVoice &v) {
+                                return v.reverb && v.index == it->first;
+                              });
+      it = used ? std::next(it) : s_ReverbProbes.erase(it);
+    }
+
+    // Voices are in priority order, so the loudest get their probes first.
+    int probes = 0;
+    for (auto &voice : acousticVoices) {
+      if (!voice.reverb || probes >= MAX_REVERB_PROBES_PER_JOB)
+        continue;
+      auto probe = s_ReverbProbes.find(voice.index);
+      if (probe == s_ReverbProbes.end() ||
+          glm::distance(probe->second.position, voice.position) >
+              s_ReverbProbeMoveThreshold) {
+        voice.probe = true;
+        probes++;
+      }
+    }
+
+    if (!acousticVoices.empty()) {
+      SnapshotObstacles(scene, s_AcousticJob.obstacles);
+      s_AcousticJob.voices = std::move(acousticVoices);
+      s_AcousticJob.listenerPos = listenerPos;
+      s_AcousticJob.generation = s_AcousticGeneration;
+      {
+        std::lock_guard<std::mutex> lock(s_AcousticMutex);
+        s_AcousticBusy = true;
+        s_AcousticQueued = true;
+      }
+      s_AcousticCv.notify_one();
+    }
+  }
+
+  int realVoices = std::min((int)activeAudio.size(), s_MaxRealVoices);
+  s_MixStats.realVoices = realVoices;
+  s_MixStats.virtualVoices = (int)activeAudio.size() - realVoices;
+
+  s_AudioStatsWindow += deltaTime;
+  if (s_AudioStatsWindow >= 1.0f) {
+    s_AcousticRaysPerSecond =
+        (float)s_AcousticRays.exchange(0) / s_AudioStatsWindow;
+    uint64_t callbacks = s_CallbackCount.exchange(0);
+    uint64_t callbackNs = s_CallbackNs.exchange(0);
+    s_MixStats.callbackAvgMs =
+        callbacks ? (float)(callbackNs / callbacks) / 1e6f : 0.0f;
+    s_MixStats.callbackMaxMs = (float)s_CallbackMaxNs.exchange(0) / 1e6f;
+    s_AudioStatsWindow = 0.0f;
+  }
+  s_MixStats.xruns = s_Xruns.load();
+
+  PROFILE_COUNTER("Audio rays/s", s_AcousticRaysPerSecond);
+  PROFILE_COUNTER("Audio callback avg ms", s_MixStats.callbackAvgMs);
+  PROFILE_COUNTER("Audio callback max ms", s_MixStats.callbackMaxMs);
+  PROFILE_COUNTER("Audio xruns", (float)s_MixStats.xruns);
+  PERF_GAUGE(PerfCounter::AudioVoices, s_MixStats.realVoices);
+  PERF_GAUGE(PerfCounter::AudioVirtualVoices, s_MixStats.virtualVoices);
+
   s_PrevListenerPos = listenerPos;
 }
 
 void AudioEngine::PlayObjectAudio(GameObject &obj) {
   if (!s_Initialized)
     return;
-  if (obj.audio.filePath.empty())
-    return;
-
-  if (!std::filesystem::exists(obj.audio.filePath)) {
-    return;
+  SoundAsset *asset = nullptr;
+  if (!obj.audio.stream) {
+    if (obj.audio.filePath.empty())
+      return;
+
+    asset = GetSoundAsset(s_Engine, obj.audio.filePath);
+    if (!asset)
+      return;
   }
 
   if (obj.audio.pSource) {
     StopObjectAudio(obj);
   }
 
-  ma_sound *sound = new ma_sound();
-
-  ma_result result = ma_sound_init_from_file(
-      s_Engine, obj.audio.filePath.c_str(), 0, NULL, NULL, sound);
-  if (result != MA_SUCCESS) {
-    Logger::AddLog("[AudioEngine] Failed to load sound: %s",
-                   obj.audio.filePath.c_str());
-    delete sound;
-    return;
+  ma_sound *sound = nullptr;
+  if (asset && !asset->pool.empty()) {
+    sound = asset->pool.back();
+    asset->pool.pop_back();
+    ma_sound_seek_to_pcm_frame(sound, 0);
+  } else {
+    sound = new ma_sound();
+    ma_result result;
+    if (obj.audio.stream) {
+      result = ma_sound_init_from_data_source(
+          s_Engine, (ma_data_source *)obj.audio.stream->GetDataSource(), 0,
+          NULL, sound);
+    } else {
+      ma_uint32 flags =
+          asset->streamed ? MA_SOUND_FLAG_STREAM : MA_SOUND_FLAG_DECODE;
+      result = ma_sound_init_from_file(s_Engine, obj.audio.filePath.c_str(),
+                                       flags, NULL, NULL, sound);
+    }
+    if (result != MA_SUCCESS) {
+      Logger::AddLog("[AudioEngine] Failed to load sound: %s",
+                     obj.audio.filePath.c_str());
+      delete sound;
+      return;
+    }
   }
+  s_ActiveSounds[sound] = {asset, obj.audio.stream};
 
   if (obj.audio.type == AudioType::Ambience) {
     ma_sound_set_spatialization_enabled(sound, MA_FALSE);
@@ -444,9 +970,67 @@ void AudioEngine::StopObjectAudio(GameObject &obj) {
   if (obj.audio.pSource) {
     ma_sound *sound = (ma_sound *)obj.audio.pSource;
     ma_sound_stop(sound);
-    ma_sound_uninit(sound);
-    delete sound;
+
+    SoundAsset *asset = nullptr;
+    auto it = s_ActiveSounds.find(sound);
+    if (it != s_ActiveSounds.end()) {
+      asset = it->second.asset;
+      s_ActiveSounds.erase(it);
+    }
+    if (asset && asset->pool.size() < MAX_POOLED_SOUNDS_PER_ASSET) {
+      asset->pool.push_back(sound);
+    } else {
+      ma_sound_uninit(sound);
+      delete sound;
+    }
     obj.audio.pSource = nullptr;
   }
   obj.audio.playing = false;
 }
+
+void AudioEngine::ClearSoundCache() {
+  for (auto &[sound, active] : s_ActiveSounds)
+    active.asset = nullptr;
+
+  for (auto &[path, asset] : s_SoundAssets) {
+    for (ma_sound *sound : asset.pool) {
+      ma_sound_uninit(sound);
+      delete sound;
+    }
+    if (asset.valid && !asset.streamed && s_Engine)
+      ma_resource_manager_unregister_file(
+          ma_engine_get_resource_manager(s_Engine), path.c_str());
+  }
+  s_SoundAssets.clear();
+}
+
+MemoryTagStats AudioEngine::GetMemoryStats() {
+  MemoryTagStats stats;
+  size_t sounds = s_ActiveSounds.size();
+  for (const auto &[path, asset] : s_SoundAssets) {
+    stats.cpuBytes += asset.decodedBytes;
+    sounds += asset.pool.size();
+  }
+  stats.cpuBytes += sounds * sizeof(ma_sound);
+  return stats;
+}
+
+float AudioEngine::GetAcousticRaysPerSecond() {
+  return s_AcousticRaysPerSecond;
+}
+
+AudioCacheStats AudioEngine::GetCacheStats() {
+  AudioCacheStats stats;
+  for (const auto &[path, asset] : s_SoundAssets) {
+    if (!asset.valid)
+      continue;
+    stats.assets++;
+    if (asset.streamed)
+      stats.streamed++;
+    else
+      stats.decoded++;
+    stats.pooledSounds += (int)asset.pool.size();
+  }
+  stats.activeSounds = (int)s_ActiveSounds.size();
+  return stats;
+}
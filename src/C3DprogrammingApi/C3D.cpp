@@ -8,6 +8,7 @@
 #include "../Renderer/VideoPlayer.h"
 #include "../Core/Application.h"
 #include "../Renderer/Renderer.h"
+#include "../Renderer/BudgetGovernor.h"
 #include "../UI/UICreationEngine.h"
 #include "../Renderer/SDFGenerator.h"
 #include <filesystem>
@@ -299,6 +300,11 @@ namespace Optimization {
     void SetSSR(bool enabled) { }
     void SetHLOD(bool enabled) { Renderer::s_EnableHLOD = enabled; }
     void SetOcclusionCulling(bool enabled) { Renderer::s_EnableOcclusionCulling = enabled; }
+    void SetReleaseCPUMeshData(bool enabled) { Renderer::s_ReleaseCPUMeshData = enabled; }
+    void SetBudgetGovernor(bool enabled, float targetMs) {
+        BudgetGovernor::s_TargetMs = std::max(targetMs, 1.0f);
+        BudgetGovernor::SetEnabled(enabled);
+    }
 }
 
 
@@ -374,7 +380,20 @@ namespace SDF {
     void SetEnabled(GameObject* obj, bool enabled) { if(obj) obj->hasSDF = enabled; }
     void SetResolution(GameObject* obj, int resolution) { if(obj) obj->sdf.resolution = resolution; }
     void SetBounds(GameObject* obj, const glm::vec3& minP, const glm::vec3& maxP) { if(obj) { obj->sdf.minP = minP; obj->sdf.maxP = maxP; } }
-    void Generate(GameObject* obj) { if(obj) SDFGenerator::GenerateSDF(obj->mesh, obj->sdf.resolution); }
+    void SetFastSweep(GameObject* obj, bool enabled) { if(obj) obj->sdf.fastSweep = enabled; }
+    void Generate(GameObject* obj) {
+        if (!obj) return;
+        SDFBakeSettings settings;
+        settings.fastSweep = obj->sdf.fastSweep;
+        SDFVolume vol = SDFGenerator::GenerateSDF(obj->mesh, obj->sdf.resolution, settings);
+        obj->sdf.textureID = vol.textureID;
+        obj->sdf.minP = vol.minAABB;
+        obj->sdf.maxP = vol.maxAABB;
+        obj->sdf.enabled = vol.textureID != 0;
+        obj->hasSDF = obj->sdf.enabled;
+        if (::Scene* scene = SceneManager::Get().GetActiveScene())
+            scene->ReleaseUnusedSDFs();
+    }
 }
 
 
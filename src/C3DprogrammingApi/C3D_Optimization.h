@@ -11,6 +11,9 @@ namespace C3D {
         void SetSSR(bool enabled);
         void SetHLOD(bool enabled);
         void SetOcclusionCulling(bool enabled);
+        void SetReleaseCPUMeshData(bool enabled);
+        // Lowers LOD, SSR, shadow and script quality to hold targetMs.
+        void SetBudgetGovernor(bool enabled, float targetMs = 16.6f);
     }
 }
 
@@ -10,6 +10,8 @@ namespace C3D {
         void SetEnabled(GameObject* obj, bool enabled);
         void SetResolution(GameObject* obj, int resolution);
         void SetBounds(GameObject* obj, const glm::vec3& minP, const glm::vec3& maxP);
+        // Exact distances only near the surface, the rest by fast sweeping.
+        void SetFastSweep(GameObject* obj, bool enabled);
         void Generate(GameObject* obj);
     }
 }
@@ -1,10 +1,14 @@
 #include "Application.h"
 #include "../Physics/HitboxGraphics.h"
 #include "2dCloud.h"
+#include "BudgetGovernor.h"
+#include "DynamicBatcher.h"
 #include "InputManager.h"
 #include "Logger.h"
+#include "RenderDevice.h"
 #include "Renderer.h"
 #include "ResourceManager.h"
+#include "SDFGenerator.h"
 #include "Tools/Profiler/GpuProfiler.h"
 #include "Tools/Profiler/Profiler.h"
 #include "VolumetricCloud.h"
@@ -18,6 +22,7 @@
 #include "../UI/Screens/FallbackScreen.h"
 #include "../UI/UICreationEngine.h"
 #include "Pipelines/StandardPipeline.h"
+#include "StreamingManager.h"
 #include "ThreadManager.h"
 #include "stb/stb_image.h"
 #include <glm/glm.hpp>
@@ -57,10 +62,15 @@ void Application::ChangeState(int newState) {
   GameStateManager::ChangeState(newState);
 }
 
-bool Application::Init() {
-  ThreadManager::Init();
-  if (m_Initialized)
+bool Application::CreateContext() {
+  if (RenderDevice::IsHeadless()) {
+    if (!RenderDevice::Init()) {
+      std::cerr << "Failed to initialize the null render device\n";
+      return false;
+    }
     return true;
+  }
+
   if (!glfwInit()) {
     std::cerr << "Failed to initialize GLFW\n";
     return false;
@@ -79,21 +89,29 @@ bool Application::Init() {
   glfwSetKeyCallback(m_Window, key_callback);
   glfwSetMouseButtonCallback(m_Window, mouse_button_callback);
   glfwSwapInterval(1);
+  glfwSetWindowUserPointer(m_Window, this);
 
   InputManager::Init(m_Window);
 
-  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+  if (!RenderDevice::Init()) {
     std::cerr << "Failed to initialize GLAD\n";
     return false;
   }
+  return true;
+}
+
+bool Application::Init() {
+  ThreadManager::Init();
+  if (m_Initialized)
+    return true;
+  if (!CreateContext())
+    return false;
 
   m_Scene = std::make_unique<Scene>();
   m_Camera =
       std::make_unique<Camera>(m_Specification.Width, m_Specification.Height,
                                glm::vec3(0.0f, 0.0f, 2.0f));
 
-  glfwSetWindowUserPointer(m_Window, this);
-
   glEnable(GL_DEPTH_TEST);
   glEnable(GL_STENCIL_TEST);
   glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
@@ -275,9 +293,34 @@ void Application::ResizeViewportFramebuffer(int width, int height) {
   CreateViewportFramebuffer(width, height);
 }
 
+void Application::SyncRenderSettings() {
+  m_RenderContext.backfaceCulling = Renderer::s_BackfaceCulling;
+  m_RenderContext.objCulling = Renderer::s_ObjFrustumCulling;
+  m_RenderContext.lightCulling = Renderer::s_LightFrustumCulling;
+  m_RenderContext.shadowCulling = Renderer::s_ShadowFrustumCulling;
+  m_RenderContext.materialOptimisation = Renderer::s_MaterialOptimisation;
+  m_RenderContext.zPrepass = Renderer::s_ZPrepass;
+  m_RenderContext.autoLOD = Renderer::s_AutoLOD;
+  m_RenderContext.clusteredShading = Renderer::s_ClusteredShading;
+  m_RenderContext.adaptiveShadowRes = Renderer::s_AdaptiveShadowRes;
+  m_RenderContext.shadowCaching = Renderer::s_ShadowCaching;
+  m_RenderContext.pointShadowRefreshBudget =
+      Renderer::s_PointShadowRefreshBudget;
+  m_RenderContext.shadowCascadeCount = Renderer::s_ShadowCascadeCount;
+  m_RenderContext.dirShadowResolution = Renderer::s_ShadowCascadeResolution;
+  m_RenderContext.cascadeUpdateInterval = Renderer::s_CascadeUpdateInterval;
+  m_RenderContext.shadowCascadeSplitLambda =
+      Renderer::s_ShadowCascadeSplitLambda;
+  m_RenderContext.shadowDistance = Renderer::s_ShadowDistance;
+  m_RenderContext.staticBatching = Renderer::s_StaticBatching;
+  m_RenderContext.dynamicBatching = Renderer::s_DynamicBatching;
+  m_RenderContext.vrs = Renderer::s_VRS;
+}
+
 void Application::Run() {
   float lastFrame = 0.0f;
   float deltaTime = 0.0f;
+  PROFILE_THREAD("Main");
 
   while (!glfwWindowShouldClose(m_Window) && m_Running) {
     float currentFrame = glfwGetTime();
@@ -285,6 +328,7 @@ void Application::Run() {
     lastFrame = currentFrame;
 
     m_RenderContext.deltaTime = deltaTime;
+    BudgetGovernor::BeginFrame();
 
     glfwPollEvents();
     InputManager::Update();
@@ -339,7 +383,8 @@ void Application::OpenProject(const std::string &path) {
   Logger::AddLog("Opened Project: %s", path.c_str());
 
   std::string title = m_Specification.Name + " - " + GetProjectName();
-  glfwSetWindowTitle(m_Window, title.c_str());
+  if (m_Window)
+    glfwSetWindowTitle(m_Window, title.c_str());
 }
 
 std::string Application::GetProjectName() const {
@@ -372,11 +417,18 @@ void Application::Shutdown() {
   if (!m_Initialized)
     return;
 
+  StreamingManager::Shutdown();
+  DynamicBatcher::Shutdown();
   ResourceManager::Clear();
+  SDFGenerator::ClearCache();
   AudioEngine::Shutdown();
-  glfwDestroyWindow(m_Window);
-  glfwTerminate();
+  if (m_Window) {
+    glfwDestroyWindow(m_Window);
+    glfwTerminate();
+    m_Window = nullptr;
+  }
   ThreadManager::Shutdown();
+  Logger::Flush();
 
   m_Initialized = false;
 }
@@ -430,6 +482,7 @@ void Application::ProcessSceneCameras() {
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
       RenderContext camCtx = m_RenderContext;
+      camCtx.primaryView = false;
       camCtx.mainFBO = obj.camera.fbo;
       camCtx.width = obj.camera.resolutionX;
       camCtx.height = obj.camera.resolutionY;
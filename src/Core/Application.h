@@ -49,15 +49,20 @@ public:
   RenderContext &GetRenderContext() { return m_RenderContext; }
 
 protected:
+  // Creates the window and GL context. With the null render device there is
+  // no window and m_Window stays null.
+  virtual bool CreateContext();
   virtual void Shutdown();
   void ChangeState(int newState);
+  // Copies the global Renderer toggles into m_RenderContext.
+  void SyncRenderSettings();
 
   virtual void OnUpdate(float deltaTime) = 0;
   virtual void OnRender() = 0;
   virtual void PostRender() {}
 
   ApplicationSpecification m_Specification;
-  GLFWwindow *m_Window;
+  GLFWwindow *m_Window = nullptr;
   bool m_Running = true;
   bool m_Initialized = false;
   std::string m_ProjectRoot = "";
@@ -1,8 +1,14 @@
 #include "Console.h"
 #include "../Physics/HitboxGraphics.h"
 #include "../Physics/PhysicsEngine.h"
+#include "../Renderer/BudgetGovernor.h"
 #include "../Renderer/RenderContext.h"
+#include "../Tools/Profiler/PerfCounters.h"
+#include "../Tools/Profiler/Profiler.h"
+#include "../Tools/Stress/StressScenario.h"
 #include "Camera.h"
+#include "Logger.h"
+#include "MemoryTracker.h"
 #include "StateManager.h"
 #include <GLFW/glfw3.h>
 #include <algorithm>
@@ -35,6 +41,7 @@ void Console::AddLog(const char *fmt, ...) {
   va_start(args, fmt);
   vsnprintf(buf, sizeof(buf), fmt, args);
   va_end(args);
+  std::lock_guard<std::mutex> lock(m_LogMutex);
   m_Log.push_back(std::string(buf));
   m_ScrollToBottom = true;
 }
@@ -71,12 +78,20 @@ void Console::ExecuteCommand(const std::string &cmd) {
     AddLog("  /vsync [on|off]     — Toggle VSync");
     AddLog("  /timescale <value>  — Set time speed multiplier");
     AddLog("  /pause              — Pause/unpause time");
+    AddLog("  /capture [frames]   — Write a trace of the next frames (300)");
+    AddLog("  /capture spike <ms> — Capture around frames slower than ms");
+    AddLog("  /stats              — Show last frame's engine counters");
+    AddLog("  /mem                — Show memory use per subsystem");
+    AddLog("  /stress <file|stop> — Run a stress scenario, writes a report");
+    AddLog("  /governor [on|off]  — Frame budget governor; also target <ms>,");
+    AddLog("                        level <n> or ladder <file>");
     AddLog("  /clouds [on|off]    — Toggle clouds");
     AddLog("  /fov <value>        — Set camera FOV");
     AddLog("  /dynamicsky [on|off]— Toggle dynamic sky mode");
     AddLog("  /ms [on|off]        — Toggle Master Control (Free Camera)");
     AddLog("  /hitbox [on|off]    — Toggle Hitbox/AABB Rendering");
     AddLog("  /enable logging     — Toggle internal Engine event logs");
+    AddLog("  /loglevel <level>   — trace, debug, info, warn or error");
   } else if (parsed == "enable logging") {
     m_EngineLoggingEnabled = !m_EngineLoggingEnabled;
     AddLog("  Engine Logging: %s", m_EngineLoggingEnabled ? "ON" : "OFF");
@@ -113,6 +128,7 @@ void Console::ExecuteCommand(const std::string &cmd) {
     m_ActivePanel = SettingsPanel::Environment;
     AddLog("  Opened Environment Settings panel");
   } else if (parsed == "clear") {
+    std::lock_guard<std::mutex> lock(m_LogMutex);
     m_Log.clear();
   } else if (parsed == "close") {
     m_Open = false;
@@ -145,6 +161,15 @@ void Console::ExecuteCommand(const std::string &cmd) {
 
     glfwSwapInterval(m_VSync ? 1 : 0);
     AddLog("  VSync: %s", m_VSync ? "ON" : "OFF");
+  } else if (parsed.rfind("loglevel", 0) == 0) {
+    std::string arg = (parsed.size() > 9) ? parsed.substr(9) : "";
+    LogLevel level;
+    if (Logger::ParseLevel(arg.c_str(), level)) {
+      Logger::s_MinLevel = level;
+      AddLog("  Log level set to: %s", Logger::GetLevelName(level));
+    } else {
+      AddLog("  [ERROR] Usage: /loglevel <trace|debug|info|warn|error>");
+    }
   } else if (parsed.rfind("timescale", 0) == 0) {
     std::string arg = (parsed.size() > 10) ? parsed.substr(10) : "";
     try {
@@ -154,6 +179,100 @@ void Console::ExecuteCommand(const std::string &cmd) {
     } catch (...) {
       AddLog("  [ERROR] Usage: /timescale <value>");
     }
+  } else if (parsed.rfind("capture", 0) == 0) {
+#ifdef C3D_NO_PROFILER
+    AddLog("  [ERROR] Profiler is compiled out of this build");
+#else
+    std::string arg = (parsed.size() > 8) ? parsed.substr(8) : "";
+    try {
+      if (arg.rfind("spike", 0) == 0) {
+        float ms = (arg.size() > 6) ? std::stof(arg.substr(6)) : 0.0f;
+        Profiler::Get().SetAutoCaptureThreshold(ms);
+        if (ms > 0.0f)
+          AddLog("  Capturing around frames slower than %.2f ms", ms);
+        else
+          AddLog("  Spike capture: OFF");
+      } else {
+        int frames = arg.empty() ? 300 : std::stoi(arg);
+        if (Profiler::Get().StartCapture(frames))
+          AddLog("  Capturing %d frames", frames);
+        else
+          AddLog("  [ERROR] A capture is already running");
+      }
+    } catch (...) {
+      AddLog("  [ERROR] Usage: /capture [frames] | /capture spike <ms>");
+    }
+#endif
+  } else if (parsed == "stats") {
+#ifdef C3D_NO_PROFILER
+    AddLog("  [ERROR] Profiler is compiled out of this build");
+#else
+    AddLog("  Engine counters (last frame):");
+    for (int c = 0; c < (int)PerfCounter::Count; ++c) {
+      AddLog("    %-24s %.6g", PerfCounters::GetName((PerfCounter)c),
+             PerfCounters::GetDisplayValue((PerfCounter)c));
+    }
+    for (auto &[pass, drawCalls] : PerfCounters::GetPassDrawCalls())
+      AddLog("    Draw calls (%s) %lld", pass.c_str(), (long long)drawCalls);
+#endif
+  } else if (parsed == "mem") {
+    const double mb = 1.0 / (1024.0 * 1024.0);
+    AddLog("  Memory (MB):            CPU       GPU");
+    for (int t = 0; t < (int)MemoryTag::Count; ++t) {
+      MemoryTagStats stats = MemoryTracker::Get((MemoryTag)t);
+      AddLog("    %-16s %9.2f %9.2f", MemoryTracker::GetTagName((MemoryTag)t),
+             stats.cpuBytes * mb, stats.gpuBytes * mb);
+    }
+    MemoryTagStats total = MemoryTracker::GetTotal();
+    AddLog("    %-16s %9.2f %9.2f", "Total", total.cpuBytes * mb,
+           total.gpuBytes * mb);
+  } else if (parsed.rfind("stress", 0) == 0) {
+    // Paths are case sensitive, so the argument comes from cmd, not parsed.
+    size_t argLength = (parsed.size() > 7) ? parsed.size() - 7 : 0;
+    std::string arg = cmd.substr(cmd.size() - argLength);
+    if (arg == "stop") {
+      StressRunner::Stop();
+      AddLog("  Stopping stress scenario");
+    } else if (arg.empty()) {
+      AddLog("  [ERROR] Usage: /stress <scenario.json> | /stress stop");
+    } else if (StressRunner::IsRunning()) {
+      AddLog("  [ERROR] A stress scenario is already running");
+    } else {
+      StressRunner::Request(arg);
+      AddLog("  Running stress scenario %s", arg.c_str());
+    }
+  } else if (parsed.rfind("governor", 0) == 0) {
+    // The ladder path keeps its case; keywords are matched in lower case.
+    std::string arg = (parsed.size() > 9) ? parsed.substr(9) : "";
+    std::string path = cmd.substr(cmd.size() - arg.size());
+    const char *usage = "  [ERROR] Usage: /governor [on|off] | target <ms> | "
+                        "level <n> | ladder <file>";
+    try {
+      if (arg == "on" || arg == "off") {
+        BudgetGovernor::SetEnabled(arg == "on");
+      } else if (arg.rfind("target ", 0) == 0) {
+        BudgetGovernor::s_TargetMs = std::max(std::stof(arg.substr(7)), 1.0f);
+      } else if (arg.rfind("level ", 0) == 0) {
+        BudgetGovernor::SetLevel(std::stoi(arg.substr(6)));
+      } else if (arg.rfind("ladder ", 0) == 0) {
+        std::string error;
+        if (!BudgetGovernor::LoadLadder(path.substr(7), error))
+          AddLog("  [ERROR] %s", error.c_str());
+      } else if (!arg.empty()) {
+        AddLog("%s", usage);
+        return;
+      }
+      const BudgetQualityLevel &quality = BudgetGovernor::GetQuality();
+      AddLog("  Governor: %s, target %.2f ms, level %d (%s)",
+             BudgetGovernor::s_Enabled ? "ON" : "OFF",
+             BudgetGovernor::s_TargetMs, BudgetGovernor::GetLevel(),
+             quality.name.c_str());
+      AddLog("    CPU %.2f ms, GPU %.2f ms, window %.2f ms",
+             BudgetGovernor::GetLastCPUMs(), BudgetGovernor::GetLastGPUMs(),
+             BudgetGovernor::GetWindowMs());
+    } catch (...) {
+      AddLog("%s", usage);
+    }
   } else if (parsed.rfind("skybox", 0) == 0) {
     std::string arg = (parsed.size() > 7) ? parsed.substr(7) : "";
     if (arg == "on")
@@ -257,6 +376,8 @@ void Console::Render(Camera *camera, RenderContext &ctx) {
   ImGui::BeginChild("ConsoleLog", ImVec2(0, -footerHeight), false,
                     ImGuiWindowFlags_HorizontalScrollbar);
 
+  // The logger's sink thread appends engine lines concurrently.
+  std::unique_lock<std::mutex> logLock(m_LogMutex);
   for (const auto &line : m_Log) {
 
     ImVec4 color = ImVec4(0.85f, 0.92f, 0.85f, 1.0f);
@@ -280,6 +401,7 @@ void Console::Render(Camera *camera, RenderContext &ctx) {
     ImGui::SetScrollHereY(1.0f);
     m_ScrollToBottom = false;
   }
+  logLock.unlock();
 
   ImGui::EndChild();
 
@@ -1,6 +1,8 @@
 #ifndef CONSOLE_H
 #define CONSOLE_H
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <functional>
@@ -54,10 +56,11 @@ private:
     void RenderLoggingScreen();
 
     bool m_Open = false;
-    bool m_EngineLoggingEnabled = false;
+    std::atomic<bool> m_EngineLoggingEnabled{false};
 
     
     std::vector<std::string> m_Log;
+    std::mutex m_LogMutex;
     char m_InputBuf[256] = {};
     bool m_ScrollToBottom = false;
     bool m_ReclaimFocus = false;
@@ -1,14 +1,18 @@
 #include "EditorApplication.h"
 #include "../Physics/HitboxGraphics.h"
+#include "../Renderer/BudgetGovernor.h"
 #include "../Renderer/StreamingManager.h"
 #include "../Scene/SceneManager.h"
 #include "../Scene/ScriptCompiler.h"
 #include "../Tools/Profiler/GpuProfiler.h"
+#include "../Tools/Profiler/PerfCounters.h"
 #include "../Tools/Profiler/Profiler.h"
+#include "../Tools/Stress/StressScenario.h"
 #include "../UI/UICreationEngine.h"
 #include "Console.h"
 #include "Editor.h"
 #include "Logger.h"
+#include "MemoryTracker.h"
 #include "Renderer.h"
 #include "ResourceManager.h"
 #include "ThreadManager.h"
@@ -497,7 +501,8 @@ void EditorApplication::EnterPlayMode() {
   s_GameCamInitialized = false;
 
   m_PlayModeSceneBackup = "/tmp/calcium3d_playmode_backup.scene";
-  m_Scene->Save(m_PlayModeSceneBackup);
+  m_Scene->Save(m_PlayModeSceneBackup, false, false);
+  StreamingManager::MarkDirty();
 
   int objCount = (int)m_Scene->GetObjects().size();
   for (int i = 0; i < objCount; i++) {
@@ -585,6 +590,7 @@ void EditorApplication::OnUpdate(float deltaTime) {
     if (Editor::isEditMode || isMasterControl || !gameCamActive) {
       m_Camera->Inputs(m_Window, deltaTime, isMasterControl);
     }
+    StressRunner::Update(*m_Scene, *m_Camera);
   }
 
   if (!Editor::isEditMode) {
@@ -617,7 +623,8 @@ void EditorApplication::OnUpdate(float deltaTime) {
     }
 
     m_Scene->Update(deltaTime, (float)glfwGetTime());
-    StreamingManager::Update(m_Camera->Position, *m_Scene);
+    StreamingManager::Update(m_Camera->Position, m_Camera->Orientation,
+                             *m_Scene);
 
     if (gameCamIdx != -1) {
       s_GameCam.Position = m_Camera->Position;
@@ -651,10 +658,15 @@ void EditorApplication::OnUpdate(float deltaTime) {
 
 void EditorApplication::OnRender() {
 
-  GpuProfiler::Get().SetEnabled(Profiler::Get().IsEnabled());
-  GpuProfiler::Get().SetPaused(Profiler::Get().IsPaused());
+#ifndef C3D_NO_PROFILER
+  // A capture or the budget governor needs GPU timings even while the
+  // profiler window is paused.
+  bool needGpuTimings = Profiler::IsRecording() || BudgetGovernor::s_Enabled;
+  GpuProfiler::Get().SetEnabled(Profiler::Get().IsEnabled() || needGpuTimings);
+  GpuProfiler::Get().SetPaused(Profiler::Get().IsPaused() && !needGpuTimings);
   Profiler::Get().BeginFrame();
   GpuProfiler::Get().BeginFrame();
+#endif
   m_EditorLayer->Begin();
   m_EditorLayer->UpdateViewportResolution(*m_Scene);
 
@@ -789,6 +801,15 @@ void EditorApplication::RenderEditor(float deltaTime) {
   m_RenderContext.autoLOD = Renderer::s_AutoLOD;
   m_RenderContext.clusteredShading = Renderer::s_ClusteredShading;
   m_RenderContext.adaptiveShadowRes = Renderer::s_AdaptiveShadowRes;
+  m_RenderContext.shadowCaching = Renderer::s_ShadowCaching;
+  m_RenderContext.pointShadowRefreshBudget =
+      Renderer::s_PointShadowRefreshBudget;
+  m_RenderContext.shadowCascadeCount = Renderer::s_ShadowCascadeCount;
+  m_RenderContext.dirShadowResolution = Renderer::s_ShadowCascadeResolution;
+  m_RenderContext.cascadeUpdateInterval = Renderer::s_CascadeUpdateInterval;
+  m_RenderContext.shadowCascadeSplitLambda =
+      Renderer::s_ShadowCascadeSplitLambda;
+  m_RenderContext.shadowDistance = Renderer::s_ShadowDistance;
   m_RenderContext.staticBatching = Renderer::s_StaticBatching;
   m_RenderContext.dynamicBatching = Renderer::s_DynamicBatching;
   m_RenderContext.vrs = Renderer::s_VRS;
@@ -856,13 +877,23 @@ void EditorApplication::RenderEditor(float deltaTime) {
 
 void EditorApplication::PostRender() {
   m_EditorLayer->End();
+#ifndef C3D_NO_PROFILER
   GpuProfiler::Get().EndFrame();
+#endif
 
   static double s_LastTime = glfwGetTime();
   double now = glfwGetTime();
   float dt = (float)(now - s_LastTime);
   s_LastTime = now;
+  BudgetGovernor::EndFrame();
+  MemoryTracker::EndFrame(m_Scene.get());
+#ifndef C3D_NO_PROFILER
+  PerfCounters::EndFrame();
+#endif
+  StressRunner::EndFrame(dt * 1000.0f);
+#ifndef C3D_NO_PROFILER
   Profiler::Get().EndFrame(dt * 1000.0f);
+#endif
 }
 
 void EditorApplication::Shutdown() {
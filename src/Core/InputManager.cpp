@@ -27,6 +27,7 @@ bool InputManager::IsKeyPressed(int key) {
 }
 
 bool InputManager::IsKeyJustPressed(int key) {
+    if (!m_Window) return false;
     bool current = glfwGetKey(m_Window, key) == GLFW_PRESS;
     bool previous = m_KeyStates[key];
     m_KeyStates[key] = current;
@@ -0,0 +1,66 @@
+#include "LinearArena.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+LinearArena::LinearArena(MemoryTag tag, size_t blockSize)
+    : m_Tag(tag), m_BlockSize(blockSize) {}
+
+LinearArena::~LinearArena() { FreeBlocks(); }
+
+void LinearArena::AddBlock(size_t size) {
+  m_Blocks.push_back({static_cast<char *>(::operator new(size)), size});
+  m_Reserved += size;
+  MemoryTracker::Track(m_Tag, (int64_t)size);
+}
+
+void LinearArena::FreeBlocks() {
+  for (Block &block : m_Blocks)
+    ::operator delete(block.data);
+  MemoryTracker::Track(m_Tag, -(int64_t)m_Reserved);
+  m_Blocks.clear();
+  m_Reserved = 0;
+}
+
+void *LinearArena::Allocate(size_t size, size_t align) {
+  size = std::max<size_t>(size, 1);
+  while (true) {
+    if (m_Current == m_Blocks.size())
+      AddBlock(std::max(m_BlockSize, size + align));
+
+    const Block &block = m_Blocks[m_Current];
+    uintptr_t base = (uintptr_t)block.data;
+    uintptr_t start = (base + m_Offset + align - 1) & ~(uintptr_t)(align - 1);
+    if (start + size <= base + block.size) {
+      m_Offset = start + size - base;
+      m_Peak = std::max(m_Peak, GetUsedBytes());
+      return (void *)start;
+    }
+    // The tail of this block stays unused until the next rewind.
+    ++m_Current;
+    m_Offset = 0;
+  }
+}
+
+void LinearArena::Rewind(const Marker &marker) {
+  m_Current = marker.block;
+  m_Offset = marker.offset;
+}
+
+void LinearArena::Reset() {
+  if (m_Blocks.size() > 1) {
+    FreeBlocks();
+    AddBlock(std::max(m_BlockSize, m_Peak));
+  }
+  m_Current = 0;
+  m_Offset = 0;
+  m_LastPeak = m_Peak;
+  m_Peak = 0;
+}
+
+size_t LinearArena::GetUsedBytes() const {
+  size_t used = m_Offset;
+  for (size_t i = 0; i < m_Current && i < m_Blocks.size(); ++i)
+    used += m_Blocks[i].size;
+  return used;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "MemoryTracker.h"
+#include <cstddef>
+#include <vector>
+
+// Bump allocator for short-lived data. Nothing is freed on its own: Rewind()
+// drops everything allocated after a marker and Reset() drops everything.
+// Blocks are kept for reuse, so an arena that is reset every frame stops
+// touching the heap once it has seen its peak. Not thread safe.
+class LinearArena {
+public:
+  struct Marker {
+    size_t block = 0;
+    size_t offset = 0;
+  };
+
+  // Rewinds the arena to where it was when the scope opened.
+  class Scope {
+  public:
+    explicit Scope(LinearArena &arena)
+        : m_Arena(arena), m_Marker(arena.GetMarker()) {}
+    ~Scope() { m_Arena.Rewind(m_Marker); }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    LinearArena &m_Arena;
+    Marker m_Marker;
+  };
+
+  explicit LinearArena(MemoryTag tag, size_t blockSize = 256 * 1024);
+  ~LinearArena();
+  LinearArena(const LinearArena &) = delete;
+  LinearArena &operator=(const LinearArena &) = delete;
+
+  void *Allocate(size_t size, size_t align = alignof(std::max_align_t));
+  Marker GetMarker() const { return {m_Current, m_Offset}; }
+  void Rewind(const Marker &marker);
+  // Empties the arena. If the last frame spilled into several blocks they
+  // are replaced by one that holds the peak.
+  void Reset();
+
+  size_t GetUsedBytes() const;
+  size_t GetReservedBytes() const { return m_Reserved; }
+  // Highest use between the last two calls to Reset().
+  size_t GetPeakBytes() const { return m_LastPeak; }
+
+private:
+  struct Block {
+    char *data;
+    size_t size;
+  };
+
+  void AddBlock(size_t size);
+  void FreeBlocks();
+
+  MemoryTag m_Tag;
+  size_t m_BlockSize;
+  std::vector<Block> m_Blocks;
+  size_t m_Current = 0;
+  size_t m_Offset = 0;
+  size_t m_Reserved = 0;
+  size_t m_Peak = 0;
+  size_t m_LastPeak = 0;
+};
+
+// Lets standard containers live in an arena. deallocate() is a no-op: a
+// container that grows leaves its old storage behind until the arena
+// rewinds, so reserve up front where the size is known.
+template <typename T> class ArenaAllocator {
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(LinearArena &arena) : m_Arena(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : m_Arena(other.m_Arena) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(m_Arena->Allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *, size_t) {}
+
+  template <typename U> bool operator==(const ArenaAllocator<U> &other) const {
+    return m_Arena == other.m_Arena;
+  }
+  template <typename U> bool operator!=(const ArenaAllocator<U> &other) const {
+    return m_Arena != other.m_Arena;
+  }
+
+  LinearArena *m_Arena;
+};
+
+template <typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -1,7 +1,10 @@
 #include "Logger.h"
-#include <cstdarg>
-#include <iostream>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
 #include <string.h>
+#include <thread>
 
 #ifndef C3D_RUNTIME
 #include <imgui.h>
@@ -9,58 +12,326 @@
 
 #include "Console.h"
 
-std::vector<std::string> Logger::buffer;
+std::deque<Logger::Entry> Logger::s_History;
+std::mutex Logger::s_Mutex;
 Console *Logger::s_RuntimeConsole = nullptr;
+std::atomic<uint64_t> Logger::s_Dropped{0};
+std::atomic<LogLevel> Logger::s_MinLevel{LogLevel::Info};
+std::atomic<uint32_t> Logger::s_CategoryMask{0xFFFFFFFFu};
+#ifdef C3D_RUNTIME
+bool Logger::s_StdoutSink = true;
+#else
+bool Logger::s_StdoutSink = false;
+#endif
+
+static constexpr size_t kLoggerRingSize = 1024; // Power of two.
+static constexpr size_t kLoggerHistorySize = 1000;
+
+struct LoggerRecord {
+  std::atomic<uint64_t> sequence{0};
+  double time = 0.0;
+  LogLevel level = LogLevel::Info;
+  LogCategory category = LogCategory::General;
+  char text[1000];
+};
+
+// Bounded MPSC queue after Vyukov: producers claim a slot with one CAS on
+// s_LoggerEnqueuePos and publish it through the slot's sequence number.
+static LoggerRecord s_LoggerRing[kLoggerRingSize];
+static std::atomic<uint64_t> s_LoggerEnqueuePos{0};
+static uint64_t s_LoggerDequeuePos = 0;
+static std::atomic<uint64_t> s_LoggerConsumed{0};
+static const auto s_LoggerEpoch = std::chrono::steady_clock::now();
+
+static std::once_flag s_LoggerStartOnce;
+static std::atomic<bool> s_LoggerRunning{false};
+static std::atomic<bool> s_LoggerSynchronous{false};
+static std::atomic<bool> s_LoggerIdle{false};
+static std::mutex s_LoggerWakeMutex;
+static std::condition_variable s_LoggerWake;
+// Held by whoever consumes, so there is only ever one.
+static std::mutex s_LoggerDrainMutex;
+static FILE *s_LoggerFile = nullptr;
+static std::thread s_LoggerThread;
+
+// Joins the sink before the statics above go away.
+struct LoggerShutdownGuard {
+  ~LoggerShutdownGuard() { Logger::Shutdown(); }
+};
+static LoggerShutdownGuard s_LoggerShutdownGuard;
+
+bool LogRateLimiter::Allow(uint32_t &suppressed) {
+  int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - s_LoggerEpoch)
+                    .count();
+  int64_t start = m_WindowStart.load(std::memory_order_relaxed);
+  if (now - start >= 1000 &&
+      m_WindowStart.compare_exchange_strong(start, now)) {
+    suppressed = m_Suppressed.exchange(0);
+    m_Count.store(1);
+    return true;
+  }
+  suppressed = 0;
+  if (m_Count.fetch_add(1) < m_PerSecond)
+    return true;
+  m_Suppressed.fetch_add(1);
+  return false;
+}
+
+void Logger::SetRuntimeConsole(Console *console) {
+  std::lock_guard<std::mutex> lock(s_Mutex);
+  s_RuntimeConsole = console;
+}
+
+bool Logger::OpenFile(const std::string &path) {
+  std::lock_guard<std::mutex> lock(s_LoggerDrainMutex);
+  if (s_LoggerFile) {
+    fclose(s_LoggerFile);
+    s_LoggerFile = nullptr;
+  }
+  if (path.empty())
+    return true;
+  s_LoggerFile = fopen(path.c_str(), "a");
+  return s_LoggerFile != nullptr;
+}
 
-void Logger::SetRuntimeConsole(Console *console) { s_RuntimeConsole = console; }
+bool Logger::ParseLevel(const char *name, LogLevel &out) {
+  static const char *names[] = {"trace", "debug", "info", "warn", "error"};
+  for (int i = 0; i < 5; ++i) {
+    const char *a = name;
+    const char *b = names[i];
+    while (*a && std::tolower((unsigned char)*a) == *b) {
+      ++a;
+      ++b;
+    }
+    if (*a == 0 && *b == 0) {
+      out = (LogLevel)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *Logger::GetLevelName(LogLevel level) {
+  switch (level) {
+  case LogLevel::Trace:
+    return "TRACE";
+  case LogLevel::Debug:
+    return "DEBUG";
+  case LogLevel::Info:
+    return "INFO";
+  case LogLevel::Warn:
+    return "WARN";
+  case LogLevel::Error:
+    return "ERROR";
+  }
+  return "?";
+}
+
+const char *Logger::GetCategoryName(LogCategory category) {
+  static const char *names[] = {"General",   "Render", "Physics",
+                                "Audio",     "Streaming", "Script",
+                                "Resource",  "Editor"};
+  size_t index = (size_t)category;
+  return index < sizeof(names) / sizeof(names[0]) ? names[index] : "?";
+}
+
+void Logger::EnsureSinkThread() {
+  std::call_once(s_LoggerStartOnce, [] {
+    for (size_t i = 0; i < kLoggerRingSize; ++i)
+      s_LoggerRing[i].sequence.store(i, std::memory_order_relaxed);
+    if (s_LoggerSynchronous)
+      return;
+    s_LoggerRunning = true;
+    s_LoggerThread = std::thread(SinkLoop);
+  });
+}
 
 void Logger::AddLog(const char *fmt, ...) {
-  char buf[1024];
   va_list args;
   va_start(args, fmt);
-  vsnprintf(buf, sizeof(buf) / sizeof(buf[0]), fmt, args);
-  buf[(sizeof(buf) / sizeof(buf[0])) - 1] = 0;
+  LogV(LogLevel::Info, LogCategory::General, fmt, args);
   va_end(args);
-  buffer.push_back(buf);
+}
 
-#ifdef C3D_RUNTIME
-  std::cout << "[LOG] " << buf << std::endl;
-#endif
+void Logger::Log(LogLevel level, LogCategory category, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  LogV(level, category, fmt, args);
+  va_end(args);
+}
+
+void Logger::LogV(LogLevel level, LogCategory category, const char *fmt,
+                  va_list args) {
+  if (!IsEnabled(level, category))
+    return;
+  EnsureSinkThread();
+
+  uint64_t pos = s_LoggerEnqueuePos.load(std::memory_order_relaxed);
+  LoggerRecord *record;
+  while (true) {
+    record = &s_LoggerRing[pos & (kLoggerRingSize - 1)];
+    uint64_t seq = record->sequence.load(std::memory_order_acquire);
+    int64_t diff = (int64_t)seq - (int64_t)pos;
+    if (diff == 0) {
+      if (s_LoggerEnqueuePos.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      s_Dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      pos = s_LoggerEnqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  record->time = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - s_LoggerEpoch)
+                     .count();
+  record->level = level;
+  record->category = category;
+  vsnprintf(record->text, sizeof(record->text), fmt, args);
+  record->sequence.store(pos + 1, std::memory_order_release);
+
+  if (s_LoggerSynchronous.load(std::memory_order_relaxed))
+    Drain();
+  else if (s_LoggerIdle.load(std::memory_order_relaxed))
+    s_LoggerWake.notify_one();
+}
+
+size_t Logger::Drain() {
+  std::lock_guard<std::mutex> drainLock(s_LoggerDrainMutex);
+  size_t count = 0;
+  while (true) {
+    LoggerRecord &record =
+        s_LoggerRing[s_LoggerDequeuePos & (kLoggerRingSize - 1)];
+    if (record.sequence.load(std::memory_order_acquire) !=
+        s_LoggerDequeuePos + 1)
+      break;
+
+    if (s_StdoutSink) {
+      // Info keeps the old "[LOG]" prefix so existing log scrapers still
+      // match.
+      const char *tag =
+          record.level == LogLevel::Info ? "LOG" : GetLevelName(record.level);
+      fprintf(stdout, "[%s] %s\n", tag, record.text);
+    }
+    if (s_LoggerFile) {
+      fprintf(s_LoggerFile, "%10.3f %-5s %-9s %s\n", record.time,
+              GetLevelName(record.level), GetCategoryName(record.category),
+              record.text);
+    }
+    {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_History.push_back({record.level, record.category, record.text});
+      if (s_History.size() > kLoggerHistorySize)
+        s_History.pop_front();
+      if (s_RuntimeConsole)
+        s_RuntimeConsole->AddEngineLog(record.text);
+    }
+
+    record.sequence.store(s_LoggerDequeuePos + kLoggerRingSize,
+                          std::memory_order_release);
+    s_LoggerDequeuePos++;
+    count++;
+  }
+  if (count) {
+    if (s_StdoutSink)
+      fflush(stdout);
+    if (s_LoggerFile)
+      fflush(s_LoggerFile);
+    s_LoggerConsumed.store(s_LoggerDequeuePos, std::memory_order_release);
+  }
+  return count;
+}
 
-  if (buffer.size() > 100) {
-    buffer.erase(buffer.begin());
+void Logger::SinkLoop() {
+  while (s_LoggerRunning.load()) {
+    if (Drain() > 0)
+      continue;
+    std::unique_lock<std::mutex> lock(s_LoggerWakeMutex);
+    s_LoggerIdle = true;
+    // The timeout covers a notify that lands between Drain() and the wait.
+    s_LoggerWake.wait_for(lock, std::chrono::milliseconds(20));
+    s_LoggerIdle = false;
   }
+}
 
-  if (s_RuntimeConsole) {
-    s_RuntimeConsole->AddEngineLog(buf);
+void Logger::Flush() {
+  uint64_t target = s_LoggerEnqueuePos.load(std::memory_order_acquire);
+  if (!s_LoggerRunning.load()) {
+    Drain();
+    return;
+  }
+  s_LoggerWake.notify_one();
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+  while (s_LoggerConsumed.load(std::memory_order_acquire) < target &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
 }
 
+void Logger::Shutdown() {
+  // Anything logged from here on is written by the caller.
+  s_LoggerSynchronous = true;
+  if (s_LoggerRunning.exchange(false)) {
+    s_LoggerWake.notify_one();
+    s_LoggerThread.join();
+  }
+  Drain();
+}
+
 void Logger::Draw(const char *title, bool *p_open) {
 #ifndef C3D_RUNTIME
+  static int s_LoggerDrawLevel = (int)LogLevel::Trace;
+
   ImGui::SetNextWindowSize(ImVec2(500, 400), ImGuiCond_FirstUseEver);
   if (!ImGui::Begin(title, p_open)) {
     ImGui::End();
     return;
   }
   if (ImGui::Button("Clear")) {
-    buffer.clear();
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_History.clear();
   }
   ImGui::SameLine();
   bool copy = ImGui::Button("Copy");
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(100.0f);
+  ImGui::Combo("Level", &s_LoggerDrawLevel,
+               "Trace\0Debug\0Info\0Warn\0Error\0");
+  uint64_t dropped = GetDroppedCount();
+  if (dropped) {
+    ImGui::SameLine();
+    ImGui::TextDisabled("(%llu dropped)", (unsigned long long)dropped);
+  }
+  std::lock_guard<std::mutex> lock(s_Mutex);
   ImGui::Separator();
   ImGui::BeginChild("scrolling", ImVec2(0, 0), false,
                     ImGuiWindowFlags_HorizontalScrollbar);
   if (copy) {
     std::string fullLog;
-    for (const auto &item : buffer) {
-      fullLog += item + "\n";
+    for (const auto &item : s_History) {
+      if ((int)item.level >= s_LoggerDrawLevel)
+        fullLog += item.text + "\n";
     }
     ImGui::SetClipboardText(fullLog.c_str());
   }
 
-  for (const auto &item : buffer) {
-    ImGui::TextUnformatted(item.c_str());
+  for (const auto &item : s_History) {
+    if ((int)item.level < s_LoggerDrawLevel)
+      continue;
+    if (item.level >= LogLevel::Warn) {
+      ImVec4 color = item.level == LogLevel::Error
+                         ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f)
+                         : ImVec4(1.0f, 0.8f, 0.3f, 1.0f);
+      ImGui::PushStyleColor(ImGuiCol_Text, color);
+      ImGui::TextUnformatted(item.text.c_str());
+      ImGui::PopStyleColor();
+    } else {
+      ImGui::TextUnformatted(item.text.c_str());
+    }
   }
 
   if (ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) {
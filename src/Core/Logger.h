@@ -1,6 +1,10 @@
 #pragma once
 
-#include <vector>
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <deque>
+#include <mutex>
 #include <string>
 
 #ifndef C3D_RUNTIME
@@ -9,12 +13,132 @@
 
 class Console;
 
+enum class LogLevel : uint8_t { Trace, Debug, Info, Warn, Error };
+
+enum class LogCategory : uint8_t {
+    General,
+    Render,
+    Physics,
+    Audio,
+    Streaming,
+    Script,
+    Resource,
+    Editor,
+    Count
+};
+
+// Levels below C3D_LOG_MIN_LEVEL and categories outside C3D_LOG_CATEGORIES
+// (a bit mask over LogCategory) compile away in the C3D_LOG* macros.
+#ifndef C3D_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define C3D_LOG_MIN_LEVEL 1
+#else
+#define C3D_LOG_MIN_LEVEL 0
+#endif
+#endif
+#ifndef C3D_LOG_CATEGORIES
+#define C3D_LOG_CATEGORIES 0xFFFFFFFFu
+#endif
+
+#define C3D_LOG_COMPILED(level, category)                                     \
+    ((int)(level) >= C3D_LOG_MIN_LEVEL &&                                     \
+     ((C3D_LOG_CATEGORIES >> (int)(category)) & 1u))
+
+#define C3D_LOG(level, category, ...)                                         \
+    do {                                                                      \
+        if constexpr (C3D_LOG_COMPILED(level, category))                      \
+            Logger::Log(level, category, __VA_ARGS__);                        \
+    } while (0)
+
+// At most perSecond messages a second from this call site. The next message
+// through reports how many were dropped.
+#define C3D_LOG_RATE_LIMITED(perSecond, level, category, ...)                 \
+    do {                                                                      \
+        if constexpr (C3D_LOG_COMPILED(level, category)) {                    \
+            static LogRateLimiter c3dLogLimiter(perSecond);                   \
+            uint32_t c3dLogSuppressed = 0;                                    \
+            if (c3dLogLimiter.Allow(c3dLogSuppressed)) {                      \
+                if (c3dLogSuppressed)                                         \
+                    Logger::Log(level, category,                              \
+                                "(%u similar messages suppressed)",           \
+                                c3dLogSuppressed);                            \
+                Logger::Log(level, category, __VA_ARGS__);                    \
+            }                                                                 \
+        }                                                                     \
+    } while (0)
+
+#define C3D_LOG_TRACE(category, ...)                                          \
+    C3D_LOG(LogLevel::Trace, category, __VA_ARGS__)
+#define C3D_LOG_DEBUG(category, ...)                                          \
+    C3D_LOG(LogLevel::Debug, category, __VA_ARGS__)
+#define C3D_LOG_INFO(category, ...)                                           \
+    C3D_LOG(LogLevel::Info, category, __VA_ARGS__)
+#define C3D_LOG_WARN(category, ...)                                           \
+    C3D_LOG(LogLevel::Warn, category, __VA_ARGS__)
+#define C3D_LOG_ERROR(category, ...)                                          \
+    C3D_LOG(LogLevel::Error, category, __VA_ARGS__)
+
+class LogRateLimiter {
+public:
+    explicit LogRateLimiter(uint32_t perSecond) : m_PerSecond(perSecond) {}
+    bool Allow(uint32_t& suppressed);
+
+private:
+    uint32_t m_PerSecond;
+    // Milliseconds; starts far enough back that the first call opens a window.
+    std::atomic<int64_t> m_WindowStart{-1000};
+    std::atomic<uint32_t> m_Count{0};
+    std::atomic<uint32_t> m_Suppressed{0};
+};
+
+// Callers format into a fixed-size record and push it onto a lock-free ring;
+// a sink thread writes records to stdout, the log file, the editor history
+// and the runtime Console. When the ring is full the record is dropped
+// rather than blocking the caller.
 class Logger {
 public:
+    // Info, General. Kept for the many existing call sites.
     static void AddLog(const char* fmt, ...);
+    static void Log(LogLevel level, LogCategory category, const char* fmt, ...);
+    static void LogV(LogLevel level, LogCategory category, const char* fmt,
+                     va_list args);
+
     static void Draw(const char* title, bool* p_open = NULL);
     static void SetRuntimeConsole(Console* console);
+    // Appends to path; empty closes the file.
+    static bool OpenFile(const std::string& path);
+
+    static bool IsEnabled(LogLevel level, LogCategory category) {
+        return level >= s_MinLevel.load(std::memory_order_relaxed) &&
+               ((s_CategoryMask.load(std::memory_order_relaxed) >>
+                 (int)category) & 1u);
+    }
+    static bool ParseLevel(const char* name, LogLevel& out);
+    static const char* GetLevelName(LogLevel level);
+    static const char* GetCategoryName(LogCategory category);
+
+    // Blocks until everything logged before the call has reached the sinks.
+    static void Flush();
+    static void Shutdown();
+    static uint64_t GetDroppedCount() { return s_Dropped.load(); }
+
+    static std::atomic<LogLevel> s_MinLevel;
+    static std::atomic<uint32_t> s_CategoryMask;
+    static bool s_StdoutSink;
+
 private:
-    static std::vector<std::string> buffer;
+    struct Entry {
+        LogLevel level;
+        LogCategory category;
+        std::string text;
+    };
+
+    static void EnsureSinkThread();
+    static void SinkLoop();
+    static size_t Drain();
+
+    static std::deque<Entry> s_History;
+    static std::mutex s_Mutex;
     static Console* s_RuntimeConsole;
+    static std::atomic<uint64_t> s_Dropped;
 };
@@ -0,0 +1,133 @@
+#include "MemoryTracker.h"
+#include "../AudioEngine/AudioEngine.h"
+#include "../Renderer/DynamicBatcher.h"
+#include "../Renderer/HLODManager.h"
+#include "../Renderer/StaticBatcher.h"
+#include "../Scene/Scene.h"
+#include "../Tools/Profiler/Profiler.h"
+#include "LinearArena.h"
+#include "ResourceManager.h"
+#include <cstdlib>
+#include <imgui.h>
+#include <string>
+#include <unordered_set>
+
+static constexpr int kMemoryTagCount = (int)MemoryTag::Count;
+
+std::atomic<int64_t> MemoryTracker::s_Tracked[kMemoryTagCount];
+MemoryTagStats MemoryTracker::s_Sampled[kMemoryTagCount];
+int MemoryTracker::s_SampleInterval = 30;
+
+static int s_MemoryTrackerFrame = 0;
+
+const char *MemoryTracker::GetTagName(MemoryTag tag) {
+  static const char *names[] = {"Meshes", "Textures", "Render", "Physics",
+                                "Audio",  "Scripts",  "UI"};
+  size_t index = (size_t)tag;
+  return index < sizeof(names) / sizeof(names[0]) ? names[index] : "?";
+}
+
+LinearArena &MemoryTracker::GetFrameArena() {
+  static LinearArena arena(MemoryTag::Render);
+  return arena;
+}
+
+MemoryTagStats MemoryTracker::Get(MemoryTag tag) {
+  MemoryTagStats stats = s_Sampled[(int)tag];
+  stats.cpuBytes += s_Tracked[(int)tag].load(std::memory_order_relaxed);
+  return stats;
+}
+
+MemoryTagStats MemoryTracker::GetTotal() {
+  MemoryTagStats total;
+  for (int t = 0; t < kMemoryTagCount; ++t) {
+    MemoryTagStats stats = Get((MemoryTag)t);
+    total.cpuBytes += stats.cpuBytes;
+    total.gpuBytes += stats.gpuBytes;
+  }
+  return total;
+}
+
+static void AddMemoryStats(MemoryTagStats &to, const MemoryTagStats &from) {
+  to.cpuBytes += from.cpuBytes;
+  to.gpuBytes += from.gpuBytes;
+}
+
+void MemoryTracker::Sample(const Scene *scene) {
+  MemoryTagStats sampled[kMemoryTagCount];
+  MemoryTagStats &meshes = sampled[(int)MemoryTag::Meshes];
+  MemoryTagStats &textures = sampled[(int)MemoryTag::Textures];
+
+  // Meshes hold their textures by value, so the same GL texture shows up
+  // many times; count each name once.
+  std::unordered_set<GLuint> textureIds;
+  auto addTexture = [&](const Texture &texture) {
+    if (texture.gpuBytes != 0 && textureIds.insert(texture.ID).second)
+      textures.gpuBytes += texture.gpuBytes;
+  };
+  for (const auto &[name, texture] : ResourceManager::GetTextures())
+    addTexture(texture);
+
+  if (scene) {
+    for (const auto &obj : scene->GetObjects()) {
+      meshes.cpuBytes += obj.mesh.GetMemoryBytes();
+      meshes.gpuBytes += obj.mesh.GetGPUBytes();
+      for (const auto &texture : obj.mesh.textures)
+        addTexture(texture);
+    }
+  }
+  AddMemoryStats(meshes, StaticBatcher::GetMemoryStats());
+  AddMemoryStats(meshes, HLODManager::GetMemoryStats());
+  sampled[(int)MemoryTag::Render] = DynamicBatcher::GetMemoryStats();
+  sampled[(int)MemoryTag::Audio] = AudioEngine::GetMemoryStats();
+
+  for (int t = 0; t < kMemoryTagCount; ++t)
+    s_Sampled[t] = sampled[t];
+}
+
+void MemoryTracker::EndFrame(const Scene *scene) {
+  GetFrameArena().Reset();
+
+  if (s_SampleInterval <= 1 || ++s_MemoryTrackerFrame >= s_SampleInterval) {
+    s_MemoryTrackerFrame = 0;
+    Sample(scene);
+  }
+
+#ifndef C3D_NO_PROFILER
+  static std::string counterNames[kMemoryTagCount];
+  Profiler &profiler = Profiler::Get();
+  for (int t = 0; t < kMemoryTagCount; ++t) {
+    if (counterNames[t].empty())
+      counterNames[t] = std::string("Memory ") + GetTagName((MemoryTag)t) +
+                        " (MB)";
+    MemoryTagStats stats = Get((MemoryTag)t);
+    profiler.SetCounter(counterNames[t],
+                        (float)(stats.cpuBytes + stats.gpuBytes) /
+                            (1024.0f * 1024.0f));
+  }
+#endif
+}
+
+// A header in front of each block remembers its size for the free side.
+static constexpr size_t kImGuiAllocHeader = 16;
+
+static void *MemoryTrackerImGuiAlloc(size_t size, void *) {
+  char *block = (char *)malloc(size + kImGuiAllocHeader);
+  if (!block)
+    return nullptr;
+  *(size_t *)block = size;
+  MemoryTracker::Track(MemoryTag::UI, (int64_t)size);
+  return block + kImGuiAllocHeader;
+}
+
+static void MemoryTrackerImGuiFree(void *ptr, void *) {
+  if (!ptr)
+    return;
+  char *block = (char *)ptr - kImGuiAllocHeader;
+  MemoryTracker::Track(MemoryTag::UI, -(int64_t)*(size_t *)block);
+  free(block);
+}
+
+void MemoryTracker::InstallImGuiAllocator() {
+  ImGui::SetAllocatorFunctions(MemoryTrackerImGuiAlloc, MemoryTrackerImGuiFree);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class LinearArena;
+class Scene;
+
+enum class MemoryTag : uint8_t {
+  Meshes,
+  Textures,
+  Render,
+  Physics,
+  Audio,
+  Scripts,
+  UI,
+  Count
+};
+
+struct MemoryTagStats {
+  int64_t cpuBytes = 0;
+  int64_t gpuBytes = 0;
+};
+
+// Bytes held per subsystem. Allocations that go through one place (arenas,
+// behaviours, ImGui) are counted as they happen with Track(); resources that
+// live in many containers (meshes, textures, sounds) are summed by Sample().
+class MemoryTracker {
+public:
+  static void Track(MemoryTag tag, int64_t bytes) {
+    s_Tracked[(int)tag].fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  // Main thread, once per frame: resets the frame arena, samples every
+  // s_SampleInterval frames and publishes the totals as profiler counters.
+  static void EndFrame(const Scene *scene);
+  static void Sample(const Scene *scene);
+
+  // Tracked bytes plus the last sample.
+  static MemoryTagStats Get(MemoryTag tag);
+  static MemoryTagStats GetTotal();
+  static const char *GetTagName(MemoryTag tag);
+
+  // Main thread scratch memory for data that does not outlive the frame.
+  static LinearArena &GetFrameArena();
+  // Counts ImGui's heap under MemoryTag::UI. Call before ImGui::CreateContext.
+  static void InstallImGuiAllocator();
+
+  static int s_SampleInterval;
+
+private:
+  static std::atomic<int64_t> s_Tracked[(int)MemoryTag::Count];
+  static MemoryTagStats s_Sampled[(int)MemoryTag::Count];
+};
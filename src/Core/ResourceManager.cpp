@@ -1,5 +1,6 @@
 #include "ResourceManager.h"
 #include "Application.h"
+#include "../Tools/Profiler/PerfCounters.h"
 #include <filesystem>
 #include <iostream>
 
@@ -126,8 +127,10 @@ Shader &ResourceManager::LoadShader(const std::string &name,
                                     const char *fShaderFile,
                                     const char *gShaderFile) {
   if (Shaders.find(name) != Shaders.end()) {
+    PERF_COUNT(PerfCounter::ResourceCacheHits, 1);
     return Shaders.at(name);
   }
+  PERF_COUNT(PerfCounter::ResourceLoads, 1);
 
   std::string vPath = ResolvePath(vShaderFile);
   std::string fPath = ResolvePath(fShaderFile);
@@ -149,6 +152,7 @@ Shader &ResourceManager::ReloadShader(const std::string &name,
                                       const char *vShaderFile,
                                       const char *fShaderFile,
                                       const char *gShaderFile) {
+  PERF_COUNT(PerfCounter::ResourceLoads, 1);
   std::string vPath = ResolvePath(vShaderFile);
   std::string fPath = ResolvePath(fShaderFile);
   std::string gPath = gShaderFile != nullptr ? ResolvePath(gShaderFile) : "";
@@ -185,8 +189,10 @@ bool ResourceManager::HasShader(const std::string &name) {
 Texture &ResourceManager::LoadTexture(const std::string &name, const char *file,
                                       const char *texType, GLuint slot) {
   if (Textures.find(name) != Textures.end()) {
+    PERF_COUNT(PerfCounter::ResourceCacheHits, 1);
     return Textures.at(name);
   }
+  PERF_COUNT(PerfCounter::ResourceLoads, 1);
 
   std::string path = ResolvePath(file);
   Textures.emplace(std::piecewise_construct, std::forward_as_tuple(name),
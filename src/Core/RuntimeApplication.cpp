@@ -1,4 +1,5 @@
 #include "RuntimeApplication.h"
+#include "../AudioEngine/AudioEngine.h"
 #include "../Core/InputManager.h"
 #include "../Physics/HitboxGraphics.h"
 #include "../Physics/PhysicsEngine.h"
@@ -7,11 +8,17 @@
 #include "../UI/Screens/StartScreen.h"
 #include "../UI/UICreationEngine.h"
 #include "2dCloud.h"
+#include "BudgetGovernor.h"
 #include "Logger.h"
+#include "MemoryTracker.h"
 #include "ObjectFactory.h"
+#include "RenderDevice.h"
 #include "Tools/Profiler/GpuProfiler.h"
+#include "Tools/Profiler/PerfCounters.h"
 #include "Tools/Profiler/Profiler.h"
+#include "Tools/Stress/StressScenario.h"
 #include "VolumetricCloud.h"
+#include <chrono>
 #include <fstream>
 #include <glm/glm.hpp>
 #include <imgui.h>
@@ -19,36 +26,133 @@
 #include <imgui_impl_opengl3.h>
 #include <iostream>
 #include <map>
+#include <thread>
 
 RuntimeApplication::RuntimeApplication(const ApplicationSpecification &spec)
     : Application(spec) {}
 
-RuntimeApplication::~RuntimeApplication() {}
+RuntimeApplication::~RuntimeApplication() {
+  Logger::SetRuntimeConsole(nullptr);
+}
+
+HeadlessConfig RuntimeApplication::s_HeadlessConfig;
 
 bool RuntimeApplication::Init() {
+  if (RenderDevice::IsHeadless())
+    AudioEngine::s_DeviceConfig.headless = true;
   if (!Application::Init())
     return false;
 
-  IMGUI_CHECKVERSION();
-  ImGui::CreateContext();
-  ImGuiIO &io = ImGui::GetIO();
-  (void)io;
-  ImGui::StyleColorsDark();
-  ImGui_ImplGlfw_InitForOpenGL(m_Window, true);
-  ImGui_ImplOpenGL3_Init("#version 330");
+  int winW = (int)m_Specification.Width, winH = (int)m_Specification.Height;
+  if (m_Window) {
+    IMGUI_CHECKVERSION();
+    MemoryTracker::InstallImGuiAllocator();
+    ImGui::CreateContext();
+    ImGuiIO &io = ImGui::GetIO();
+    (void)io;
+    ImGui::StyleColorsDark();
+    ImGui_ImplGlfw_InitForOpenGL(m_Window, true);
+    ImGui_ImplOpenGL3_Init("#version 330");
+    glfwGetFramebufferSize(m_Window, &winW, &winH);
+  }
 
   m_Console = std::make_unique<Console>();
   Logger::SetRuntimeConsole(m_Console.get());
   m_Console->Init();
 
-  int winW, winH;
-  glfwGetFramebufferSize(m_Window, &winW, &winH);
   CreateViewportFramebuffer(winW, winH);
 
   LoadProjectConfig();
   return true;
 }
 
+void RuntimeApplication::Run() {
+  if (m_Window)
+    Application::Run();
+  else
+    RunHeadless();
+}
+
+double RuntimeApplication::GetTime() const {
+  return m_Window ? glfwGetTime() : m_SimTime;
+}
+
+void RuntimeApplication::RunHeadless() {
+  using Clock = std::chrono::steady_clock;
+  PROFILE_THREAD("Main");
+
+  const float rate = std::max(s_HeadlessConfig.tickRate, 1.0f);
+  const float dt = 1.0f / rate;
+  const auto period = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / rate));
+  Logger::AddLog("Headless: %s render device, %.0f Hz%s",
+                 RenderDevice::GetBackendName(), rate,
+                 s_HeadlessConfig.render ? "" : ", rendering off");
+
+  uint64_t ticks = 0, overruns = 0;
+  double busySeconds = 0.0;
+  auto next = Clock::now();
+  const uint64_t maxTicks = s_HeadlessConfig.maxTicks;
+  while (m_Running && (maxTicks == 0 || ticks < maxTicks)) {
+    auto start = Clock::now();
+    BudgetGovernor::BeginFrame();
+#ifndef C3D_NO_PROFILER
+    Profiler::Get().BeginFrame();
+#endif
+    RenderDevice::BeginFrame();
+    m_RenderContext.deltaTime = dt;
+
+    // Same order as Application::Run.
+    GameStateManager::Update(dt);
+    OnUpdate(dt);
+    if (GameStateManager::IsState(GameState::GAMEPLAY))
+      m_Scene->Update(dt, (float)m_SimTime);
+    if (m_Camera && m_Scene) {
+      AudioEngine::Update(m_Scene.get(), m_Camera->Position,
+                          m_Camera->Orientation, m_Camera->Up, dt);
+    }
+    if (s_HeadlessConfig.render)
+      RenderScene(m_ViewportWidth, m_ViewportHeight);
+
+    m_SimTime += dt;
+    ++ticks;
+    auto end = Clock::now();
+    double tickSeconds = std::chrono::duration<double>(end - start).count();
+    busySeconds += tickSeconds;
+    BudgetGovernor::EndFrame();
+    MemoryTracker::EndFrame(m_Scene.get());
+#ifndef C3D_NO_PROFILER
+    PerfCounters::EndFrame();
+#endif
+    StressRunner::EndFrame((float)(tickSeconds * 1000.0));
+#ifndef C3D_NO_PROFILER
+    Profiler::Get().EndFrame((float)(tickSeconds * 1000.0));
+#endif
+
+    // A late tick does not make the next ones run back to back; the
+    // simulation falls behind the wall clock instead.
+    next += period;
+    if (end > next) {
+      ++overruns;
+      next = end;
+    } else {
+      std::this_thread::sleep_until(next);
+    }
+  }
+
+  const RenderDeviceStats &device = RenderDevice::GetStats();
+  Logger::AddLog("Headless: %llu ticks, %.3f ms per tick, %llu overruns",
+                 (unsigned long long)ticks,
+                 ticks ? busySeconds * 1000.0 / (double)ticks : 0.0,
+                 (unsigned long long)overruns);
+  Logger::AddLog("Headless: %u buffers (%.1f MB), %u textures (%.1f MB), "
+                 "%u renderbuffers (%.1f MB)",
+                 device.buffers, (double)device.bufferBytes / 1048576.0,
+                 device.textures, (double)device.textureBytes / 1048576.0,
+                 device.renderbuffers,
+                 (double)device.renderbufferBytes / 1048576.0);
+}
+
 void RuntimeApplication::LoadProjectConfig() {
   bool sceneLoaded = false;
 
@@ -403,7 +507,7 @@ void RuntimeApplication::OnUpdate(float deltaTime) {
   SceneManager::Get().Update(deltaTime);
 
   if (m_Scene) {
-    m_Scene->Update(deltaTime, (float)glfwGetTime());
+    m_Scene->Update(deltaTime, (float)GetTime());
   }
 
   if (m_IsDemoScene && m_Window) {
@@ -473,6 +577,9 @@ void RuntimeApplication::OnUpdate(float deltaTime) {
     glfwSetCursorPos(m_Window, centerX, centerY);
   }
 
+  if (m_Scene && m_Camera)
+    StressRunner::Update(*m_Scene, *m_Camera);
+
   if (InputManager::IsKeyJustPressed(GLFW_KEY_F1)) {
     m_ShowStateWarning = !m_ShowStateWarning;
   }
@@ -541,6 +648,15 @@ void RuntimeApplication::OnUpdate(float deltaTime) {
 }
 
 void RuntimeApplication::OnRender() {
+#ifndef C3D_NO_PROFILER
+  // The runtime has no profiler window; it only records for captures and
+  // the budget governor.
+  GpuProfiler::Get().SetEnabled(Profiler::IsRecording() ||
+                                BudgetGovernor::s_Enabled);
+  Profiler::Get().BeginFrame();
+  GpuProfiler::Get().BeginFrame();
+#endif
+
   int winW, winH;
   glfwGetFramebufferSize(m_Window, &winW, &winH);
 
@@ -550,34 +666,48 @@ void RuntimeApplication::OnRender() {
       ResizeMSAAFramebuffer(winW, winH);
   }
 
-  glViewport(0, 0, winW, winH);
+  RenderScene(winW, winH);
+
+  if (m_MSAASamples > 0) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_MSAAFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_ViewportFBO);
+    glBlitFramebuffer(0, 0, winW, winH, 0, 0, winW, winH, GL_COLOR_BUFFER_BIT,
+                      GL_NEAREST);
+  }
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_ViewportFBO);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0, 0, winW, winH, 0, 0, winW, winH, GL_COLOR_BUFFER_BIT,
+                    GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  if (m_Console && m_Console->IsHitboxEnabled()) {
+    Renderer::RenderHitboxes(*m_Scene, *m_Camera);
+  }
+
+  ImGui_ImplOpenGL3_NewFrame();
+  ImGui_ImplGlfw_NewFrame();
+  ImGui::NewFrame();
+}
+
+void RuntimeApplication::RenderScene(int width, int height) {
+  glViewport(0, 0, width, height);
 
   if (m_Camera) {
-    m_Camera->width = winW;
-    m_Camera->height = winH;
+    m_Camera->width = width;
+    m_Camera->height = height;
   }
 
-  m_RenderContext.width = winW;
-  m_RenderContext.height = winH;
+  m_RenderContext.width = width;
+  m_RenderContext.height = height;
   m_RenderContext.camera = m_Camera.get();
   m_RenderContext.scene = m_Scene.get();
   m_RenderContext.cloud2d = m_Cloud2D.get();
   m_RenderContext.volCloud = m_VolumetricCloud.get();
-  m_RenderContext.time = glfwGetTime();
+  m_RenderContext.time = GetTime();
   m_RenderContext.deltaTime = m_LastDeltaTime;
 
-  m_RenderContext.backfaceCulling = Renderer::s_BackfaceCulling;
-  m_RenderContext.objCulling = Renderer::s_ObjFrustumCulling;
-  m_RenderContext.lightCulling = Renderer::s_LightFrustumCulling;
-  m_RenderContext.shadowCulling = Renderer::s_ShadowFrustumCulling;
-  m_RenderContext.materialOptimisation = Renderer::s_MaterialOptimisation;
-  m_RenderContext.zPrepass = Renderer::s_ZPrepass;
-  m_RenderContext.autoLOD = Renderer::s_AutoLOD;
-  m_RenderContext.clusteredShading = Renderer::s_ClusteredShading;
-  m_RenderContext.adaptiveShadowRes = Renderer::s_AdaptiveShadowRes;
-  m_RenderContext.staticBatching = Renderer::s_StaticBatching;
-  m_RenderContext.dynamicBatching = Renderer::s_DynamicBatching;
-  m_RenderContext.vrs = Renderer::s_VRS;
+  SyncRenderSettings();
 
   m_RenderContext.showSkybox = m_Console->IsSkyboxEnabled();
   m_RenderContext.showGradientSky = m_Console->IsGradientSkyEnabled();
@@ -608,27 +738,6 @@ void RuntimeApplication::OnRender() {
     GPU_PROFILE_SCOPE("RenderPipeline");
     m_RenderPipeline->Execute(m_RenderContext);
   }
-
-  if (m_MSAASamples > 0) {
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_MSAAFBO);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_ViewportFBO);
-    glBlitFramebuffer(0, 0, winW, winH, 0, 0, winW, winH, GL_COLOR_BUFFER_BIT,
-                      GL_NEAREST);
-  }
-
-  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_ViewportFBO);
-  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-  glBlitFramebuffer(0, 0, winW, winH, 0, 0, winW, winH, GL_COLOR_BUFFER_BIT,
-                    GL_NEAREST);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-  if (m_Console && m_Console->IsHitboxEnabled()) {
-    Renderer::RenderHitboxes(*m_Scene, *m_Camera);
-  }
-
-  ImGui_ImplOpenGL3_NewFrame();
-  ImGui_ImplGlfw_NewFrame();
-  ImGui::NewFrame();
 }
 
 void RuntimeApplication::PostRender() {
@@ -743,4 +852,21 @@ void RuntimeApplication::PostRender() {
   m_Console->Render(m_Camera.get(), m_RenderContext);
   ImGui::Render();
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+#ifndef C3D_NO_PROFILER
+  GpuProfiler::Get().EndFrame();
+#endif
+
+  static double s_LastFrameTime = glfwGetTime();
+  double now = glfwGetTime();
+  float dt = (float)(now - s_LastFrameTime);
+  s_LastFrameTime = now;
+  BudgetGovernor::EndFrame();
+  MemoryTracker::EndFrame(m_Scene.get());
+#ifndef C3D_NO_PROFILER
+  PerfCounters::EndFrame();
+#endif
+  StressRunner::EndFrame(dt * 1000.0f);
+#ifndef C3D_NO_PROFILER
+  Profiler::Get().EndFrame(dt * 1000.0f);
+#endif
 }
@@ -4,13 +4,27 @@
 #include "Application.h"
 #include "Console.h"
 #include <nlohmann/json.hpp>
+#include <cstdint>
 #include <memory>
 
+// Used when the render device is RenderBackend::Null: no window, no ImGui,
+// the game ticks at a fixed rate until closed or maxTicks is reached.
+struct HeadlessConfig {
+    float tickRate = 60.0f;
+    uint64_t maxTicks = 0; // 0 runs until Close().
+    // Runs the render pipeline against the null device so culling, batching
+    // and draw counts are exercised. Off for a pure simulation server.
+    bool render = true;
+};
+
 class RuntimeApplication : public Application {
 public:
     RuntimeApplication(const ApplicationSpecification& spec);
     ~RuntimeApplication() override;
     bool Init() override;
+    void Run() override;
+
+    static HeadlessConfig s_HeadlessConfig;
 
 protected:
     void OnUpdate(float deltaTime) override;
@@ -20,6 +34,11 @@ protected:
 private:
     void LoadProjectConfig();
     void CreateDefaultScene();
+    void RunHeadless();
+    void RenderScene(int width, int height);
+    // glfwGetTime(), or the simulated time when headless.
+    double GetTime() const;
+    double m_SimTime = 0.0;
     float m_LastDeltaTime = 0.0f;
     std::unique_ptr<Console> m_Console;
     bool m_ShowStateWarning = false;
@@ -34,7 +34,7 @@ public:
 
     static void PushState(const std::string& name, std::any payload = {}) {
         if (m_Registry.find(name) == m_Registry.end()) {
-            Logger::AddLog("[ERROR] Failed to push state: %s not registered.", name.c_str());
+            C3D_LOG_ERROR(LogCategory::General, "[ERROR] Failed to push state: %s not registered.", name.c_str());
             return;
         }
 
@@ -64,7 +64,7 @@ public:
 
     static void ChangeState(const std::string& name, std::any payload = {}) {
         if (m_Registry.find(name) == m_Registry.end()) {
-            Logger::AddLog("[ERROR] Failed to change state: %s not registered.", name.c_str());
+            C3D_LOG_ERROR(LogCategory::General, "[ERROR] Failed to change state: %s not registered.", name.c_str());
             return;
         }
 
@@ -134,7 +134,7 @@ public:
 
     static void ChangeState(int id, std::any payload = {}) {
         if (m_StateNames.find(id) == m_StateNames.end()) {
-            Logger::AddLog("[ERROR] Failed to change state: ID %d not mapped to any string logic.", id);
+            C3D_LOG_ERROR(LogCategory::General, "[ERROR] Failed to change state: ID %d not mapped to any string logic.", id);
             return;
         }
         
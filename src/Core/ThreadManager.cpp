@@ -1,5 +1,7 @@
 #include "ThreadManager.h"
+#include "../Tools/Profiler/Profiler.h"
 #include <algorithm>
+#include <string>
 
 std::vector<std::thread> ThreadManager::s_Workers;
 std::queue<ThreadManager::Task> ThreadManager::s_Tasks;
@@ -18,7 +20,7 @@ void ThreadManager::Init() {
     s_Stop = false;
 
     for (int i = 0; i < s_ThreadCount; ++i) {
-        s_Workers.emplace_back(WorkerThread);
+        s_Workers.emplace_back(WorkerThread, i);
     }
     
     std::cout << "[ThreadManager] Initialized with " << s_ThreadCount << " worker threads (80% of " << cores << " cores)" << std::endl;
@@ -50,6 +52,7 @@ void ThreadManager::ParallelFor(int start, int end, std::function<void(int)> fun
         std::condition_variable cv;
         SharedState(int count) : remaining(count) {}
     };
+    PROFILE_SCOPE("ParallelFor");
     auto state = std::make_shared<SharedState>(end - start);
 
     {
@@ -70,7 +73,8 @@ void ThreadManager::ParallelFor(int start, int end, std::function<void(int)> fun
     state->cv.wait(lock, [&state]() { return state->remaining == 0; });
 }
 
-void ThreadManager::WorkerThread() {
+void ThreadManager::WorkerThread(int index) {
+    PROFILE_THREAD("Worker " + std::to_string(index));
     while (true) {
         Task task;
         {
@@ -80,6 +84,7 @@ void ThreadManager::WorkerThread() {
             task = std::move(s_Tasks.front());
             s_Tasks.pop();
         }
+        PROFILE_SCOPE("Job");
         task.func();
     }
 }
@@ -22,7 +22,7 @@ public:
     static void SetEnabled(bool enabled) { s_Enabled = enabled; }
 
 private:
-    static void WorkerThread();
+    static void WorkerThread(int index);
 
     struct Task {
         std::function<void()> func;
@@ -1,6 +1,13 @@
 #include "Application.h"
 #include "ResourceManager.h"
 #include "GPUManager.h"
+#include "RenderDevice.h"
+#include "Renderer.h"
+#include "BudgetGovernor.h"
+#include "Logger.h"
+#include "../Tools/Profiler/Profiler.h"
+#include <cstdlib>
+#include <cstring>
 
 #ifdef C3D_RUNTIME
 #include "RuntimeApplication.h"
@@ -9,7 +16,48 @@
 #endif
 
 int main(int argc, char** argv) {
-    GPUManager::EnsureProperGPU(argc, argv);
+    // --log-file <path>    also append the log to path
+    // --log-level <level>  trace, debug, info (default), warn or error
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--log-file") == 0) {
+            if (!Logger::OpenFile(argv[++i]))
+                printf("[Calcium3D] Could not open log file %s\n", argv[i]);
+        } else if (std::strcmp(argv[i], "--log-level") == 0) {
+            LogLevel level;
+            if (Logger::ParseLevel(argv[++i], level))
+                Logger::s_MinLevel = level;
+        }
+    }
+
+#ifdef C3D_RUNTIME
+    // --headless           no window or GPU: null render device, fixed tick
+    // --tick-rate <hz>     headless tick rate (default 60)
+    // --ticks <n>          stop after n headless ticks
+    // --no-render          headless without running the render pipeline
+    // --release-mesh-cpu   drop CPU copies of static meshes after loading
+    // --governor <ms>      lower quality automatically to hold a frame time
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            RenderDevice::s_Backend = RenderBackend::Null;
+        } else if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            RuntimeApplication::s_HeadlessConfig.tickRate =
+                (float)std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            RuntimeApplication::s_HeadlessConfig.maxTicks =
+                std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--no-render") == 0) {
+            RuntimeApplication::s_HeadlessConfig.render = false;
+        } else if (std::strcmp(argv[i], "--release-mesh-cpu") == 0) {
+            Renderer::s_ReleaseCPUMeshData = true;
+        } else if (std::strcmp(argv[i], "--governor") == 0 && i + 1 < argc) {
+            BudgetGovernor::s_TargetMs = (float)std::atof(argv[++i]);
+            BudgetGovernor::SetEnabled(BudgetGovernor::s_TargetMs > 0.0f);
+        }
+    }
+#endif
+
+    if (!RenderDevice::IsHeadless())
+        GPUManager::EnsureProperGPU(argc, argv);
     
     printf("[Calcium3D] Engine Starting...\n");
     
@@ -27,7 +75,25 @@ int main(int argc, char** argv) {
     if (!app.Init()) {
         return -1;
     }
-    
+
+#ifndef C3D_NO_PROFILER
+    // --capture <frames> [path]  write a trace of the first frames
+    // --capture-spike <ms>       write a trace around any slower frame
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            int frames = std::atoi(argv[++i]);
+            const char* path = "";
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                path = argv[++i];
+            Profiler::Get().StartCapture(frames, path);
+        } else if (std::strcmp(argv[i], "--capture-spike") == 0 &&
+                   i + 1 < argc) {
+            float ms = (float)std::atof(argv[++i]);
+            Profiler::Get().SetAutoCaptureThreshold(ms);
+        }
+    }
+#endif
+
     app.Run();
     return 0;
 }
\ No newline at end of file
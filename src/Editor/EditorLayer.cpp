@@ -6,6 +6,9 @@
 #include "../Physics/HitboxGraphics.h"
 #include "../Physics/PhysicsEngine.h"
 #include "../Renderer/AtlasManager.h"
+#include "../Renderer/BudgetGovernor.h"
+#include "../Renderer/ClusteredLighting.h"
+#include "../Renderer/DynamicBatcher.h"
 #include "../Renderer/HLODManager.h"
 #include "../Renderer/SDFGenerator.h"
 #include "../Renderer/StaticBatcher.h"
@@ -20,7 +23,9 @@
 #include "Core/Application.h"
 #include "Core/EditorApplication.h"
 #include "Editor.h"
+#include "LinearArena.h"
 #include "Logger.h"
+#include "MemoryTracker.h"
 #include "ModelImport/ModelImporter.h"
 #include "ObjectFactory.h"
 #include "PlayMode.h"
@@ -277,6 +282,7 @@ void EditorLayer::Init(GLFWwindow *window) {
   glfwSwapInterval(vsync ? 1 : 0);
 
   IMGUI_CHECKVERSION();
+  MemoryTracker::InstallImGuiAllocator();
   ImGui::CreateContext();
   ImGuiIO &io = ImGui::GetIO();
   (void)io;
@@ -939,16 +945,24 @@ void EditorLayer::DrawSceneHierarchy(Scene &scene) {
 
     auto executePaste = [&](int targetParentIndex) {
       if (!m_ClipboardNodes.empty()) {
+        std::vector<Mesh> meshes(m_ClipboardNodes.size());
+        for (size_t i = 0; i < m_ClipboardNodes.size(); ++i) {
+          if (Scene::CopyMesh(m_ClipboardNodes[i], meshes[i]))
+            continue;
+          Logger::AddLog("[ERROR] Cannot paste '%s': its CPU mesh data was "
+                         "released and cannot be rebuilt",
+                         m_ClipboardNodes[i].name.c_str());
+          for (size_t j = 0; j < i; ++j)
+            meshes[j].Delete();
+          return;
+        }
+
         std::unordered_map<int, int> clipToNew;
         selectedObjects.clear();
 
         for (int i = 0; i < m_ClipboardNodes.size(); ++i) {
           auto &src = m_ClipboardNodes[i];
-          Mesh newMesh(const_cast<std::vector<Vertex> &>(src.mesh.vertices),
-                       const_cast<std::vector<GLuint> &>(src.mesh.indices),
-                       src.mesh.textures);
-
-          GameObject newObj(std::move(newMesh), src.name);
+          GameObject newObj(std::move(meshes[i]), src.name);
           newObj.position = src.position;
           newObj.rotation = src.rotation;
           newObj.scale = src.scale;
@@ -1451,15 +1465,25 @@ void EditorLayer::DrawInspector(Scene &scene) {
       ImGui::Text("Transform");
 
       if (ImGui::Button("Bake SDF Shadows")) {
-        SDFVolume vol = SDFGenerator::GenerateSDF(obj.mesh, 32);
+        SDFBakeSettings settings;
+        settings.fastSweep = obj.sdf.fastSweep;
+        SDFVolume vol =
+            SDFGenerator::GenerateSDF(obj.mesh, obj.sdf.resolution, settings);
         obj.sdf.textureID = vol.textureID;
         obj.sdf.minP = vol.minAABB;
         obj.sdf.maxP = vol.maxAABB;
         obj.sdf.resolution = vol.resolution;
         obj.sdf.enabled = true;
         obj.hasSDF = true;
+        scene.ReleaseUnusedSDFs();
         Logger::AddLog("[SDF] Baked SDF for %s", obj.name.c_str());
       }
+      ImGui::SameLine();
+      if (ImGui::Checkbox("Fast Sweep", &obj.sdf.fastSweep))
+        TriggerAutoSave(scene);
+      if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Exact distances only near the surface; the rest "
+                          "of the volume is filled by fast sweeping.");
       ImGui::Checkbox("Is Occluder", &obj.isOccluder);
 
       float pos[3] = {obj.position.x, obj.position.y, obj.position.z};
@@ -2777,36 +2801,40 @@ void EditorLayer::DrawSettings(Scene &scene, Camera &camera) {
     ImGui::SameLine();
     ImGui::TextDisabled("(?)");
     if (ImGui::IsItemHovered())
-      ImGui::SetTooltip("Each layer can be toggled. Distances are connected: "
-                        "LOD 1 < LOD 2 < LOD 3 < LOD 4.\nValues scale with "
-                        "object radius (Value = Meters for 1m radius).");
+      ImGui::SetTooltip("LODs and HLOD proxies are picked by how many pixels "
+                        "their simplification error covers on screen.\nThe "
+                        "checkboxes toggle individual LOD layers.");
 
     for (int i = 0; i < 4; ++i) {
       ImGui::PushID(i + 500);
-
-      std::string checkLabel = "L##" + std::to_string(i + 1);
+      std::string checkLabel = "L" + std::to_string(i + 1);
       ImGui::Checkbox(checkLabel.c_str(), &Renderer::s_LODEnabled[i]);
-      ImGui::SameLine();
-
-      std::string sliderLabel = "Layer " + std::to_string(i + 1) + " Dist";
-      ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x - 20.0f);
-      if (ImGui::SliderFloat(sliderLabel.c_str(), &Renderer::s_LODDistances[i],
-                             0.0f, 1000.0f, "%.1f m")) {
-
-        for (int j = i + 1; j < 4; ++j) {
-          if (Renderer::s_LODDistances[j] < Renderer::s_LODDistances[j - 1])
-            Renderer::s_LODDistances[j] = Renderer::s_LODDistances[j - 1];
-        }
-
-        for (int j = i - 1; j >= 0; --j) {
-          if (Renderer::s_LODDistances[j] > Renderer::s_LODDistances[j + 1])
-            Renderer::s_LODDistances[j] = Renderer::s_LODDistances[j + 1];
-        }
-      }
-
+      if (i < 3)
+        ImGui::SameLine();
       ImGui::PopID();
     }
 
+    ImGui::SliderFloat("Pixel Tolerance", &Renderer::s_LODPixelTolerance,
+                       0.25f, 16.0f, "%.2f px");
+    ImGui::SliderFloat("Hysteresis", &Renderer::s_LODHysteresis, 0.0f, 0.9f,
+                       "%.2f");
+    ImGui::Checkbox("Dithered Cross-Fade", &Renderer::s_LODCrossFade);
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Not applied while the Z-Prepass is enabled.");
+    if (Renderer::s_LODCrossFade)
+      ImGui::SliderFloat("Fade Time", &Renderer::s_LODFadeTime, 0.05f, 1.0f,
+                         "%.2f s");
+    ImGui::InputInt("Triangle Budget", &Renderer::s_LODTriangleBudget, 10000,
+                    100000);
+    if (Renderer::s_LODTriangleBudget < 0)
+      Renderer::s_LODTriangleBudget = 0;
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Scales the pixel tolerance each frame to stay near "
+                        "this many triangles. 0 disables.");
+    ImGui::Text("Triangles: %zu  Effective Tolerance: %.2f px",
+                Renderer::s_LODTrianglesLastFrame,
+                Renderer::GetLODTolerance());
+
     ImGui::Unindent();
 
     ImGui::Separator();
@@ -2825,6 +2853,16 @@ void EditorLayer::DrawSettings(Scene &scene, Camera &camera) {
       Logger::AddLog("[Optimization] Clustered Shading %s",
                      Renderer::s_ClusteredShading ? "Enabled" : "Disabled");
     }
+    if (Renderer::s_ClusteredShading) {
+      ImGui::Indent();
+      ImGui::SliderInt("Max Lights / Cluster",
+                       &ClusteredLighting::s_MaxLightsPerCluster, 8, 1024);
+      const auto &cl = ClusteredLighting::GetStats();
+      ImGui::Text("%d lights, %d indices (max %d), %.1f KB, %.2f ms", cl.lights,
+                  cl.lightIndices, cl.maxLightsInCluster,
+                  cl.uploadBytes / 1024.0f, cl.binMs);
+      ImGui::Unindent();
+    }
     ImGui::Unindent();
 
     ImGui::Separator();
@@ -2844,6 +2882,50 @@ void EditorLayer::DrawSettings(Scene &scene, Camera &camera) {
       Logger::AddLog("[Optimization] Adaptive Shadows %s",
                      Renderer::s_AdaptiveShadowRes ? "Enabled" : "Disabled");
     }
+    if (ImGui::Checkbox("Cache Static Shadows", &Renderer::s_ShadowCaching)) {
+      Logger::AddLog("[Optimization] Shadow Caching %s",
+                     Renderer::s_ShadowCaching ? "Enabled" : "Disabled");
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("(?)");
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Renders static casters once per light and only "
+                        "redraws dynamic casters each frame.");
+    if (Renderer::s_ShadowCaching) {
+      ImGui::Indent();
+      ImGui::SliderInt("Cubemap Refreshes / Frame",
+                       &Renderer::s_PointShadowRefreshBudget, 1, 4);
+      ImGui::Unindent();
+    }
+
+    ImGui::SliderInt("Sun Cascades", &Renderer::s_ShadowCascadeCount, 1,
+                     MAX_SHADOW_CASCADES);
+    const int cascadeResolutions[] = {512, 1024, 2048, 4096};
+    const char *cascadeResolutionNames[] = {"512", "1024", "2048", "4096"};
+    int cascadeResIndex = 1;
+    for (int i = 0; i < 4; i++) {
+      if (cascadeResolutions[i] == Renderer::s_ShadowCascadeResolution)
+        cascadeResIndex = i;
+    }
+    if (ImGui::Combo("Cascade Resolution", &cascadeResIndex,
+                     cascadeResolutionNames, 4)) {
+      Renderer::s_ShadowCascadeResolution = cascadeResolutions[cascadeResIndex];
+    }
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Size of each cascade's tile. The atlas is this times "
+                        "the cascade count\n(2x2 tiles for four cascades), "
+                        "plus a same-sized static cache.");
+    ImGui::SliderFloat("Shadow Distance", &Renderer::s_ShadowDistance, 10.0f,
+                       500.0f);
+    ImGui::SliderFloat("Split Lambda", &Renderer::s_ShadowCascadeSplitLambda,
+                       0.0f, 1.0f);
+    ImGui::SliderInt("Far Cascade Interval",
+                     &Renderer::s_CascadeUpdateInterval, 1, 8);
+    ImGui::SameLine();
+    ImGui::TextDisabled("(?)");
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Cascades past the first are re-rendered every N "
+                        "frames.");
     ImGui::Unindent();
 
     ImGui::Separator();
@@ -2858,14 +2940,42 @@ void EditorLayer::DrawSettings(Scene &scene, Camera &camera) {
       StaticBatcher::Bake(*Application::Get().GetScene());
       Logger::AddLog("[Optimization] Baked Static Batches.");
     }
+    ImGui::Indent();
+    ImGui::SliderFloat("Chunk Size", &StaticBatcher::s_ChunkSize, 8.0f, 256.0f,
+                       "%.0f");
+    if (StaticBatcher::HasBatches())
+      ImGui::Text("Chunks: %d drawn / %d", StaticBatcher::GetDrawnLastFrame(),
+                  StaticBatcher::GetBatchCount());
+    ImGui::Unindent();
     if (ImGui::Checkbox("Dynamic Batching", &Renderer::s_DynamicBatching)) {
       Logger::AddLog("[Optimization] Dynamic Batching %s",
                      Renderer::s_DynamicBatching ? "Enabled" : "Disabled");
     }
+    if (Renderer::s_DynamicBatching) {
+      ImGui::Indent();
+      ImGui::Text("Dynamic: %d objects in %d draws",
+                  DynamicBatcher::GetObjectsLastFrame(),
+                  DynamicBatcher::GetBatchesLastFrame());
+      ImGui::Unindent();
+    }
+    ImGui::SliderFloat("HLOD Cluster Size", &HLODManager::s_ClusterSize,
+                       10.0f, 200.0f, "%.0f");
+    ImGui::SliderInt("HLOD Levels", &HLODManager::s_Levels, 1, 5);
+    ImGui::SliderInt("HLOD Triangle Budget", &HLODManager::s_TriangleBudget,
+                     256, 32768);
+    ImGui::SliderInt("HLOD Atlas Size", &HLODManager::s_AtlasResolution, 256,
+                     4096);
     if (ImGui::Button("Bake HLOD")) {
       HLODManager::BakeHLOD(*Application::Get().GetScene());
       Logger::AddLog("[Optimization] Baked HLOD Clusters.");
     }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear HLOD"))
+      HLODManager::Clear();
+    if (!HLODManager::GetProxies().empty())
+      ImGui::Text("HLOD: %d proxies, %d roots",
+                  (int)HLODManager::GetProxies().size(),
+                  (int)HLODManager::GetRoots().size());
     if (ImGui::Button("Bake Texture Atlas")) {
       AtlasManager::BakeSceneTextures(*Application::Get().GetScene());
     }
@@ -2914,6 +3024,30 @@ void EditorLayer::DrawSettings(Scene &scene, Camera &camera) {
     if (ImGui::SliderFloat("Streaming Radius", &radius, 10.0f, 500.0f)) {
       StreamingManager::SetStreamingRadius(radius);
     }
+    if (StreamingManager::s_EnableStreaming) {
+      ImGui::Indent();
+      ImGui::SliderFloat("Upload Budget (ms)",
+                         &StreamingManager::s_UploadBudgetMs, 0.25f, 8.0f);
+      int memoryMB = (int)(StreamingManager::s_MemoryBudgetBytes >> 20);
+      if (ImGui::SliderInt("Memory Budget (MB)", &memoryMB, 32, 8192)) {
+        StreamingManager::s_MemoryBudgetBytes = (size_t)memoryMB << 20;
+      }
+      if (ImGui::SliderFloat("Sector Size", &StreamingManager::s_CellSize,
+                             10.0f, 500.0f)) {
+        StreamingManager::MarkDirty();
+      }
+      const StreamingStats &ss = StreamingManager::GetStats();
+      ImGui::Text("Sectors: %d (%d in range)", ss.sectors, ss.sectorsInRange);
+      ImGui::Text("Queue: %d  Decoding: %d  Awaiting Upload: %d",
+                  ss.queueDepth, ss.inFlight, ss.awaitingUpload);
+      ImGui::Text("Resident: %d (%.1f MB)  Placeholders: %d",
+                  ss.residentObjects, ss.bytesResident / (1024.0f * 1024.0f),
+                  ss.placeholderObjects);
+      ImGui::Text("Last Frame: %d loads (%.2f ms), %d evictions",
+                  ss.loadsLastFrame, ss.uploadMsLastFrame,
+                  ss.evictionsLastFrame);
+      ImGui::Unindent();
+    }
     if (ImGui::Checkbox("Low Latency (Reflex)", &Renderer::s_LowLatencyMode)) {
       Logger::AddLog("[Performance] Low Latency Mode %s",
                      Renderer::s_LowLatencyMode ? "Enabled" : "Disabled");
@@ -2947,6 +3081,212 @@ void EditorLayer::DrawSettings(Scene &scene, Camera &camera) {
                      AudioEngine::s_CullWhenInaudible ? "Enabled" : "Disabled");
     }
     ImGui::SliderInt("Voices", &AudioEngine::s_MaxRealVoices, 1, 128);
+    ImGui::SliderFloat("Stream Clips Longer Than (s)",
+                       &AudioEngine::s_StreamThresholdSeconds, 1.0f, 60.0f);
+    AudioCacheStats audioCache = AudioEngine::GetCacheStats();
+    ImGui::Text("%d clips (%d decoded, %d streamed), %d active, %d pooled",
+                audioCache.assets, audioCache.decoded, audioCache.streamed,
+                audioCache.activeSounds, audioCache.pooledSounds);
+    if (ImGui::Button("Clear Sound Cache"))
+      AudioEngine::ClearSoundCache();
+    ImGui::SliderFloat("Acoustics Rate (Hz)",
+                       &AudioEngine::s_AcousticUpdateRate, 5.0f, 30.0f);
+    ImGui::SliderFloat("Reverb Probe Move Threshold",
+                       &AudioEngine::s_ReverbProbeMoveThreshold, 0.1f, 5.0f);
+    ImGui::Text("Acoustic rays: %.0f/s",
+                AudioEngine::GetAcousticRaysPerSecond());
+
+    AudioMixStats mix = AudioEngine::GetMixStats();
+    ImGui::Text("%s: %s", mix.backend.c_str(), mix.device.c_str());
+    ImGui::Text("%d Hz, %d ch, %d x %d frames (%.1f ms)", mix.sampleRate,
+                mix.channels, mix.periods, mix.periodFrames, mix.periodMs);
+    ImGui::Text("Callback avg %.3f ms, max %.3f ms, xruns %llu",
+                mix.callbackAvgMs, mix.callbackMaxMs,
+                (unsigned long long)mix.xruns);
+    ImGui::Text("Voices: %d real, %d virtual", mix.realVoices,
+                mix.virtualVoices);
+
+    static std::vector<std::string> audioDevices;
+    AudioDeviceConfig &audioConfig = AudioEngine::s_DeviceConfig;
+    if (ImGui::BeginCombo("Output Device",
+                          audioConfig.deviceName.empty()
+                              ? "System Default"
+                              : audioConfig.deviceName.c_str())) {
+      if (ImGui::Selectable("System Default", audioConfig.deviceName.empty()))
+        audioConfig.deviceName.clear();
+      for (const std::string &name : audioDevices) {
+        if (ImGui::Selectable(name.c_str(), audioConfig.deviceName == name))
+          audioConfig.deviceName = name;
+      }
+      ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Refresh##AudioDevices") || audioDevices.empty())
+      audioDevices = AudioEngine::GetPlaybackDevices();
+    const char *layouts[] = {"Auto", "Stereo", "5.1", "7.1"};
+    const AudioChannelLayout layoutValues[] = {
+        AudioChannelLayout::Auto, AudioChannelLayout::Stereo,
+        AudioChannelLayout::Surround51, AudioChannelLayout::Surround71};
+    int layoutIdx = 0;
+    for (int i = 0; i < 4; i++)
+      if (layoutValues[i] == audioConfig.layout)
+        layoutIdx = i;
+    if (ImGui::Combo("Speaker Layout", &layoutIdx, layouts, 4))
+      audioConfig.layout = layoutValues[layoutIdx];
+    ImGui::InputInt("Sample Rate (0 = native)", &audioConfig.sampleRate);
+    ImGui::InputInt("Period Frames (0 = default)", &audioConfig.periodFrames);
+    ImGui::SliderInt("Periods (0 = default)", &audioConfig.periods, 0, 4);
+    ImGui::Checkbox("Low Latency Profile", &audioConfig.lowLatency);
+    if (ImGui::Button("Apply Audio Device"))
+      AudioEngine::Restart(Application::Get().GetScene());
+    ImGui::Unindent();
+
+    ImGui::Separator();
+    ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.6f, 1.0f), "MEMORY Category");
+    ImGui::Indent();
+    const float mb = 1.0f / (1024.0f * 1024.0f);
+    if (ImGui::BeginTable("MemoryTags", 3,
+                          ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+      ImGui::TableSetupColumn("Tag");
+      ImGui::TableSetupColumn("CPU (MB)");
+      ImGui::TableSetupColumn("GPU (MB)");
+      ImGui::TableHeadersRow();
+      for (int t = 0; t < (int)MemoryTag::Count; ++t) {
+        MemoryTagStats stats = MemoryTracker::Get((MemoryTag)t);
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(MemoryTracker::GetTagName((MemoryTag)t));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", (float)stats.cpuBytes * mb);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", (float)stats.gpuBytes * mb);
+      }
+      MemoryTagStats total = MemoryTracker::GetTotal();
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted("Total");
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", (float)total.cpuBytes * mb);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", (float)total.gpuBytes * mb);
+      ImGui::EndTable();
+    }
+    LinearArena &frameArena = MemoryTracker::GetFrameArena();
+    ImGui::Text("Frame arena: %.1f KB peak, %.1f KB reserved",
+                (float)frameArena.GetPeakBytes() / 1024.0f,
+                (float)frameArena.GetReservedBytes() / 1024.0f);
+    ImGui::SliderInt("Sample Interval (frames)",
+                     &MemoryTracker::s_SampleInterval, 1, 120);
+    if (ImGui::Checkbox("Release CPU Mesh Data",
+                        &Renderer::s_ReleaseCPUMeshData)) {
+      Logger::AddLog("[Optimization] Release CPU Mesh Data %s",
+                     Renderer::s_ReleaseCPUMeshData ? "Enabled" : "Disabled");
+    }
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Applies after scene loads and batch/HLOD bakes.");
+    if (ImGui::Button("Release CPU Mesh Data Now")) {
+      Application::Get().GetScene()->ReleaseCPUMeshData();
+      MemoryTracker::Sample(Application::Get().GetScene());
+    }
+    ImGui::Unindent();
+
+    ImGui::Separator();
+    ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.5f, 1.0f), "BUDGET Category");
+    ImGui::Indent();
+    bool governor = BudgetGovernor::s_Enabled;
+    if (ImGui::Checkbox("Frame Budget Governor", &governor))
+      BudgetGovernor::SetEnabled(governor);
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Steps down the quality ladder while frames are "
+                        "over budget and back up once they recover.");
+    ImGui::DragFloat("Target Frame (ms)", &BudgetGovernor::s_TargetMs, 0.1f,
+                     4.0f, 100.0f, "%.1f");
+    ImGui::Text("Level %d (%s): CPU %.2f ms, GPU %.2f ms, window %.2f ms",
+                BudgetGovernor::GetLevel(),
+                BudgetGovernor::GetQuality().name.c_str(),
+                BudgetGovernor::GetLastCPUMs(), BudgetGovernor::GetLastGPUMs(),
+                BudgetGovernor::GetWindowMs());
+    if (!BudgetGovernor::GetLastDecision().empty())
+      ImGui::TextDisabled("%s", BudgetGovernor::GetLastDecision().c_str());
+    ImGui::SliderInt("Window (frames)", &BudgetGovernor::s_WindowFrames, 5,
+                     240);
+    ImGui::SliderFloat("Recover Below (x target)",
+                       &BudgetGovernor::s_RecoverRatio, 0.3f, 0.95f, "%.2f");
+    ImGui::SliderInt("Recover Windows", &BudgetGovernor::s_RecoverWindows, 1,
+                     20);
+    ImGui::SliderInt("Cooldown Windows", &BudgetGovernor::s_CooldownWindows,
+                     0, 20);
+
+    if (ImGui::TreeNode("Quality Ladder")) {
+      std::vector<BudgetQualityLevel> &ladder = BudgetGovernor::s_Ladder;
+      if (ladder.empty())
+        BudgetGovernor::ResetLadder();
+      if (ImGui::BeginTable("GovernorLadder", 6,
+                            ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+        ImGui::TableSetupColumn("Level");
+        ImGui::TableSetupColumn("LOD Tol.");
+        ImGui::TableSetupColumn("SSR");
+        ImGui::TableSetupColumn("Shadow Int.");
+        ImGui::TableSetupColumn("Script Dist.");
+        ImGui::TableSetupColumn("Lights/Cluster");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < (int)ladder.size(); ++i) {
+          BudgetQualityLevel &level = ladder[i];
+          ImGui::PushID(i);
+          ImGui::TableNextRow();
+          ImGui::TableNextColumn();
+          if (ImGui::Selectable(level.name.c_str(),
+                                BudgetGovernor::GetLevel() == i))
+            BudgetGovernor::SetLevel(i);
+          ImGui::TableNextColumn();
+          ImGui::SetNextItemWidth(-1);
+          ImGui::DragFloat("##lod", &level.lodToleranceScale, 0.05f, 0.1f,
+                           16.0f, "x%.2f");
+          ImGui::TableNextColumn();
+          ImGui::SetNextItemWidth(-1);
+          ImGui::SliderFloat("##ssr", &level.ssrScale, 0.05f, 1.0f, "x%.2f");
+          ImGui::TableNextColumn();
+          ImGui::SetNextItemWidth(-1);
+          ImGui::SliderInt("##shadow", &level.shadowIntervalScale, 1, 8,
+                           "x%d");
+          ImGui::TableNextColumn();
+          ImGui::SetNextItemWidth(-1);
+          ImGui::SliderFloat("##script", &level.scriptThrottleScale, 0.0f,
+                             1.0f, "x%.2f");
+          ImGui::TableNextColumn();
+          ImGui::SetNextItemWidth(-1);
+          ImGui::SliderInt("##lights", &level.maxLightsPerCluster, 0, 256,
+                           level.maxLightsPerCluster ? "%d" : "no cap");
+          ImGui::PopID();
+        }
+        ImGui::EndTable();
+      }
+      if (ImGui::Button("Add Level")) {
+        BudgetQualityLevel level = ladder.back();
+        level.name = "Level " + std::to_string(ladder.size());
+        ladder.push_back(level);
+      }
+      ImGui::SameLine();
+      if (ImGui::Button("Remove Level") && ladder.size() > 1) {
+        ladder.pop_back();
+        BudgetGovernor::SetLevel(
+            std::min(BudgetGovernor::GetLevel(), (int)ladder.size() - 1),
+            "ladder edited");
+      }
+      ImGui::SameLine();
+      if (ImGui::Button("Reset Ladder"))
+        BudgetGovernor::ResetLadder();
+
+      static char ladderPath[256] = "Resource/Governor/ladder.json";
+      ImGui::InputText("##LadderPath", ladderPath, sizeof(ladderPath));
+      ImGui::SameLine();
+      if (ImGui::Button("Load Ladder")) {
+        std::string error;
+        if (!BudgetGovernor::LoadLadder(ladderPath, error))
+          Logger::AddLog("[Optimization] Ladder: %s", error.c_str());
+      }
+      ImGui::TreePop();
+    }
     ImGui::Unindent();
   }
 
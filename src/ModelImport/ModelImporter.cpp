@@ -40,7 +40,7 @@ bool ModelImporter::IsModelFile(const std::string& extension) {
     return false;
 }
 
-ImportResult ModelImporter::Import(const std::string& filepath) {
+ImportResult ModelImporter::Import(const std::string& filepath, bool loadTextures) {
     std::string ext = fs::path(filepath).extension().string();
     std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
 
@@ -55,11 +55,11 @@ ImportResult ModelImporter::Import(const std::string& filepath) {
         return result;
     }
 
-    if (ext == ".obj")       result = ImportOBJ(filepath);
-    else if (ext == ".fbx")  result = ImportFBX(filepath);
-    else if (ext == ".gltf" || ext == ".glb") result = ImportGLTF(filepath);
-    else if (ext == ".stl")  result = ImportSTL(filepath);
-    else if (ext == ".ply")  result = ImportPLY(filepath);
+    if (ext == ".obj")       result = ImportOBJ(filepath, loadTextures);
+    else if (ext == ".fbx")  result = ImportFBX(filepath, loadTextures);
+    else if (ext == ".gltf" || ext == ".glb") result = ImportGLTF(filepath, loadTextures);
+    else if (ext == ".stl")  result = ImportSTL(filepath, loadTextures);
+    else if (ext == ".ply")  result = ImportPLY(filepath, loadTextures);
     else {
         result.error = "Unsupported format: " + ext;
         Logger::AddLog("[ModelImporter] ERROR: %s", result.error.c_str());
@@ -76,7 +76,7 @@ ImportResult ModelImporter::Import(const std::string& filepath) {
 
 
 
-ImportResult ModelImporter::ImportOBJ(const std::string& filepath) {
+ImportResult ModelImporter::ImportOBJ(const std::string& filepath, bool loadTextures) {
     ImportResult result;
     result.sourceFile = filepath;
 
@@ -142,7 +142,8 @@ ImportResult ModelImporter::ImportOBJ(const std::string& filepath) {
                 if (!mat.diffuse_texname.empty()) {
                     std::string texPath = baseDir + mat.diffuse_texname;
                     if (fs::exists(texPath)) {
-                        mesh.textures.push_back(Texture(texPath.c_str(), "diffuse"));
+                        mesh.texturePaths.push_back(texPath);
+                        if (loadTextures) mesh.textures.push_back(Texture(texPath.c_str(), "diffuse"));
                     }
                 }
             }
@@ -158,7 +159,7 @@ ImportResult ModelImporter::ImportOBJ(const std::string& filepath) {
 
 
 
-ImportResult ModelImporter::ImportFBX(const std::string& filepath) {
+ImportResult ModelImporter::ImportFBX(const std::string& filepath, bool loadTextures) {
     ImportResult result;
     result.sourceFile = filepath;
 
@@ -342,7 +343,8 @@ ImportResult ModelImporter::ImportFBX(const std::string& filepath) {
             }
             
             if (!diffPath.empty()) {
-                mesh.textures.push_back(Texture(diffPath.c_str(), "diffuse"));
+                mesh.texturePaths.push_back(diffPath);
+                if (loadTextures) mesh.textures.push_back(Texture(diffPath.c_str(), "diffuse"));
                 
                 mesh.albedo = glm::vec3(1.0f);
             }
@@ -365,7 +367,7 @@ ImportResult ModelImporter::ImportFBX(const std::string& filepath) {
 
 
 
-ImportResult ModelImporter::ImportGLTF(const std::string& filepath) {
+ImportResult ModelImporter::ImportGLTF(const std::string& filepath, bool loadTextures) {
     ImportResult result;
     result.sourceFile = filepath;
 
@@ -610,7 +612,8 @@ ImportResult ModelImporter::ImportGLTF(const std::string& filepath) {
                                             }
                                             
                                             if (!diffPath.empty()) {
-                                                mesh.textures.push_back(Texture(diffPath.c_str(), "diffuse"));
+                                                mesh.texturePaths.push_back(diffPath);
+                                                if (loadTextures) mesh.textures.push_back(Texture(diffPath.c_str(), "diffuse"));
                                                 mesh.albedo = glm::vec3(1.0f); 
                                             } else {
                                                 Logger::AddLog("[ModelImporter] Texture not found: %s", searchName.c_str());
@@ -691,7 +694,7 @@ ImportResult ModelImporter::ImportGLTF(const std::string& filepath) {
     return result;
 }
 
-ImportResult ModelImporter::ImportSTL(const std::string& filepath) {
+ImportResult ModelImporter::ImportSTL(const std::string& filepath, bool loadTextures) {
     ImportResult result;
     result.sourceFile = filepath;
 
@@ -781,7 +784,7 @@ ImportResult ModelImporter::ImportSTL(const std::string& filepath) {
 
 
 
-ImportResult ModelImporter::ImportPLY(const std::string& filepath) {
+ImportResult ModelImporter::ImportPLY(const std::string& filepath, bool loadTextures) {
     ImportResult result;
     result.sourceFile = filepath;
 
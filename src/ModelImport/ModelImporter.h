@@ -12,6 +12,7 @@ struct ImportedMeshData {
     std::vector<Vertex> vertices;
     std::vector<GLuint> indices;
     std::vector<Texture> textures;
+    std::vector<std::string> texturePaths;
     std::string name;
 
     glm::vec3 albedo = glm::vec3(0.8f);
@@ -32,18 +33,20 @@ struct ImportResult {
 
 class ModelImporter {
 public:
-    static ImportResult Import(const std::string& filepath);
+    // loadTextures = false skips all GL calls so the import can run off the
+    // render thread; texturePaths is filled in either way.
+    static ImportResult Import(const std::string& filepath, bool loadTextures = true);
 
     static bool IsModelFile(const std::string& extension);
 
     static std::vector<std::string> GetSupportedExtensions();
 
 private:
-    static ImportResult ImportOBJ(const std::string& filepath);
-    static ImportResult ImportFBX(const std::string& filepath);
-    static ImportResult ImportGLTF(const std::string& filepath);
-    static ImportResult ImportSTL(const std::string& filepath);
-    static ImportResult ImportPLY(const std::string& filepath);
+    static ImportResult ImportOBJ(const std::string& filepath, bool loadTextures);
+    static ImportResult ImportFBX(const std::string& filepath, bool loadTextures);
+    static ImportResult ImportGLTF(const std::string& filepath, bool loadTextures);
+    static ImportResult ImportSTL(const std::string& filepath, bool loadTextures);
+    static ImportResult ImportPLY(const std::string& filepath, bool loadTextures);
 };
 
 #endif
@@ -1,6 +1,8 @@
 #include "PhysicsEngine.h"
+#include "../Core/LinearArena.h"
 #include "../Core/ThreadManager.h"
 #include "../Scene/Scene.h"
+#include "../Tools/Profiler/PerfCounters.h"
 #include <algorithm>
 #include <iostream>
 #include <glm/gtc/matrix_transform.hpp>
@@ -64,6 +66,9 @@ static float getSampledWaveHeight(glm::vec2 pos, float time, float waveSpeed, fl
 }
 
 
+// Transient data of one substep, rewound when the substep ends.
+static LinearArena s_PhysicsScratch(MemoryTag::Physics, 64 * 1024);
+
 bool PhysicsEngine::GlobalGravityEnabled = true;
 glm::vec3 PhysicsEngine::Gravity = glm::vec3(0.0f, -9.81f, 0.0f);
 glm::vec3 PhysicsEngine::GlobalAcceleration = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -110,12 +115,6 @@ AABB PhysicsEngine::GetTransformedAABB(const AABB& localAABB, const glm::vec3& p
 }
 
 
-struct OBB {
-    glm::vec3 center;
-    glm::vec3 axes[3];
-    glm::vec3 halfExtents;
-};
-
 OBB GetGameObjectOBB(const GameObject& obj) {
     OBB obb;
     glm::vec3 localCenter = (obj.collider.min + obj.collider.max) * 0.5f;
@@ -263,6 +262,8 @@ void PhysicsEngine::Update(float deltaTime, float time, std::vector<GameObject>&
     if (deltaTime <= 0.0f || !GlobalPhysicsEnabled) return;
 
     float subDeltaTime = deltaTime / (float)SubSteps;
+    int64_t pairsTested = 0;
+    int64_t contacts = 0;
 
     for (int step = 0; step < SubSteps; ++step) {
         
@@ -276,7 +277,8 @@ void PhysicsEngine::Update(float deltaTime, float time, std::vector<GameObject>&
             int waveSystem;
             float tiling;
         };
-        std::vector<WaterVolume> waterVolumes;
+        LinearArena::Scope scratchScope(s_PhysicsScratch);
+        ArenaVector<WaterVolume> waterVolumes{ArenaAllocator<WaterVolume>(s_PhysicsScratch)};
         for (const auto& wObj : objects) {
             if (wObj.hasWater && wObj.isActive) {
                 AABB worldAABB = GetTransformedAABB(wObj.collider, wObj.position, wObj.rotation, wObj.scale);
@@ -415,6 +417,7 @@ void PhysicsEngine::Update(float deltaTime, float time, std::vector<GameObject>&
                 if (!objB.isActive || !objB.enableCollision) continue;
                 
                 OBB obbB = GetGameObjectOBB(objB);
+                ++pairsTested;
 
                 glm::vec3 normal;
                 float penetration;
@@ -441,6 +444,7 @@ void PhysicsEngine::Update(float deltaTime, float time, std::vector<GameObject>&
                     float invMassB = objB.isStatic ? 0.0f : (1.0f / objB.mass);
 
                     if (invMassA + invMassB == 0.0f) continue; 
+                    ++contacts;
 
                     
                     const float slop = 0.02f; 
@@ -625,6 +629,9 @@ void PhysicsEngine::Update(float deltaTime, float time, std::vector<GameObject>&
     }
 
     
+    PERF_COUNT(PerfCounter::PhysicsPairs, pairsTested);
+    PERF_COUNT(PerfCounter::PhysicsContacts, contacts);
+
     for (auto& obj : objects) {
         obj.acceleration = glm::vec3(0.0f);
         obj.torque = glm::vec3(0.0f);
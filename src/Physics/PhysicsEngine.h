@@ -14,6 +14,17 @@ struct AABB {
 
 struct GameObject; 
 
+// Oriented box of a collider in world space, used by the narrow phase.
+struct OBB {
+    glm::vec3 center;
+    glm::vec3 axes[3];
+    glm::vec3 halfExtents;
+};
+
+OBB GetGameObjectOBB(const GameObject& obj);
+// Separating axis test. On overlap, outNormal points from b towards a.
+bool TestOBBOBB(const OBB& a, const OBB& b, glm::vec3& outNormal, float& outPenetration);
+
 class PhysicsEngine {
 public:
     static bool GlobalGravityEnabled;
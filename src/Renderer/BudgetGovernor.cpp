@@ -0,0 +1,226 @@
+#include "BudgetGovernor.h"
+#include "../Core/Logger.h"
+#include "../Tools/Profiler/Profiler.h"
+#ifndef C3D_NO_PROFILER
+#include "../Tools/Profiler/GpuProfiler.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+bool BudgetGovernor::s_Enabled = false;
+float BudgetGovernor::s_TargetMs = 16.6f;
+int BudgetGovernor::s_WindowFrames = 30;
+float BudgetGovernor::s_RecoverRatio = 0.75f;
+int BudgetGovernor::s_RecoverWindows = 4;
+int BudgetGovernor::s_CooldownWindows = 2;
+std::vector<BudgetQualityLevel> BudgetGovernor::s_Ladder;
+
+int BudgetGovernor::s_Level = 0;
+long long BudgetGovernor::s_FrameStartNs = 0;
+float BudgetGovernor::s_LastCPUMs = 0.0f;
+float BudgetGovernor::s_LastGPUMs = 0.0f;
+double BudgetGovernor::s_WindowSum = 0.0;
+int BudgetGovernor::s_WindowCount = 0;
+float BudgetGovernor::s_WindowMs = 0.0f;
+int BudgetGovernor::s_UnderWindows = 0;
+int BudgetGovernor::s_Cooldown = 0;
+std::string BudgetGovernor::s_LastDecision;
+
+static long long GovernorNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static void GovernorMarker(const std::string &text) {
+#ifndef C3D_NO_PROFILER
+  Profiler::Get().AddMarker(text);
+#endif
+}
+
+// Resets to the default ladder the first time it is needed, so the vector
+// is never empty.
+static std::vector<BudgetQualityLevel> &GovernorLadder() {
+  if (BudgetGovernor::s_Ladder.empty())
+    BudgetGovernor::ResetLadder();
+  return BudgetGovernor::s_Ladder;
+}
+
+void BudgetGovernor::ResetLadder() {
+  // name, LOD tolerance, SSR, shadow interval, throttle distance, lights
+  s_Ladder = {
+      {"Full", 1.0f, 1.0f, 1, 1.0f, 0},
+      {"High", 1.5f, 0.75f, 1, 1.0f, 0},
+      {"Medium", 2.0f, 0.5f, 2, 0.75f, 128},
+      {"Low", 3.0f, 0.5f, 3, 0.5f, 64},
+      {"Minimum", 4.0f, 0.25f, 4, 0.35f, 32},
+  };
+  s_Level = std::min(s_Level, (int)s_Ladder.size() - 1);
+}
+
+bool BudgetGovernor::LoadLadder(const std::string &path, std::string &error) {
+  std::vector<BudgetQualityLevel> ladder;
+  try {
+    std::ifstream file(path);
+    if (!file) {
+      error = "cannot open " + path;
+      return false;
+    }
+    nlohmann::json json = nlohmann::json::parse(file);
+    if (!json.is_array()) {
+      error = "expected an array of levels";
+      return false;
+    }
+    for (const auto &entry : json) {
+      BudgetQualityLevel level;
+      level.name = entry.value("name", "Level " +
+                                           std::to_string(ladder.size()));
+      level.lodToleranceScale = std::max(
+          entry.value("lodToleranceScale", level.lodToleranceScale), 0.01f);
+      level.ssrScale =
+          std::clamp(entry.value("ssrScale", level.ssrScale), 0.05f, 1.0f);
+      level.shadowIntervalScale = std::max(
+          entry.value("shadowIntervalScale", level.shadowIntervalScale), 1);
+      level.scriptThrottleScale = std::max(
+          entry.value("scriptThrottleScale", level.scriptThrottleScale),
+          0.0f);
+      level.maxLightsPerCluster = std::max(
+          entry.value("maxLightsPerCluster", level.maxLightsPerCluster), 0);
+      ladder.push_back(std::move(level));
+    }
+  } catch (const std::exception &e) {
+    error = e.what();
+    return false;
+  }
+  if (ladder.empty()) {
+    error = "the ladder has no levels";
+    return false;
+  }
+  s_Ladder = std::move(ladder);
+  ChangeLevel(std::min(s_Level, (int)s_Ladder.size() - 1), "ladder loaded");
+  return true;
+}
+
+const BudgetQualityLevel &BudgetGovernor::GetQuality() {
+  static const BudgetQualityLevel full{"Off"};
+  if (!s_Enabled)
+    return full;
+  std::vector<BudgetQualityLevel> &ladder = GovernorLadder();
+  return ladder[std::clamp(s_Level, 0, (int)ladder.size() - 1)];
+}
+
+int BudgetGovernor::ScaleShadowInterval(int interval) {
+  return std::max(interval, 1) * std::max(GetQuality().shadowIntervalScale, 1);
+}
+
+int BudgetGovernor::ScalePointShadowBudget(int budget) {
+  if (budget <= 0)
+    return budget;
+  return std::max(budget / std::max(GetQuality().shadowIntervalScale, 1), 1);
+}
+
+int BudgetGovernor::ClampLightsPerCluster(int limit) {
+  int cap = GetQuality().maxLightsPerCluster;
+  return cap > 0 ? std::min(limit, cap) : limit;
+}
+
+void BudgetGovernor::SetEnabled(bool enabled) {
+  if (enabled == s_Enabled)
+    return;
+  s_Enabled = enabled;
+  s_FrameStartNs = 0;
+  s_WindowSum = 0.0;
+  s_WindowCount = 0;
+  s_UnderWindows = 0;
+  s_Cooldown = 0;
+  s_Level = 0;
+  s_LastDecision = enabled ? "Governor on" : "Governor off";
+  GovernorMarker(s_LastDecision);
+  C3D_LOG_INFO(LogCategory::Render, "%s (target %.2f ms)",
+               s_LastDecision.c_str(), s_TargetMs);
+}
+
+void BudgetGovernor::SetLevel(int level, const char *reason) {
+  ChangeLevel(level, reason);
+}
+
+void BudgetGovernor::ChangeLevel(int level, const std::string &reason) {
+  std::vector<BudgetQualityLevel> &ladder = GovernorLadder();
+  level = std::clamp(level, 0, (int)ladder.size() - 1);
+  s_UnderWindows = 0;
+  s_Cooldown = s_CooldownWindows;
+  if (level == s_Level)
+    return;
+
+  char text[256];
+  std::snprintf(text, sizeof(text), "Governor: %s -> %s (%s)",
+                ladder[std::min(s_Level, (int)ladder.size() - 1)].name.c_str(),
+                ladder[level].name.c_str(), reason.c_str());
+  s_Level = level;
+  s_LastDecision = text;
+  GovernorMarker(s_LastDecision);
+  C3D_LOG_INFO(LogCategory::Render, "%s", text);
+}
+
+void BudgetGovernor::BeginFrame() {
+  s_FrameStartNs = s_Enabled ? GovernorNow() : 0;
+}
+
+void BudgetGovernor::EndFrame() {
+  if (!s_Enabled || s_FrameStartNs == 0)
+    return;
+  s_LastCPUMs = (float)(GovernorNow() - s_FrameStartNs) * 1e-6f;
+  s_FrameStartNs = 0;
+
+  // Span of the newest frame of GPU scopes; it arrives a few frames late,
+  // which the windowing absorbs.
+  s_LastGPUMs = 0.0f;
+#ifndef C3D_NO_PROFILER
+  const std::vector<ProfileGpuEvent> &events =
+      GpuProfiler::Get().GetLastEvents();
+  if (!events.empty()) {
+    uint64_t first = events.front().startNs;
+    uint64_t last = events.front().endNs;
+    for (const ProfileGpuEvent &e : events) {
+      first = std::min(first, e.startNs);
+      last = std::max(last, e.endNs);
+    }
+    s_LastGPUMs = (float)(last - first) * 1e-6f;
+  }
+#endif
+
+  float cost = std::max(s_LastCPUMs, s_LastGPUMs);
+  PROFILE_COUNTER("Governor Level", (float)s_Level);
+  PROFILE_COUNTER("Governor Frame (ms)", cost);
+  s_WindowSum += cost;
+  if (++s_WindowCount < std::max(s_WindowFrames, 1))
+    return;
+  s_WindowMs = (float)(s_WindowSum / (double)s_WindowCount);
+  s_WindowSum = 0.0;
+  s_WindowCount = 0;
+  if (s_Cooldown > 0) {
+    --s_Cooldown;
+    return;
+  }
+
+  char reason[96];
+  if (s_WindowMs > s_TargetMs) {
+    s_UnderWindows = 0;
+    if (s_Level + 1 < (int)GovernorLadder().size()) {
+      std::snprintf(reason, sizeof(reason), "%.2f ms over %.2f ms budget",
+                    s_WindowMs, s_TargetMs);
+      ChangeLevel(s_Level + 1, reason);
+    }
+  } else if (s_WindowMs < s_TargetMs * s_RecoverRatio && s_Level > 0) {
+    if (++s_UnderWindows >= std::max(s_RecoverWindows, 1)) {
+      std::snprintf(reason, sizeof(reason), "%.2f ms under %.2f ms budget",
+                    s_WindowMs, s_TargetMs);
+      ChangeLevel(s_Level - 1, reason);
+    }
+  } else {
+    s_UnderWindows = 0;
+  }
+}
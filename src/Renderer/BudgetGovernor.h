@@ -0,0 +1,79 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// One rung of the governor's quality ladder. Each field scales the hand-set
+// value where it is consumed, so turning the governor off restores exactly
+// what the settings say.
+struct BudgetQualityLevel {
+  std::string name;
+  // Multiplies Renderer::GetLODTolerance(); larger drops detail sooner.
+  float lodToleranceScale = 1.0f;
+  // Multiplies SSR resolution and ray march steps.
+  float ssrScale = 1.0f;
+  // Multiplies the cascade update interval and divides the point shadow
+  // refresh budget.
+  int shadowIntervalScale = 1;
+  // Multiplies the script throttling distances. Below 1, far scripts are
+  // throttled even when component throttling is off.
+  float scriptThrottleScale = 1.0f;
+  // Caps lights per cluster; 0 keeps ClusteredLighting's own limit.
+  int maxLightsPerCluster = 0;
+};
+
+// Keeps frames inside s_TargetMs by walking s_Ladder: frame cost is the
+// slower of CPU time (BeginFrame to EndFrame, so swap and frame limiting are
+// excluded) and GPU time from GpuProfiler. Every s_WindowFrames frames the
+// average is compared with the target. One window over steps down a level;
+// s_RecoverWindows windows in a row under target * s_RecoverRatio step back
+// up. After any change the next s_CooldownWindows windows are ignored, so a
+// level gets time to show its effect.
+class BudgetGovernor {
+public:
+  static bool s_Enabled;
+  static float s_TargetMs;
+  static int s_WindowFrames;
+  static float s_RecoverRatio;
+  static int s_RecoverWindows;
+  static int s_CooldownWindows;
+  // Level 0 is full quality; later levels are cheaper.
+  static std::vector<BudgetQualityLevel> s_Ladder;
+
+  // Main thread, at the start and end of each frame's CPU work.
+  static void BeginFrame();
+  static void EndFrame();
+
+  static void SetEnabled(bool enabled);
+  // Jumps to a level by hand; the governor carries on from there.
+  static void SetLevel(int level, const char *reason = "manual");
+  static int GetLevel() { return s_Level; }
+  static void ResetLadder();
+  // A JSON array of levels using BudgetQualityLevel's field names. False
+  // with a message in error when the file is unreadable or empty.
+  static bool LoadLadder(const std::string &path, std::string &error);
+
+  // Identity while disabled.
+  static const BudgetQualityLevel &GetQuality();
+  static int ScaleShadowInterval(int interval);
+  static int ScalePointShadowBudget(int budget);
+  static int ClampLightsPerCluster(int limit);
+
+  static float GetLastCPUMs() { return s_LastCPUMs; }
+  static float GetLastGPUMs() { return s_LastGPUMs; }
+  static float GetWindowMs() { return s_WindowMs; }
+  static const std::string &GetLastDecision() { return s_LastDecision; }
+
+private:
+  static void ChangeLevel(int level, const std::string &reason);
+
+  static int s_Level;
+  static long long s_FrameStartNs;
+  static float s_LastCPUMs;
+  static float s_LastGPUMs;
+  static double s_WindowSum;
+  static int s_WindowCount;
+  static float s_WindowMs;
+  static int s_UnderWindows;
+  static int s_Cooldown;
+  static std::string s_LastDecision;
+};
@@ -1,23 +1,73 @@
 #include "ClusteredLighting.h"
+#include "../Core/ThreadManager.h"
+#include "BudgetGovernor.h"
 #include "Tools/Profiler/Profiler.h"
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstring>
 #include <glad/glad.h>
 #include <iostream>
 
 #ifndef GL_SHADER_STORAGE_BUFFER
 #define GL_SHADER_STORAGE_BUFFER 0x90D2
 #endif
+#ifndef GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#endif
+
+static constexpr int CLUSTER_RING_REGIONS = 3;
 
-unsigned int ClusteredLighting::s_LightSSBO = 0;
-unsigned int ClusteredLighting::s_ClusterSSBO = 0;
+unsigned int ClusteredLighting::s_SSBO = 0;
 bool ClusteredLighting::s_Initialized = false;
+int ClusteredLighting::s_MaxLightsPerCluster = 256;
 std::vector<ClusteredLighting::PointLightShaderData>
     ClusteredLighting::s_LightBuffer;
-std::vector<ClusteredLighting::ClusterData> ClusteredLighting::s_ClusterBuffer;
+std::vector<ClusteredLighting::ClusterAABB> ClusteredLighting::s_ClusterBounds;
+ClusteredLightingStats ClusteredLighting::s_Stats;
+
+struct ClusterLightBounds {
+  glm::vec3 viewPos;
+  float radius;
+  int minSlice;
+  int maxSlice;
+};
+
+// Per depth slice scratch; each slice is binned by its own task.
+struct ClusterSliceBins {
+  std::vector<uint16_t> tiles;
+  std::vector<uint32_t> lights;
+  std::vector<uint32_t> sorted;
+  uint32_t counts[CLUSTERS_PER_SLICE];
+  uint32_t offsets[CLUSTERS_PER_SLICE];
+  uint32_t base = 0;
+  int maxCount = 0;
+};
+
+static std::vector<ClusterLightBounds> s_ClusterLightBounds;
+static ClusterSliceBins s_SliceBins[CLUSTER_Z];
+static std::vector<glm::vec3> s_RowBoundsMin;
+static std::vector<glm::vec3> s_RowBoundsMax;
+static glm::mat4 s_BoundsProjection(0.0f);
+static float s_BoundsNear = 0.0f;
+static float s_BoundsFar = 0.0f;
+
+static GLint s_SSBOAlignment = 256;
+static size_t s_ClusterLightCapacity = 0;
+static size_t s_ClusterIndexCapacity = 0;
+static size_t s_ClusterRegionSize = 0;
+static size_t s_RegionLightOffset = 0;
+static size_t s_RegionIndexOffset = 0;
+static int s_ClusterRegion = 0;
+static int s_LastClusterRegion = -1;
+static GLsync s_ClusterFences[CLUSTER_RING_REGIONS] = {};
+
+static size_t AlignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
 
-float squaredDistPointAABB(const glm::vec3 &point, const glm::vec3 &min,
-                           const glm::vec3 &max) {
+static float squaredDistPointAABB(const glm::vec3 &point, const glm::vec3 &min,
+                                  const glm::vec3 &max) {
   float sqDist = 0.0f;
   for (int i = 0; i < 3; i++) {
     float v = point[i];
@@ -33,17 +83,97 @@ void ClusteredLighting::Init() {
   if (s_Initialized)
     return;
 
-  s_ClusterBuffer.resize(TOTAL_CLUSTERS);
+  glGenBuffers(1, &s_SSBO);
+  glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &s_SSBOAlignment);
+  if (s_SSBOAlignment <= 0)
+    s_SSBOAlignment = 256;
 
-  glGenBuffers(1, &s_LightSSBO);
-  glGenBuffers(1, &s_ClusterSSBO);
+  EnsureCapacity(256, 4096);
+  s_Initialized = true;
+}
 
-  
-  glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_ClusterSSBO);
-  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ClusterData) * TOTAL_CLUSTERS,
-               nullptr, GL_DYNAMIC_DRAW);
+void ClusteredLighting::EnsureCapacity(size_t lightCount, size_t indexCount) {
+  if (lightCount <= s_ClusterLightCapacity &&
+      indexCount <= s_ClusterIndexCapacity && s_ClusterRegionSize != 0)
+    return;
 
-  s_Initialized = true;
+  for (auto &fence : s_ClusterFences) {
+    if (fence) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+
+  s_ClusterLightCapacity =
+      std::max(s_ClusterLightCapacity, lightCount * 3 / 2);
+  s_ClusterIndexCapacity =
+      std::max(s_ClusterIndexCapacity, indexCount * 3 / 2);
+
+  size_t align = (size_t)s_SSBOAlignment;
+  size_t gridBytes = TOTAL_CLUSTERS * sizeof(ClusterRange);
+  s_RegionLightOffset = AlignUp(gridBytes, align);
+  s_RegionIndexOffset =
+      AlignUp(s_RegionLightOffset +
+                  s_ClusterLightCapacity * sizeof(PointLightShaderData),
+              align);
+  s_ClusterRegionSize = AlignUp(
+      s_RegionIndexOffset + s_ClusterIndexCapacity * sizeof(uint32_t), align);
+
+  // Re-specifying the store orphans regions the GPU may still be reading.
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_SSBO);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+               s_ClusterRegionSize * CLUSTER_RING_REGIONS, nullptr,
+               GL_STREAM_DRAW);
+  s_LastClusterRegion = -1;
+}
+
+void ClusteredLighting::BuildClusterBounds(const glm::mat4 &projection,
+                                           float zNear, float zFar) {
+  if (projection == s_BoundsProjection && zNear == s_BoundsNear &&
+      zFar == s_BoundsFar && !s_ClusterBounds.empty())
+    return;
+
+  s_BoundsProjection = projection;
+  s_BoundsNear = zNear;
+  s_BoundsFar = zFar;
+  s_ClusterBounds.resize(TOTAL_CLUSTERS);
+  s_RowBoundsMin.assign(CLUSTER_Z * CLUSTER_Y, glm::vec3(1e30f));
+  s_RowBoundsMax.assign(CLUSTER_Z * CLUSTER_Y, glm::vec3(-1e30f));
+
+  glm::mat4 invProj = glm::inverse(projection);
+  auto toView = [&invProj](float x, float y) {
+    glm::vec4 p = invProj * glm::vec4(x, y, -1.0f, 1.0f);
+    p /= p.w;
+    // Direction scaled so that depth (-z) is 1.
+    return glm::vec3(p) / -p.z;
+  };
+
+  for (int z = 0; z < CLUSTER_Z; ++z) {
+    float d0 = zNear * std::pow(zFar / zNear, (float)z / CLUSTER_Z);
+    float d1 = zNear * std::pow(zFar / zNear, (float)(z + 1) / CLUSTER_Z);
+    for (int y = 0; y < CLUSTER_Y; ++y) {
+      float ny0 = -1.0f + 2.0f * y / CLUSTER_Y;
+      float ny1 = -1.0f + 2.0f * (y + 1) / CLUSTER_Y;
+      for (int x = 0; x < CLUSTER_X; ++x) {
+        float nx0 = -1.0f + 2.0f * x / CLUSTER_X;
+        float nx1 = -1.0f + 2.0f * (x + 1) / CLUSTER_X;
+        glm::vec3 r0 = toView(nx0, ny0);
+        glm::vec3 r1 = toView(nx1, ny1);
+
+        glm::vec3 corners[4] = {r0 * d0, r1 * d0, r0 * d1, r1 * d1};
+        ClusterAABB box{corners[0], corners[0]};
+        for (const auto &c : corners) {
+          box.minP = glm::min(box.minP, c);
+          box.maxP = glm::max(box.maxP, c);
+        }
+
+        int row = z * CLUSTER_Y + y;
+        s_ClusterBounds[z * CLUSTERS_PER_SLICE + y * CLUSTER_X + x] = box;
+        s_RowBoundsMin[row] = glm::min(s_RowBoundsMin[row], box.minP);
+        s_RowBoundsMax[row] = glm::max(s_RowBoundsMax[row], box.maxP);
+      }
+    }
+  }
 }
 
 void ClusteredLighting::UpdateClusters(Camera &camera, Scene &scene) {
@@ -51,133 +181,217 @@ void ClusteredLighting::UpdateClusters(Camera &camera, Scene &scene) {
   if (!s_Initialized)
     Init();
 
-  
-  for (auto &cluster : s_ClusterBuffer) {
-    cluster.count = 0;
-  }
+  auto binStart = std::chrono::steady_clock::now();
   s_LightBuffer.clear();
+  s_ClusterLightBounds.clear();
 
-  
   float zNear = camera.nearPlane;
   float zFar = camera.farPlane;
-
-  
   float zScale = (float)CLUSTER_Z / std::log2(zFar / zNear);
   float zBias =
       -((float)CLUSTER_Z * std::log2(zNear) / std::log2(zFar / zNear));
 
-  
   glm::mat4 view = camera.GetViewMatrix();
+  BuildClusterBounds(camera.GetProjectionMatrix(), zNear, zFar);
 
   auto &pointLights = scene.GetPointLights();
-  int lightIndex = 0;
-
   for (size_t i = 0; i < pointLights.size(); ++i) {
     auto &ptLight = pointLights[i];
     if (!ptLight.enabled)
       continue;
 
-    glm::vec3 worldPos = ptLight.position;
-    glm::vec3 viewPos = glm::vec3(view * glm::vec4(worldPos, 1.0f));
-
-    
-    
-    float maxRange = (-ptLight.linear +
-                      std::sqrt(ptLight.linear * ptLight.linear -
-                                4 * ptLight.quadratic *
-                                    (ptLight.constant - (256.0f / 5.0f)))) /
-                     (2 * ptLight.quadratic);
+    float maxRange;
+    if (ptLight.quadratic > 0.0f) {
+      maxRange = (-ptLight.linear +
+                  std::sqrt(ptLight.linear * ptLight.linear -
+                            4 * ptLight.quadratic *
+                                (ptLight.constant - (256.0f / 5.0f)))) /
+                 (2 * ptLight.quadratic);
+    } else if (ptLight.linear > 0.0f) {
+      maxRange = ((256.0f / 5.0f) - ptLight.constant) / ptLight.linear;
+    } else {
+      maxRange = zFar;
+    }
 
     PointLightShaderData pl;
-    pl.positionAndRadius = glm::vec4(worldPos, maxRange);
+    pl.positionAndRadius = glm::vec4(ptLight.position, maxRange);
     pl.colorAndIntensity = glm::vec4(ptLight.color.r, ptLight.color.g,
                                      ptLight.color.b, ptLight.intensity);
     s_LightBuffer.push_back(pl);
 
-    
-    float minZ = -viewPos.z - maxRange;
-    float maxZ = -viewPos.z + maxRange;
+    ClusterLightBounds bounds;
+    bounds.viewPos = glm::vec3(view * glm::vec4(ptLight.position, 1.0f));
+    bounds.radius = maxRange;
 
-    if (minZ < zNear)
-      minZ = zNear;
-    if (maxZ > zFar)
-      maxZ = zFar;
+    float minZ = -bounds.viewPos.z - maxRange;
+    float maxZ = -bounds.viewPos.z + maxRange;
     if (maxZ < zNear || minZ > zFar) {
-      lightIndex++;
-      continue;
+      bounds.minSlice = 1;
+      bounds.maxSlice = 0;
+    } else {
+      minZ = std::max(minZ, zNear);
+      maxZ = std::min(maxZ, zFar);
+      bounds.minSlice =
+          std::clamp((int)(std::log2(minZ) * zScale + zBias), 0, CLUSTER_Z - 1);
+      bounds.maxSlice =
+          std::clamp((int)(std::log2(maxZ) * zScale + zBias), 0, CLUSTER_Z - 1);
     }
+    s_ClusterLightBounds.push_back(bounds);
+  }
+
+  uint32_t lightCount = (uint32_t)s_LightBuffer.size();
+  uint32_t perClusterCap = (uint32_t)std::max(
+      BudgetGovernor::ClampLightsPerCluster(s_MaxLightsPerCluster), 1);
 
-    int startZ =
-        std::clamp((int)(std::log2(minZ) * zScale + zBias), 0, CLUSTER_Z - 1);
-    int endZ =
-        std::clamp((int)(std::log2(maxZ) * zScale + zBias), 0, CLUSTER_Z - 1);
-
-    
-    
-    
-    
-    glm::vec4 p1 = camera.GetProjectionMatrix() *
-                   glm::vec4(viewPos.x - maxRange, viewPos.y - maxRange,
-                             viewPos.z + maxRange, 1.0);
-    glm::vec4 p2 = camera.GetProjectionMatrix() *
-                   glm::vec4(viewPos.x + maxRange, viewPos.y + maxRange,
-                             viewPos.z - maxRange, 1.0);
-
-    p1 /= p1.w;
-    p2 /= p2.w;
-
-    int startX =
-        std::clamp((int)((p1.x + 1.0f) * 0.5f * CLUSTER_X), 0, CLUSTER_X - 1);
-    int endX =
-        std::clamp((int)((p2.x + 1.0f) * 0.5f * CLUSTER_X), 0, CLUSTER_X - 1);
-    int startY =
-        std::clamp((int)((p1.y + 1.0f) * 0.5f * CLUSTER_Y), 0, CLUSTER_Y - 1);
-    int endY =
-        std::clamp((int)((p2.y + 1.0f) * 0.5f * CLUSTER_Y), 0, CLUSTER_Y - 1);
-
-    
-    for (int z = startZ; z <= endZ; ++z) {
-      for (int y = startY; y <= endY; ++y) {
-        for (int x = startX; x <= endX; ++x) {
-          int clusterIdx = x + (y * CLUSTER_X) + (z * CLUSTER_X * CLUSTER_Y);
-          if (clusterIdx >= 0 && clusterIdx < TOTAL_CLUSTERS) {
-            ClusterData &cluster = s_ClusterBuffer[clusterIdx];
-            if (cluster.count < MAX_LIGHTS_PER_CLUSTER) {
-              cluster.lightIndices[cluster.count++] = lightIndex;
-            }
+  ThreadManager::ParallelFor(0, CLUSTER_Z, [&](int z) {
+    ClusterSliceBins &bins = s_SliceBins[z];
+    bins.tiles.clear();
+    bins.lights.clear();
+
+    for (uint32_t l = 0; l < lightCount; ++l) {
+      const ClusterLightBounds &lb = s_ClusterLightBounds[l];
+      if (z < lb.minSlice || z > lb.maxSlice)
+        continue;
+      float r2 = lb.radius * lb.radius;
+
+      for (int y = 0; y < CLUSTER_Y; ++y) {
+        int row = z * CLUSTER_Y + y;
+        if (squaredDistPointAABB(lb.viewPos, s_RowBoundsMin[row],
+                                 s_RowBoundsMax[row]) > r2)
+          continue;
+        for (int x = 0; x < CLUSTER_X; ++x) {
+          int tile = y * CLUSTER_X + x;
+          const ClusterAABB &box =
+              s_ClusterBounds[z * CLUSTERS_PER_SLICE + tile];
+          if (squaredDistPointAABB(lb.viewPos, box.minP, box.maxP) <= r2) {
+            bins.tiles.push_back((uint16_t)tile);
+            bins.lights.push_back(l);
           }
         }
       }
     }
 
-    lightIndex++;
+    // Counting sort by tile keeps lights in scene order within a cluster.
+    std::memset(bins.counts, 0, sizeof(bins.counts));
+    for (uint16_t tile : bins.tiles) {
+      if (bins.counts[tile] < perClusterCap)
+        bins.counts[tile]++;
+    }
+    uint32_t running = 0;
+    bins.maxCount = 0;
+    for (int t = 0; t < CLUSTERS_PER_SLICE; ++t) {
+      bins.offsets[t] = running;
+      running += bins.counts[t];
+      bins.maxCount = std::max(bins.maxCount, (int)bins.counts[t]);
+    }
+    bins.sorted.resize(running);
+
+    uint32_t fill[CLUSTERS_PER_SLICE] = {};
+    for (size_t p = 0; p < bins.tiles.size(); ++p) {
+      uint16_t tile = bins.tiles[p];
+      if (fill[tile] < bins.counts[tile])
+        bins.sorted[bins.offsets[tile] + fill[tile]++] = bins.lights[p];
+    }
+  });
+
+  uint32_t totalIndices = 0;
+  int maxInCluster = 0;
+  for (auto &bins : s_SliceBins) {
+    bins.base = totalIndices;
+    totalIndices += (uint32_t)bins.sorted.size();
+    maxInCluster = std::max(maxInCluster, bins.maxCount);
   }
 
-  
-  if (!s_LightBuffer.empty()) {
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_LightSSBO);
-    glBufferData(GL_SHADER_STORAGE_BUFFER,
-                 s_LightBuffer.size() * sizeof(PointLightShaderData),
-                 s_LightBuffer.data(), GL_DYNAMIC_DRAW);
+  // The fence covers everything issued since the previous update, i.e. the
+  // draws that read the previous region.
+  if (s_LastClusterRegion >= 0) {
+    if (s_ClusterFences[s_LastClusterRegion])
+      glDeleteSync(s_ClusterFences[s_LastClusterRegion]);
+    s_ClusterFences[s_LastClusterRegion] =
+        glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    s_ClusterRegion = (s_LastClusterRegion + 1) % CLUSTER_RING_REGIONS;
   }
+  EnsureCapacity(lightCount, totalIndices);
 
-  glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_ClusterSSBO);
-  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
-                  TOTAL_CLUSTERS * sizeof(ClusterData), s_ClusterBuffer.data());
+  GLsync &fence = s_ClusterFences[s_ClusterRegion];
+  if (fence) {
+    glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  size_t regionBase = s_ClusterRegionSize * s_ClusterRegion;
+  size_t usedBytes = s_RegionIndexOffset + totalIndices * sizeof(uint32_t);
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_SSBO);
+  uint8_t *dst = (uint8_t *)glMapBufferRange(
+      GL_SHADER_STORAGE_BUFFER, regionBase, usedBytes,
+      GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+          GL_MAP_INVALIDATE_RANGE_BIT);
+  if (dst) {
+    ClusterRange *grid = (ClusterRange *)dst;
+    uint32_t *indices = (uint32_t *)(dst + s_RegionIndexOffset);
+
+    ThreadManager::ParallelFor(0, CLUSTER_Z, [&](int z) {
+      const ClusterSliceBins &bins = s_SliceBins[z];
+      for (int t = 0; t < CLUSTERS_PER_SLICE; ++t) {
+        grid[z * CLUSTERS_PER_SLICE + t] = {bins.base + bins.offsets[t],
+                                            bins.counts[t]};
+      }
+      if (!bins.sorted.empty())
+        std::memcpy(indices + bins.base, bins.sorted.data(),
+                    bins.sorted.size() * sizeof(uint32_t));
+    });
+
+    if (lightCount > 0)
+      std::memcpy(dst + s_RegionLightOffset, s_LightBuffer.data(),
+                  lightCount * sizeof(PointLightShaderData));
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+  }
+
+  s_LastClusterRegion = s_ClusterRegion;
+
+  s_Stats.lights = (int)lightCount;
+  s_Stats.lightIndices = (int)totalIndices;
+  s_Stats.maxLightsInCluster = maxInCluster;
+  s_Stats.uploadBytes = TOTAL_CLUSTERS * sizeof(ClusterRange) +
+                        lightCount * sizeof(PointLightShaderData) +
+                        totalIndices * sizeof(uint32_t);
+  s_Stats.binMs = std::chrono::duration<float, std::milli>(
+                      std::chrono::steady_clock::now() - binStart)
+                      .count();
 }
 
 void ClusteredLighting::BindBuffers(unsigned int lightBindingPoint) {
-  if (!s_Initialized)
+  if (!s_Initialized || s_LastClusterRegion < 0)
     return;
-  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, lightBindingPoint, s_LightSSBO);
-  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, lightBindingPoint + 1,
-                   s_ClusterSSBO);
+
+  size_t regionBase = s_ClusterRegionSize * s_LastClusterRegion;
+  size_t lightBytes =
+      std::max<size_t>(s_Stats.lights, 1) * sizeof(PointLightShaderData);
+  size_t indexBytes =
+      std::max<size_t>(s_Stats.lightIndices, 1) * sizeof(uint32_t);
+
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, lightBindingPoint, s_SSBO,
+                    regionBase + s_RegionLightOffset, lightBytes);
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, lightBindingPoint + 1, s_SSBO,
+                    regionBase, TOTAL_CLUSTERS * sizeof(ClusterRange));
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, lightBindingPoint + 2, s_SSBO,
+                    regionBase + s_RegionIndexOffset, indexBytes);
 }
 
 void ClusteredLighting::Shutdown() {
-  if (s_LightSSBO)
-    glDeleteBuffers(1, &s_LightSSBO);
-  if (s_ClusterSSBO)
-    glDeleteBuffers(1, &s_ClusterSSBO);
+  for (auto &fence : s_ClusterFences) {
+    if (fence) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+  if (s_SSBO)
+    glDeleteBuffers(1, &s_SSBO);
+  s_SSBO = 0;
+  s_ClusterLightCapacity = s_ClusterIndexCapacity = s_ClusterRegionSize = 0;
+  s_LastClusterRegion = -1;
+  s_ClusterRegion = 0;
   s_Initialized = false;
 }
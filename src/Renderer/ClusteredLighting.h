@@ -3,6 +3,8 @@
 
 #include "../Scene/Scene.h"
 #include "Camera.h"
+#include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <vector>
 
@@ -10,32 +12,58 @@ constexpr int CLUSTER_X = 16;
 constexpr int CLUSTER_Y = 9;
 constexpr int CLUSTER_Z = 24;
 constexpr int TOTAL_CLUSTERS = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
-constexpr int MAX_LIGHTS_PER_CLUSTER = 64;
+constexpr int CLUSTERS_PER_SLICE = CLUSTER_X * CLUSTER_Y;
 
+struct ClusteredLightingStats {
+  int lights = 0;
+  int lightIndices = 0;
+  int maxLightsInCluster = 0;
+  size_t uploadBytes = 0;
+  float binMs = 0.0f;
+};
+
+// Lights are binned into a froxel grid (CLUSTER_X x CLUSTER_Y screen tiles,
+// CLUSTER_Z logarithmic depth slices). The GPU sees three buffers: the
+// lights, an (offset, count) pair per cluster, and one compacted list of
+// light indices that the pairs point into.
 class ClusteredLighting {
 public:
   static void Init();
   static void UpdateClusters(Camera &camera, Scene &scene);
+  // Lights at bindingPoint, the cluster grid at +1, the index list at +2.
   static void BindBuffers(unsigned int bindingPoint);
   static void Shutdown();
 
+  static const ClusteredLightingStats &GetStats() { return s_Stats; }
+
+  static int s_MaxLightsPerCluster;
+
 private:
   struct PointLightShaderData {
     glm::vec4 positionAndRadius;
     glm::vec4 colorAndIntensity;
   };
 
-  struct ClusterData {
-    int count;
-    int lightIndices[MAX_LIGHTS_PER_CLUSTER];
+  struct ClusterRange {
+    uint32_t offset;
+    uint32_t count;
   };
 
-  static unsigned int s_LightSSBO;
-  static unsigned int s_ClusterSSBO;
+  struct ClusterAABB {
+    glm::vec3 minP;
+    glm::vec3 maxP;
+  };
+
+  static void BuildClusterBounds(const glm::mat4 &projection, float zNear,
+                                 float zFar);
+  static void EnsureCapacity(size_t lightCount, size_t indexCount);
+
+  static unsigned int s_SSBO;
   static bool s_Initialized;
 
   static std::vector<PointLightShaderData> s_LightBuffer;
-  static std::vector<ClusterData> s_ClusterBuffer;
+  static std::vector<ClusterAABB> s_ClusterBounds;
+  static ClusteredLightingStats s_Stats;
 };
 
 #endif
@@ -1,82 +1,114 @@
 #include "DynamicBatcher.h"
+#include "../Core/LinearArena.h"
 #include "../Core/Logger.h"
-#include "StaticBatcher.h" 
+#include "../Core/ThreadManager.h"
+#include <algorithm>
 #include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define C3D_DYNAMIC_BATCH_SSE 1
+#endif
 
-extern std::string GetMaterialSignature(const Material &mat);
+static constexpr int DYNAMIC_RING_REGIONS = 3;
+static constexpr int DYNAMIC_OBJECTS_PER_TASK = 32;
+static constexpr size_t DYNAMIC_MAX_VERTICES = 300;
 
-void DynamicBatcher::DrawBatches(Scene &scene, Shader &shader, Camera &camera) {
-  auto &objects = scene.GetObjects();
-  std::map<std::string, DynamicBatch> batches;
+std::unordered_map<uint64_t, int> DynamicBatcher::s_MaterialIds;
+std::vector<DynamicBatcher::DynamicBatch> DynamicBatcher::s_Batches;
+GLuint DynamicBatcher::s_VAO = 0;
+GLuint DynamicBatcher::s_VBO = 0;
+GLuint DynamicBatcher::s_EBO = 0;
+size_t DynamicBatcher::s_VertexCapacity = 0;
+size_t DynamicBatcher::s_IndexCapacity = 0;
+int DynamicBatcher::s_Region = 0;
+int DynamicBatcher::s_BatchesLastFrame = 0;
+int DynamicBatcher::s_ObjectsLastFrame = 0;
 
-  
-  for (size_t i = 0; i < objects.size(); ++i) {
-    auto &obj = objects[i];
-    if (!obj.isStatic && obj.isActive && obj.meshType != MeshType::Camera &&
-        obj.meshType != MeshType::None) {
-      
-      if (obj.mesh.vertices.size() < 300) {
-        std::string sig = GetMaterialSignature(obj.material);
-        auto &batch = batches[sig];
-
-        if (batch.vertices.empty()) {
-          batch.material = obj.material;
-          if (!obj.mesh.textures.empty()) {
-            batch.textures = obj.mesh.textures;
-          }
-        }
-
-        glm::mat4 model = scene.GetGlobalTransform(i);
-        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
-
-        GLuint indexOffset = batch.vertices.size();
-
-        
-        for (const auto &v : obj.mesh.vertices) {
-          Vertex worldVert = v;
-          worldVert.position = glm::vec3(model * glm::vec4(v.position, 1.0f));
-          worldVert.normal = glm::normalize(normalMatrix * v.normal);
-          batch.vertices.push_back(worldVert);
-        }
-
-        
-        for (GLuint index : obj.mesh.indices) {
-          batch.indices.push_back(index + indexOffset);
-        }
-
-        
-        
-      }
-    }
-  }
+static GLsync s_RegionFences[DYNAMIC_RING_REGIONS] = {};
 
-  
-  if (batches.empty())
-    return;
+struct DynamicBatchObject {
+  int objectIndex = 0;
+  int materialId = 0;
+  glm::mat4 model;
+  GLuint firstVertex = 0;
+  GLuint firstIndex = 0;
+  GLuint batchVertexOffset = 0;
+};
 
-  
-  GLuint vao, vbo, ebo;
-  glGenVertexArrays(1, &vao);
-  glGenBuffers(1, &vbo);
-  glGenBuffers(1, &ebo);
+static std::vector<DynamicBatchObject> s_BatchObjects;
 
-  for (auto &pair : batches) {
-    auto &batch = pair.second;
-    if (batch.vertices.empty())
-      continue;
+static void TransformVertices(const Vertex *src, Vertex *dst, size_t count,
+                              const glm::mat4 &model,
+                              const glm::mat3 &normalMatrix) {
+#ifdef C3D_DYNAMIC_BATCH_SSE
+  const __m128 c0 = _mm_loadu_ps(&model[0][0]);
+  const __m128 c1 = _mm_loadu_ps(&model[1][0]);
+  const __m128 c2 = _mm_loadu_ps(&model[2][0]);
+  const __m128 c3 = _mm_loadu_ps(&model[3][0]);
+  const glm::mat3 &nm = normalMatrix;
+  const __m128 n0 = _mm_set_ps(0.0f, nm[0][2], nm[0][1], nm[0][0]);
+  const __m128 n1 = _mm_set_ps(0.0f, nm[1][2], nm[1][1], nm[1][0]);
+  const __m128 n2 = _mm_set_ps(0.0f, nm[2][2], nm[2][1], nm[2][0]);
 
-    glBindVertexArray(vao);
+  alignas(16) float p[4];
+  alignas(16) float n[4];
+  for (size_t i = 0; i < count; ++i) {
+    Vertex v = src[i];
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, batch.vertices.size() * sizeof(Vertex),
-                 batch.vertices.data(), GL_DYNAMIC_DRAW);
+    __m128 pos = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(v.position.x)),
+                   _mm_mul_ps(c1, _mm_set1_ps(v.position.y))),
+        _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(v.position.z)), c3));
+    _mm_store_ps(p, pos);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, batch.indices.size() * sizeof(GLuint),
-                 batch.indices.data(), GL_DYNAMIC_DRAW);
+    __m128 nrm = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(n0, _mm_set1_ps(v.normal.x)),
+                   _mm_mul_ps(n1, _mm_set1_ps(v.normal.y))),
+        _mm_mul_ps(n2, _mm_set1_ps(v.normal.z)));
+    __m128 sq = _mm_mul_ps(nrm, nrm);
+    __m128 sum =
+        _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    nrm = _mm_div_ps(nrm, _mm_sqrt_ps(sum));
+    _mm_store_ps(n, nrm);
+
+    v.position = glm::vec3(p[0], p[1], p[2]);
+    v.normal = glm::vec3(n[0], n[1], n[2]);
+    dst[i] = v;
+  }
+#else
+  for (size_t i = 0; i < count; ++i) {
+    Vertex v = src[i];
+    v.position = glm::vec3(model * glm::vec4(v.position, 1.0f));
+    v.normal = glm::normalize(normalMatrix * v.normal);
+    dst[i] = v;
+  }
+#endif
+}
+
+int DynamicBatcher::GetMaterialId(uint64_t materialHash) {
+  auto it = s_MaterialIds.find(materialHash);
+  if (it != s_MaterialIds.end())
+    return it->second;
+
+  int id = (int)s_MaterialIds.size();
+  s_MaterialIds.emplace(materialHash, id);
+  return id;
+}
+
+void DynamicBatcher::EnsureCapacity(size_t vertexCount, size_t indexCount) {
+  if (s_VAO == 0) {
+    glGenVertexArrays(1, &s_VAO);
+    glGenBuffers(1, &s_VBO);
+    glGenBuffers(1, &s_EBO);
+
+    glBindVertexArray(s_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, s_VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_EBO);
 
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
@@ -90,6 +122,180 @@ void DynamicBatcher::DrawBatches(Scene &scene, Shader &shader, Camera &camera) {
     glEnableVertexAttribArray(3);
     glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
                           (void *)offsetof(Vertex, normal));
+  } else {
+    glBindVertexArray(s_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, s_VBO);
+  }
+
+  if (vertexCount <= s_VertexCapacity && indexCount <= s_IndexCapacity)
+    return;
+
+  // Reallocating orphans the old storage, so in-flight regions stay valid
+  // and their fences can simply be dropped.
+  for (auto &fence : s_RegionFences) {
+    if (fence) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+
+  s_VertexCapacity =
+      std::max(s_VertexCapacity, std::max<size_t>(vertexCount * 3 / 2, 16384));
+  s_IndexCapacity =
+      std::max(s_IndexCapacity, std::max<size_t>(indexCount * 3 / 2, 49152));
+
+  glBufferData(GL_ARRAY_BUFFER,
+               s_VertexCapacity * sizeof(Vertex) * DYNAMIC_RING_REGIONS,
+               nullptr, GL_STREAM_DRAW);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+               s_IndexCapacity * sizeof(GLuint) * DYNAMIC_RING_REGIONS, nullptr,
+               GL_STREAM_DRAW);
+  s_Region = 0;
+}
+
+void DynamicBatcher::DrawBatches(Scene &scene, Shader &shader, Camera &camera) {
+  auto &objects = scene.GetObjects();
+  s_BatchesLastFrame = 0;
+  s_ObjectsLastFrame = 0;
+
+  // Material edits keep minting new hashes; start over rather than grow the
+  // batch table without bound.
+  if (s_MaterialIds.size() >= 4096) {
+    s_MaterialIds.clear();
+    s_Batches.clear();
+  }
+
+  s_BatchObjects.clear();
+  for (size_t i = 0; i < objects.size(); ++i) {
+    auto &obj = objects[i];
+    if (!obj.isStatic && obj.isActive && obj.meshType != MeshType::Camera &&
+        obj.meshType != MeshType::None && !obj.mesh.vertices.empty() &&
+        obj.mesh.vertices.size() < DYNAMIC_MAX_VERTICES) {
+      DynamicBatchObject entry;
+      entry.objectIndex = (int)i;
+      s_BatchObjects.push_back(entry);
+    }
+  }
+
+  if (s_BatchObjects.empty())
+    return;
+
+  int objectCount = (int)s_BatchObjects.size();
+  int taskCount =
+      (objectCount + DYNAMIC_OBJECTS_PER_TASK - 1) / DYNAMIC_OBJECTS_PER_TASK;
+
+  LinearArena &frameArena = MemoryTracker::GetFrameArena();
+  LinearArena::Scope frameScope(frameArena);
+  ArenaVector<uint64_t> hashes(objectCount, 0,
+                               ArenaAllocator<uint64_t>(frameArena));
+  ThreadManager::ParallelFor(0, taskCount, [&](int task) {
+    int end = std::min(objectCount, (task + 1) * DYNAMIC_OBJECTS_PER_TASK);
+    for (int c = task * DYNAMIC_OBJECTS_PER_TASK; c < end; ++c) {
+      auto &entry = s_BatchObjects[c];
+      hashes[c] = objects[entry.objectIndex].material.Hash();
+      entry.model = scene.GetGlobalTransform(entry.objectIndex);
+    }
+  });
+
+  for (auto &batch : s_Batches) {
+    batch.objects.clear();
+    batch.vertexCount = 0;
+    batch.indexCount = 0;
+  }
+
+  for (int c = 0; c < objectCount; ++c) {
+    auto &entry = s_BatchObjects[c];
+    entry.materialId = GetMaterialId(hashes[c]);
+    if (entry.materialId >= (int)s_Batches.size())
+      s_Batches.resize(entry.materialId + 1);
+
+    auto &batch = s_Batches[entry.materialId];
+    const auto &obj = objects[entry.objectIndex];
+    if (batch.objects.empty()) {
+      batch.material = obj.material;
+      batch.textureID = 0;
+    }
+    if (batch.textureID == 0 && !obj.mesh.textures.empty())
+      batch.textureID = obj.mesh.textures[0].ID;
+    batch.objects.push_back(c);
+  }
+
+  // Lay batches out back to back so each is one contiguous draw.
+  GLuint vertexCursor = 0, indexCursor = 0;
+  for (auto &batch : s_Batches) {
+    if (batch.objects.empty())
+      continue;
+    batch.firstVertex = vertexCursor;
+    batch.firstIndex = indexCursor;
+    for (int c : batch.objects) {
+      auto &entry = s_BatchObjects[c];
+      const auto &mesh = objects[entry.objectIndex].mesh;
+      entry.firstVertex = vertexCursor;
+      entry.firstIndex = indexCursor;
+      entry.batchVertexOffset = vertexCursor - batch.firstVertex;
+      vertexCursor += (GLuint)mesh.vertices.size();
+      indexCursor += (GLuint)mesh.indices.size();
+    }
+    batch.vertexCount = vertexCursor - batch.firstVertex;
+    batch.indexCount = indexCursor - batch.firstIndex;
+  }
+
+  EnsureCapacity(vertexCursor, indexCursor);
+
+  GLsync &fence = s_RegionFences[s_Region];
+  if (fence) {
+    glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  size_t regionVertexBase = s_VertexCapacity * s_Region;
+  size_t regionIndexBase = s_IndexCapacity * s_Region;
+  const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                              GL_MAP_INVALIDATE_RANGE_BIT;
+
+  Vertex *vertexDst = (Vertex *)glMapBufferRange(
+      GL_ARRAY_BUFFER, regionVertexBase * sizeof(Vertex),
+      (size_t)vertexCursor * sizeof(Vertex), mapFlags);
+  GLuint *indexDst = (GLuint *)glMapBufferRange(
+      GL_ELEMENT_ARRAY_BUFFER, regionIndexBase * sizeof(GLuint),
+      (size_t)indexCursor * sizeof(GLuint), mapFlags);
+
+  if (vertexDst && indexDst) {
+    ThreadManager::ParallelFor(0, taskCount, [&](int task) {
+      int end = std::min(objectCount, (task + 1) * DYNAMIC_OBJECTS_PER_TASK);
+      for (int c = task * DYNAMIC_OBJECTS_PER_TASK; c < end; ++c) {
+        const auto &entry = s_BatchObjects[c];
+        const auto &mesh = objects[entry.objectIndex].mesh;
+        glm::mat3 normalMatrix =
+            glm::transpose(glm::inverse(glm::mat3(entry.model)));
+        TransformVertices(mesh.vertices.data(), vertexDst + entry.firstVertex,
+                          mesh.vertices.size(), entry.model, normalMatrix);
+
+        GLuint *dst = indexDst + entry.firstIndex;
+        for (size_t i = 0; i < mesh.indices.size(); ++i)
+          dst[i] = mesh.indices[i] + entry.batchVertexOffset;
+      }
+    });
+  }
+
+  bool mapped = vertexDst && indexDst;
+  if (vertexDst)
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+  if (indexDst)
+    glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+
+  if (!mapped) {
+    glBindVertexArray(0);
+    return;
+  }
+
+  glm::mat4 identity = glm::mat4(1.0f);
+  shader.setMat4("model", identity);
+
+  for (auto &batch : s_Batches) {
+    if (batch.objects.empty() || batch.indexCount == 0)
+      continue;
 
     const Material &mat = batch.material;
     shader.setVec3("material.albedo", mat.albedo);
@@ -99,22 +305,50 @@ void DynamicBatcher::DrawBatches(Scene &scene, Shader &shader, Camera &camera) {
     shader.setInt("material.useTexture", mat.useTexture ? 1 : 0);
     shader.setInt("material.isTransparent", mat.isTransparent ? 1 : 0);
 
-    
-    glm::mat4 identity = glm::mat4(1.0f);
-    shader.setMat4("model", identity);
-
-    
-    if (mat.useTexture && !batch.textures.empty()) {
+    if (mat.useTexture && batch.textureID != 0) {
       glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_2D, batch.textures[0].ID);
+      glBindTexture(GL_TEXTURE_2D, batch.textureID);
       shader.setInt("diffuse0", 0);
     }
 
-    glDrawElements(GL_TRIANGLES, batch.indices.size(), GL_UNSIGNED_INT, 0);
+    glDrawElementsBaseVertex(
+        GL_TRIANGLES, batch.indexCount, GL_UNSIGNED_INT,
+        (void *)((regionIndexBase + batch.firstIndex) * sizeof(GLuint)),
+        (GLint)(regionVertexBase + batch.firstVertex));
+
+    s_BatchesLastFrame++;
+    s_ObjectsLastFrame += (int)batch.objects.size();
   }
 
+  fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  s_Region = (s_Region + 1) % DYNAMIC_RING_REGIONS;
+
   glBindVertexArray(0);
-  glDeleteVertexArrays(1, &vao);
-  glDeleteBuffers(1, &vbo);
-  glDeleteBuffers(1, &ebo);
+}
+
+void DynamicBatcher::Shutdown() {
+  for (auto &fence : s_RegionFences) {
+    if (fence) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+  if (s_VAO != 0) {
+    glDeleteVertexArrays(1, &s_VAO);
+    glDeleteBuffers(1, &s_VBO);
+    glDeleteBuffers(1, &s_EBO);
+  }
+  s_VAO = s_VBO = s_EBO = 0;
+  s_VertexCapacity = s_IndexCapacity = 0;
+  s_MaterialIds.clear();
+  s_Batches.clear();
+}
+
+MemoryTagStats DynamicBatcher::GetMemoryStats() {
+  MemoryTagStats stats;
+  stats.cpuBytes = s_BatchObjects.capacity() * sizeof(DynamicBatchObject);
+  stats.gpuBytes = (s_VertexCapacity * sizeof(Vertex) +
+                    s_IndexCapacity * sizeof(GLuint)) *
+                   DYNAMIC_RING_REGIONS;
+  return stats;
 }
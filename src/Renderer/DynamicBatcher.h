@@ -1,24 +1,52 @@
 #ifndef DYNAMIC_BATCHER_H
 #define DYNAMIC_BATCHER_H
 
+#include "../Core/MemoryTracker.h"
 #include "../Scene/Scene.h"
 #include "Mesh.h"
 #include "Shader.h"
-#include <map>
-#include <string>
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
+// Small dynamic meshes are transformed into world space every frame and
+// drawn in one call per material. Vertices go into a triple-buffered ring so
+// the CPU never writes a region the GPU may still be reading.
 class DynamicBatcher {
 public:
   static void DrawBatches(Scene &scene, Shader &shader, Camera &camera);
+  static void Shutdown();
+
+  static int GetBatchesLastFrame() { return s_BatchesLastFrame; }
+  static int GetObjectsLastFrame() { return s_ObjectsLastFrame; }
+  static MemoryTagStats GetMemoryStats();
 
 private:
   struct DynamicBatch {
     Material material;
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
-    std::vector<Texture> textures;
+    GLuint textureID = 0;
+    std::vector<int> objects;
+    GLuint firstVertex = 0;
+    GLuint vertexCount = 0;
+    GLuint firstIndex = 0;
+    GLuint indexCount = 0;
   };
+
+  static void EnsureCapacity(size_t vertexCount, size_t indexCount);
+  static int GetMaterialId(uint64_t materialHash);
+
+  static std::unordered_map<uint64_t, int> s_MaterialIds;
+  static std::vector<DynamicBatch> s_Batches;
+
+  static GLuint s_VAO;
+  static GLuint s_VBO;
+  static GLuint s_EBO;
+  static size_t s_VertexCapacity;
+  static size_t s_IndexCapacity;
+  static int s_Region;
+
+  static int s_BatchesLastFrame;
+  static int s_ObjectsLastFrame;
 };
 
 #endif
@@ -1,8 +1,36 @@
 #include "HLODManager.h"
+#include "../Core/Application.h"
+#include "../Core/ThreadManager.h"
+#include "LODGenerator.h"
+#include "Renderer.h"
+#include <Core/Logger.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <map>
+#include <stb/stb_image.h>
+#include <unordered_map>
 
 std::vector<HLODProxy> HLODManager::s_Proxies;
+std::vector<int> HLODManager::s_Roots;
+float HLODManager::s_ClusterSize = 50.0f;
+int HLODManager::s_Levels = 3;
+int HLODManager::s_TriangleBudget = 4096;
+int HLODManager::s_AtlasResolution = 1024;
+
+static constexpr uint32_t HLOD_CACHE_VERSION = 4;
+static constexpr char HLOD_CACHE_MAGIC[8] = {'C', '3', 'D', 'H',
+                                             'L', 'O', 'D', 0};
+static constexpr int HLOD_MAX_TILE = 256;
+// Upper bounds for counts read back from a cache file; anything larger is
+// treated as corruption.
+static constexpr uint32_t HLOD_CACHE_MAX_ELEMENTS = 1u << 24;
+static constexpr uint32_t HLOD_CACHE_MAX_ATLAS = 16384;
 
 struct GridKey {
   int x, y, z;
@@ -15,99 +43,558 @@ struct GridKey {
   }
 };
 
-void HLODManager::BakeHLOD(Scene &scene, float clusterSize) {
-  s_Proxies.clear();
+static GridKey CellOf(const glm::vec3 &p, float cellSize) {
+  return {(int)std::floor(p.x / cellSize), (int)std::floor(p.y / cellSize),
+          (int)std::floor(p.z / cellSize)};
+}
+
+static int FloorDiv2(int v) { return v >= 0 ? v / 2 : -((-v + 1) / 2); }
+
+static uint64_t HashBytes(uint64_t h, const void *data, size_t size) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    h ^= bytes[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+// Texture downsampled to at most HLOD_MAX_TILE, shared by every cluster
+// that uses it during one bake.
+struct HLODTexture {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> pixels;
+  glm::vec3 average = glm::vec3(1.0f);
+  bool valid = false;
+};
+
+// Everything a worker needs about one source object, captured up front so
+// the workers never read the scene.
+struct HLODSource {
+  glm::mat4 world;
+  glm::mat3 normalMatrix;
+  glm::vec3 position;
+  const Mesh *mesh = nullptr;
+  glm::vec3 albedo;
+  const HLODTexture *texture = nullptr;
+  bool uvsInTile = false;
+  uint64_t hash = 0;
+};
+
+struct HLODCluster {
+  int level = 0;
+  GridKey key;
+  std::vector<int> objects;
+  std::vector<int> children;
+  uint64_t hash = 0;
+
+  bool ready = false;
+  std::vector<Vertex> vertices;
+  std::vector<GLuint> indices;
+  int atlasWidth = 0;
+  int atlasHeight = 0;
+  std::vector<uint8_t> atlas;
+  float error = 0.0f;
+};
+
+static void ResampleRGBA(const uint8_t *src, int sw, int sh, uint8_t *dst,
+                         int dw, int dh, int dstStride) {
+  for (int y = 0; y < dh; ++y) {
+    int y0 = y * sh / dh;
+    int y1 = std::max(y0 + 1, (y + 1) * sh / dh);
+    for (int x = 0; x < dw; ++x) {
+      int x0 = x * sw / dw;
+      int x1 = std::max(x0 + 1, (x + 1) * sw / dw);
+      uint32_t sum[4] = {0, 0, 0, 0};
+      for (int sy = y0; sy < y1; ++sy)
+        for (int sx = x0; sx < x1; ++sx)
+          for (int c = 0; c < 4; ++c)
+            sum[c] += src[(sy * sw + sx) * 4 + c];
+      uint32_t count = (uint32_t)((y1 - y0) * (x1 - x0));
+      for (int c = 0; c < 4; ++c)
+        dst[(y * dstStride + x) * 4 + c] = (uint8_t)(sum[c] / count);
+    }
+  }
+}
+
+static void LoadHLODTexture(const std::string &path, HLODTexture &out) {
+  int w, h, c;
+  unsigned char *data = stbi_load(path.c_str(), &w, &h, &c, 4);
+  if (!data)
+    return;
+
+  out.width = std::min(w, HLOD_MAX_TILE);
+  out.height = std::min(h, HLOD_MAX_TILE);
+  out.pixels.resize((size_t)out.width * out.height * 4);
+  ResampleRGBA(data, w, h, out.pixels.data(), out.width, out.height,
+               out.width);
+  stbi_image_free(data);
+
+  glm::dvec3 sum(0.0);
+  for (size_t i = 0; i < out.pixels.size(); i += 4)
+    sum += glm::dvec3(out.pixels[i], out.pixels[i + 1], out.pixels[i + 2]);
+  out.average =
+      glm::vec3(sum / (255.0 * (double)(out.width * out.height)));
+  out.valid = true;
+}
+
+static std::string DiffusePath(const GameObject &obj) {
+  if (!obj.material.useTexture || obj.material.textureScaling)
+    return "";
+  if (!obj.material.diffusePath.empty())
+    return obj.material.diffusePath;
+  for (const auto &tex : obj.mesh.textures)
+    if (tex.type && std::strcmp(tex.type, "diffuse") == 0)
+      return tex.path;
+  return "";
+}
+
+static std::string HLODCachePath(uint64_t hash) {
+  char name[64];
+  snprintf(name, sizeof(name), "%016llx.hlod", (unsigned long long)hash);
+  return HLODManager::GetCacheDirectory() + "/" + name;
+}
+
+static bool ReadHLODCache(HLODCluster &cluster) {
+  std::ifstream file(HLODCachePath(cluster.hash), std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  char magic[8];
+  uint32_t counts[4] = {0, 0, 0, 0};
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char *>(counts), sizeof(counts));
+  file.read(reinterpret_cast<char *>(&cluster.error), sizeof(cluster.error));
+  if (!file || std::memcmp(magic, HLOD_CACHE_MAGIC, sizeof(magic)) != 0)
+    return false;
+
+  // The payload must match the counts exactly, so a truncated or corrupt
+  // entry is rebaked instead of read past its end.
+  if (counts[0] > HLOD_CACHE_MAX_ELEMENTS ||
+      counts[1] > HLOD_CACHE_MAX_ELEMENTS || counts[1] % 3 != 0 ||
+      counts[2] > HLOD_CACHE_MAX_ATLAS || counts[3] > HLOD_CACHE_MAX_ATLAS)
+    return false;
+  std::streamoff header = file.tellg();
+  file.seekg(0, std::ios::end);
+  std::streamoff remaining = file.tellg() - header;
+  file.seekg(header);
+  uint64_t payload = (uint64_t)counts[0] * sizeof(Vertex) +
+                     (uint64_t)counts[1] * sizeof(GLuint) +
+                     (uint64_t)counts[2] * counts[3] * 4;
+  if (!file || remaining < 0 || payload != (uint64_t)remaining)
+    return false;
+
+  cluster.vertices.resize(counts[0]);
+  cluster.indices.resize(counts[1]);
+  cluster.atlasWidth = (int)counts[2];
+  cluster.atlasHeight = (int)counts[3];
+  cluster.atlas.resize((size_t)counts[2] * counts[3] * 4);
+  file.read(reinterpret_cast<char *>(cluster.vertices.data()),
+            cluster.vertices.size() * sizeof(Vertex));
+  file.read(reinterpret_cast<char *>(cluster.indices.data()),
+            cluster.indices.size() * sizeof(GLuint));
+  file.read(reinterpret_cast<char *>(cluster.atlas.data()),
+            cluster.atlas.size());
+  if (!file)
+    return false;
+  for (GLuint index : cluster.indices)
+    if (index >= counts[0])
+      return false;
+  return true;
+}
+
+static void WriteHLODCache(const HLODCluster &cluster) {
+  std::string path = HLODCachePath(cluster.hash);
+  std::error_code ec;
+  std::filesystem::create_directories(
+      std::filesystem::path(path).parent_path(), ec);
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return;
+
+  uint32_t counts[4] = {(uint32_t)cluster.vertices.size(),
+                        (uint32_t)cluster.indices.size(),
+                        (uint32_t)cluster.atlasWidth,
+                        (uint32_t)cluster.atlasHeight};
+  file.write(HLOD_CACHE_MAGIC, sizeof(HLOD_CACHE_MAGIC));
+  file.write(reinterpret_cast<const char *>(counts), sizeof(counts));
+  file.write(reinterpret_cast<const char *>(&cluster.error),
+             sizeof(cluster.error));
+  file.write(reinterpret_cast<const char *>(cluster.vertices.data()),
+             cluster.vertices.size() * sizeof(Vertex));
+  file.write(reinterpret_cast<const char *>(cluster.indices.data()),
+             cluster.indices.size() * sizeof(GLuint));
+  file.write(reinterpret_cast<const char *>(cluster.atlas.data()),
+             cluster.atlas.size());
+}
+
+// Gives every object its own tile of a cluster atlas (albedo baked in),
+// moves it to world space and simplifies the objects to the cluster's
+// triangle budget before merging them.
+static void BakeCluster(HLODCluster &cluster,
+                        const std::vector<HLODSource> &sources,
+                        int atlasResolution, int triangleBudget) {
+  int count = (int)cluster.objects.size();
+  int cols = (int)std::ceil(std::sqrt((double)count));
+  int rows = (count + cols - 1) / cols;
+  int tile = std::clamp(atlasResolution / cols, 4, HLOD_MAX_TILE);
+  cluster.error = 0.0f;
+  cluster.atlasWidth = cols * tile;
+  cluster.atlasHeight = rows * tile;
+  cluster.atlas.assign((size_t)cluster.atlasWidth * cluster.atlasHeight * 4,
+                       255);
+  glm::vec2 atlasSize(cluster.atlasWidth, cluster.atlasHeight);
+
+  std::vector<std::vector<Vertex>> parts(count);
+  std::vector<std::vector<GLuint>> partIndices(count);
+  size_t triangles = 0;
+  for (int t = 0; t < count; ++t) {
+    const HLODSource &src = sources[cluster.objects[t]];
+    int tx = (t % cols) * tile;
+    int ty = (t / cols) * tile;
+    uint8_t *tilePixels =
+        cluster.atlas.data() + ((size_t)ty * cluster.atlasWidth + tx) * 4;
+
+    bool mapped = src.texture && src.uvsInTile;
+    if (mapped) {
+      ResampleRGBA(src.texture->pixels.data(), src.texture->width,
+                   src.texture->height, tilePixels, tile, tile,
+                   cluster.atlasWidth);
+      for (int y = 0; y < tile; ++y) {
+        uint8_t *row = tilePixels + (size_t)y * cluster.atlasWidth * 4;
+        for (int x = 0; x < tile; ++x)
+          for (int c = 0; c < 3; ++c)
+            row[x * 4 + c] = (uint8_t)std::min(
+                255.0f, row[x * 4 + c] * src.albedo[c]);
+      }
+    } else {
+      glm::vec3 color = src.albedo;
+      if (src.texture)
+        color *= src.texture->average;
+      for (int y = 0; y < tile; ++y) {
+        uint8_t *row = tilePixels + (size_t)y * cluster.atlasWidth * 4;
+        for (int x = 0; x < tile; ++x) {
+          for (int c = 0; c < 3; ++c)
+            row[x * 4 + c] =
+                (uint8_t)(std::clamp(color[c], 0.0f, 1.0f) * 255.0f);
+          row[x * 4 + 3] = 255;
+        }
+      }
+    }
+
+    // Half a texel of padding keeps bilinear filtering inside the tile.
+    glm::vec2 tileMin = (glm::vec2(tx, ty) + 0.5f) / atlasSize;
+    glm::vec2 tileScale = glm::vec2(tile - 1.0f) / atlasSize;
+
+    std::vector<Vertex> &part = parts[t];
+    part.reserve(src.mesh->vertices.size());
+    glm::vec3 minP(1e30f), maxP(-1e30f);
+    for (const auto &v : src.mesh->vertices) {
+      Vertex mv = v;
+      mv.position = glm::vec3(src.world * glm::vec4(v.position, 1.0f));
+      minP = glm::min(minP, mv.position);
+      maxP = glm::max(maxP, mv.position);
+      mv.normal = glm::normalize(src.normalMatrix * v.normal);
+      mv.texUV = tileMin + (mapped ? glm::clamp(v.texUV, 0.0f, 1.0f)
+                                   : glm::vec2(0.5f)) *
+                               tileScale;
+      part.push_back(mv);
+    }
+    partIndices[t] = src.mesh->indices;
+    triangles += partIndices[t].size() / 3;
+
+    // Surface detail finer than one tile texel is gone from the proxy.
+    if (!src.mesh->vertices.empty())
+      cluster.error =
+          std::max(cluster.error, glm::distance(minP, maxP) / (float)tile);
+  }
+
+  // Objects are simplified one at a time: the simplifier averages UVs of
+  // vertices sharing a grid cell, which across objects would land between
+  // atlas tiles. The grid also makes the ratio only a rough triangle count,
+  // so it is tightened until the merged result fits.
+  float ratio = std::min((float)triangleBudget / (float)triangles, 1.0f);
+  float simplifyError = 0.0f;
+  std::vector<Vertex> outVertices;
+  std::vector<GLuint> outIndices;
+  for (int attempt = 0; attempt < 6; ++attempt) {
+    cluster.vertices.clear();
+    cluster.indices.clear();
+    simplifyError = 0.0f;
+    for (int t = 0; t < count; ++t) {
+      float partError = 0.0f;
+      LODGenerator::SimplifyMesh(parts[t], partIndices[t], ratio, outVertices,
+                                 outIndices, &partError);
+      simplifyError = std::max(simplifyError, partError);
+      GLuint base = (GLuint)cluster.vertices.size();
+      cluster.vertices.insert(cluster.vertices.end(), outVertices.begin(),
+                              outVertices.end());
+      for (GLuint idx : outIndices)
+        cluster.indices.push_back(idx + base);
+    }
+    size_t outTriangles = cluster.indices.size() / 3;
+    if ((int)outTriangles <= triangleBudget || outTriangles == 0)
+      break;
+    ratio *= 0.9f * (float)triangleBudget / (float)outTriangles;
+  }
+  cluster.error = std::max(cluster.error, simplifyError);
+}
+
+static unsigned int UploadHLODAtlas(const HLODCluster &cluster) {
+  if (cluster.atlas.empty())
+    return 0;
+  unsigned int id = 0;
+  glGenTextures(1, &id);
+  glBindTexture(GL_TEXTURE_2D, id);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, cluster.atlasWidth,
+               cluster.atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               cluster.atlas.data());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glGenerateMipmap(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return id;
+}
+
+std::string HLODManager::GetCacheDirectory() {
+  std::string projectRoot = Application::Get().GetProjectRoot();
+  if (projectRoot.empty())
+    return "Cache/HLOD";
+  return projectRoot + "/Cache/HLOD";
+}
+
+void HLODManager::BakeHLOD(Scene &scene) { Build(scene, true); }
+
+void HLODManager::LoadFromCache(Scene &scene) {
+  std::error_code ec;
+  if (!std::filesystem::is_directory(GetCacheDirectory(), ec)) {
+    Clear();
+    return;
+  }
+  Build(scene, false);
+}
+
+void HLODManager::Build(Scene &scene, bool bakeMissing) {
+  Clear();
 
-  std::map<GridKey, std::vector<int>> clusters;
   auto &objects = scene.GetObjects();
+  int levels = std::max(s_Levels, 1);
+  float clusterSize = std::max(s_ClusterSize, 1.0f);
+  int triangleBudget = std::max(s_TriangleBudget, 64);
+  int atlasResolution = std::max(s_AtlasResolution, 64);
 
-  
-  for (int i = 0; i < objects.size(); ++i) {
+  std::vector<HLODSource> sources(objects.size());
+  std::vector<int> eligible;
+  std::vector<std::string> texturePaths(objects.size());
+  std::map<std::string, HLODTexture> textures;
+  for (int i = 0; i < (int)objects.size(); ++i) {
     const auto &obj = objects[i];
     if (!obj.isStatic || !obj.isActive || obj.mesh.vertices.empty())
       continue;
+    HLODSource &src = sources[i];
+    src.world = scene.GetGlobalTransform(i);
+    src.normalMatrix = glm::transpose(glm::inverse(glm::mat3(src.world)));
+    src.position = glm::vec3(src.world[3]);
+    src.mesh = &obj.mesh;
+    src.albedo = obj.material.albedo;
 
-    GridKey key;
-    key.x = static_cast<int>(std::floor(obj.position.x / clusterSize));
-    key.y = static_cast<int>(std::floor(obj.position.y / clusterSize));
-    key.z = static_cast<int>(std::floor(obj.position.z / clusterSize));
+    glm::vec2 uvMin(1e30f), uvMax(-1e30f);
+    for (const auto &v : obj.mesh.vertices) {
+      uvMin = glm::min(uvMin, v.texUV);
+      uvMax = glm::max(uvMax, v.texUV);
+    }
+    src.uvsInTile = uvMin.x >= -0.01f && uvMin.y >= -0.01f &&
+                    uvMax.x <= 1.01f && uvMax.y <= 1.01f;
 
-    clusters[key].push_back(i);
+    texturePaths[i] = DiffusePath(obj);
+    if (!texturePaths[i].empty())
+      textures[texturePaths[i]];
+    eligible.push_back(i);
   }
 
-  
-  for (auto const &[key, clusterIndices] : clusters) {
-    if (clusterIndices.size() < 2)
-      continue; 
+  // Per-object hashes cover everything that ends up in a proxy, so a
+  // cluster's cache entry is reused exactly when none of its objects
+  // changed.
+  ThreadManager::ParallelFor(0, (int)eligible.size(), [&](int e) {
+    int i = eligible[e];
+    const auto &obj = objects[i];
+    HLODSource &src = sources[i];
+    uint64_t h = 1469598103934665603ull;
+    h = HashBytes(h, &src.world, sizeof(src.world));
+    h = HashBytes(h, &src.albedo, sizeof(src.albedo));
+    for (const auto &v : obj.mesh.vertices) {
+      h = HashBytes(h, &v.position, sizeof(v.position));
+      h = HashBytes(h, &v.normal, sizeof(v.normal));
+      h = HashBytes(h, &v.texUV, sizeof(v.texUV));
+    }
+    h = HashBytes(h, obj.mesh.indices.data(),
+                  obj.mesh.indices.size() * sizeof(GLuint));
+    h = HashBytes(h, texturePaths[i].data(), texturePaths[i].size());
+    src.hash = h;
+  });
 
-    HLODProxy proxy;
-    proxy.originalObjectIndices = clusterIndices;
+  std::vector<HLODCluster> clusters;
+  std::map<GridKey, int> previousLevel;
+  for (int level = 0; level < levels; ++level) {
+    float cellSize = clusterSize * (float)(1 << level);
+    std::map<GridKey, std::vector<int>> cells;
+    for (int i : eligible)
+      cells[CellOf(sources[i].position, cellSize)].push_back(i);
+
+    std::map<GridKey, std::vector<int>> childrenOf;
+    for (const auto &[key, idx] : previousLevel)
+      childrenOf[{FloorDiv2(key.x), FloorDiv2(key.y), FloorDiv2(key.z)}]
+          .push_back(idx);
+
+    std::map<GridKey, int> currentLevel;
+    for (auto &[key, members] : cells) {
+      if (members.size() < 2)
+        continue;
+      std::vector<int> children;
+      if (level > 0) {
+        auto it = childrenOf.find(key);
+        if (it != childrenOf.end())
+          children = it->second;
+        // A parent over a single child would just repeat it.
+        if (children.size() < 2)
+          continue;
+      }
+
+      HLODCluster cluster;
+      cluster.level = level;
+      cluster.key = key;
+      cluster.objects = std::move(members);
+      cluster.children = std::move(children);
+      uint64_t h = 1469598103934665603ull;
+      for (int i : cluster.objects)
+        h = HashBytes(h, &sources[i].hash, sizeof(uint64_t));
+      int settings[3] = {triangleBudget, atlasResolution, level};
+      h = HashBytes(h, settings, sizeof(settings));
+      h = HashBytes(h, &HLOD_CACHE_VERSION, sizeof(HLOD_CACHE_VERSION));
+      cluster.hash = h;
+
+      currentLevel[key] = (int)clusters.size();
+      clusters.push_back(std::move(cluster));
+    }
+    previousLevel = std::move(currentLevel);
+    if (previousLevel.size() < 2)
+      break;
+  }
+
+  ThreadManager::ParallelFor(0, (int)clusters.size(), [&](int c) {
+    clusters[c].ready = ReadHLODCache(clusters[c]);
+  });
+
+  int cached = 0;
+  std::vector<int> toBake;
+  for (int c = 0; c < (int)clusters.size(); ++c) {
+    if (clusters[c].ready)
+      cached++;
+    else if (bakeMissing)
+      toBake.push_back(c);
+  }
 
-    std::vector<const GameObject *> clusterObjects;
-    for (int idx : clusterIndices)
-      clusterObjects.push_back(&objects[idx]);
+  if (!toBake.empty()) {
+    for (const auto &cluster : clusters)
+      for (int i : cluster.objects)
+        if (!texturePaths[i].empty())
+          sources[i].texture = &textures[texturePaths[i]];
 
-    proxy.mesh = MergeMeshes(clusterObjects, scene);
+    std::vector<std::pair<const std::string, HLODTexture> *> pending;
+    for (auto &entry : textures)
+      pending.push_back(&entry);
+    ThreadManager::ParallelFor(0, (int)pending.size(), [&](int t) {
+      LoadHLODTexture(pending[t]->first, pending[t]->second);
+    });
+    for (auto &src : sources)
+      if (src.texture && !src.texture->valid)
+        src.texture = nullptr;
 
-    
-    glm::vec3 minP(1e6f), maxP(-1e6f);
-    for (const auto &v : proxy.mesh.vertices) {
+    ThreadManager::ParallelFor(0, (int)toBake.size(), [&](int b) {
+      HLODCluster &cluster = clusters[toBake[b]];
+      BakeCluster(cluster, sources, atlasResolution, triangleBudget);
+      cluster.ready = !cluster.indices.empty();
+      if (cluster.ready)
+        WriteHLODCache(cluster);
+    });
+  }
+
+  std::vector<int> proxyOf(clusters.size(), -1);
+  size_t sourceTriangles = 0;
+  size_t proxyTriangles = 0;
+  for (int c = 0; c < (int)clusters.size(); ++c) {
+    HLODCluster &cluster = clusters[c];
+    if (!cluster.ready)
+      continue;
+
+    HLODProxy proxy;
+    proxy.level = cluster.level;
+    proxy.originalObjectIndices = cluster.objects;
+    for (int child : cluster.children)
+      if (proxyOf[child] >= 0)
+        proxy.children.push_back(proxyOf[child]);
+
+    glm::vec3 minP(1e30f), maxP(-1e30f);
+    for (const auto &v : cluster.vertices) {
       minP = glm::min(minP, v.position);
       maxP = glm::max(maxP, v.position);
     }
-
     proxy.center = (minP + maxP) * 0.5f;
     proxy.radius = glm::distance(minP, maxP) * 0.5f;
-    proxy.threshold = clusterSize * 1.5f; 
+    proxy.error = cluster.error;
+    for (int child : proxy.children)
+      proxy.error = std::max(proxy.error, s_Proxies[child].error);
+    proxy.atlasTexture = UploadHLODAtlas(cluster);
+    if (proxy.atlasTexture)
+      proxy.atlasBytes =
+          (size_t)cluster.atlasWidth * cluster.atlasHeight * 4 * 4 / 3;
+    // Proxies are already at their budget, so skip the per-mesh LOD chain.
+    proxy.mesh = Mesh(cluster.vertices, cluster.indices, {}, {});
     proxy.active = true;
 
+    for (int i : cluster.objects)
+      sourceTriangles += objects[i].mesh.indexCount / 3;
+    proxyTriangles += cluster.indices.size() / 3;
+
+    proxyOf[c] = (int)s_Proxies.size();
+    for (int child : proxy.children)
+      s_Proxies[child].parent = proxyOf[c];
     s_Proxies.push_back(std::move(proxy));
   }
+
+  for (int p = 0; p < (int)s_Proxies.size(); ++p)
+    if (s_Proxies[p].parent < 0)
+      s_Roots.push_back(p);
+
+  if (!s_Proxies.empty() || bakeMissing)
+    Logger::AddLog("[HLOD] %d proxies (%d from cache), %zu -> %zu triangles",
+                   (int)s_Proxies.size(), cached, sourceTriangles,
+                   proxyTriangles);
+  if (Renderer::s_ReleaseCPUMeshData) {
+    for (auto &proxy : s_Proxies)
+      proxy.mesh.ReleaseCPUData();
+  }
 }
 
 void HLODManager::Clear() {
   for (auto &proxy : s_Proxies) {
     proxy.mesh.Delete();
+    if (proxy.atlasTexture)
+      glDeleteTextures(1, &proxy.atlasTexture);
   }
   s_Proxies.clear();
+  s_Roots.clear();
 }
 
-void HLODManager::Update(float dt) {
-  
-}
-
-Mesh HLODManager::MergeMeshes(const std::vector<const GameObject *> &objects,
-                              const Scene &scene) {
-  std::vector<Vertex> mergedVertices;
-  std::vector<GLuint> mergedIndices;
-  std::vector<Texture>
-      mergedTextures; 
-                      
-
-  if (!objects.empty()) {
-    mergedTextures = objects[0]->mesh.textures;
+MemoryTagStats HLODManager::GetMemoryStats() {
+  MemoryTagStats stats;
+  for (const auto &proxy : s_Proxies) {
+    stats.cpuBytes += proxy.mesh.GetMemoryBytes();
+    stats.gpuBytes += proxy.mesh.GetGPUBytes() + proxy.atlasBytes;
   }
-
-  for (const auto *obj : objects) {
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, obj->position);
-    model = model * glm::mat4_cast(obj->rotation);
-    model = glm::scale(model, obj->scale);
-
-    GLuint baseIndex = static_cast<GLuint>(mergedVertices.size());
-
-    for (const auto &v : obj->mesh.vertices) {
-      Vertex mv = v;
-      mv.position = glm::vec3(model * glm::vec4(v.position, 1.0f));
-      mv.normal = glm::normalize(glm::vec3(glm::transpose(glm::inverse(model)) *
-                                           glm::vec4(v.normal, 0.0f)));
-      mergedVertices.push_back(mv);
-    }
-
-    for (const auto &idx : obj->mesh.indices) {
-      mergedIndices.push_back(idx + baseIndex);
-    }
-  }
-
-  return Mesh(mergedVertices, mergedIndices, mergedTextures);
+  return stats;
 }
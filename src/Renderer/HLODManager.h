@@ -1,32 +1,65 @@
 #ifndef HLOD_MANAGER_H
 #define HLOD_MANAGER_H
 
+#include "../Core/MemoryTracker.h"
 #include "Mesh.h"
 #include "Scene.h"
 #include <memory>
+#include <string>
 #include <vector>
 
+// A merged, simplified stand-in for every static object in one grid cell.
+// Level 0 cells are s_ClusterSize wide and each level above doubles the
+// cell, so a proxy's children are the proxies of the level below that fall
+// inside it.
 struct HLODProxy {
   Mesh mesh;
+  unsigned int atlasTexture = 0;
+  size_t atlasBytes = 0;
   glm::vec3 center;
   float radius;
-  float threshold = 100.0f; 
+  // World-space error of the proxy against the source objects: the larger of
+  // the simplifier's deviation and one atlas texel. Never below a child's.
+  float error = 0.0f;
   bool active = false;
+  // Selection state kept by the renderer for the main view. fade is how much
+  // of the proxy is shown, 1 meaning it fully replaces its subtree.
+  bool selected = false;
+  float fade = 0.0f;
+  float lodTime = -1.0f;
+  int level = 0;
+  int parent = -1;
+  std::vector<int> children;
   std::vector<int> originalObjectIndices;
 };
 
 class HLODManager {
 public:
-  static void BakeHLOD(Scene &scene, float clusterSize = 50.0f);
+  // Proxies found in the disk cache are loaded, the rest are baked in
+  // parallel and written to the cache.
+  static void BakeHLOD(Scene &scene);
+  // Same clustering as BakeHLOD, but only picks up proxies that are already
+  // cached. Used when a scene is loaded.
+  static void LoadFromCache(Scene &scene);
   static void Clear();
 
-  static const std::vector<HLODProxy> &GetProxies() { return s_Proxies; }
-  static void Update(float dt);
+  static std::vector<HLODProxy> &GetProxies() { return s_Proxies; }
+  static const std::vector<int> &GetRoots() { return s_Roots; }
+  // Proxy meshes and their atlases.
+  static MemoryTagStats GetMemoryStats();
+
+  static std::string GetCacheDirectory();
+
+  static float s_ClusterSize;
+  static int s_Levels;
+  static int s_TriangleBudget;
+  static int s_AtlasResolution;
 
 private:
+  static void Build(Scene &scene, bool bakeMissing);
+
   static std::vector<HLODProxy> s_Proxies;
-  static Mesh MergeMeshes(const std::vector<const GameObject *> &objects,
-                          const Scene &scene);
+  static std::vector<int> s_Roots;
 };
 
 #endif
@@ -79,7 +79,10 @@ void LODGenerator::SimplifyMesh(const std::vector<Vertex> &inVertices,
                                 const std::vector<GLuint> &inIndices,
                                 float targetRatio,
                                 std::vector<Vertex> &outVertices,
-                                std::vector<GLuint> &outIndices) {
+                                std::vector<GLuint> &outIndices,
+                                float *outError) {
+  if (outError)
+    *outError = 0.0f;
 
   if (inIndices.size() < 40 || targetRatio >= 0.99f) {
     outVertices = inVertices;
@@ -213,6 +216,11 @@ void LODGenerator::SimplifyMesh(const std::vector<Vertex> &inVertices,
     }
 
     outV.position = bestPos;
+    if (outError) {
+      for (size_t vIdx : cell.originalVertices)
+        *outError = std::max(
+            *outError, glm::distance(inVertices[vIdx].position, bestPos));
+    }
 
     
     
@@ -241,5 +249,7 @@ void LODGenerator::SimplifyMesh(const std::vector<Vertex> &inVertices,
   if (outIndices.empty()) {
     outVertices = inVertices;
     outIndices = inIndices;
+    if (outError)
+      *outError = 0.0f;
   }
 }
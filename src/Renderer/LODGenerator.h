@@ -6,10 +6,13 @@
 
 class LODGenerator {
 public:
+  // outError, if given, receives the largest distance any input vertex moved,
+  // in the same units as the input positions.
   static void SimplifyMesh(const std::vector<Vertex> &inVertices,
                            const std::vector<GLuint> &inIndices,
                            float targetRatio, std::vector<Vertex> &outVertices,
-                           std::vector<GLuint> &outIndices);
+                           std::vector<GLuint> &outIndices,
+                           float *outError = nullptr);
 };
 
 #endif
@@ -1,6 +1,7 @@
 #ifndef MATERIAL_H
 #define MATERIAL_H
 
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <nlohmann/json.hpp>
 #include <string>
@@ -31,6 +32,34 @@ struct Material {
   unsigned int atlasTextureID = 0;
   std::string diffusePath = "";
 
+  // FNV-1a over everything that changes how a batch is shaded; used as the
+  // batching key instead of building a string per object.
+  uint64_t Hash() const {
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](const void *data, size_t size) {
+      const unsigned char *bytes = static_cast<const unsigned char *>(data);
+      for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+      }
+    };
+    auto mixString = [&mix](const std::string &s) {
+      mix(s.data(), s.size());
+      mix("|", 1);
+    };
+    mixString(diffuseTexture);
+    mixString(specularTexture);
+    mixString(customShaderName);
+    float values[6] = {albedo.r, albedo.g, albedo.b, metallic, roughness, ao};
+    mix(values, sizeof(values));
+    unsigned char flags[3] = {(unsigned char)isTransparent,
+                              (unsigned char)useTexture,
+                              (unsigned char)isAtlased};
+    mix(flags, sizeof(flags));
+    mix(&atlasTextureID, sizeof(atlasTextureID));
+    return h;
+  }
+
   nlohmann::json Serialize() const {
     nlohmann::json j;
     j["albedo"] = {albedo.r, albedo.g, albedo.b};
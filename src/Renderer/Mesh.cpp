@@ -1,6 +1,7 @@
 #include "Mesh.h"
 #include "../Core/Logger.h"
 #include "LODGenerator.h"
+#include <algorithm>
 #include <limits>
 
 Mesh::Mesh(const std::vector<Vertex> &vertices,
@@ -9,6 +10,27 @@ Mesh::Mesh(const std::vector<Vertex> &vertices,
   Mesh::indices = indices;
   Mesh::textures = std::move(textures);
 
+  SetupMesh();
+
+  if (indices.size() > 900) {
+    GenerateLODs();
+  }
+}
+
+Mesh::Mesh(const std::vector<Vertex> &vertices,
+           const std::vector<GLuint> &indices, std::vector<Texture> textures,
+           std::vector<LODLevel> lods) {
+  Mesh::vertices = vertices;
+  Mesh::indices = indices;
+  Mesh::textures = std::move(textures);
+
+  SetupMesh();
+
+  lodLevels = std::move(lods);
+  UploadLODs();
+}
+
+void Mesh::SetupMesh() {
   minAABB = glm::vec3(std::numeric_limits<float>::max());
   maxAABB = glm::vec3(std::numeric_limits<float>::lowest());
 
@@ -22,6 +44,9 @@ Mesh::Mesh(const std::vector<Vertex> &vertices,
     maxAABB.z = std::max(maxAABB.z, vertex.position.z);
   }
 
+  vertexCount = (GLsizei)vertices.size();
+  indexCount = (GLsizei)indices.size();
+
   vao.Bind();
   VBO VBO(vertices);
   vboID = VBO.ID;
@@ -43,72 +68,151 @@ Mesh::Mesh(const std::vector<Vertex> &vertices,
   vao.Unbind();
   VBO.Unbind();
   EBO.Unbind();
-
-  if (indices.size() > 900) {
-    GenerateLODs();
-  }
 }
 
-void Mesh::GenerateLODs() {
-  lodLevels.clear();
+std::vector<Mesh::LODLevel>
+Mesh::BuildLODLevels(const std::vector<Vertex> &vertices,
+                     const std::vector<GLuint> &indices) {
+  std::vector<LODLevel> levels;
 
   float targetRatios[] = {0.5f, 0.05f, 0.01f, 0.002f};
 
-  std::vector<Vertex> currentVerts = vertices;
-  std::vector<GLuint> currentInds = indices;
-
   for (int i = 0; i < 4; ++i) {
     LODLevel lod;
 
     LODGenerator::SimplifyMesh(vertices, indices, targetRatios[i], lod.vertices,
-                               lod.indices);
+                               lod.indices, &lod.error);
+    // Selection walks the chain until the error is too large, so keep it
+    // monotonic even where a coarser grid happened to land closer.
+    if (!levels.empty())
+      lod.error = std::max(lod.error, levels.back().error);
 
     if (lod.indices.size() <
-            (i == 0 ? indices.size() : lodLevels.back().indices.size()) &&
+            (i == 0 ? indices.size() : levels.back().indices.size()) &&
         !lod.indices.empty()) {
-      glGenVertexArrays(1, &lod.vao);
-      glGenBuffers(1, &lod.vbo);
-      glGenBuffers(1, &lod.ebo);
+      levels.push_back(std::move(lod));
+    } else {
+      break;
+    }
+  }
 
-      glBindVertexArray(lod.vao);
+  return levels;
+}
 
-      glBindBuffer(GL_ARRAY_BUFFER, lod.vbo);
-      glBufferData(GL_ARRAY_BUFFER, lod.vertices.size() * sizeof(Vertex),
-                   lod.vertices.data(), GL_STATIC_DRAW);
+void Mesh::GenerateLODs() {
+  lodLevels = BuildLODLevels(vertices, indices);
+  UploadLODs();
 
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod.ebo);
-      glBufferData(GL_ELEMENT_ARRAY_BUFFER, lod.indices.size() * sizeof(GLuint),
-                   lod.indices.data(), GL_STATIC_DRAW);
+  if (!lodLevels.empty()) {
+    Logger::AddLog("Generated %zu LOD levels for mesh containing %zu indices.",
+                   lodLevels.size(), indices.size());
+  }
+}
 
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                            (void *)offsetof(Vertex, position));
-      glEnableVertexAttribArray(1);
-      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                            (void *)offsetof(Vertex, color));
-      glEnableVertexAttribArray(2);
-      glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                            (void *)offsetof(Vertex, texUV));
-      glEnableVertexAttribArray(3);
-      glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                            (void *)offsetof(Vertex, normal));
+void Mesh::UploadLODs() {
+  for (auto &lod : lodLevels) {
+    if (lod.vao != 0)
+      continue;
 
-      glBindVertexArray(0);
+    lod.vertexCount = (GLsizei)lod.vertices.size();
+    lod.indexCount = (GLsizei)lod.indices.size();
+    glGenVertexArrays(1, &lod.vao);
+    glGenBuffers(1, &lod.vbo);
+    glGenBuffers(1, &lod.ebo);
 
-      lodLevels.push_back(lod);
+    glBindVertexArray(lod.vao);
 
-    } else {
-      break;
-    }
+    glBindBuffer(GL_ARRAY_BUFFER, lod.vbo);
+    glBufferData(GL_ARRAY_BUFFER, lod.vertices.size() * sizeof(Vertex),
+                 lod.vertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, lod.indices.size() * sizeof(GLuint),
+                 lod.indices.data(), GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          (void *)offsetof(Vertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          (void *)offsetof(Vertex, color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          (void *)offsetof(Vertex, texUV));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          (void *)offsetof(Vertex, normal));
+
+    glBindVertexArray(0);
   }
+}
 
-  if (!lodLevels.empty()) {
-    Logger::AddLog("Generated %zu LOD levels for mesh containing %zu indices.",
-                   lodLevels.size(), indices.size());
+bool Mesh::DropToCoarsestLOD() {
+  if (lodLevels.empty())
+    return false;
+
+  LODLevel coarsest = std::move(lodLevels.back());
+  lodLevels.pop_back();
+
+  for (auto &lod : lodLevels) {
+    if (lod.vao != 0)
+      glDeleteVertexArrays(1, &lod.vao);
+    if (lod.vbo != 0)
+      glDeleteBuffers(1, &lod.vbo);
+    if (lod.ebo != 0)
+      glDeleteBuffers(1, &lod.ebo);
   }
+  lodLevels.clear();
+
+  Delete();
+
+  vao.ID = coarsest.vao;
+  vboID = coarsest.vbo;
+  eboID = coarsest.ebo;
+  vertices = std::move(coarsest.vertices);
+  indices = std::move(coarsest.indices);
+  vertexCount = coarsest.vertexCount;
+  indexCount = coarsest.indexCount;
+  currentLOD = 0;
+  fadeFromLOD = -1;
+  return true;
+}
+
+size_t Mesh::ReleaseCPUData() {
+  size_t bytes = GetMemoryBytes();
+  std::vector<Vertex>().swap(vertices);
+  std::vector<GLuint>().swap(indices);
+  for (auto &lod : lodLevels) {
+    std::vector<Vertex>().swap(lod.vertices);
+    std::vector<GLuint>().swap(lod.indices);
+  }
+  cpuDataReleased = true;
+  return bytes;
+}
+
+size_t Mesh::GetMemoryBytes() const {
+  size_t bytes =
+      vertices.size() * sizeof(Vertex) + indices.size() * sizeof(GLuint);
+  for (const auto &lod : lodLevels) {
+    bytes += lod.vertices.size() * sizeof(Vertex) +
+             lod.indices.size() * sizeof(GLuint);
+  }
+  return bytes;
+}
+
+size_t Mesh::GetGPUBytes() const {
+  size_t bytes = (size_t)vertexCount * sizeof(Vertex) +
+                 (size_t)indexCount * sizeof(GLuint);
+  for (const auto &lod : lodLevels) {
+    bytes += (size_t)lod.vertexCount * sizeof(Vertex) +
+             (size_t)lod.indexCount * sizeof(GLuint);
+  }
+  return bytes;
 }
 
 void Mesh::UpdateVBO() {
+  if (cpuDataReleased)
+    return;
   glBindBuffer(GL_ARRAY_BUFFER, vboID);
   glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex),
                vertices.data(), GL_STATIC_DRAW);
@@ -117,12 +221,16 @@ void Mesh::UpdateVBO() {
 
 void Mesh::Delete() {
   vao.Delete();
+  vao.ID = 0;
   if (vboID != 0)
     glDeleteBuffers(1, &vboID);
   if (eboID != 0)
     glDeleteBuffers(1, &eboID);
   vboID = 0;
   eboID = 0;
+  vertexCount = 0;
+  indexCount = 0;
+  cpuDataReleased = false;
   vertices.clear();
   indices.clear();
 }
@@ -168,11 +276,11 @@ void Mesh::Draw(Shader &shader, Camera &camera, glm::vec3 position,
 
   if (currentLOD > 0 && currentLOD <= lodLevels.size()) {
     glBindVertexArray(lodLevels[currentLOD - 1].vao);
-    glDrawElements(GL_TRIANGLES, lodLevels[currentLOD - 1].indices.size(),
+    glDrawElements(GL_TRIANGLES, lodLevels[currentLOD - 1].indexCount,
                    GL_UNSIGNED_INT, 0);
   } else {
     vao.Bind();
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
   }
   glBindVertexArray(0);
 }
@@ -222,11 +330,11 @@ void Mesh::Draw(Shader &shader, Camera &camera, const glm::mat4 &model,
 
   if (currentLOD > 0 && currentLOD <= lodLevels.size()) {
     glBindVertexArray(lodLevels[currentLOD - 1].vao);
-    glDrawElements(GL_TRIANGLES, lodLevels[currentLOD - 1].indices.size(),
+    glDrawElements(GL_TRIANGLES, lodLevels[currentLOD - 1].indexCount,
                    GL_UNSIGNED_INT, 0);
   } else {
     vao.Bind();
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
   }
   glBindVertexArray(0);
 }
@@ -277,7 +385,9 @@ bool Mesh::Intersect(const glm::vec3 &ray_origin,
 }
 
 void Mesh::RemapUVs(const glm::vec2 &offset, const glm::vec2 &scale) {
-  
+  if (cpuDataReleased)
+    return;
+
   for (auto &v : vertices) {
     v.texUV = offset + v.texUV * scale;
   }
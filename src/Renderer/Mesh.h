@@ -20,6 +20,11 @@ public:
   GLuint eboID;
   glm::vec3 minAABB;
   glm::vec3 maxAABB;
+  // Sizes of the uploaded buffers. Unlike the vectors above they survive
+  // ReleaseCPUData(), so drawing goes by these.
+  GLsizei vertexCount = 0;
+  GLsizei indexCount = 0;
+  bool cpuDataReleased = false;
   Mesh() : vboID(0), eboID(0) {}
 
   Mesh(const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices,
@@ -46,11 +51,43 @@ public:
     unsigned int vao = 0;
     unsigned int vbo = 0;
     unsigned int ebo = 0;
+    GLsizei vertexCount = 0;
+    GLsizei indexCount = 0;
+    // Largest object-space deviation from the full-detail mesh.
+    float error = 0.0f;
   };
 
   std::vector<LODLevel> lodLevels;
   int currentLOD = 0;
+  // Cross-fade from the previously shown LOD (-1 when not fading) and its
+  // progress in [0, 1]. lodTime is the frame time the selection last ran.
+  int fadeFromLOD = -1;
+  float lodFade = 1.0f;
+  float lodTime = -1.0f;
+
+  // Uses LOD geometry built ahead of time (e.g. on a streaming worker)
+  // instead of simplifying on the calling thread.
+  Mesh(const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices,
+       std::vector<Texture> textures, std::vector<LODLevel> lods);
 
   void GenerateLODs();
+  void UploadLODs();
+  static std::vector<LODLevel> BuildLODLevels(const std::vector<Vertex> &vertices,
+                                              const std::vector<GLuint> &indices);
+
+  // Frees the full-detail buffers and keeps the coarsest LOD as the base
+  // mesh. Returns false (and leaves the mesh untouched) if there are no LODs.
+  bool DropToCoarsestLOD();
+  // Frees the CPU copies of the vertices and indices, LODs included, and
+  // returns the bytes freed. The mesh still draws, but code that reads the
+  // vectors (batching, HLOD and SDF baking, duplication) sees no geometry.
+  size_t ReleaseCPUData();
+  // CPU-side vertex and index data.
+  size_t GetMemoryBytes() const;
+  // Vertex and index buffers on the GPU.
+  size_t GetGPUBytes() const;
+
+private:
+  void SetupMesh();
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,488 @@
+#include "NullGL.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <glad/glad.h>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+RenderDeviceStats NullGL::s_Stats;
+bool NullGL::s_Loaded = false;
+
+static std::atomic<GLuint> s_NullGLNextName{1};
+static GLint s_NullGLViewport[4] = {0, 0, 1, 1};
+// Memory handed out by glMapBufferRange, one block per buffer target.
+static std::unordered_map<GLenum, std::vector<uint8_t>> s_NullGLMapScratch;
+
+static uint64_t NullGLTriangles(GLenum mode, GLsizei count) {
+  if (mode == GL_TRIANGLES)
+    return (uint64_t)count / 3;
+  if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count > 2)
+    return (uint64_t)count - 2;
+  return 0;
+}
+
+static void NullGLCountDraw(GLenum mode, GLsizei count, GLsizei instances) {
+  NullGL::s_Stats.drawCalls++;
+  NullGL::s_Stats.triangles +=
+      NullGLTriangles(mode, count) * (uint64_t)instances;
+}
+
+// Storage bookkeeping. Bindings are tracked only as far as needed to know
+// which object a storage call lands on.
+static std::unordered_map<GLenum, GLuint> s_NullGLBoundBuffers;
+static std::unordered_map<GLuint, uint64_t> s_NullGLBufferBytes;
+static GLuint s_NullGLActiveUnit = 0;
+static std::unordered_map<uint64_t, GLuint> s_NullGLBoundTextures;
+// Per texture, bytes per (level, cube face) image; -1 holds the estimate for
+// generated mipmaps.
+static std::unordered_map<GLuint, std::map<int, uint64_t>> s_NullGLTexBytes;
+static GLuint s_NullGLBoundRenderbuffer = 0;
+static std::unordered_map<GLuint, uint64_t> s_NullGLRenderbufferBytes;
+
+static uint64_t NullGLBytesPerPixel(GLenum format) {
+  switch (format) {
+  case GL_RGBA32F:
+  case GL_RGBA32I:
+  case GL_RGBA32UI:
+    return 16;
+  case GL_RGB32F:
+    return 12;
+  case GL_RGBA16F:
+  case GL_RG32F:
+  case GL_DEPTH32F_STENCIL8:
+    return 8;
+  case GL_RGB16F:
+    return 6;
+  case GL_RGB:
+  case GL_RGB8:
+  case GL_SRGB8:
+    return 3;
+  case GL_RG:
+  case GL_RG8:
+  case GL_R16F:
+  case GL_DEPTH_COMPONENT16:
+    return 2;
+  case GL_RED:
+  case GL_R8:
+  case GL_STENCIL_INDEX8:
+    return 1;
+  default:
+    return 4;
+  }
+}
+
+static uint64_t NullGLTextureKey(GLenum target) {
+  if (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X &&
+      target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z)
+    target = GL_TEXTURE_CUBE_MAP;
+  return ((uint64_t)s_NullGLActiveUnit << 32) | target;
+}
+
+static void NullGLSetTextureImage(GLenum target, int image, uint64_t bytes) {
+  GLuint texture = s_NullGLBoundTextures[NullGLTextureKey(target)];
+  if (texture == 0)
+    return;
+  auto &images = s_NullGLTexBytes[texture];
+  if (images.empty())
+    NullGL::s_Stats.textures++;
+  uint64_t &slot = images[image];
+  NullGL::s_Stats.textureBytes += bytes - slot;
+  slot = bytes;
+}
+
+static int NullGLImageIndex(GLenum target, GLint level) {
+  int face = 0;
+  if (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X &&
+      target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z)
+    face = (int)(target - GL_TEXTURE_CUBE_MAP_POSITIVE_X);
+  return level * 6 + face;
+}
+
+static void APIENTRY NullGLBindBuffer(GLenum target, GLuint buffer) {
+  s_NullGLBoundBuffers[target] = buffer;
+}
+
+static void APIENTRY NullGLBindBufferRange(GLenum target, GLuint,
+                                           GLuint buffer, GLintptr,
+                                           GLsizeiptr) {
+  s_NullGLBoundBuffers[target] = buffer;
+}
+
+static void APIENTRY NullGLBindBufferBase(GLenum target, GLuint,
+                                          GLuint buffer) {
+  s_NullGLBoundBuffers[target] = buffer;
+}
+
+static void APIENTRY NullGLBufferData(GLenum target, GLsizeiptr size,
+                                      const void *, GLenum) {
+  GLuint buffer = s_NullGLBoundBuffers[target];
+  if (buffer == 0)
+    return;
+  auto it = s_NullGLBufferBytes.find(buffer);
+  if (it == s_NullGLBufferBytes.end()) {
+    it = s_NullGLBufferBytes.emplace(buffer, 0).first;
+    NullGL::s_Stats.buffers++;
+  }
+  NullGL::s_Stats.bufferBytes += (uint64_t)size - it->second;
+  it->second = (uint64_t)size;
+}
+
+static void APIENTRY NullGLDeleteBuffers(GLsizei n, const GLuint *buffers) {
+  for (GLsizei i = 0; i < n; ++i) {
+    auto it = s_NullGLBufferBytes.find(buffers[i]);
+    if (it == s_NullGLBufferBytes.end())
+      continue;
+    NullGL::s_Stats.buffers--;
+    NullGL::s_Stats.bufferBytes -= it->second;
+    s_NullGLBufferBytes.erase(it);
+  }
+}
+
+static void APIENTRY NullGLActiveTexture(GLenum unit) {
+  s_NullGLActiveUnit = unit - GL_TEXTURE0;
+}
+
+static void APIENTRY NullGLBindTexture(GLenum target, GLuint texture) {
+  s_NullGLBoundTextures[NullGLTextureKey(target)] = texture;
+}
+
+static void APIENTRY NullGLTexImage2D(GLenum target, GLint level,
+                                      GLint internalFormat, GLsizei w,
+                                      GLsizei h, GLint, GLenum, GLenum,
+                                      const void *) {
+  NullGLSetTextureImage(target, NullGLImageIndex(target, level),
+                        (uint64_t)w * (uint64_t)h *
+                            NullGLBytesPerPixel((GLenum)internalFormat));
+}
+
+static void APIENTRY NullGLTexImage3D(GLenum target, GLint level,
+                                      GLint internalFormat, GLsizei w,
+                                      GLsizei h, GLsizei d, GLint, GLenum,
+                                      GLenum, const void *) {
+  NullGLSetTextureImage(target, NullGLImageIndex(target, level),
+                        (uint64_t)w * (uint64_t)h * (uint64_t)d *
+                            NullGLBytesPerPixel((GLenum)internalFormat));
+}
+
+static void APIENTRY NullGLTexImage2DMultisample(GLenum target,
+                                                 GLsizei samples,
+                                                 GLenum internalFormat,
+                                                 GLsizei w, GLsizei h,
+                                                 GLboolean) {
+  NullGLSetTextureImage(target, 0,
+                        (uint64_t)samples * (uint64_t)w * (uint64_t)h *
+                            NullGLBytesPerPixel(internalFormat));
+}
+
+// A full mip chain adds about a third of the base level.
+static void APIENTRY NullGLGenerateMipmap(GLenum target) {
+  GLuint texture = s_NullGLBoundTextures[NullGLTextureKey(target)];
+  auto it = s_NullGLTexBytes.find(texture);
+  if (it == s_NullGLTexBytes.end())
+    return;
+  uint64_t base = 0;
+  for (const auto &[image, bytes] : it->second)
+    if (image >= 0 && image < 6)
+      base += bytes;
+  NullGLSetTextureImage(target, -1, base / 3);
+}
+
+static void APIENTRY NullGLDeleteTextures(GLsizei n, const GLuint *textures) {
+  for (GLsizei i = 0; i < n; ++i) {
+    auto it = s_NullGLTexBytes.find(textures[i]);
+    if (it == s_NullGLTexBytes.end())
+      continue;
+    for (const auto &[image, bytes] : it->second)
+      NullGL::s_Stats.textureBytes -= bytes;
+    NullGL::s_Stats.textures--;
+    s_NullGLTexBytes.erase(it);
+  }
+}
+
+static void APIENTRY NullGLBindRenderbuffer(GLenum, GLuint renderbuffer) {
+  s_NullGLBoundRenderbuffer = renderbuffer;
+}
+
+static void NullGLSetRenderbufferBytes(uint64_t bytes) {
+  if (s_NullGLBoundRenderbuffer == 0)
+    return;
+  auto it = s_NullGLRenderbufferBytes.find(s_NullGLBoundRenderbuffer);
+  if (it == s_NullGLRenderbufferBytes.end()) {
+    it = s_NullGLRenderbufferBytes.emplace(s_NullGLBoundRenderbuffer, 0).first;
+    NullGL::s_Stats.renderbuffers++;
+  }
+  NullGL::s_Stats.renderbufferBytes += bytes - it->second;
+  it->second = bytes;
+}
+
+static void APIENTRY NullGLRenderbufferStorage(GLenum, GLenum format,
+                                               GLsizei w, GLsizei h) {
+  NullGLSetRenderbufferBytes((uint64_t)w * (uint64_t)h *
+                             NullGLBytesPerPixel(format));
+}
+
+static void APIENTRY NullGLRenderbufferStorageMultisample(GLenum,
+                                                          GLsizei samples,
+                                                          GLenum format,
+                                                          GLsizei w,
+                                                          GLsizei h) {
+  NullGLSetRenderbufferBytes((uint64_t)std::max(samples, 1) * (uint64_t)w *
+                             (uint64_t)h * NullGLBytesPerPixel(format));
+}
+
+static void APIENTRY NullGLDeleteRenderbuffers(GLsizei n,
+                                               const GLuint *renderbuffers) {
+  for (GLsizei i = 0; i < n; ++i) {
+    auto it = s_NullGLRenderbufferBytes.find(renderbuffers[i]);
+    if (it == s_NullGLRenderbufferBytes.end())
+      continue;
+    NullGL::s_Stats.renderbuffers--;
+    NullGL::s_Stats.renderbufferBytes -= it->second;
+    s_NullGLRenderbufferBytes.erase(it);
+  }
+}
+
+// Every entry point without a stub of its own. Returning zero covers the
+// handful that return a value (glIsEnabled, glGetUniformLocation, ...).
+static uintptr_t APIENTRY NullGLZero() { return 0; }
+
+static const GLubyte *APIENTRY NullGLGetString(GLenum name) {
+  switch (name) {
+  case GL_VERSION:
+    return (const GLubyte *)"3.3.0 Null";
+  case GL_SHADING_LANGUAGE_VERSION:
+    return (const GLubyte *)"3.30";
+  case GL_RENDERER:
+    return (const GLubyte *)"Null Device";
+  default:
+    return (const GLubyte *)"Calcium3D";
+  }
+}
+
+// glad refuses a GL 3 context that reports no extensions.
+static const GLubyte *APIENTRY NullGLGetStringi(GLenum, GLuint) {
+  return (const GLubyte *)"GL_C3D_null_device";
+}
+
+static void APIENTRY NullGLGenNames(GLsizei n, GLuint *names) {
+  for (GLsizei i = 0; i < n; ++i)
+    names[i] = s_NullGLNextName++;
+}
+
+static GLuint APIENTRY NullGLCreateShader(GLenum) { return s_NullGLNextName++; }
+static GLuint APIENTRY NullGLCreateProgram() { return s_NullGLNextName++; }
+
+static void APIENTRY NullGLViewport(GLint x, GLint y, GLsizei w, GLsizei h) {
+  s_NullGLViewport[0] = x;
+  s_NullGLViewport[1] = y;
+  s_NullGLViewport[2] = w;
+  s_NullGLViewport[3] = h;
+}
+
+static void APIENTRY NullGLGetIntegerv(GLenum pname, GLint *data) {
+  switch (pname) {
+  case GL_VIEWPORT:
+    std::memcpy(data, s_NullGLViewport, sizeof(s_NullGLViewport));
+    break;
+  case GL_POLYGON_MODE:
+    data[0] = data[1] = GL_FILL;
+    break;
+  case GL_NUM_EXTENSIONS:
+    data[0] = 1;
+    break;
+  default:
+    data[0] = 0;
+    break;
+  }
+}
+
+static void APIENTRY NullGLGetFloatv(GLenum, GLfloat *data) { data[0] = 0.0f; }
+static void APIENTRY NullGLGetBooleanv(GLenum, GLboolean *data) {
+  data[0] = GL_FALSE;
+}
+
+static void APIENTRY NullGLGetObjectiv(GLuint, GLenum pname, GLint *params) {
+  bool status = pname == GL_COMPILE_STATUS || pname == GL_LINK_STATUS ||
+                pname == GL_VALIDATE_STATUS;
+  *params = status ? GL_TRUE : 0;
+}
+
+static void APIENTRY NullGLGetInfoLog(GLuint, GLsizei bufSize,
+                                      GLsizei *length, GLchar *infoLog) {
+  if (length)
+    *length = 0;
+  if (infoLog && bufSize > 0)
+    infoLog[0] = '\0';
+}
+
+static void APIENTRY NullGLGetQueryObjectiv(GLuint, GLenum pname,
+                                            GLint *params) {
+  *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+
+static void APIENTRY NullGLGetQueryObjectui64v(GLuint, GLenum,
+                                               GLuint64 *params) {
+  *params = 0;
+}
+
+static GLenum APIENTRY NullGLCheckFramebufferStatus(GLenum) {
+  return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static GLsync APIENTRY NullGLFenceSync(GLenum, GLbitfield) {
+  return (GLsync)(uintptr_t)s_NullGLNextName++;
+}
+
+static GLenum APIENTRY NullGLClientWaitSync(GLsync, GLbitfield, GLuint64) {
+  return GL_ALREADY_SIGNALED;
+}
+
+static void *APIENTRY NullGLMapBufferRange(GLenum target, GLintptr,
+                                           GLsizeiptr length, GLbitfield) {
+  std::vector<uint8_t> &scratch = s_NullGLMapScratch[target];
+  if (scratch.size() < (size_t)length)
+    scratch.resize((size_t)length);
+  return scratch.data();
+}
+
+static GLboolean APIENTRY NullGLUnmapBuffer(GLenum) { return GL_TRUE; }
+
+static void APIENTRY NullGLDrawArrays(GLenum mode, GLint, GLsizei count) {
+  NullGLCountDraw(mode, count, 1);
+}
+
+static void APIENTRY NullGLDrawArraysInstanced(GLenum mode, GLint,
+                                               GLsizei count,
+                                               GLsizei instances) {
+  NullGLCountDraw(mode, count, instances);
+}
+
+static void APIENTRY NullGLDrawElements(GLenum mode, GLsizei count, GLenum,
+                                        const void *) {
+  NullGLCountDraw(mode, count, 1);
+}
+
+static void APIENTRY NullGLDrawElementsBaseVertex(GLenum mode, GLsizei count,
+                                                  GLenum, const void *,
+                                                  GLint) {
+  NullGLCountDraw(mode, count, 1);
+}
+
+static void APIENTRY NullGLDrawRangeElements(GLenum mode, GLuint, GLuint,
+                                             GLsizei count, GLenum,
+                                             const void *) {
+  NullGLCountDraw(mode, count, 1);
+}
+
+static void APIENTRY NullGLDrawElementsInstanced(GLenum mode, GLsizei count,
+                                                 GLenum, const void *,
+                                                 GLsizei instances) {
+  NullGLCountDraw(mode, count, instances);
+}
+
+static void APIENTRY NullGLDrawElementsInstancedBaseVertex(
+    GLenum mode, GLsizei count, GLenum, const void *, GLsizei instances,
+    GLint) {
+  NullGLCountDraw(mode, count, instances);
+}
+
+static void APIENTRY NullGLMultiDrawArrays(GLenum mode, const GLint *,
+                                           const GLsizei *counts,
+                                           GLsizei drawCount) {
+  for (GLsizei i = 0; i < drawCount; ++i)
+    NullGLCountDraw(mode, counts[i], 1);
+}
+
+static void APIENTRY NullGLMultiDrawElements(GLenum mode,
+                                             const GLsizei *counts, GLenum,
+                                             const void *const *,
+                                             GLsizei drawCount) {
+  for (GLsizei i = 0; i < drawCount; ++i)
+    NullGLCountDraw(mode, counts[i], 1);
+}
+
+static void APIENTRY NullGLMultiDrawElementsBaseVertex(
+    GLenum mode, const GLsizei *counts, GLenum, const void *const *,
+    GLsizei drawCount, const GLint *) {
+  for (GLsizei i = 0; i < drawCount; ++i)
+    NullGLCountDraw(mode, counts[i], 1);
+}
+
+static void *NullGLGetProcAddress(const char *name) {
+  struct Entry {
+    const char *name;
+    void *proc;
+  };
+  static const Entry entries[] = {
+      {"glGetString", (void *)&NullGLGetString},
+      {"glGetStringi", (void *)&NullGLGetStringi},
+      {"glGenBuffers", (void *)&NullGLGenNames},
+      {"glGenVertexArrays", (void *)&NullGLGenNames},
+      {"glGenTextures", (void *)&NullGLGenNames},
+      {"glGenFramebuffers", (void *)&NullGLGenNames},
+      {"glGenRenderbuffers", (void *)&NullGLGenNames},
+      {"glGenQueries", (void *)&NullGLGenNames},
+      {"glGenSamplers", (void *)&NullGLGenNames},
+      {"glCreateShader", (void *)&NullGLCreateShader},
+      {"glCreateProgram", (void *)&NullGLCreateProgram},
+      {"glBindBuffer", (void *)&NullGLBindBuffer},
+      {"glBindBufferRange", (void *)&NullGLBindBufferRange},
+      {"glBindBufferBase", (void *)&NullGLBindBufferBase},
+      {"glBufferData", (void *)&NullGLBufferData},
+      {"glDeleteBuffers", (void *)&NullGLDeleteBuffers},
+      {"glActiveTexture", (void *)&NullGLActiveTexture},
+      {"glBindTexture", (void *)&NullGLBindTexture},
+      {"glTexImage2D", (void *)&NullGLTexImage2D},
+      {"glTexImage3D", (void *)&NullGLTexImage3D},
+      {"glTexImage2DMultisample", (void *)&NullGLTexImage2DMultisample},
+      {"glGenerateMipmap", (void *)&NullGLGenerateMipmap},
+      {"glDeleteTextures", (void *)&NullGLDeleteTextures},
+      {"glBindRenderbuffer", (void *)&NullGLBindRenderbuffer},
+      {"glRenderbufferStorage", (void *)&NullGLRenderbufferStorage},
+      {"glRenderbufferStorageMultisample",
+       (void *)&NullGLRenderbufferStorageMultisample},
+      {"glDeleteRenderbuffers", (void *)&NullGLDeleteRenderbuffers},
+      {"glViewport", (void *)&NullGLViewport},
+      {"glGetIntegerv", (void *)&NullGLGetIntegerv},
+      {"glGetFloatv", (void *)&NullGLGetFloatv},
+      {"glGetBooleanv", (void *)&NullGLGetBooleanv},
+      {"glGetShaderiv", (void *)&NullGLGetObjectiv},
+      {"glGetProgramiv", (void *)&NullGLGetObjectiv},
+      {"glGetShaderInfoLog", (void *)&NullGLGetInfoLog},
+      {"glGetProgramInfoLog", (void *)&NullGLGetInfoLog},
+      {"glGetQueryObjectiv", (void *)&NullGLGetQueryObjectiv},
+      {"glGetQueryObjectuiv", (void *)&NullGLGetQueryObjectiv},
+      {"glGetQueryObjecti64v", (void *)&NullGLGetQueryObjectui64v},
+      {"glGetQueryObjectui64v", (void *)&NullGLGetQueryObjectui64v},
+      {"glCheckFramebufferStatus", (void *)&NullGLCheckFramebufferStatus},
+      {"glFenceSync", (void *)&NullGLFenceSync},
+      {"glClientWaitSync", (void *)&NullGLClientWaitSync},
+      {"glMapBufferRange", (void *)&NullGLMapBufferRange},
+      {"glUnmapBuffer", (void *)&NullGLUnmapBuffer},
+      {"glDrawArrays", (void *)&NullGLDrawArrays},
+      {"glDrawArraysInstanced", (void *)&NullGLDrawArraysInstanced},
+      {"glDrawElements", (void *)&NullGLDrawElements},
+      {"glDrawElementsBaseVertex", (void *)&NullGLDrawElementsBaseVertex},
+      {"glDrawRangeElements", (void *)&NullGLDrawRangeElements},
+      {"glDrawElementsInstanced", (void *)&NullGLDrawElementsInstanced},
+      {"glDrawElementsInstancedBaseVertex",
+       (void *)&NullGLDrawElementsInstancedBaseVertex},
+      {"glMultiDrawArrays", (void *)&NullGLMultiDrawArrays},
+      {"glMultiDrawElements", (void *)&NullGLMultiDrawElements},
+      {"glMultiDrawElementsBaseVertex",
+       (void *)&NullGLMultiDrawElementsBaseVertex},
+  };
+  for (const Entry &entry : entries) {
+    if (std::strcmp(entry.name, name) == 0)
+      return entry.proc;
+  }
+  return (void *)&NullGLZero;
+}
+
+bool NullGL::Load() {
+  if (!s_Loaded)
+    s_Loaded = gladLoadGLLoader(&NullGLGetProcAddress) != 0;
+  return s_Loaded;
+}
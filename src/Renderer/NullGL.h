@@ -0,0 +1,22 @@
+#pragma once
+#include "RenderDevice.h"
+
+// Loads glad with stubs instead of a driver, so the engine runs without a GPU
+// or a display. Calls that create objects hand out fresh names, queries
+// report success, buffer maps return scratch memory, and draws and the sizes
+// of buffer, texture and renderbuffer storage are counted. Nothing is
+// rendered. Use it through RenderDevice with RenderBackend::Null.
+class NullGL {
+public:
+  static bool Load();
+  static bool IsLoaded() { return s_Loaded; }
+  static void ResetFrameStats() {
+    s_Stats.drawCalls = 0;
+    s_Stats.triangles = 0;
+  }
+
+  static RenderDeviceStats s_Stats;
+
+private:
+  static bool s_Loaded;
+};
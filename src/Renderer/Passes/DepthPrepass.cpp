@@ -40,7 +40,7 @@ void DepthPrepass::Execute(const RenderContext &context) {
         true,  
         false, 
         context.autoLOD, false, context.staticBatching,
-        context.dynamicBatching);
+        context.dynamicBatching, context.primaryView);
   }
 
   glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE); 
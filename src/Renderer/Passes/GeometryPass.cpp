@@ -168,6 +168,13 @@ void GeometryPass::Execute(const RenderContext &context) {
 
     if (context.enableShadows) {
       activeShader->setMat4("lightSpaceMatrix", context.lightSpaceMatrix);
+      activeShader->setInt("shadowCascadeCount", context.activeShadowCascades);
+      for (int i = 0; i < context.activeShadowCascades; i++) {
+        std::string idx = "[" + std::to_string(i) + "]";
+        activeShader->setMat4("cascadeMatrices" + idx,
+                              context.cascadeMatrices[i]);
+        activeShader->setVec4("cascadeRects" + idx, context.cascadeRects[i]);
+      }
       glActiveTexture(GL_TEXTURE4);
       glBindTexture(GL_TEXTURE_2D, context.dirShadowMap);
       activeShader->setInt("dirShadowMap", 4);
@@ -201,7 +208,8 @@ void GeometryPass::Execute(const RenderContext &context) {
         context.deltaTime, context.time, 1, context.cullingCamera,
         context.objCulling, context.backfaceCulling,
         context.materialOptimisation, context.visualizeCulling, context.autoLOD,
-        context.zPrepass, context.staticBatching, context.dynamicBatching);
+        context.zPrepass, context.staticBatching, context.dynamicBatching,
+        context.primaryView);
 
     
     if (context.wireframe) {
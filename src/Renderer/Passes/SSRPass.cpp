@@ -2,6 +2,7 @@
 #include "../../Core/ResourceManager.h"
 #include "../../Environment/2dCloud.h"
 #include "../../Scene/Scene.h"
+#include "../BudgetGovernor.h"
 #include "../Camera.h"
 #include "../Frustum.h"
 #include "../Tools/Profiler/GpuProfiler.h"
@@ -251,8 +252,10 @@ void SSRPass::Execute(const RenderContext &context) {
   m_SSRShader->setMat4("invView", glm::inverse(view));
   m_SSRShader->setVec3("camPos", context.camera->Position);
 
-  m_SSRShader->setFloat("ssrResolution", context.ssrResolution);
-  m_SSRShader->setInt("ssrMaxSteps", context.ssrMaxSteps);
+  float ssrScale = BudgetGovernor::GetQuality().ssrScale;
+  m_SSRShader->setFloat("ssrResolution", context.ssrResolution * ssrScale);
+  m_SSRShader->setInt("ssrMaxSteps",
+                      std::max((int)(context.ssrMaxSteps * ssrScale), 1));
   m_SSRShader->setFloat("ssrMaxDistance", context.ssrMaxDistance);
   m_SSRShader->setFloat("ssrThickness", context.ssrThickness);
   m_SSRShader->setFloat("ssrRenderDistance", context.ssrRenderDistance);
@@ -1,15 +1,139 @@
 #include "ShadowPass.h"
 #include "../Tools/Profiler/GpuProfiler.h"
+#include "../Tools/Profiler/PerfCounters.h"
 #include "../Tools/Profiler/Profiler.h"
+#include "BudgetGovernor.h"
 #include "Camera.h"
 #include "Frustum.h"
 #include "Renderer.h"
 #include "ResourceManager.h"
 #include "Scene.h"
 #include <glad/glad.h>
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 
+static constexpr float POINT_SHADOW_NEAR = 0.5f;
+// How far behind a cascade (towards the sun) casters are still captured.
+static constexpr float DIR_SHADOW_CASTER_MARGIN = 50.0f;
+
+static void AllocateShadowMap2D(unsigned int tex, int width, int height) {
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0,
+               GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+}
+
+static unsigned int CreateShadowMap2D(int width, int height) {
+  unsigned int tex;
+  glGenTextures(1, &tex);
+  AllocateShadowMap2D(tex, width, height);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+  float borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+  glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+  return tex;
+}
+
+static void AllocateShadowCubemap(unsigned int tex, int res) {
+  glBindTexture(GL_TEXTURE_CUBE_MAP, tex);
+  for (unsigned int j = 0; j < 6; ++j) {
+    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + j, 0, GL_DEPTH_COMPONENT,
+                 res, res, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+  }
+}
+
+static unsigned int CreateShadowCubemap(int res) {
+  unsigned int tex;
+  glGenTextures(1, &tex);
+  AllocateShadowCubemap(tex, res);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  return tex;
+}
+
+// Atlas tile of a cascade as (offset.xy, scale.zw) in texture space.
+static glm::vec4 CascadeRect(int index, int cols, int rows) {
+  return glm::vec4(float(index % cols) / cols, float(index / cols) / rows,
+                   1.0f / cols, 1.0f / rows);
+}
+
+// Maps light clip space onto one atlas tile, so shaders that only know
+// lightSpaceMatrix still sample the first cascade.
+static glm::mat4 AtlasTileMatrix(const glm::vec4 &rect) {
+  glm::mat4 m(1.0f);
+  m[0][0] = rect.z;
+  m[1][1] = rect.w;
+  m[3][0] = rect.x * 2.0f + rect.z - 1.0f;
+  m[3][1] = rect.y * 2.0f + rect.w - 1.0f;
+  return m;
+}
+
+// Light matrix covering the camera slice [splitNear, splitFar]. The slice is
+// wrapped in a sphere so the projection keeps its size while the camera
+// turns, and the centre is snapped to whole texels so edges do not shimmer
+// while it moves.
+static glm::mat4 FitCascade(const Camera &camera, float splitNear,
+                            float splitFar, const glm::vec3 &lightDir,
+                            int res) {
+  glm::vec3 forward = glm::normalize(camera.Orientation);
+  glm::vec3 right = glm::normalize(glm::cross(forward, camera.Up));
+  glm::vec3 up = glm::cross(right, forward);
+  float aspect =
+      camera.height > 0 ? (float)camera.width / camera.height : 1.0f;
+  float tanY = std::tan(glm::radians(camera.FOV) * 0.5f);
+  float tanX = tanY * aspect;
+
+  glm::vec3 corners[8];
+  glm::vec3 center(0.0f);
+  for (int i = 0; i < 8; i++) {
+    float d = (i & 4) ? splitFar : splitNear;
+    float sx = (i & 1) ? tanX : -tanX;
+    float sy = (i & 2) ? tanY : -tanY;
+    corners[i] = camera.Position + (forward + right * sx + up * sy) * d;
+    center += corners[i];
+  }
+  center /= 8.0f;
+
+  float radius = 0.0f;
+  for (int i = 0; i < 8; i++)
+    radius = glm::max(radius, glm::distance(corners[i], center));
+  radius = std::ceil(radius * 16.0f) / 16.0f;
+
+  glm::vec3 worldUp = std::abs(lightDir.y) > 0.99f ? glm::vec3(0, 0, 1)
+                                                   : glm::vec3(0, 1, 0);
+  glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), -lightDir, worldUp);
+  float texel = 2.0f * radius / res;
+  glm::vec3 snapped = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+  snapped.x = std::floor(snapped.x / texel) * texel;
+  snapped.y = std::floor(snapped.y / texel) * texel;
+  center = glm::vec3(glm::inverse(lightRotation) * glm::vec4(snapped, 1.0f));
+
+  float back = radius + DIR_SHADOW_CASTER_MARGIN;
+  glm::mat4 lightView =
+      glm::lookAt(center + lightDir * back, center, worldUp);
+  glm::mat4 lightProjection =
+      glm::ortho(-radius, radius, -radius, radius, 0.0f, back + radius);
+  return lightProjection * lightView;
+}
+
+static unsigned int CreateDepthOnlyFBO(unsigned int depthTex) {
+  unsigned int fbo;
+  glGenFramebuffers(1, &fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  if (depthTex)
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+                           depthTex, 0);
+  glDrawBuffer(GL_NONE);
+  glReadBuffer(GL_NONE);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  return fbo;
+}
+
 ShadowPass::ShadowPass() { m_Name = "ShadowPass"; }
 
 ShadowPass::~ShadowPass() {
@@ -17,51 +141,280 @@ ShadowPass::~ShadowPass() {
     glDeleteFramebuffers(1, &m_DirShadowFBO);
   if (m_DirShadowMap)
     glDeleteTextures(1, &m_DirShadowMap);
+  if (m_DirStaticFBO)
+    glDeleteFramebuffers(1, &m_DirStaticFBO);
+  if (m_DirStaticMap)
+    glDeleteTextures(1, &m_DirStaticMap);
 
   if (m_PointShadowFBO)
     glDeleteFramebuffers(1, &m_PointShadowFBO);
+  if (m_CopyReadFBO)
+    glDeleteFramebuffers(1, &m_CopyReadFBO);
+  if (m_CopyDrawFBO)
+    glDeleteFramebuffers(1, &m_CopyDrawFBO);
   for (int i = 0; i < 4; i++) {
     if (m_PointShadowMaps[i])
       glDeleteTextures(1, &m_PointShadowMaps[i]);
+    if (m_PointStaticMaps[i])
+      glDeleteTextures(1, &m_PointStaticMaps[i]);
   }
 }
 
 void ShadowPass::Init() {
+  m_DirShadowMap = CreateShadowMap2D(m_DirShadowRes, m_DirShadowRes);
+  m_DirShadowFBO = CreateDepthOnlyFBO(m_DirShadowMap);
+  m_DirStaticMap = CreateShadowMap2D(m_DirShadowRes, m_DirShadowRes);
+  m_DirStaticFBO = CreateDepthOnlyFBO(m_DirStaticMap);
+
+  m_PointShadowFBO = CreateDepthOnlyFBO(0);
+  m_CopyReadFBO = CreateDepthOnlyFBO(0);
+  m_CopyDrawFBO = CreateDepthOnlyFBO(0);
+  for (int i = 0; i < 4; i++) {
+    m_PointShadowMaps[i] = CreateShadowCubemap(m_PointShadowRes);
+    m_PointStaticMaps[i] = CreateShadowCubemap(m_PointShadowRes);
+  }
+}
 
-  glGenFramebuffers(1, &m_DirShadowFBO);
-  glGenTextures(1, &m_DirShadowMap);
-  glBindTexture(GL_TEXTURE_2D, m_DirShadowMap);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, m_DirShadowRes,
-               m_DirShadowRes, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-  float borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-  glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+void ShadowPass::UpdateCasters(const RenderContext &context) {
+  PROFILE_SCOPE("ShadowCasters");
+  const auto &objects = context.scene->GetObjects();
+  size_t count = objects.size();
+  m_CasterMatrices.resize(count);
+  m_CasterMin.resize(count);
+  m_CasterMax.resize(count);
+  m_CasterTypes.assign(count, CasterNone);
+
+  uint64_t signature = 1469598103934665603ull;
+  auto mix = [&signature](const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      signature ^= bytes[i];
+      signature *= 1099511628211ull;
+    }
+  };
+
+  for (size_t idx = 0; idx < count; ++idx) {
+    const auto &obj = objects[idx];
+    if (!obj.isActive || obj.meshType == MeshType::Camera ||
+        obj.mesh.indexCount == 0)
+      continue;
+
+    glm::mat4 finalM = glm::scale(context.scene->GetGlobalTransform(idx),
+                                  glm::vec3(context.globalTilingFactor));
+    m_CasterMatrices[idx] = finalM;
+
+    const glm::vec3 &mn = obj.mesh.minAABB;
+    const glm::vec3 &mx = obj.mesh.maxAABB;
+    glm::vec3 corners[8] = {{mn.x, mn.y, mn.z}, {mx.x, mn.y, mn.z},
+                            {mn.x, mx.y, mn.z}, {mx.x, mx.y, mn.z},
+                            {mn.x, mn.y, mx.z}, {mx.x, mn.y, mx.z},
+                            {mn.x, mx.y, mx.z}, {mx.x, mx.y, mx.z}};
+    glm::vec3 worldMin(1e30f), worldMax(-1e30f);
+    for (int c = 0; c < 8; c++) {
+      glm::vec3 wc = glm::vec3(finalM * glm::vec4(corners[c], 1.0f));
+      worldMin = glm::min(worldMin, wc);
+      worldMax = glm::max(worldMax, wc);
+    }
+    m_CasterMin[idx] = worldMin;
+    m_CasterMax[idx] = worldMax;
+
+    if (obj.isStatic) {
+      m_CasterTypes[idx] = CasterStatic;
+      GLuint vao = obj.mesh.vao.ID;
+      GLsizei indexCount = obj.mesh.indexCount;
+      mix(&idx, sizeof(idx));
+      mix(&finalM, sizeof(finalM));
+      mix(&vao, sizeof(vao));
+      mix(&indexCount, sizeof(indexCount));
+    } else {
+      m_CasterTypes[idx] = CasterDynamic;
+    }
+  }
+  m_StaticSignature = signature;
+}
 
-  glBindFramebuffer(GL_FRAMEBUFFER, m_DirShadowFBO);
-  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
-                         m_DirShadowMap, 0);
-  glDrawBuffer(GL_NONE);
-  glReadBuffer(GL_NONE);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+void ShadowPass::DrawDirCasters(const RenderContext &context, Shader &shader,
+                                const Frustum *frustum, CasterType type) {
+  const auto &objects = context.scene->GetObjects();
+  for (size_t idx = 0; idx < objects.size(); ++idx) {
+    if (m_CasterTypes[idx] != type)
+      continue;
+    if (frustum && !frustum->IsOnFrustum(m_CasterMin[idx], m_CasterMax[idx])) {
+      PERF_COUNT(PerfCounter::ShadowCastersCulled, 1);
+      continue;
+    }
 
-  glGenFramebuffers(1, &m_PointShadowFBO);
-  for (int i = 0; i < 4; i++) {
-    glGenTextures(1, &m_PointShadowMaps[i]);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_PointShadowMaps[i]);
-    for (unsigned int j = 0; j < 6; ++j) {
-      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + j, 0, GL_DEPTH_COMPONENT,
-                   m_PointShadowRes, m_PointShadowRes, 0, GL_DEPTH_COMPONENT,
-                   GL_FLOAT, NULL);
+    const auto &obj = objects[idx];
+    shader.setMat4("model", m_CasterMatrices[idx]);
+    obj.mesh.vao.Bind();
+    glDrawElements(GL_TRIANGLES, obj.mesh.indexCount, GL_UNSIGNED_INT, 0);
+    obj.mesh.vao.Unbind();
+  }
+}
+
+int ShadowPass::PointFaceMask(size_t idx, const glm::vec3 &lightPos, float far,
+                              const Frustum *faces) const {
+  glm::vec3 d = glm::max(glm::max(m_CasterMin[idx] - lightPos,
+                                  lightPos - m_CasterMax[idx]),
+                         glm::vec3(0.0f));
+  if (glm::dot(d, d) > far * far)
+    return 0;
+
+  int mask = 0;
+  for (int j = 0; j < 6; ++j) {
+    if (faces[j].IsOnFrustum(m_CasterMin[idx], m_CasterMax[idx]))
+      mask |= 1 << j;
+  }
+  return mask;
+}
+
+void ShadowPass::DrawPointCasters(const RenderContext &context, Shader &shader,
+                                  const glm::vec3 &lightPos, float far,
+                                  const Frustum *faces, CasterType type) {
+  const auto &objects = context.scene->GetObjects();
+  for (size_t idx = 0; idx < objects.size(); ++idx) {
+    if (m_CasterTypes[idx] != type)
+      continue;
+    int mask = PointFaceMask(idx, lightPos, far, faces);
+    if (mask == 0)
+      continue;
+
+    const auto &obj = objects[idx];
+    shader.setInt("skipFaceMask", ~mask & 63);
+    shader.setMat4("model", m_CasterMatrices[idx]);
+    obj.mesh.vao.Bind();
+    glDrawElements(GL_TRIANGLES, obj.mesh.indexCount, GL_UNSIGNED_INT, 0);
+    obj.mesh.vao.Unbind();
+  }
+  shader.setInt("skipFaceMask", 0);
+}
+
+void ShadowPass::CopyCubemap(unsigned int src, unsigned int dst, int res) {
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_CopyReadFBO);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_CopyDrawFBO);
+  for (unsigned int j = 0; j < 6; ++j) {
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                           GL_TEXTURE_CUBE_MAP_POSITIVE_X + j, src, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                           GL_TEXTURE_CUBE_MAP_POSITIVE_X + j, dst, 0);
+    glBlitFramebuffer(0, 0, res, res, 0, 0, res, res, GL_DEPTH_BUFFER_BIT,
+                      GL_NEAREST);
+  }
+}
+
+void ShadowPass::RenderCascade(const RenderContext &context, Shader &shader,
+                               int index, const glm::mat4 &matrix) {
+  ShadowCascade &cascade = m_Cascades[index];
+  int res = m_DirShadowRes;
+  int x = (index % m_AtlasCols) * res;
+  int y = (index / m_AtlasCols) * res;
+  glViewport(x, y, res, res);
+  glScissor(x, y, res, res);
+  shader.setMat4("lightSpaceMatrix", matrix);
+
+  Frustum cascadeFrustum = Frustum::CreateFrustumFromCamera(matrix);
+  const Frustum *cullFrustum =
+      context.shadowCulling ? &cascadeFrustum : nullptr;
+
+  if (!context.shadowCaching) {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_DirShadowFBO);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    DrawDirCasters(context, shader, cullFrustum, CasterStatic);
+    DrawDirCasters(context, shader, cullFrustum, CasterDynamic);
+    cascade.staticValid = false;
+    cascade.liveIsStatic = false;
+  } else {
+    bool staticDirty = !cascade.staticValid ||
+                       cascade.staticMatrix != matrix ||
+                       cascade.staticSignature != m_StaticSignature;
+    if (staticDirty) {
+      PROFILE_SCOPE("DirShadowStaticRefresh");
+      glBindFramebuffer(GL_FRAMEBUFFER, m_DirStaticFBO);
+      glClear(GL_DEPTH_BUFFER_BIT);
+      DrawDirCasters(context, shader, cullFrustum, CasterStatic);
+      cascade.staticMatrix = matrix;
+      cascade.staticSignature = m_StaticSignature;
+      cascade.staticValid = true;
+      cascade.liveIsStatic = false;
+    }
+
+    bool hasDynamic = false;
+    for (size_t idx = 0; idx < m_CasterTypes.size() && !hasDynamic; ++idx) {
+      hasDynamic = m_CasterTypes[idx] == CasterDynamic &&
+                   (!cullFrustum || cullFrustum->IsOnFrustum(
+                                        m_CasterMin[idx], m_CasterMax[idx]));
+    }
+
+    // With no dynamic casters the live tile already equals the cache.
+    if (!cascade.liveIsStatic || hasDynamic) {
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, m_DirStaticFBO);
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_DirShadowFBO);
+      glBlitFramebuffer(x, y, x + res, y + res, x, y, x + res, y + res,
+                        GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+      glBindFramebuffer(GL_FRAMEBUFFER, m_DirShadowFBO);
+      DrawDirCasters(context, shader, cullFrustum, CasterDynamic);
+      cascade.liveIsStatic = !hasDynamic;
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
   }
+  cascade.matrix = matrix;
+  cascade.valid = true;
+}
+
+void ShadowPass::UpdateCascades(const RenderContext &context) {
+  int count = glm::clamp(context.shadowCascadeCount, 1, MAX_SHADOW_CASCADES);
+  int res = glm::clamp(context.dirShadowResolution, 256, 4096);
+  if (count != m_CascadeCount || res != m_DirShadowRes) {
+    m_CascadeCount = count;
+    m_DirShadowRes = res;
+    // Tiles sit in one strip up to three cascades and 2x2 for four, so no
+    // tile is allocated without a cascade to fill it.
+    m_AtlasCols = count <= 3 ? count : 2;
+    m_AtlasRows = (count + m_AtlasCols - 1) / m_AtlasCols;
+    AllocateShadowMap2D(m_DirShadowMap, res * m_AtlasCols, res * m_AtlasRows);
+    AllocateShadowMap2D(m_DirStaticMap, res * m_AtlasCols, res * m_AtlasRows);
+    for (auto &cascade : m_Cascades)
+      cascade = ShadowCascade();
+  }
+
+  const Camera &camera = *context.camera;
+  glm::vec3 lightDir = context.sunPosition;
+  if (glm::length(lightDir) < 1.0f)
+    lightDir = glm::vec3(0, 100, 0);
+  lightDir = glm::normalize(lightDir);
+
+  float zNear = glm::max(camera.nearPlane, 0.01f);
+  float zFar = glm::max(glm::min(context.shadowDistance, camera.farPlane),
+                        zNear + 1.0f);
+  float lambda = glm::clamp(context.shadowCascadeSplitLambda, 0.0f, 1.0f);
+  int interval =
+      BudgetGovernor::ScaleShadowInterval(context.cascadeUpdateInterval);
+
+  Shader &shadowShader = ResourceManager::GetShader("shadow");
+  shadowShader.use();
+  glEnable(GL_SCISSOR_TEST);
+
+  float splitNear = zNear;
+  for (int i = 0; i < count; ++i) {
+    float p = float(i + 1) / count;
+    float logSplit = zNear * std::pow(zFar / zNear, p);
+    float uniformSplit = zNear + (zFar - zNear) * p;
+    float splitFar = glm::mix(uniformSplit, logSplit, lambda);
+
+    // Far cascades are spread over the interval instead of all landing on
+    // the same frame; the first one always follows the camera.
+    ShadowCascade &cascade = m_Cascades[i];
+    bool due = i == 0 || !cascade.valid || cascade.splitFar != splitFar ||
+               (m_FrameIndex + i) % interval == 0;
+    if (due) {
+      RenderCascade(context, shadowShader, i,
+                    FitCascade(camera, splitNear, splitFar, lightDir, res));
+      cascade.splitFar = splitFar;
+    }
+    splitNear = splitFar;
+  }
+
+  glDisable(GL_SCISSOR_TEST);
+  m_FrameIndex++;
 }
 
 void ShadowPass::Execute(const RenderContext &context) {
@@ -79,79 +432,23 @@ void ShadowPass::Execute(const RenderContext &context) {
     return;
   }
 
+  UpdateCasters(context);
   glEnable(GL_DEPTH_TEST);
 
-  if (context.enableShadows && context.sunEnabled) {
+  if (context.enableShadows && context.sunEnabled && context.camera) {
     PROFILE_SCOPE("DirShadows");
-    glViewport(0, 0, m_DirShadowRes, m_DirShadowRes);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_DirShadowFBO);
-    glClear(GL_DEPTH_BUFFER_BIT);
     glCullFace(GL_FRONT);
     glEnable(GL_CULL_FACE);
+    UpdateCascades(context);
 
-    glm::vec3 lightPos = context.sunPosition;
-    if (glm::length(lightPos) < 1.0f)
-      lightPos = glm::vec3(0, 100, 0);
-
-    float orthoSize = 25.0f;
-    glm::mat4 lightProjection =
-        glm::ortho(-orthoSize, orthoSize, -orthoSize, orthoSize, 1.0f, 100.0f);
-
-    glm::vec3 target =
-        context.camera ? context.camera->Position : glm::vec3(0.0f);
-    glm::mat4 lightView = glm::lookAt(target + normalize(lightPos) * 30.0f,
-                                      target, glm::vec3(0.0, 1.0, 0.0));
-
-    context.lightSpaceMatrix = lightProjection * lightView;
-
-    Shader &shadowShader = ResourceManager::GetShader("shadow");
-    shadowShader.use();
-    shadowShader.setMat4("lightSpaceMatrix", context.lightSpaceMatrix);
-
-    auto &dirObjects = context.scene->GetObjects();
-    for (size_t idx = 0; idx < dirObjects.size(); ++idx) {
-      const auto &obj = dirObjects[idx];
-      if (!obj.isActive || obj.meshType == MeshType::Camera)
-        continue;
-
-      glm::mat4 model = context.scene->GetGlobalTransform(idx);
-
-      if (context.shadowCulling) {
-        
-        Frustum lightFrustum =
-            Frustum::CreateFrustumFromCamera(context.lightSpaceMatrix);
-
-        
-        glm::vec3 corners[8] = {
-            {obj.mesh.minAABB.x, obj.mesh.minAABB.y, obj.mesh.minAABB.z},
-            {obj.mesh.maxAABB.x, obj.mesh.minAABB.y, obj.mesh.minAABB.z},
-            {obj.mesh.minAABB.x, obj.mesh.maxAABB.y, obj.mesh.minAABB.z},
-            {obj.mesh.maxAABB.x, obj.mesh.maxAABB.y, obj.mesh.minAABB.z},
-            {obj.mesh.minAABB.x, obj.mesh.minAABB.y, obj.mesh.maxAABB.z},
-            {obj.mesh.maxAABB.x, obj.mesh.minAABB.y, obj.mesh.maxAABB.z},
-            {obj.mesh.minAABB.x, obj.mesh.maxAABB.y, obj.mesh.maxAABB.z},
-            {obj.mesh.maxAABB.x, obj.mesh.maxAABB.y, obj.mesh.maxAABB.z}};
-
-        glm::vec3 worldMin(1e30f), worldMax(-1e30f);
-        glm::mat4 finalM =
-            glm::scale(model, glm::vec3(context.globalTilingFactor));
-
-        for (int c = 0; c < 8; c++) {
-          glm::vec3 wc = glm::vec3(finalM * glm::vec4(corners[c], 1.0f));
-          worldMin = glm::min(worldMin, wc);
-          worldMax = glm::max(worldMax, wc);
-        }
-
-        if (!lightFrustum.IsOnFrustum(worldMin, worldMax))
-          continue;
-      }
-
-      shadowShader.setMat4(
-          "model", glm::scale(model, glm::vec3(context.globalTilingFactor)));
-      obj.mesh.vao.Bind();
-      glDrawElements(GL_TRIANGLES, obj.mesh.indices.size(), GL_UNSIGNED_INT, 0);
-      obj.mesh.vao.Unbind();
+    for (int i = 0; i < m_CascadeCount; ++i) {
+      context.cascadeMatrices[i] = m_Cascades[i].matrix;
+      context.cascadeRects[i] = CascadeRect(i, m_AtlasCols, m_AtlasRows);
+      context.cascadeSplits[i] = m_Cascades[i].splitFar;
     }
+    context.activeShadowCascades = m_CascadeCount;
+    context.lightSpaceMatrix =
+        AtlasTileMatrix(context.cascadeRects[0]) * context.cascadeMatrices[0];
   }
 
   if (context.enablePointShadows) {
@@ -161,8 +458,18 @@ void ShadowPass::Execute(const RenderContext &context) {
     Shader &pointShadowShader = ResourceManager::GetShader("point_shadow");
 
     int shadowCasters = 0;
+    int staticRefreshes = 0;
+    const int refreshBudget = BudgetGovernor::ScalePointShadowBudget(
+        context.pointShadowRefreshBudget);
     const auto &pointLights = context.scene->GetPointLights();
 
+    Frustum camFrustum;
+    if (context.lightCulling && context.camera) {
+      camFrustum = Frustum::CreateFrustumFromCamera(
+          context.camera->GetProjectionMatrix() *
+          context.camera->GetViewMatrix());
+    }
+
     for (const auto &light : pointLights) {
       if (!light.enabled || !light.castShadows)
         continue;
@@ -171,20 +478,13 @@ void ShadowPass::Execute(const RenderContext &context) {
 
       float far = context.pointShadowFarPlane;
 
-      
       if (context.lightCulling && context.camera) {
-        Frustum camFrustum = Frustum::CreateFrustumFromCamera(
-            context.camera->GetProjectionMatrix() *
-            context.camera->GetViewMatrix());
-
-        
         if (!camFrustum.IsSphereOnFrustum(light.position, far)) {
-          shadowCasters++; 
+          shadowCasters++;
           continue;
         }
       }
 
-      
       int targetRes = m_PointShadowRes;
       if (context.adaptiveShadowRes && context.camera) {
         float dist = glm::distance(light.position, context.camera->Position);
@@ -195,26 +495,17 @@ void ShadowPass::Execute(const RenderContext &context) {
       }
       targetRes = glm::max(targetRes, 32);
 
-      
-      if (targetRes != m_CurrentPointShadowRes[shadowCasters]) {
-        glBindTexture(GL_TEXTURE_CUBE_MAP, m_PointShadowMaps[shadowCasters]);
-        for (unsigned int j = 0; j < 6; ++j) {
-          glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + j, 0,
-                       GL_DEPTH_COMPONENT, targetRes, targetRes, 0,
-                       GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-        }
-        m_CurrentPointShadowRes[shadowCasters] = targetRes;
+      int slot = shadowCasters;
+      PointShadowCache &cache = m_PointCache[slot];
+      if (targetRes != m_CurrentPointShadowRes[slot]) {
+        AllocateShadowCubemap(m_PointShadowMaps[slot], targetRes);
+        AllocateShadowCubemap(m_PointStaticMaps[slot], targetRes);
+        m_CurrentPointShadowRes[slot] = targetRes;
+        cache.valid = false;
       }
 
-      glViewport(0, 0, targetRes, targetRes);
-      glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-                           m_PointShadowMaps[shadowCasters], 0);
-      glClear(GL_DEPTH_BUFFER_BIT);
-
-      float aspect = 1.0f;
-      float near = 0.5f;
-      glm::mat4 shadowProj =
-          glm::perspective(glm::radians(90.0f), aspect, near, far);
+      glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), 1.0f,
+                                              POINT_SHADOW_NEAR, far);
 
       glm::mat4 shadowTransforms[6] = {
           shadowProj * glm::lookAt(light.position,
@@ -236,47 +527,72 @@ void ShadowPass::Execute(const RenderContext &context) {
                                    light.position + glm::vec3(0.0, 0.0, -1.0),
                                    glm::vec3(0.0, -1.0, 0.0))};
 
+      Frustum faces[6];
+      for (int j = 0; j < 6; ++j)
+        faces[j] = Frustum::CreateFrustumFromCamera(shadowTransforms[j]);
+
       pointShadowShader.use();
       for (int j = 0; j < 6; ++j)
         pointShadowShader.setMat4("shadowMatrices[" + std::to_string(j) + "]",
                                   shadowTransforms[j]);
       pointShadowShader.setVec3("lightPos", light.position);
       pointShadowShader.setFloat("far_plane", far);
+      glViewport(0, 0, targetRes, targetRes);
 
-      
-      auto &ptObjects = context.scene->GetObjects();
-      for (size_t idx = 0; idx < ptObjects.size(); ++idx) {
-        const auto &obj = ptObjects[idx];
-        if (!obj.isActive || obj.meshType == MeshType::Camera)
-          continue;
+      if (!context.shadowCaching) {
+        glBindFramebuffer(GL_FRAMEBUFFER, m_PointShadowFBO);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                             m_PointShadowMaps[slot], 0);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        DrawPointCasters(context, pointShadowShader, light.position, far,
+                         faces, CasterStatic);
+        DrawPointCasters(context, pointShadowShader, light.position, far,
+                         faces, CasterDynamic);
+        cache.valid = false;
+        cache.liveIsStatic = false;
+        shadowCasters++;
+        continue;
+      }
 
-        glm::mat4 model = context.scene->GetGlobalTransform(idx);
-        glm::mat4 finalM =
-            glm::scale(model, glm::vec3(context.globalTilingFactor));
-
-        if (context.shadowCulling) {
-          
-          glm::vec3 objCenter = glm::vec3(
-              finalM *
-              glm::vec4((obj.mesh.minAABB + obj.mesh.maxAABB) * 0.5f, 1.0f));
-          float objRadius =
-              glm::length(obj.mesh.maxAABB - obj.mesh.minAABB) * 0.5f;
-          
-          float maxScale =
-              glm::max(glm::length(glm::vec3(finalM[0])),
-                       glm::max(glm::length(glm::vec3(finalM[1])),
-                                glm::length(glm::vec3(finalM[2]))));
-          objRadius *= maxScale;
-
-          if (glm::distance(light.position, objCenter) > far + objRadius)
-            continue;
-        }
+      bool staticDirty = !cache.valid || cache.position != light.position ||
+                         cache.farPlane != far ||
+                         cache.resolution != targetRes ||
+                         cache.signature != m_StaticSignature;
+      // Over budget, a stale cache keeps being used until a later frame.
+      if (staticDirty &&
+          (!cache.valid ||
+           staticRefreshes < refreshBudget)) {
+        PROFILE_SCOPE("PointShadowStaticRefresh");
+        glBindFramebuffer(GL_FRAMEBUFFER, m_PointShadowFBO);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                             m_PointStaticMaps[slot], 0);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        DrawPointCasters(context, pointShadowShader, light.position, far,
+                         faces, CasterStatic);
+        cache.position = light.position;
+        cache.farPlane = far;
+        cache.resolution = targetRes;
+        cache.signature = m_StaticSignature;
+        cache.valid = true;
+        cache.liveIsStatic = false;
+        staticRefreshes++;
+      }
+
+      bool hasDynamic = false;
+      for (size_t idx = 0; idx < m_CasterTypes.size() && !hasDynamic; ++idx) {
+        hasDynamic = m_CasterTypes[idx] == CasterDynamic &&
+                     PointFaceMask(idx, light.position, far, faces) != 0;
+      }
 
-        pointShadowShader.setMat4("model", finalM);
-        obj.mesh.vao.Bind();
-        glDrawElements(GL_TRIANGLES, obj.mesh.indices.size(), GL_UNSIGNED_INT,
-                       0);
-        obj.mesh.vao.Unbind();
+      if (!cache.liveIsStatic || hasDynamic) {
+        CopyCubemap(m_PointStaticMaps[slot], m_PointShadowMaps[slot],
+                    targetRes);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_PointShadowFBO);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                             m_PointShadowMaps[slot], 0);
+        DrawPointCasters(context, pointShadowShader, light.position, far,
+                         faces, CasterDynamic);
+        cache.liveIsStatic = !hasDynamic;
       }
       shadowCasters++;
     }
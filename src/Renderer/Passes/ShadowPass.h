@@ -1,6 +1,12 @@
 #pragma once
 
 #include "RenderPass.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+class Shader;
+struct Frustum;
 
 class ShadowPass : public RenderPass {
 public:
@@ -12,12 +18,72 @@ public:
   void Resize(int width, int height) override;
 
 private:
+  enum CasterType : uint8_t { CasterNone = 0, CasterStatic, CasterDynamic };
+
+  // Static-only depth for one point light slot, re-rendered when the key
+  // (light placement, resolution or static caster set) changes.
+  struct PointShadowCache {
+    glm::vec3 position = glm::vec3(0.0f);
+    float farPlane = 0.0f;
+    int resolution = 0;
+    uint64_t signature = 0;
+    bool valid = false;
+    bool liveIsStatic = false;
+  };
+
+  // One tile of the sun shadow atlas. The matrix is only replaced when the
+  // cascade is re-rendered, so skipped cascades stay consistent with the
+  // depth they hold.
+  struct ShadowCascade {
+    glm::mat4 matrix = glm::mat4(1.0f);
+    glm::mat4 staticMatrix = glm::mat4(0.0f);
+    uint64_t staticSignature = 0;
+    float splitFar = 0.0f;
+    bool valid = false;
+    bool staticValid = false;
+    bool liveIsStatic = false;
+  };
+
+  void UpdateCasters(const RenderContext &context);
+  void UpdateCascades(const RenderContext &context);
+  void RenderCascade(const RenderContext &context, Shader &shader, int index,
+                     const glm::mat4 &matrix);
+  void DrawDirCasters(const RenderContext &context, Shader &shader,
+                      const Frustum *frustum, CasterType type);
+  void DrawPointCasters(const RenderContext &context, Shader &shader,
+                        const glm::vec3 &lightPos, float far,
+                        const Frustum *faces, CasterType type);
+  int PointFaceMask(size_t idx, const glm::vec3 &lightPos, float far,
+                    const Frustum *faces) const;
+  void CopyCubemap(unsigned int src, unsigned int dst, int res);
+
   unsigned int m_DirShadowFBO = 0;
   unsigned int m_DirShadowMap = 0;
-  int m_DirShadowRes = 2048;
+  int m_DirShadowRes = 1024;
+  int m_CascadeCount = 0;
+  int m_AtlasCols = 1;
+  int m_AtlasRows = 1;
+
+  unsigned int m_DirStaticFBO = 0;
+  unsigned int m_DirStaticMap = 0;
+  ShadowCascade m_Cascades[MAX_SHADOW_CASCADES];
+  uint64_t m_FrameIndex = 0;
 
   unsigned int m_PointShadowFBO = 0;
   unsigned int m_PointShadowMaps[4] = {0};
   int m_PointShadowRes = 1024;
   int m_CurrentPointShadowRes[4] = {1024, 1024, 1024, 1024};
+
+  unsigned int m_PointStaticMaps[4] = {0};
+  PointShadowCache m_PointCache[4];
+  unsigned int m_CopyReadFBO = 0;
+  unsigned int m_CopyDrawFBO = 0;
+
+  // World matrices and bounds for every caster, computed once per frame and
+  // shared by the directional pass and every cubemap face.
+  std::vector<glm::mat4> m_CasterMatrices;
+  std::vector<glm::vec3> m_CasterMin;
+  std::vector<glm::vec3> m_CasterMax;
+  std::vector<uint8_t> m_CasterTypes;
+  uint64_t m_StaticSignature = 0;
 };
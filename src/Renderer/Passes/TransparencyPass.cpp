@@ -251,7 +251,8 @@ void TransparencyPass::Execute(const RenderContext &context) {
         context.globalTilingFactor, context.renderEditorObjects,
         context.deltaTime, context.time, 2, nullptr, context.objCulling, false,
         context.materialOptimisation, context.visualizeCulling, context.autoLOD,
-        context.zPrepass, context.staticBatching, context.dynamicBatching);
+        context.zPrepass, context.staticBatching, context.dynamicBatching,
+        context.primaryView);
   }
 
   glDisable(GL_BLEND);
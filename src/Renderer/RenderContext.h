@@ -32,15 +32,35 @@ struct RenderContext {
   unsigned int outputTexture = 0;
 
 #define MAX_SHADOW_POINT_LIGHTS 4
+#define MAX_SHADOW_CASCADES 4
   bool enableShadows = true;
   bool enablePointShadows = true;
   float shadowBias = 0.005f;
-  int dirShadowResolution = 2048;
+  // Per-cascade tile size of the sun shadow atlas; the atlas itself is up to
+  // three tiles wide.
+  int dirShadowResolution = 1024;
+  // The view range up to shadowDistance is split into shadowCascadeCount
+  // slices; lambda blends logarithmic (1) and uniform (0) split placement.
+  // Cascades past the first are re-rendered every cascadeUpdateInterval
+  // frames.
+  int shadowCascadeCount = 3;
+  float shadowCascadeSplitLambda = 0.75f;
+  float shadowDistance = 100.0f;
+  int cascadeUpdateInterval = 1;
   int pointShadowResolution = 512;
   float pointShadowFarPlane = 25.0f;
+  // Static casters are rendered into per-light caches and only dynamic
+  // casters are redrawn each frame.
+  bool shadowCaching = true;
+  int pointShadowRefreshBudget = 2;
 
   mutable unsigned int dirShadowMap = 0;
   mutable glm::mat4 lightSpaceMatrix = glm::mat4(1.0f);
+  mutable int activeShadowCascades = 0;
+  mutable glm::mat4 cascadeMatrices[MAX_SHADOW_CASCADES];
+  // Atlas tile of each cascade as (offset.xy, scale.zw) in texture space.
+  mutable glm::vec4 cascadeRects[MAX_SHADOW_CASCADES];
+  mutable float cascadeSplits[MAX_SHADOW_CASCADES] = {0.0f};
   mutable unsigned int pointShadowCubemaps[MAX_SHADOW_POINT_LIGHTS] = {0};
 
   int width = 0;
@@ -86,6 +106,9 @@ struct RenderContext {
   
   bool zPrepass = false;
   bool autoLOD = true;
+  // False for secondary views such as scene camera previews, which must not
+  // disturb the main view's LOD hysteresis and cross-fade state.
+  bool primaryView = true;
   bool clusteredShading = false;
   bool adaptiveShadowRes = true;
   bool staticBatching = false;
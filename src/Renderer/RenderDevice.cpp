@@ -0,0 +1,216 @@
+#include "RenderDevice.h"
+#include "NullGL.h"
+#include "../Tools/Profiler/PerfCounters.h"
+#include <cstring>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+RenderBackend RenderDevice::s_Backend = RenderBackend::OpenGL;
+
+// GL_NVX_gpu_memory_info, in KiB.
+static constexpr GLenum kRenderDeviceTotalVidmemNVX = 0x9048;
+static constexpr GLenum kRenderDeviceAvailableVidmemNVX = 0x9049;
+static int s_RenderDeviceHasMemoryInfo = -1;
+
+#ifndef C3D_NO_PROFILER
+// The loaded entry points, called through by the counting wrappers below.
+static PFNGLDRAWARRAYSPROC s_RenderDeviceDrawArrays;
+static PFNGLDRAWARRAYSINSTANCEDPROC s_RenderDeviceDrawArraysInstanced;
+static PFNGLDRAWELEMENTSPROC s_RenderDeviceDrawElements;
+static PFNGLDRAWELEMENTSBASEVERTEXPROC s_RenderDeviceDrawElementsBaseVertex;
+static PFNGLDRAWRANGEELEMENTSPROC s_RenderDeviceDrawRangeElements;
+static PFNGLDRAWELEMENTSINSTANCEDPROC s_RenderDeviceDrawElementsInstanced;
+static PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC
+    s_RenderDeviceDrawElementsInstancedBaseVertex;
+static PFNGLMULTIDRAWARRAYSPROC s_RenderDeviceMultiDrawArrays;
+static PFNGLMULTIDRAWELEMENTSPROC s_RenderDeviceMultiDrawElements;
+static PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC
+    s_RenderDeviceMultiDrawElementsBaseVertex;
+static PFNGLUSEPROGRAMPROC s_RenderDeviceUseProgram;
+static PFNGLBINDTEXTUREPROC s_RenderDeviceBindTexture;
+static PFNGLBINDVERTEXARRAYPROC s_RenderDeviceBindVertexArray;
+
+static void RenderDeviceCountDraw(GLenum mode, GLsizei count,
+                                  GLsizei instances) {
+  int64_t triangles = 0;
+  if (mode == GL_TRIANGLES)
+    triangles = count / 3;
+  else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count > 2)
+    triangles = count - 2;
+  PERF_COUNT(PerfCounter::DrawCalls, 1);
+  PERF_COUNT(PerfCounter::Triangles, triangles * instances);
+}
+
+static void APIENTRY RenderDeviceDrawArrays(GLenum mode, GLint first,
+                                            GLsizei count) {
+  RenderDeviceCountDraw(mode, count, 1);
+  s_RenderDeviceDrawArrays(mode, first, count);
+}
+
+static void APIENTRY RenderDeviceDrawArraysInstanced(GLenum mode, GLint first,
+                                                     GLsizei count,
+                                                     GLsizei instances) {
+  RenderDeviceCountDraw(mode, count, instances);
+  s_RenderDeviceDrawArraysInstanced(mode, first, count, instances);
+}
+
+static void APIENTRY RenderDeviceDrawElements(GLenum mode, GLsizei count,
+                                              GLenum type,
+                                              const void *indices) {
+  RenderDeviceCountDraw(mode, count, 1);
+  s_RenderDeviceDrawElements(mode, count, type, indices);
+}
+
+static void APIENTRY RenderDeviceDrawElementsBaseVertex(GLenum mode,
+                                                        GLsizei count,
+                                                        GLenum type,
+                                                        const void *indices,
+                                                        GLint baseVertex) {
+  RenderDeviceCountDraw(mode, count, 1);
+  s_RenderDeviceDrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+}
+
+static void APIENTRY RenderDeviceDrawRangeElements(GLenum mode, GLuint start,
+                                                   GLuint end, GLsizei count,
+                                                   GLenum type,
+                                                   const void *indices) {
+  RenderDeviceCountDraw(mode, count, 1);
+  s_RenderDeviceDrawRangeElements(mode, start, end, count, type, indices);
+}
+
+static void APIENTRY RenderDeviceDrawElementsInstanced(GLenum mode,
+                                                       GLsizei count,
+                                                       GLenum type,
+                                                       const void *indices,
+                                                       GLsizei instances) {
+  RenderDeviceCountDraw(mode, count, instances);
+  s_RenderDeviceDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+static void APIENTRY RenderDeviceDrawElementsInstancedBaseVertex(
+    GLenum mode, GLsizei count, GLenum type, const void *indices,
+    GLsizei instances, GLint baseVertex) {
+  RenderDeviceCountDraw(mode, count, instances);
+  s_RenderDeviceDrawElementsInstancedBaseVertex(mode, count, type, indices,
+                                                instances, baseVertex);
+}
+
+static void APIENTRY RenderDeviceMultiDrawArrays(GLenum mode,
+                                                 const GLint *first,
+                                                 const GLsizei *count,
+                                                 GLsizei drawCount) {
+  for (GLsizei i = 0; i < drawCount; ++i)
+    RenderDeviceCountDraw(mode, count[i], 1);
+  s_RenderDeviceMultiDrawArrays(mode, first, count, drawCount);
+}
+
+static void APIENTRY RenderDeviceMultiDrawElements(GLenum mode,
+                                                   const GLsizei *count,
+                                                   GLenum type,
+                                                   const void *const *indices,
+                                                   GLsizei drawCount) {
+  for (GLsizei i = 0; i < drawCount; ++i)
+    RenderDeviceCountDraw(mode, count[i], 1);
+  s_RenderDeviceMultiDrawElements(mode, count, type, indices, drawCount);
+}
+
+static void APIENTRY RenderDeviceMultiDrawElementsBaseVertex(
+    GLenum mode, const GLsizei *count, GLenum type, const void *const *indices,
+    GLsizei drawCount, const GLint *baseVertex) {
+  for (GLsizei i = 0; i < drawCount; ++i)
+    RenderDeviceCountDraw(mode, count[i], 1);
+  s_RenderDeviceMultiDrawElementsBaseVertex(mode, count, type, indices,
+                                            drawCount, baseVertex);
+}
+
+static void APIENTRY RenderDeviceUseProgram(GLuint program) {
+  PERF_COUNT(PerfCounter::ShaderBinds, 1);
+  s_RenderDeviceUseProgram(program);
+}
+
+static void APIENTRY RenderDeviceBindTexture(GLenum target, GLuint texture) {
+  PERF_COUNT(PerfCounter::TextureBinds, 1);
+  s_RenderDeviceBindTexture(target, texture);
+}
+
+static void APIENTRY RenderDeviceBindVertexArray(GLuint array) {
+  PERF_COUNT(PerfCounter::VAOBinds, 1);
+  s_RenderDeviceBindVertexArray(array);
+}
+
+// Puts a counting wrapper in front of each draw and bind entry point, so
+// every call site is counted on either backend without touching it.
+static void RenderDeviceInstallCounters() {
+#define C3D_WRAP_GL(fn)                                                        \
+  if (glad_gl##fn) {                                                           \
+    s_RenderDevice##fn = glad_gl##fn;                                          \
+    glad_gl##fn = RenderDevice##fn;                                            \
+  }
+  C3D_WRAP_GL(DrawArrays)
+  C3D_WRAP_GL(DrawArraysInstanced)
+  C3D_WRAP_GL(DrawElements)
+  C3D_WRAP_GL(DrawElementsBaseVertex)
+  C3D_WRAP_GL(DrawRangeElements)
+  C3D_WRAP_GL(DrawElementsInstanced)
+  C3D_WRAP_GL(DrawElementsInstancedBaseVertex)
+  C3D_WRAP_GL(MultiDrawArrays)
+  C3D_WRAP_GL(MultiDrawElements)
+  C3D_WRAP_GL(MultiDrawElementsBaseVertex)
+  C3D_WRAP_GL(UseProgram)
+  C3D_WRAP_GL(BindTexture)
+  C3D_WRAP_GL(BindVertexArray)
+#undef C3D_WRAP_GL
+}
+#endif
+
+bool RenderDevice::Init() {
+  bool loaded = s_Backend == RenderBackend::Null
+                    ? NullGL::Load()
+                    : gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) != 0;
+#ifndef C3D_NO_PROFILER
+  if (loaded)
+    RenderDeviceInstallCounters();
+#endif
+  return loaded;
+}
+
+const char *RenderDevice::GetBackendName() {
+  return s_Backend == RenderBackend::Null ? "Null" : "OpenGL";
+}
+
+void RenderDevice::BeginFrame() {
+  if (s_Backend == RenderBackend::Null)
+    NullGL::ResetFrameStats();
+}
+
+const RenderDeviceStats &RenderDevice::GetStats() {
+  static const RenderDeviceStats s_NoStats;
+  return s_Backend == RenderBackend::Null ? NullGL::s_Stats : s_NoStats;
+}
+
+uint64_t RenderDevice::GetAllocatedBytes() {
+  if (s_Backend == RenderBackend::Null) {
+    const RenderDeviceStats &stats = NullGL::s_Stats;
+    return stats.bufferBytes + stats.textureBytes + stats.renderbufferBytes;
+  }
+
+  if (s_RenderDeviceHasMemoryInfo < 0) {
+    s_RenderDeviceHasMemoryInfo = 0;
+    GLint extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+    for (GLint i = 0; i < extensions; ++i) {
+      const char *name = (const char *)glGetStringi(GL_EXTENSIONS, i);
+      if (name && std::strcmp(name, "GL_NVX_gpu_memory_info") == 0) {
+        s_RenderDeviceHasMemoryInfo = 1;
+        break;
+      }
+    }
+  }
+  if (!s_RenderDeviceHasMemoryInfo)
+    return 0;
+  GLint totalKb = 0;
+  GLint availableKb = 0;
+  glGetIntegerv(kRenderDeviceTotalVidmemNVX, &totalKb);
+  glGetIntegerv(kRenderDeviceAvailableVidmemNVX, &availableKb);
+  return totalKb > availableKb ? (uint64_t)(totalKb - availableKb) * 1024 : 0;
+}
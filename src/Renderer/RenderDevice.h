@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+
+enum class RenderBackend {
+  OpenGL,
+  // No window, no GPU. See NullGL.h.
+  Null
+};
+
+// Draws submitted since BeginFrame() and device memory in use. Only the null
+// backend counts; on OpenGL the driver keeps these books and they read 0.
+struct RenderDeviceStats {
+  uint64_t drawCalls = 0;
+  uint64_t triangles = 0;
+  uint32_t buffers = 0;
+  uint64_t bufferBytes = 0;
+  uint32_t textures = 0;
+  uint64_t textureBytes = 0;
+  uint32_t renderbuffers = 0;
+  uint64_t renderbufferBytes = 0;
+};
+
+// Everything that creates GPU resources or submits draws goes through the GL
+// entry points glad loads, so the device is the table behind them: the
+// driver's for OpenGL, stubs for Null. Pick the backend before
+// Application::Init().
+class RenderDevice {
+public:
+  // OpenGL needs a current context. Null needs nothing.
+  static bool Init();
+  static bool IsHeadless() { return s_Backend == RenderBackend::Null; }
+  static const char *GetBackendName();
+  static void BeginFrame();
+  static const RenderDeviceStats &GetStats();
+  // Device memory in use: the null backend's own count, or on OpenGL what
+  // GL_NVX_gpu_memory_info reports for the whole GPU. 0 when unknown.
+  static uint64_t GetAllocatedBytes();
+
+  static RenderBackend s_Backend;
+};
@@ -1,4 +1,6 @@
 #include "RenderPipeline.h"
+#include "RenderDevice.h"
+#include "../Tools/Profiler/PerfCounters.h"
 #include <iostream>
 
 void RenderPipeline::AddPass(std::unique_ptr<RenderPass> pass)
@@ -13,10 +15,22 @@ void RenderPipeline::ClearPasses()
 
 void RenderPipeline::Execute(const RenderContext& context)
 {
+#ifdef C3D_NO_PROFILER
     for (auto& pass : m_Passes)
     {
         pass->Execute(context);
     }
+#else
+    PERF_GAUGE(PerfCounter::GpuMemoryBytes, RenderDevice::GetAllocatedBytes());
+    for (auto& pass : m_Passes)
+    {
+        auto before = PerfCounters::GetThreadTotal(PerfCounter::DrawCalls);
+        pass->Execute(context);
+        auto after = PerfCounters::GetThreadTotal(PerfCounter::DrawCalls);
+        if (!pass->m_Name.empty())
+            PerfCounters::AddPassDrawCalls(pass->m_Name, after - before);
+    }
+#endif
 }
 
 void RenderPipeline::Resize(int width, int height)
@@ -1,5 +1,7 @@
 #include "Renderer.h"
 #include "AudioEngine/AudioEngine.h"
+#include "BudgetGovernor.h"
+#include "Core/LinearArena.h"
 #include "Core/Logger.h"
 #include "Core/ResourceManager.h"
 #include "DynamicBatcher.h"
@@ -8,6 +10,7 @@
 #include "Physics/PhysicsEngine.h"
 #include "StaticBatcher.h"
 #include "Tools/Profiler/GpuProfiler.h"
+#include "Tools/Profiler/PerfCounters.h"
 #include "Tools/Profiler/Profiler.h"
 #include "VideoPlayer.h"
 #include "C3DprogrammingApi/C3D.h"
@@ -30,15 +33,31 @@ bool Renderer::s_EnableOcclusionCulling = true;
 bool Renderer::s_VisualizeZPrepass = false;
 bool Renderer::s_VisualizeVRS = false;
 bool Renderer::s_AdaptiveShadowRes = true;
+bool Renderer::s_ShadowCaching = true;
+int Renderer::s_PointShadowRefreshBudget = 2;
+int Renderer::s_ShadowCascadeCount = 3;
+int Renderer::s_ShadowCascadeResolution = 1024;
+int Renderer::s_CascadeUpdateInterval = 1;
+float Renderer::s_ShadowCascadeSplitLambda = 0.75f;
+float Renderer::s_ShadowDistance = 100.0f;
 bool Renderer::s_StaticBatching = false;
 bool Renderer::s_DynamicBatching = false;
 bool Renderer::s_ClusteredShading = false;
 bool Renderer::s_AutoLOD = true;
-float Renderer::s_LODDistances[4] = {12.2f, 36.5f, 74.1f, 102.6f};
 bool Renderer::s_LODEnabled[4] = {true, true, true, true};
+float Renderer::s_LODPixelTolerance = 1.0f;
+float Renderer::s_LODHysteresis = 0.25f;
+bool Renderer::s_LODCrossFade = true;
+float Renderer::s_LODFadeTime = 0.25f;
+int Renderer::s_LODTriangleBudget = 0;
+float Renderer::s_LODQualityScale = 1.0f;
+size_t Renderer::s_LODTrianglesLastFrame = 0;
+float Renderer::s_LODFrameTime = -1.0f;
+size_t Renderer::s_LODFrameTriangles = 0;
 int Renderer::s_MaxFPS = 144;
 bool Renderer::s_LowLatencyMode = false;
 bool Renderer::s_ComponentThrottling = false;
+bool Renderer::s_ReleaseCPUMeshData = false;
 
 static GLuint s_boxVAO = 0;
 static GLuint s_boxVBO = 0;
@@ -106,6 +125,77 @@ void Renderer::EndScene() {}
 void Renderer::RenderMesh(Mesh &mesh, Shader &shader, const glm::vec3 &position,
                           const glm::quat &rotation, const glm::vec3 &scale) {}
 
+float Renderer::LODPixelsPerUnit(const Camera &camera,
+                                 const glm::vec3 &center, float radius) {
+  float distance = glm::distance(camera.Position, center) - radius;
+  distance = glm::max(distance, camera.nearPlane);
+  float focal = (float)glm::max(camera.height, 1) * 0.5f /
+                std::tan(glm::radians(camera.FOV) * 0.5f);
+  return focal / distance;
+}
+
+float Renderer::GetLODTolerance() {
+  return s_LODPixelTolerance * s_LODQualityScale *
+         BudgetGovernor::GetQuality().lodToleranceScale;
+}
+
+int Renderer::SelectLOD(const Mesh &mesh, float pixelsPerUnit,
+                        int currentLOD) {
+  float tolerance = GetLODTolerance();
+  int selected = 0;
+  for (int i = 1; i <= (int)mesh.lodLevels.size(); ++i) {
+    if (i <= 4 && !s_LODEnabled[i - 1])
+      continue;
+    float limit =
+        i > currentLOD ? tolerance * (1.0f - s_LODHysteresis) : tolerance;
+    // Errors grow with the level, so the first miss ends the search.
+    if (mesh.lodLevels[i - 1].error * pixelsPerUnit > limit)
+      break;
+    selected = i;
+  }
+  return selected;
+}
+
+// Nudges the tolerance scale toward the triangle budget using the count from
+// the frame that just finished. Small steps, because LOD switches change the
+// count in jumps and hysteresis delays the response.
+void Renderer::UpdateLODBudget() {
+  s_LODTrianglesLastFrame =
+      s_LODFrameTriangles + StaticBatcher::GetTrianglesLastFrame();
+  s_LODFrameTriangles = 0;
+
+  if (s_LODTriangleBudget <= 0) {
+    s_LODQualityScale = 1.0f;
+    return;
+  }
+  float ratio = (float)s_LODTrianglesLastFrame / (float)s_LODTriangleBudget;
+  if (ratio > 1.05f)
+    s_LODQualityScale *= 1.1f;
+  else if (ratio < 0.9f)
+    s_LODQualityScale *= 0.95f;
+  s_LODQualityScale = glm::clamp(s_LODQualityScale, 0.25f, 64.0f);
+  PROFILE_COUNTER("LOD Quality Scale", s_LODQualityScale);
+}
+
+static size_t LODTriangleCount(const Mesh &mesh, int lod) {
+  if (lod > 0 && lod <= (int)mesh.lodLevels.size())
+    return mesh.lodLevels[lod - 1].indexCount / 3;
+  return mesh.indexCount / 3;
+}
+
+// Fragments keep only when their dither value falls in [lo, hi). Stored as
+// (lo, 1 - hi) so that an unset uniform keeps everything.
+static void SetLODDither(Shader &shader, float lo, float hi) {
+  shader.setVec2("lodDither", glm::vec2(lo, 1.0f - hi));
+}
+
+// Shaders without the dither discard would draw both sides of a fade at full
+// opacity, so objects using them switch LODs outright and HLOD hand-overs
+// happen at the halfway point of the fade.
+static bool HasLODDither(const Shader &shader) {
+  return shader.hasUniform("lodDither");
+}
+
 void Renderer::RenderScene(Scene &scene, Camera &camera, Shader &shader,
                            float tilingFactor, bool renderEditorObjects,
                            float dt, float time, int renderLayer,
@@ -113,10 +203,26 @@ void Renderer::RenderScene(Scene &scene, Camera &camera, Shader &shader,
                            bool useBackfaceCulling,
                            bool useMaterialOptimisation, bool visualizeCulling,
                            bool useAutoLOD, bool useZPrepass,
-                           bool useStaticBatching, bool useDynamicBatching) {
+                           bool useStaticBatching, bool useDynamicBatching,
+                           bool primaryView) {
   PROFILE_SCOPE("RenderScene_Iterate");
   auto &objects = scene.GetObjects();
 
+  // LOD and HLOD state (hysteresis, fades, the triangle count) follows the
+  // main view only; the first of its passes each frame advances it and the
+  // later ones reuse the result. Other views select without storing.
+  // Culling counters follow the same first pass.
+  bool countFrame = false;
+  if (primaryView && time != s_LODFrameTime) {
+    s_LODFrameTime = time;
+    UpdateLODBudget();
+    countFrame = true;
+  }
+  float lodTolerance = GetLODTolerance();
+  float fadeStep = dt / glm::max(s_LODFadeTime, 0.001f);
+  // The depth prepass has no dither, so it would punch holes in both LODs.
+  bool lodCrossFade = s_LODCrossFade && !s_ZPrepass && renderLayer != 2;
+
   glm::mat4 viewMatrix = camera.GetViewMatrix();
   glm::mat4 projectionMatrix = camera.GetProjectionMatrix();
   glm::mat4 camMatrix = projectionMatrix * viewMatrix;
@@ -157,26 +263,92 @@ void Renderer::RenderScene(Scene &scene, Camera &camera, Shader &shader,
                                                cRef.GetViewMatrix());
   }
 
-  std::vector<bool> skipObjects(objects.size(), false);
+  LinearArena &frameArena = MemoryTracker::GetFrameArena();
+  LinearArena::Scope frameScope(frameArena);
+  ArenaVector<bool> skipObjects(objects.size(), false,
+                                ArenaAllocator<bool>(frameArena));
+  // Dither interval each object may draw into while an HLOD fade is running.
+  ArenaVector<glm::vec2> objectDither(objects.size(), glm::vec2(0.0f, 1.0f),
+                                      ArenaAllocator<glm::vec2>(frameArena));
   if (s_EnableHLOD) {
-    const auto &proxies = HLODManager::GetProxies();
-    for (const auto &proxy : proxies) {
+    // Walk from the coarsest proxies down; a proxy whose error projects under
+    // the tolerance replaces its whole subtree, otherwise its children get
+    // the same test. A fading proxy shares its dither interval with them.
+    auto &proxies = HLODManager::GetProxies();
+    // Each proxy is visited at most once.
+    ArenaVector<std::pair<int, glm::vec2>> pending{
+        ArenaAllocator<std::pair<int, glm::vec2>>(frameArena)};
+    pending.reserve(proxies.size());
+    for (auto it = HLODManager::GetRoots().rbegin();
+         it != HLODManager::GetRoots().rend(); ++it)
+      pending.push_back({*it, glm::vec2(0.0f, 1.0f)});
+    while (!pending.empty()) {
+      HLODProxy &proxy = proxies[pending.back().first];
+      glm::vec2 range = pending.back().second;
+      pending.pop_back();
       if (!proxy.active)
         continue;
-      float dist = glm::distance(cameraPos, proxy.center);
-      if (dist > proxy.threshold) {
-        proxy.mesh.Draw(shader, camera, proxy.center);
-        for (int idx : proxy.originalObjectIndices) {
-          if (idx >= 0 && idx < (int)skipObjects.size()) {
-            skipObjects[idx] = true;
-          }
+
+      float limit = proxy.selected
+                        ? lodTolerance
+                        : lodTolerance * (1.0f - s_LODHysteresis);
+      bool wanted =
+          proxy.error *
+              LODPixelsPerUnit(camera, proxy.center, proxy.radius) <=
+          limit;
+      float shown = wanted ? 1.0f : 0.0f;
+      if (primaryView) {
+        if (proxy.lodTime != time) {
+          proxy.lodTime = time;
+          proxy.selected = wanted;
+          if (!lodCrossFade)
+            proxy.fade = shown;
+          else if (wanted)
+            proxy.fade = glm::min(proxy.fade + fadeStep, 1.0f);
+          else
+            proxy.fade = glm::max(proxy.fade - fadeStep, 0.0f);
+          if (proxy.fade > 0.0f)
+            s_LODFrameTriangles += proxy.mesh.indexCount / 3;
         }
+        shown = proxy.fade;
+        if (!HasLODDither(shader))
+          shown = shown >= 0.5f ? 1.0f : 0.0f;
+      }
+
+      float split = range.x + (range.y - range.x) * shown;
+      if (shown > 0.0f && renderLayer != 2) {
+        // Albedo is baked into the proxy atlas.
+        shader.setVec3("material.albedo", glm::vec3(1.0f));
+        shader.setFloat("material.metallic", 0.0f);
+        shader.setFloat("material.roughness", 0.8f);
+        shader.setFloat("material.ao", 1.0f);
+        shader.setBool("material.useTexture", proxy.atlasTexture != 0);
+        shader.setBool("material.useAlphaDiscard", false);
+        shader.setBool("textureScaling", false);
+        shader.setBool("useSDF", false);
+        SetLODDither(shader, range.x, split);
+        proxy.mesh.Draw(shader, camera, glm::mat4(1.0f), proxy.atlasTexture);
+      }
+      for (int idx : proxy.originalObjectIndices) {
+        if (idx < 0 || idx >= (int)skipObjects.size())
+          continue;
+        if (shown >= 1.0f)
+          skipObjects[idx] = true;
+        else
+          objectDither[idx] = glm::vec2(split, range.y);
+      }
+      if (shown < 1.0f) {
+        for (auto it = proxy.children.rbegin(); it != proxy.children.rend();
+             ++it)
+          pending.push_back({*it, glm::vec2(split, range.y)});
       }
     }
+    SetLODDither(shader, 0.0f, 1.0f);
   }
 
-  std::vector<AABB> occluders;
+  ArenaVector<AABB> occluders{ArenaAllocator<AABB>(frameArena)};
   if (s_EnableOcclusionCulling) {
+    occluders.reserve(objects.size());
     for (const auto &obj : objects) {
       if (obj.isActive && obj.isOccluder) {
         occluders.push_back(PhysicsEngine::GetTransformedAABB(
@@ -186,8 +358,11 @@ void Renderer::RenderScene(Scene &scene, Camera &camera, Shader &shader,
   }
 
   for (size_t i = 0; i < objects.size(); ++i) {
-    if (skipObjects[i])
+    if (skipObjects[i]) {
+      if (countFrame)
+        PERF_COUNT(PerfCounter::CulledHLOD, 1);
       continue;
+    }
     auto &object = objects[i];
     if (!object.isActive)
       continue;
@@ -215,8 +390,11 @@ void Renderer::RenderScene(Scene &scene, Camera &camera, Shader &shader,
           }
         }
       }
-      if (isOccluded)
+      if (isOccluded) {
+        if (countFrame)
+          PERF_COUNT(PerfCounter::CulledOcclusion, 1);
         continue;
+      }
     }
 
     if (!renderEditorObjects && object.meshType == MeshType::Camera)
@@ -252,6 +430,10 @@ void Renderer::RenderScene(Scene &scene, Camera &camera, Shader &shader,
       }
     }
 
+    if (countFrame)
+      PERF_COUNT(isCulled ? PerfCounter::CulledFrustum
+                          : PerfCounter::ObjectsDrawn,
+                 1);
     if (isCulled && (!visualizeCulling || !s_ShowCulledAsWireframe)) {
       continue;
     }
@@ -376,20 +558,6 @@ void Renderer::RenderScene(Scene &scene, Camera &camera, Shader &shader,
             delete vp;
             object.screen.videoPlayerHandle.reset();
           }
-
-          if (object.screen.videoPlayerHandle) {
-
-            std::string audioPath = object.screen.filePath + "_audio.wav";
-            object.hasAudio = true;
-            if (object.audio.filePath != audioPath) {
-              object.audio.filePath = audioPath;
-              object.audio.playing = !object.screen.videoPaused;
-              object.audio.playOnAwake = true;
-              if (object.audio.playing) {
-                AudioEngine::PlayObjectAudio(object);
-              }
-            }
-          }
         }
         if (object.screen.videoPlayerHandle) {
           VideoPlayer *vp =
@@ -405,6 +573,17 @@ void Renderer::RenderScene(Scene &scene, Camera &camera, Shader &shader,
           }
           texOverride = vp->GetTextureID();
 
+          // The player owns the soundtrack stream; a reopened video brings a
+          // new one, so the voice is restarted on it.
+          std::shared_ptr<AudioStream> stream = vp->GetAudioStream();
+          if (stream && object.audio.stream != stream) {
+            AudioEngine::StopObjectAudio(object);
+            object.hasAudio = true;
+            object.audio.stream = stream;
+            object.audio.filePath.clear();
+            object.audio.playOnAwake = true;
+          }
+
           if (object.hasAudio) {
             object.audio.looping = object.screen.videoLoop;
             object.audio.volume = object.screen.videoVolume;
@@ -448,28 +627,53 @@ void Renderer::RenderScene(Scene &scene, Camera &camera, Shader &shader,
     activeShader->setBool("material.useAlphaDiscard",
                           object.material.useAlphaDiscard && actualUseTexture);
 
-    object.mesh.currentLOD = 0;
-
-    if (useAutoLOD && !object.mesh.lodLevels.empty()) {
-      float distance = glm::distance(cameraPos, glm::vec3(finalMatrix[3]));
+    Mesh &mesh = object.mesh;
+    int storedLOD = mesh.currentLOD;
+    int fadeFrom = -1;
+    float fade = 1.0f;
+    if (useAutoLOD && !mesh.lodLevels.empty()) {
       float maxScale =
           glm::max(glm::length(glm::vec3(finalMatrix[0])),
                    glm::max(glm::length(glm::vec3(finalMatrix[1])),
                             glm::length(glm::vec3(finalMatrix[2]))));
-      float radius = glm::length(object.mesh.maxAABB - object.mesh.minAABB) *
-                     0.5f * maxScale;
-
-      float scaledDistance = distance / glm::max(radius, 0.1f);
-
-      object.mesh.currentLOD = 0;
-      for (int i = 3; i >= 0; --i) {
-        if (s_LODEnabled[i] && (int)object.mesh.lodLevels.size() >= (i + 1)) {
-          if (scaledDistance > s_LODDistances[i]) {
-            object.mesh.currentLOD = i + 1;
-            break;
+      glm::vec3 center = glm::vec3(
+          finalMatrix * glm::vec4((mesh.minAABB + mesh.maxAABB) * 0.5f, 1.0f));
+      float radius =
+          glm::length(mesh.maxAABB - mesh.minAABB) * 0.5f * maxScale;
+      float pixelsPerUnit =
+          LODPixelsPerUnit(camera, center, radius) * maxScale;
+
+      if (!primaryView) {
+        mesh.currentLOD = SelectLOD(mesh, pixelsPerUnit, storedLOD);
+      } else {
+        if (mesh.lodTime != time) {
+          mesh.lodTime = time;
+          int lod = SelectLOD(mesh, pixelsPerUnit, mesh.currentLOD);
+          if (lod != mesh.currentLOD) {
+            mesh.fadeFromLOD = lodCrossFade ? mesh.currentLOD : -1;
+            mesh.lodFade = 0.0f;
+            mesh.currentLOD = lod;
+          } else if (mesh.fadeFromLOD >= 0) {
+            mesh.lodFade += fadeStep;
           }
+          if (!lodCrossFade || mesh.lodFade >= 1.0f)
+            mesh.fadeFromLOD = -1;
+          PERF_COUNT((PerfCounter)((int)PerfCounter::ObjectsLOD0 +
+                                   glm::min(mesh.currentLOD, 3)),
+                     1);
+
+          s_LODFrameTriangles += LODTriangleCount(mesh, mesh.currentLOD);
+          if (mesh.fadeFromLOD >= 0)
+            s_LODFrameTriangles += LODTriangleCount(mesh, mesh.fadeFromLOD);
         }
+        storedLOD = mesh.currentLOD;
+        fadeFrom = mesh.fadeFromLOD;
+        fade = mesh.lodFade;
       }
+    } else {
+      mesh.currentLOD = 0;
+      mesh.fadeFromLOD = -1;
+      storedLOD = 0;
     }
 
     unsigned int finalTexOverride = texOverride;
@@ -488,7 +692,24 @@ void Renderer::RenderScene(Scene &scene, Camera &camera, Shader &shader,
     activeShader->setBool("textureScaling", object.material.textureScaling);
     activeShader->setFloat("textureScaleValue", object.material.textureScale);
 
-    object.mesh.Draw(*activeShader, camera, finalMatrix, finalTexOverride);
+    // While fading, the new LOD takes the lower part of the object's dither
+    // interval and the old one the rest, so every pixel is drawn once.
+    glm::vec2 range = objectDither[i];
+    if (!HasLODDither(*activeShader)) {
+      if (range.x < 0.5f)
+        mesh.Draw(*activeShader, camera, finalMatrix, finalTexOverride);
+    } else if (fadeFrom >= 0) {
+      float split = range.x + (range.y - range.x) * fade;
+      SetLODDither(*activeShader, range.x, split);
+      mesh.Draw(*activeShader, camera, finalMatrix, finalTexOverride);
+      mesh.currentLOD = fadeFrom;
+      SetLODDither(*activeShader, split, range.y);
+      mesh.Draw(*activeShader, camera, finalMatrix, finalTexOverride);
+      mesh.currentLOD = storedLOD;
+    } else {
+      SetLODDither(*activeShader, range.x, range.y);
+      mesh.Draw(*activeShader, camera, finalMatrix, finalTexOverride);
+    }
 
     if (visualizeCulling && renderLayer != 2) {
       if (!ResourceManager::HasShader("culling_vis")) {
@@ -510,12 +731,10 @@ void Renderer::RenderScene(Scene &scene, Camera &camera, Shader &shader,
       glLineWidth(2.0f);
       glEnable(GL_DEPTH_TEST);
 
-      int indicesCount = object.mesh.indices.size();
-      if (object.mesh.currentLOD != -1 &&
-          (size_t)object.mesh.currentLOD < object.mesh.lodLevels.size()) {
-        glBindVertexArray(object.mesh.lodLevels[object.mesh.currentLOD].vao);
-        indicesCount =
-            object.mesh.lodLevels[object.mesh.currentLOD].indices.size();
+      int indicesCount = (int)LODTriangleCount(mesh, mesh.currentLOD) * 3;
+      if (mesh.currentLOD > 0 &&
+          mesh.currentLOD <= (int)mesh.lodLevels.size()) {
+        glBindVertexArray(mesh.lodLevels[mesh.currentLOD - 1].vao);
       } else {
         object.mesh.vao.Bind();
       }
@@ -540,17 +759,23 @@ void Renderer::RenderScene(Scene &scene, Camera &camera, Shader &shader,
       currentIsWireframe = false;
       activeShader->use();
     }
+    mesh.currentLOD = storedLOD;
 
     if (useBackfaceCulling && renderLayer != 2) {
       glFrontFace(GL_CCW);
     }
   }
 
+  shader.use();
+  SetLODDither(shader, 0.0f, 1.0f);
+
   if (renderLayer <= 1) {
     if (useStaticBatching && StaticBatcher::HasBatches()) {
       PROFILE_SCOPE("StaticBatching");
       GPU_PROFILE_SCOPE("StaticBatching");
-      StaticBatcher::DrawBatches(shader, camera);
+      StaticBatcher::DrawBatches(shader, camera,
+                                 useObjCulling ? &frustum : nullptr, useAutoLOD,
+                                 primaryView);
     }
     if (useDynamicBatching) {
       PROFILE_SCOPE("DynamicBatching");
@@ -30,7 +30,18 @@ public:
       bool useObjCulling = true, bool useBackfaceCulling = true,
       bool useMaterialOptimisation = false, bool visualizeCulling = false,
       bool useAutoLOD = true, bool useZPrepass = false,
-      bool useStaticBatching = false, bool useDynamicBatching = false);
+      bool useStaticBatching = false, bool useDynamicBatching = false,
+      bool primaryView = true);
+
+  // Screen pixels covered by one world unit at the nearest point of a
+  // bounding sphere, for the camera's vertical FOV and viewport height.
+  static float LODPixelsPerUnit(const Camera &camera, const glm::vec3 &center,
+                                float radius);
+  // Coarsest enabled LOD whose projected error (LODLevel::error times
+  // pixelsPerUnit) is within the pixel tolerance. Going coarser than
+  // currentLOD has to clear a tolerance tightened by s_LODHysteresis.
+  static int SelectLOD(const Mesh &mesh, float pixelsPerUnit, int currentLOD);
+  static float GetLODTolerance();
 
   static void RenderHitboxes(Scene &scene, Camera &camera);
 
@@ -51,19 +62,40 @@ public:
   static bool s_VisualizeZPrepass;
   static bool s_VisualizeVRS;
   static bool s_AdaptiveShadowRes;
+  static bool s_ShadowCaching;
+  static int s_PointShadowRefreshBudget;
+  static int s_ShadowCascadeCount;
+  // Per-cascade tile size, not the size of the whole sun shadow atlas.
+  static int s_ShadowCascadeResolution;
+  static int s_CascadeUpdateInterval;
+  static float s_ShadowCascadeSplitLambda;
+  static float s_ShadowDistance;
   static bool s_StaticBatching;
   static bool s_DynamicBatching;
   static bool s_ClusteredShading;
   static bool s_AutoLOD;
-  static float s_LODDistances[4];
   static bool s_LODEnabled[4];
+  static float s_LODPixelTolerance;
+  static float s_LODHysteresis;
+  static bool s_LODCrossFade;
+  static float s_LODFadeTime;
+  // Triangles per frame the tolerance is scaled to hit; 0 disables.
+  static int s_LODTriangleBudget;
+  static float s_LODQualityScale;
+  static size_t s_LODTrianglesLastFrame;
 
   static int s_MaxFPS;
   static bool s_LowLatencyMode;
   static bool s_ComponentThrottling;
+  // Scene::ReleaseCPUMeshData() after every scene load and bake.
+  static bool s_ReleaseCPUMeshData;
 
 private:
   static void Clear();
+  static void UpdateLODBudget();
+
+  static float s_LODFrameTime;
+  static size_t s_LODFrameTriangles;
 };
 
 #endif
@@ -1,33 +1,577 @@
 #include "SDFGenerator.h"
+#include "../Core/Application.h"
+#include "../Core/ThreadManager.h"
 #include <Core/Logger.h>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <glad/glad.h>
 #include <limits>
+#include <mutex>
+#include <unordered_map>
+
+static constexpr uint32_t SDF_CACHE_VERSION = 2;
+static constexpr char SDF_CACHE_MAGIC[8] = {'C', '3', 'D', 'S', 'D', 'F', 0, 0};
+
+struct SDFTriangle {
+  glm::vec3 v0, v1, v2;
+  glm::vec3 minP, maxP;
+  glm::vec3 centroid;
+};
+
+struct SDFBVHNode {
+  glm::vec3 minP, maxP;
+  int left = -1;
+  int right = -1;
+  int first = 0;
+  int count = 0;
+};
+
+class SDFBVH {
+public:
+  explicit SDFBVH(std::vector<SDFTriangle> tris) : m_Tris(std::move(tris)) {
+    if (m_Tris.empty())
+      return;
+    m_Nodes.reserve(m_Tris.size() * 2);
+    Build(0, (int)m_Tris.size());
+  }
+
+  bool Empty() const { return m_Tris.empty(); }
+
+  float ClosestDistanceSq(const glm::vec3 &p) const {
+    float best = std::numeric_limits<float>::max();
+    if (m_Nodes.empty())
+      return best;
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+      const SDFBVHNode &node = m_Nodes[stack[--top]];
+      if (BoxDistanceSq(p, node.minP, node.maxP) >= best)
+        continue;
+
+      if (node.left < 0) {
+        for (int i = node.first; i < node.first + node.count; ++i) {
+          const SDFTriangle &t = m_Tris[i];
+          glm::vec3 c = ClosestPointOnTriangle(p, t.v0, t.v1, t.v2);
+          glm::vec3 d = p - c;
+          best = std::min(best, glm::dot(d, d));
+        }
+        continue;
+      }
+
+      float dl = BoxDistanceSq(p, m_Nodes[node.left].minP,
+                               m_Nodes[node.left].maxP);
+      float dr = BoxDistanceSq(p, m_Nodes[node.right].minP,
+                               m_Nodes[node.right].maxP);
+      // Visit the nearer child first so `best` shrinks early.
+      if (dl < dr) {
+        stack[top++] = node.right;
+        stack[top++] = node.left;
+      } else {
+        stack[top++] = node.left;
+        stack[top++] = node.right;
+      }
+    }
+    return best;
+  }
+
+  // Appends the ray parameter of every triangle crossing along the ray.
+  void IntersectAll(const glm::vec3 &origin, const glm::vec3 &dir,
+                    std::vector<float> &hits) const {
+    if (m_Nodes.empty())
+      return;
+    glm::vec3 invDir = 1.0f / dir;
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+      const SDFBVHNode &node = m_Nodes[stack[--top]];
+      if (!RayHitsBox(origin, invDir, node.minP, node.maxP))
+        continue;
+
+      if (node.left < 0) {
+        for (int i = node.first; i < node.first + node.count; ++i) {
+          float t;
+          if (RayTriangle(origin, dir, m_Tris[i], t))
+            hits.push_back(t);
+        }
+        continue;
+      }
+      stack[top++] = node.left;
+      stack[top++] = node.right;
+    }
+  }
+
+private:
+  int Build(int first, int count) {
+    int index = (int)m_Nodes.size();
+    m_Nodes.emplace_back();
+
+    glm::vec3 minP(std::numeric_limits<float>::max());
+    glm::vec3 maxP(std::numeric_limits<float>::lowest());
+    glm::vec3 cMin = minP, cMax = maxP;
+    for (int i = first; i < first + count; ++i) {
+      minP = glm::min(minP, m_Tris[i].minP);
+      maxP = glm::max(maxP, m_Tris[i].maxP);
+      cMin = glm::min(cMin, m_Tris[i].centroid);
+      cMax = glm::max(cMax, m_Tris[i].centroid);
+    }
+    m_Nodes[index].minP = minP;
+    m_Nodes[index].maxP = maxP;
+
+    glm::vec3 extent = cMax - cMin;
+    int axis = 0;
+    if (extent.y > extent.x)
+      axis = 1;
+    if (extent.z > extent[axis])
+      axis = 2;
+
+    if (count <= 4 || extent[axis] <= 0.0f) {
+      m_Nodes[index].first = first;
+      m_Nodes[index].count = count;
+      return index;
+    }
+
+    int mid = first + count / 2;
+    std::nth_element(m_Tris.begin() + first, m_Tris.begin() + mid,
+                     m_Tris.begin() + first + count,
+                     [axis](const SDFTriangle &a, const SDFTriangle &b) {
+                       return a.centroid[axis] < b.centroid[axis];
+                     });
+
+    int left = Build(first, mid - first);
+    int right = Build(mid, first + count - mid);
+    m_Nodes[index].left = left;
+    m_Nodes[index].right = right;
+    return index;
+  }
+
+  static float BoxDistanceSq(const glm::vec3 &p, const glm::vec3 &minP,
+                             const glm::vec3 &maxP) {
+    glm::vec3 d = glm::max(glm::max(minP - p, p - maxP), glm::vec3(0.0f));
+    return glm::dot(d, d);
+  }
+
+  static bool RayHitsBox(const glm::vec3 &o, const glm::vec3 &invDir,
+                         const glm::vec3 &minP, const glm::vec3 &maxP) {
+    glm::vec3 t0 = (minP - o) * invDir;
+    glm::vec3 t1 = (maxP - o) * invDir;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), tNear.z);
+    float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+    return exit >= std::max(enter, 0.0f);
+  }
+
+  static bool RayTriangle(const glm::vec3 &o, const glm::vec3 &d,
+                          const SDFTriangle &t, float &outT) {
+    glm::vec3 e1 = t.v1 - t.v0;
+    glm::vec3 e2 = t.v2 - t.v0;
+    glm::vec3 p = glm::cross(d, e2);
+    float det = glm::dot(e1, p);
+    if (std::fabs(det) < 1e-12f)
+      return false;
+    float invDet = 1.0f / det;
+    glm::vec3 s = o - t.v0;
+    float u = glm::dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f)
+      return false;
+    glm::vec3 q = glm::cross(s, e1);
+    float v = glm::dot(d, q) * invDet;
+    if (v < 0.0f || u + v > 1.0f)
+      return false;
+    outT = glm::dot(e2, q) * invDet;
+    return outT >= 0.0f;
+  }
+
+public:
+  // Ericson, Real-Time Collision Detection, 5.1.5.
+  static glm::vec3 ClosestPointOnTriangle(const glm::vec3 &p,
+                                          const glm::vec3 &a,
+                                          const glm::vec3 &b,
+                                          const glm::vec3 &c) {
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+      return a;
+
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+      return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+      return a + ab * (d1 / (d1 - d3));
+
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+      return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+      return a + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+      return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    float denom = 1.0f / (va + vb + vc);
+    float v = vb * denom;
+    float w = vc * denom;
+    return a + ab * v + ac * w;
+  }
+
+private:
+  std::vector<SDFTriangle> m_Tris;
+  std::vector<SDFBVHNode> m_Nodes;
+};
+
+static std::vector<SDFTriangle>
+GatherTriangles(const std::vector<Vertex> &vertices,
+                const std::vector<GLuint> &indices) {
+  std::vector<SDFTriangle> tris;
+  tris.reserve(indices.size() / 3);
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    if (indices[i] >= vertices.size() || indices[i + 1] >= vertices.size() ||
+        indices[i + 2] >= vertices.size())
+      continue;
+    SDFTriangle t;
+    t.v0 = vertices[indices[i]].position;
+    t.v1 = vertices[indices[i + 1]].position;
+    t.v2 = vertices[indices[i + 2]].position;
+    t.minP = glm::min(t.v0, glm::min(t.v1, t.v2));
+    t.maxP = glm::max(t.v0, glm::max(t.v1, t.v2));
+    t.centroid = (t.v0 + t.v1 + t.v2) / 3.0f;
+    tris.push_back(t);
+  }
+  return tris;
+}
+
+// Inside test by ray parity: one ray per grid row along each axis, and a
+// voxel counts as inside when at least two of the three rows agree. The vote
+// keeps small holes in non-watertight meshes from flipping whole rows.
+static std::vector<uint8_t> ComputeInsideVotes(const SDFBVH &bvh,
+                                               const glm::vec3 &minP,
+                                               const glm::vec3 &voxel,
+                                               int res) {
+  std::vector<uint8_t> votes((size_t)res * res * res, 0);
+  // A tiny skew keeps rays from running exactly along shared edges.
+  const glm::vec3 jitter(1.3e-4f, 2.9e-4f, 1.7e-4f);
+
+  for (int axis = 0; axis < 3; ++axis) {
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
+    ThreadManager::ParallelFor(0, res, [&](int j) {
+      std::vector<float> hits;
+      for (int i = 0; i < res; ++i) {
+        glm::vec3 origin = minP + voxel * 0.5f;
+        origin[u] += voxel[u] * i + jitter[u] * voxel[u];
+        origin[v] += voxel[v] * j + jitter[v] * voxel[v];
+        origin[axis] = minP[axis] - voxel[axis];
+        glm::vec3 dir(0.0f);
+        dir[axis] = 1.0f;
+
+        hits.clear();
+        bvh.IntersectAll(origin, dir, hits);
+        std::sort(hits.begin(), hits.end());
+
+        size_t h = 0;
+        for (int k = 0; k < res; ++k) {
+          float t = voxel[axis] * (k + 1.5f);
+          while (h < hits.size() && hits[h] < t)
+            ++h;
+          if (h % 2 == 1) {
+            glm::ivec3 c;
+            c[axis] = k;
+            c[u] = i;
+            c[v] = j;
+            size_t idx =
+                (size_t)c.x + (size_t)c.y * res + (size_t)c.z * res * res;
+            // Rows along different axes write the same voxel from different
+            // tasks only in different passes, so no atomics are needed.
+            votes[idx]++;
+          }
+        }
+      }
+    });
+  }
+  return votes;
+}
+
+static void FastSweep(std::vector<float> &dist,
+                      const std::vector<uint8_t> &fixed, int res, float h) {
+  auto at = [res](int x, int y, int z) {
+    return (size_t)x + (size_t)y * res + (size_t)z * res * res;
+  };
+
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int sweep = 0; sweep < 8; ++sweep) {
+      int sx = (sweep & 1) ? -1 : 1;
+      int sy = (sweep & 2) ? -1 : 1;
+      int sz = (sweep & 4) ? -1 : 1;
+      for (int zi = 0; zi < res; ++zi) {
+        int z = sz > 0 ? zi : res - 1 - zi;
+        for (int yi = 0; yi < res; ++yi) {
+          int y = sy > 0 ? yi : res - 1 - yi;
+          for (int xi = 0; xi < res; ++xi) {
+            int x = sx > 0 ? xi : res - 1 - xi;
+            size_t idx = at(x, y, z);
+            if (fixed[idx])
+              continue;
+
+            float a = std::min(x > 0 ? dist[at(x - 1, y, z)] : dist[idx],
+                               x < res - 1 ? dist[at(x + 1, y, z)] : dist[idx]);
+            float b = std::min(y > 0 ? dist[at(x, y - 1, z)] : dist[idx],
+                               y < res - 1 ? dist[at(x, y + 1, z)] : dist[idx]);
+            float c = std::min(z > 0 ? dist[at(x, y, z - 1)] : dist[idx],
+                               z < res - 1 ? dist[at(x, y, z + 1)] : dist[idx]);
+            if (a > b)
+              std::swap(a, b);
+            if (b > c)
+              std::swap(b, c);
+            if (a > b)
+              std::swap(a, b);
+
+            // Godunov upwind solution of |grad d| = 1, one to three terms.
+            float d = a + h;
+            if (d > b) {
+              d = 0.5f * (a + b + std::sqrt(2.0f * h * h - (a - b) * (a - b)));
+              if (d > c) {
+                float s = a + b + c;
+                float q = a * a + b * b + c * c - h * h;
+                d = (s + std::sqrt(std::max(0.0f, s * s - 3.0f * q))) / 3.0f;
+              }
+            }
+            dist[idx] = std::min(dist[idx], d);
+          }
+        }
+      }
+    }
+  }
+}
+
+std::vector<float> SDFGenerator::BakeDistanceField(
+    const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices,
+    const glm::vec3 &minP, const glm::vec3 &maxP, int resolution,
+    const SDFBakeSettings &settings) {
+  int res = std::max(resolution, 1);
+  size_t voxelCount = (size_t)res * res * res;
+  std::vector<float> data(voxelCount, std::numeric_limits<float>::max());
+
+  std::vector<SDFTriangle> tris = GatherTriangles(vertices, indices);
+  SDFBVH bvh(tris);
+  if (bvh.Empty())
+    return data;
+
+  glm::vec3 voxel = glm::max((maxP - minP) / (float)res, glm::vec3(1e-6f));
+  auto center = [&](int x, int y, int z) {
+    return minP + voxel * glm::vec3(x + 0.5f, y + 0.5f, z + 0.5f);
+  };
+
+  std::vector<uint8_t> exact(voxelCount, 1);
+  if (settings.fastSweep) {
+    std::fill(exact.begin(), exact.end(), 0);
+    int band = std::max(settings.exactBand, 1);
+    for (const auto &t : tris) {
+      glm::ivec3 lo = glm::ivec3(glm::floor((t.minP - minP) / voxel)) - band;
+      glm::ivec3 hi = glm::ivec3(glm::floor((t.maxP - minP) / voxel)) + band;
+      lo = glm::clamp(lo, glm::ivec3(0), glm::ivec3(res - 1));
+      hi = glm::clamp(hi, glm::ivec3(0), glm::ivec3(res - 1));
+      for (int z = lo.z; z <= hi.z; ++z)
+        for (int y = lo.y; y <= hi.y; ++y)
+          for (int x = lo.x; x <= hi.x; ++x)
+            exact[(size_t)x + (size_t)y * res + (size_t)z * res * res] = 1;
+    }
+  }
+
+  ThreadManager::ParallelFor(0, res, [&](int z) {
+    for (int y = 0; y < res; ++y) {
+      for (int x = 0; x < res; ++x) {
+        size_t idx = (size_t)x + (size_t)y * res + (size_t)z * res * res;
+        if (exact[idx])
+          data[idx] = std::sqrt(bvh.ClosestDistanceSq(center(x, y, z)));
+      }
+    }
+  });
+
+  if (settings.fastSweep) {
+    float h = std::min(voxel.x, std::min(voxel.y, voxel.z));
+    FastSweep(data, exact, res, h);
+  }
+
+  std::vector<uint8_t> votes = ComputeInsideVotes(bvh, minP, voxel, res);
+  for (size_t i = 0; i < voxelCount; ++i) {
+    if (votes[i] >= 2)
+      data[i] = -data[i];
+  }
+  return data;
+}
+
+static uint64_t HashMesh(const Mesh &mesh, int resolution,
+                         const SDFBakeSettings &settings) {
+  uint64_t h = 1469598103934665603ull;
+  auto mix = [&h](const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      h ^= bytes[i];
+      h *= 1099511628211ull;
+    }
+  };
+  for (const auto &v : mesh.vertices)
+    mix(&v.position, sizeof(v.position));
+  if (!mesh.indices.empty())
+    mix(mesh.indices.data(), mesh.indices.size() * sizeof(GLuint));
+  mix(&resolution, sizeof(resolution));
+  uint32_t mode = settings.fastSweep ? (uint32_t)settings.exactBand : 0u;
+  mix(&mode, sizeof(mode));
+  mix(&SDF_CACHE_VERSION, sizeof(SDF_CACHE_VERSION));
+  return h;
+}
+
+std::string SDFGenerator::GetCacheDirectory() {
+  std::string projectRoot = Application::Get().GetProjectRoot();
+  if (projectRoot.empty())
+    return "Cache/SDF";
+  return projectRoot + "/Cache/SDF";
+}
+
+static std::string CacheFilePath(uint64_t hash, int resolution) {
+  char name[64];
+  snprintf(name, sizeof(name), "%016llx_%d.sdf", (unsigned long long)hash,
+           resolution);
+  return SDFGenerator::GetCacheDirectory() + "/" + name;
+}
+
+static bool ReadCacheFile(const std::string &path, int resolution,
+                          glm::vec3 &minP, glm::vec3 &maxP,
+                          std::vector<float> &data) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  char magic[8];
+  int32_t res = 0;
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char *>(&res), sizeof(res));
+  file.read(reinterpret_cast<char *>(&minP), sizeof(minP));
+  file.read(reinterpret_cast<char *>(&maxP), sizeof(maxP));
+  if (!file || std::memcmp(magic, SDF_CACHE_MAGIC, sizeof(magic)) != 0 ||
+      res != resolution)
+    return false;
+
+  data.resize((size_t)res * res * res);
+  file.read(reinterpret_cast<char *>(data.data()), data.size() * sizeof(float));
+  return (bool)file;
+}
+
+static void WriteCacheFile(const std::string &path, int resolution,
+                           const glm::vec3 &minP, const glm::vec3 &maxP,
+                           const std::vector<float> &data) {
+  std::error_code ec;
+  std::filesystem::create_directories(
+      std::filesystem::path(path).parent_path(), ec);
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return;
+
+  int32_t res = resolution;
+  file.write(SDF_CACHE_MAGIC, sizeof(SDF_CACHE_MAGIC));
+  file.write(reinterpret_cast<const char *>(&res), sizeof(res));
+  file.write(reinterpret_cast<const char *>(&minP), sizeof(minP));
+  file.write(reinterpret_cast<const char *>(&maxP), sizeof(maxP));
+  file.write(reinterpret_cast<const char *>(data.data()),
+             data.size() * sizeof(float));
+}
+
+static std::mutex s_SDFCacheMutex;
+static std::unordered_map<uint64_t, SDFVolume> s_SDFVolumes;
+
+void SDFGenerator::ClearCache() {
+  std::lock_guard<std::mutex> lock(s_SDFCacheMutex);
+  for (auto &[hash, vol] : s_SDFVolumes) {
+    if (vol.textureID != 0)
+      glDeleteTextures(1, &vol.textureID);
+  }
+  s_SDFVolumes.clear();
+}
+
+void SDFGenerator::ReleaseUnused(
+    const std::unordered_set<unsigned int> &inUse) {
+  std::lock_guard<std::mutex> lock(s_SDFCacheMutex);
+  for (auto it = s_SDFVolumes.begin(); it != s_SDFVolumes.end();) {
+    if (inUse.count(it->second.textureID)) {
+      ++it;
+      continue;
+    }
+    if (it->second.textureID != 0)
+      glDeleteTextures(1, &it->second.textureID);
+    it = s_SDFVolumes.erase(it);
+  }
+}
 
 SDFVolume SDFGenerator::GenerateSDF(const Mesh &mesh, int resolution) {
-  Logger::AddLog("[SDF] Generating %dx%dx%d volume...", resolution, resolution,
-                 resolution);
+  return GenerateSDF(mesh, resolution, SDFBakeSettings());
+}
+
+SDFVolume SDFGenerator::GenerateSDF(const Mesh &mesh, int resolution,
+                                    const SDFBakeSettings &settings) {
+  if (mesh.vertices.empty() || mesh.indices.empty() || resolution <= 0) {
+    Logger::AddLog("[SDF] Skipped: mesh has no CPU-side geometry.");
+    return {0, mesh.minAABB, mesh.maxAABB, resolution};
+  }
+
+  uint64_t hash = HashMesh(mesh, resolution, settings);
+  {
+    std::lock_guard<std::mutex> lock(s_SDFCacheMutex);
+    auto it = s_SDFVolumes.find(hash);
+    if (it != s_SDFVolumes.end())
+      return it->second;
+  }
 
-  std::vector<float> data(resolution * resolution * resolution);
   glm::vec3 minP = mesh.minAABB;
   glm::vec3 maxP = mesh.maxAABB;
 
-  
+  // Flat meshes such as a Plane still get some depth, so no voxel axis is
+  // zero.
   glm::vec3 size = maxP - minP;
+  float minSize = std::max(std::max(size.x, std::max(size.y, size.z)) * 0.05f,
+                           1e-3f);
+  glm::vec3 grow = glm::max(glm::vec3(minSize) - size, glm::vec3(0.0f));
+  minP -= grow * 0.5f;
+  maxP += grow * 0.5f;
+  size = maxP - minP;
   minP -= size * 0.1f;
   maxP += size * 0.1f;
-  size = maxP - minP;
 
-  for (int z = 0; z < resolution; z++) {
-    for (int y = 0; y < resolution; y++) {
-      for (int x = 0; x < resolution; x++) {
-        glm::vec3 samplePos = minP + size * glm::vec3((float)x / resolution,
-                                                      (float)y / resolution,
-                                                      (float)z / resolution);
-        data[x + y * resolution + z * resolution * resolution] =
-            CalculateDistanceToMesh(samplePos, mesh);
-      }
-    }
+  std::vector<float> data;
+  std::string cachePath = CacheFilePath(hash, resolution);
+  bool fromDisk = settings.useDiskCache &&
+                  ReadCacheFile(cachePath, resolution, minP, maxP, data);
+
+  if (fromDisk) {
+    Logger::AddLog("[SDF] Loaded %dx%dx%d volume from cache.", resolution,
+                   resolution, resolution);
+  } else {
+    auto start = std::chrono::steady_clock::now();
+    data = BakeDistanceField(mesh.vertices, mesh.indices, minP, maxP,
+                             resolution, settings);
+    float ms = std::chrono::duration<float, std::milli>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+    Logger::AddLog("[SDF] Baked %dx%dx%d volume (%zu tris) in %.1f ms",
+                   resolution, resolution, resolution, mesh.indices.size() / 3,
+                   ms);
+    if (settings.useDiskCache)
+      WriteCacheFile(cachePath, resolution, minP, maxP, data);
   }
 
   unsigned int texID;
@@ -42,28 +586,41 @@ SDFVolume SDFGenerator::GenerateSDF(const Mesh &mesh, int resolution) {
   glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-  return {texID, minP, maxP, resolution};
+  SDFVolume vol = {texID, minP, maxP, resolution};
+  std::lock_guard<std::mutex> lock(s_SDFCacheMutex);
+  s_SDFVolumes[hash] = vol;
+  return vol;
 }
 
 float SDFGenerator::CalculateDistanceToMesh(const glm::vec3 &samplePoint,
                                             const Mesh &mesh) {
-  float minDist = std::numeric_limits<float>::max();
+  float minDistSq = std::numeric_limits<float>::max();
+  int crossings = 0;
+  const glm::vec3 dir = glm::normalize(glm::vec3(1.0f, 1.3e-4f, 2.9e-4f));
 
-  
-  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+  for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
     glm::vec3 v0 = mesh.vertices[mesh.indices[i]].position;
     glm::vec3 v1 = mesh.vertices[mesh.indices[i + 1]].position;
     glm::vec3 v2 = mesh.vertices[mesh.indices[i + 2]].position;
 
-    
-    glm::vec3 center = (v0 + v1 + v2) / 3.0f;
-    float d = glm::distance(samplePoint, center);
-    if (d < minDist)
-      minDist = d;
+    glm::vec3 c = SDFBVH::ClosestPointOnTriangle(samplePoint, v0, v1, v2);
+    glm::vec3 d = samplePoint - c;
+    minDistSq = std::min(minDistSq, glm::dot(d, d));
+
+    glm::vec3 e1 = v1 - v0, e2 = v2 - v0;
+    glm::vec3 p = glm::cross(dir, e2);
+    float det = glm::dot(e1, p);
+    if (std::fabs(det) < 1e-12f)
+      continue;
+    glm::vec3 s = samplePoint - v0;
+    float u = glm::dot(s, p) / det;
+    glm::vec3 q = glm::cross(s, e1);
+    float v = glm::dot(dir, q) / det;
+    if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f &&
+        glm::dot(e2, q) / det >= 0.0f)
+      crossings++;
   }
 
-  
-  
-  
-  return minDist;
+  float dist = std::sqrt(minDistSq);
+  return (crossings % 2 == 1) ? -dist : dist;
 }
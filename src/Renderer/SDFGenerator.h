@@ -2,6 +2,8 @@
 #define SDFGENERATOR_H
 
 #include "Mesh.h"
+#include <string>
+#include <unordered_set>
 #include <vector>
 
 struct SDFVolume {
@@ -11,11 +13,35 @@ struct SDFVolume {
   int resolution;
 };
 
+struct SDFBakeSettings {
+  // Exact distances are only evaluated within exactBand voxels of the
+  // surface; the rest of the grid is filled by fast sweeping.
+  bool fastSweep = false;
+  int exactBand = 2;
+  bool useDiskCache = true;
+};
+
 class SDFGenerator {
 public:
   static SDFVolume GenerateSDF(const Mesh &mesh, int resolution = 32);
+  static SDFVolume GenerateSDF(const Mesh &mesh, int resolution,
+                               const SDFBakeSettings &settings);
+
+  // Signed distance (negative inside) sampled at voxel centres of the
+  // [minP, maxP] box, laid out x-fastest.
+  static std::vector<float> BakeDistanceField(
+      const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices,
+      const glm::vec3 &minP, const glm::vec3 &maxP, int resolution,
+      const SDFBakeSettings &settings = SDFBakeSettings());
+
   static float CalculateDistanceToMesh(const glm::vec3 &samplePoint,
                                        const Mesh &mesh);
+
+  // Deletes every cached volume; GenerateSDF loads them back from disk.
+  static void ClearCache();
+  // Deletes cached volumes whose texture is not in inUse.
+  static void ReleaseUnused(const std::unordered_set<unsigned int> &inUse);
+  static std::string GetCacheDirectory();
 };
 
 #endif
@@ -87,6 +87,10 @@ void Shader::use() { glUseProgram(ID); }
 
 void Shader::Delete() { glDeleteProgram(ID); }
 
+bool Shader::hasUniform(const std::string &name) const {
+  return GetUniformLocation(name) != -1;
+}
+
 GLint Shader::GetUniformLocation(const std::string &name) const {
   auto it = m_UniformLocationCache.find(name);
   if (it != m_UniformLocationCache.end())
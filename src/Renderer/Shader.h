@@ -26,6 +26,8 @@ public:
   void setVec2(const std::string &name, const glm::vec2 &value) const;
   void setVec3(const std::string &name, const glm::vec3 &value) const;
   void setVec4(const std::string &name, const glm::vec4 &value) const;
+  // False when the linked program has no active uniform of that name.
+  bool hasUniform(const std::string &name) const;
 
 private:
   void checkCompileErrors(GLuint shader, std::string type);
@@ -1,83 +1,179 @@
 #include "StaticBatcher.h"
 #include "../Core/Logger.h"
+#include "../Core/ThreadManager.h"
+#include "Renderer.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
+#include <unordered_map>
 
-std::map<std::string, StaticBatcher::Batch> StaticBatcher::s_Batches;
+std::vector<StaticBatcher::Batch> StaticBatcher::s_Batches;
+int StaticBatcher::s_DrawnLastFrame = 0;
+size_t StaticBatcher::s_TrianglesLastFrame = 0;
+float StaticBatcher::s_ChunkSize = 64.0f;
 
-std::string GetMaterialSignature(const Material &mat) {
-  return mat.diffuseTexture + "|" + mat.specularTexture + "|" +
-         mat.customShaderName + "|" + std::to_string(mat.albedo.r) +
-         std::to_string(mat.albedo.g) + std::to_string(mat.albedo.b) + "|" +
-         std::to_string(mat.metallic) + "|" + std::to_string(mat.roughness) +
-         "|" + std::to_string(mat.isTransparent);
-}
+struct StaticBatchKey {
+  uint64_t materialHash;
+  glm::ivec3 cell;
+
+  bool operator==(const StaticBatchKey &o) const {
+    return materialHash == o.materialHash && cell == o.cell;
+  }
+};
+
+struct StaticBatchKeyHash {
+  size_t operator()(const StaticBatchKey &k) const {
+    size_t h = (size_t)k.materialHash;
+    h ^= (size_t)k.cell.x * 73856093u;
+    h ^= (size_t)k.cell.y * 19349663u;
+    h ^= (size_t)k.cell.z * 83492791u;
+    return h;
+  }
+};
+
+struct StaticBatchGeometry {
+  std::vector<Vertex> vertices;
+  std::vector<GLuint> indices;
+  std::vector<Mesh::LODLevel> lods;
+};
 
 void StaticBatcher::Bake(Scene &scene) {
   Clear();
   auto &objects = scene.GetObjects();
 
-  
+  std::vector<int> candidates;
   for (size_t i = 0; i < objects.size(); ++i) {
     auto &obj = objects[i];
     if (obj.isStatic && obj.isActive && obj.meshType != MeshType::Camera &&
-        obj.meshType != MeshType::None) {
-      std::string sig = GetMaterialSignature(obj.material);
-      s_Batches[sig].material = obj.material;
-      s_Batches[sig].originalObjectIndices.push_back((int)i);
+        obj.meshType != MeshType::None && !obj.mesh.vertices.empty()) {
+      candidates.push_back((int)i);
     }
   }
+  if (candidates.empty())
+    return;
+
+  // Per-object material hash and world transform, computed once up front.
+  std::vector<uint64_t> hashes(candidates.size());
+  std::vector<glm::mat4> transforms(candidates.size());
+  std::vector<glm::ivec3> cells(candidates.size());
+  float chunkSize = glm::max(s_ChunkSize, 1.0f);
+
+  ThreadManager::ParallelFor(0, (int)candidates.size(), [&](int c) {
+    const auto &obj = objects[candidates[c]];
+    hashes[c] = obj.material.Hash();
+    transforms[c] = scene.GetGlobalTransform(candidates[c]);
+    glm::vec3 localCenter = (obj.mesh.minAABB + obj.mesh.maxAABB) * 0.5f;
+    glm::vec3 center = glm::vec3(transforms[c] * glm::vec4(localCenter, 1.0f));
+    cells[c] = glm::ivec3(glm::floor(center / chunkSize));
+  });
+
+  std::unordered_map<StaticBatchKey, int, StaticBatchKeyHash> lookup;
+  std::vector<std::vector<int>> members;
+  for (size_t c = 0; c < candidates.size(); ++c) {
+    StaticBatchKey key{hashes[c], cells[c]};
+    auto it = lookup.find(key);
+    if (it == lookup.end()) {
+      it = lookup.emplace(key, (int)s_Batches.size()).first;
+      Batch batch;
+      batch.material = objects[candidates[c]].material;
+      batch.materialHash = key.materialHash;
+      batch.cell = key.cell;
+      s_Batches.push_back(batch);
+      members.emplace_back();
+    }
+    s_Batches[it->second].originalObjectIndices.push_back(candidates[c]);
+    members[it->second].push_back((int)c);
+  }
 
-  
-  for (auto &pair : s_Batches) {
-    std::vector<Vertex> batchVertices;
-    std::vector<GLuint> batchIndices;
-    std::vector<Texture> batchTextures; 
-
-    GLuint indexOffset = 0;
+  // Merge and simplify each chunk on the worker pool; only the GL upload
+  // below has to happen on this thread.
+  std::vector<StaticBatchGeometry> geometry(s_Batches.size());
+  ThreadManager::ParallelFor(0, (int)s_Batches.size(), [&](int b) {
+    StaticBatchGeometry &geo = geometry[b];
+    size_t vertexCount = 0, indexCount = 0;
+    for (int c : members[b]) {
+      vertexCount += objects[candidates[c]].mesh.vertices.size();
+      indexCount += objects[candidates[c]].mesh.indices.size();
+    }
+    geo.vertices.reserve(vertexCount);
+    geo.indices.reserve(indexCount);
 
-    for (int idx : pair.second.originalObjectIndices) {
-      auto &obj = objects[idx];
-      glm::mat4 model = scene.GetGlobalTransform(idx);
+    for (int c : members[b]) {
+      const auto &obj = objects[candidates[c]];
+      const glm::mat4 &model = transforms[c];
       glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+      GLuint indexOffset = (GLuint)geo.vertices.size();
 
-      if (batchTextures.empty() && !obj.mesh.textures.empty()) {
-        batchTextures = obj.mesh.textures;
-      }
-
-      
       for (const auto &v : obj.mesh.vertices) {
         Vertex worldVert = v;
         worldVert.position = glm::vec3(model * glm::vec4(v.position, 1.0f));
         worldVert.normal = glm::normalize(normalMatrix * v.normal);
-        batchVertices.push_back(worldVert);
+        geo.vertices.push_back(worldVert);
       }
+      for (GLuint index : obj.mesh.indices)
+        geo.indices.push_back(index + indexOffset);
+    }
 
-      
-      for (GLuint index : obj.mesh.indices) {
-        batchIndices.push_back(index + indexOffset);
-      }
-      indexOffset += obj.mesh.vertices.size();
+    if (geo.indices.size() > 900)
+      geo.lods = Mesh::BuildLODLevels(geo.vertices, geo.indices);
+  });
 
-      
-      obj.isActive = false;
-    }
+  size_t totalVertices = 0;
+  for (size_t b = 0; b < s_Batches.size(); ++b) {
+    StaticBatchGeometry &geo = geometry[b];
+    if (geo.vertices.empty())
+      continue;
 
-    if (!batchVertices.empty()) {
-      pair.second.combinedMesh =
-          new Mesh(batchVertices, batchIndices, batchTextures);
-      Logger::AddLog("Baked static batch with %zu vertices, %zu indices",
-                     batchVertices.size(), batchIndices.size());
+    std::vector<Texture> batchTextures;
+    for (int idx : s_Batches[b].originalObjectIndices) {
+      if (!objects[idx].mesh.textures.empty()) {
+        batchTextures = objects[idx].mesh.textures;
+        break;
+      }
     }
+
+    s_Batches[b].combinedMesh =
+        new Mesh(geo.vertices, geo.indices, batchTextures, std::move(geo.lods));
+    totalVertices += geo.vertices.size();
   }
+
+  for (int idx : candidates)
+    objects[idx].isActive = false;
+
+  Logger::AddLog("Baked %zu static chunks (%zu objects, %zu vertices)",
+                 s_Batches.size(), candidates.size(), totalVertices);
+  if (Renderer::s_ReleaseCPUMeshData)
+    ReleaseCPUData();
 }
 
-void StaticBatcher::DrawBatches(Shader &shader, Camera &camera) {
-  for (auto &pair : s_Batches) {
-    if (!pair.second.combinedMesh)
+void StaticBatcher::DrawBatches(Shader &shader, Camera &camera,
+                                const Frustum *frustum, bool useAutoLOD,
+                                bool primaryView) {
+  s_DrawnLastFrame = 0;
+  size_t triangles = 0;
+  glm::mat4 identity = glm::mat4(1.0f);
+
+  for (auto &batch : s_Batches) {
+    Mesh *mesh = batch.combinedMesh;
+    if (!mesh)
+      continue;
+
+    if (frustum && !frustum->IsOnFrustum(mesh->minAABB, mesh->maxAABB))
       continue;
 
-    const Material &mat = pair.second.material;
+    // Same selection as regular objects, without the cross-fade; chunk
+    // vertices are already in world space so the bounds give both the
+    // centre and the radius.
+    int storedLOD = mesh->currentLOD;
+    mesh->currentLOD = 0;
+    if (useAutoLOD && !mesh->lodLevels.empty()) {
+      glm::vec3 center = (mesh->minAABB + mesh->maxAABB) * 0.5f;
+      float radius = glm::length(mesh->maxAABB - mesh->minAABB) * 0.5f;
+      mesh->currentLOD = Renderer::SelectLOD(
+          *mesh, Renderer::LODPixelsPerUnit(camera, center, radius),
+          storedLOD);
+    }
+
+    const Material &mat = batch.material;
     shader.setVec3("material.albedo", mat.albedo);
     shader.setFloat("material.metallic", mat.metallic);
     shader.setFloat("material.roughness", mat.roughness);
@@ -85,22 +181,57 @@ void StaticBatcher::DrawBatches(Shader &shader, Camera &camera) {
     shader.setInt("material.useTexture", mat.useTexture ? 1 : 0);
     shader.setInt("material.isTransparent", mat.isTransparent ? 1 : 0);
 
-    
-    glm::mat4 identity = glm::mat4(1.0f);
     shader.setMat4("model", identity);
-
-    pair.second.combinedMesh->Draw(shader, camera, identity);
+    mesh->Draw(shader, camera, identity);
+    s_DrawnLastFrame++;
+
+    if (mesh->currentLOD > 0)
+      triangles += mesh->lodLevels[mesh->currentLOD - 1].indexCount / 3;
+    else
+      triangles += mesh->indexCount / 3;
+    if (!primaryView)
+      mesh->currentLOD = storedLOD;
   }
+
+  if (primaryView)
+    s_TrianglesLastFrame = triangles;
 }
 
 void StaticBatcher::Clear() {
-  for (auto &pair : s_Batches) {
-    if (pair.second.combinedMesh) {
-      pair.second.combinedMesh->Delete();
-      delete pair.second.combinedMesh;
+  for (auto &batch : s_Batches) {
+    if (batch.combinedMesh) {
+      for (auto &lod : batch.combinedMesh->lodLevels) {
+        glDeleteVertexArrays(1, &lod.vao);
+        glDeleteBuffers(1, &lod.vbo);
+        glDeleteBuffers(1, &lod.ebo);
+      }
+      batch.combinedMesh->Delete();
+      delete batch.combinedMesh;
     }
   }
   s_Batches.clear();
+  s_DrawnLastFrame = 0;
+  s_TrianglesLastFrame = 0;
 }
 
 bool StaticBatcher::HasBatches() { return !s_Batches.empty(); }
+
+size_t StaticBatcher::ReleaseCPUData() {
+  size_t bytes = 0;
+  for (auto &batch : s_Batches) {
+    if (batch.combinedMesh)
+      bytes += batch.combinedMesh->ReleaseCPUData();
+  }
+  return bytes;
+}
+
+MemoryTagStats StaticBatcher::GetMemoryStats() {
+  MemoryTagStats stats;
+  for (const auto &batch : s_Batches) {
+    if (!batch.combinedMesh)
+      continue;
+    stats.cpuBytes += batch.combinedMesh->GetMemoryBytes();
+    stats.gpuBytes += batch.combinedMesh->GetGPUBytes();
+  }
+  return stats;
+}
@@ -1,29 +1,49 @@
 #ifndef STATIC_BATCHER_H
 #define STATIC_BATCHER_H
 
+#include "../Core/MemoryTracker.h"
 #include "../Scene/Scene.h"
+#include "Frustum.h"
 #include "Mesh.h"
 #include "Shader.h"
-#include <map>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 class StaticBatcher {
 public:
   static void Bake(Scene &scene);
-  static void DrawBatches(Shader &shader, Camera &camera);
+  // frustum may be null to draw every chunk. Only the primary view keeps
+  // the per-chunk LOD hysteresis state and the triangle count.
+  static void DrawBatches(Shader &shader, Camera &camera,
+                          const Frustum *frustum = nullptr,
+                          bool useAutoLOD = false, bool primaryView = true);
   static void Clear();
   static bool HasBatches();
 
+  static int GetBatchCount() { return (int)s_Batches.size(); }
+  static int GetDrawnLastFrame() { return s_DrawnLastFrame; }
+  static size_t GetTrianglesLastFrame() { return s_TrianglesLastFrame; }
+
+  // Frees the CPU copies of the chunk meshes; returns the bytes freed.
+  static size_t ReleaseCPUData();
+  static MemoryTagStats GetMemoryStats();
+
+  // Edge length of the world-space cells static objects are clustered into.
+  static float s_ChunkSize;
+
 private:
   struct Batch {
     Mesh *combinedMesh = nullptr;
     Material material;
-    std::vector<int> originalObjectIndices; 
+    uint64_t materialHash = 0;
+    glm::ivec3 cell = glm::ivec3(0);
+    std::vector<int> originalObjectIndices;
   };
 
-  
-  static std::map<std::string, Batch> s_Batches;
+  static std::vector<Batch> s_Batches;
+  static int s_DrawnLastFrame;
+  static size_t s_TrianglesLastFrame;
 };
 
 #endif
@@ -1,44 +1,1034 @@
 #include "StreamingManager.h"
 #include "../Core/Logger.h"
+#include "../Core/ResourceManager.h"
 #include "../ModelImport/ModelImporter.h"
 #include "../Scene/Scene.h"
+#include "../Tools/Profiler/PerfCounters.h"
+#include "../Tools/Profiler/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
 #include <glm/gtx/norm.hpp>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 bool StreamingManager::s_EnableStreaming = true;
 float StreamingManager::s_StreamingRadius = 100.0f;
+float StreamingManager::s_UploadBudgetMs = 2.0f;
+size_t StreamingManager::s_UploadBudgetBytes = 16 * 1024 * 1024;
+size_t StreamingManager::s_MemoryBudgetBytes = 512 * 1024 * 1024;
+float StreamingManager::s_UnloadDelaySeconds = 2.0f;
+float StreamingManager::s_CellSize = 50.0f;
+StreamingStats StreamingManager::s_Stats;
+
+struct PreparedMesh {
+  ImportedMeshData data;
+  std::vector<Mesh::LODLevel> lods;
+  size_t bytes = 0;
+};
+
+struct StreamRequest {
+  int objectIndex;
+  std::string modelPath;
+  int meshIndex;
+  float priority;
+};
+
+struct StreamResult {
+  int objectIndex;
+  std::string modelPath;
+  int meshIndex;
+  unsigned int generation;
+  std::shared_ptr<const PreparedMesh> mesh;
+};
+
+static constexpr int STREAMING_WORKERS = 2;
+static constexpr size_t STREAMING_CACHE_BYTES = 64 * 1024 * 1024;
+static constexpr char STREAMING_SECTOR_MAGIC[8] = {'C', '3', 'D', 'S',
+                                                   'E', 'C', 'T', 0};
+static constexpr uint32_t STREAMING_SECTOR_VERSION = 1;
+
+static std::mutex s_Mutex;
+static std::condition_variable s_Condition;
+static std::vector<StreamRequest> s_Queue;
+static std::deque<StreamResult> s_Completed;
+static std::unordered_set<int> s_InFlight;
+static std::vector<std::thread> s_Workers;
+static bool s_Stop = false;
+static unsigned int s_Generation = 0;
+static Scene *s_ActiveScene = nullptr;
+// CacheKey()s whose import failed; not requested again until the scene
+// changes. Main thread only.
+static std::unordered_set<std::string> s_FailedKeys;
+// CacheKey() -> sector payload file holding that mesh, from the last loaded
+// manifest. Guarded by s_Mutex.
+static std::unordered_map<std::string, std::string> s_SectorFiles;
+
+static constexpr int64_t NO_CELL = std::numeric_limits<int64_t>::min();
+
+static std::unordered_map<int64_t, StreamingCell> s_Cells;
+static std::unordered_set<int64_t> s_InRangeCells;
+static std::unordered_set<int64_t> s_OutCells;
+static std::vector<int64_t> s_ObjectCell;
+// Transforms the grid was built from, checked a slice per frame so moved or
+// re-flagged static objects rebuild it.
+struct StreamingTransform {
+  glm::vec3 position;
+  glm::quat rotation;
+  glm::vec3 scale;
+};
+static std::vector<StreamingTransform> s_ObjectTransform;
+static size_t s_VerifyCursor = 0;
+static constexpr size_t STREAMING_VERIFY_PER_FRAME = 512;
+static Scene *s_GridScene = nullptr;
+static bool s_GridDirty = true;
+static size_t s_GridObjectCount = 0;
+static float s_GridCellSize = 0.0f;
+static bool s_HasEvaluated = false;
+static glm::vec3 s_LastEvalPos(0.0f);
+static float s_LastEvalRadius = 0.0f;
+
+static std::mutex s_CacheMutex;
+static std::list<std::pair<std::string, std::shared_ptr<const PreparedMesh>>>
+    s_PreparedCache;
+static size_t s_PreparedCacheBytes = 0;
+
+static double NowSeconds() {
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string CacheKey(const std::string &path, int meshIndex) {
+  return path + "#" + std::to_string(meshIndex);
+}
+
+static std::shared_ptr<const PreparedMesh>
+FindPrepared(const std::string &key) {
+  std::lock_guard<std::mutex> lock(s_CacheMutex);
+  for (auto it = s_PreparedCache.begin(); it != s_PreparedCache.end(); ++it) {
+    if (it->first == key) {
+      s_PreparedCache.splice(s_PreparedCache.begin(), s_PreparedCache, it);
+      return it->second;
+    }
+  }
+  return nullptr;
+}
+
+static void StorePrepared(const std::string &key,
+                          std::shared_ptr<const PreparedMesh> mesh) {
+  std::lock_guard<std::mutex> lock(s_CacheMutex);
+  s_PreparedCache.emplace_front(key, mesh);
+  s_PreparedCacheBytes += mesh->bytes;
+  while (s_PreparedCacheBytes > STREAMING_CACHE_BYTES &&
+         s_PreparedCache.size() > 1) {
+    s_PreparedCacheBytes -= s_PreparedCache.back().second->bytes;
+    s_PreparedCache.pop_back();
+  }
+}
+
+static std::shared_ptr<const PreparedMesh>
+PrepareMesh(const ImportResult &file, int meshIndex) {
+  if (!file.success || meshIndex < 0 || meshIndex >= (int)file.meshes.size())
+    return nullptr;
+  auto built = std::make_shared<PreparedMesh>();
+  built->data = file.meshes[meshIndex];
+  if (built->data.indices.size() > 900) {
+    built->lods =
+        Mesh::BuildLODLevels(built->data.vertices, built->data.indices);
+  }
+  built->bytes = built->data.vertices.size() * sizeof(Vertex) +
+                 built->data.indices.size() * sizeof(GLuint);
+  for (const auto &lod : built->lods) {
+    built->bytes += lod.vertices.size() * sizeof(Vertex) +
+                    lod.indices.size() * sizeof(GLuint);
+  }
+  return built;
+}
+
+// Sector payloads hold the prepared meshes (vertices, indices, texture paths
+// and LOD chain) of every model mesh a sector uses, so a sector entering
+// range is read from one file without parsing models or simplifying LODs.
+template <typename T>
+static void SectorWriteVector(std::ofstream &file, const std::vector<T> &v) {
+  uint32_t count = (uint32_t)v.size();
+  file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  file.write(reinterpret_cast<const char *>(v.data()), count * sizeof(T));
+}
+
+static void SectorWriteString(std::ofstream &file, const std::string &str) {
+  uint32_t length = (uint32_t)str.size();
+  file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+  file.write(str.data(), length);
+}
+
+// Counts are checked against the bytes left in the file so a truncated or
+// corrupt payload fails instead of allocating or reading past its end.
+template <typename T>
+static bool SectorReadVector(std::ifstream &file, std::streamoff size,
+                             std::vector<T> &v) {
+  uint32_t count = 0;
+  file.read(reinterpret_cast<char *>(&count), sizeof(count));
+  if (!file || (uint64_t)count * sizeof(T) >
+                   (uint64_t)(size - (std::streamoff)file.tellg()))
+    return false;
+  v.resize(count);
+  file.read(reinterpret_cast<char *>(v.data()), count * sizeof(T));
+  return (bool)file;
+}
+
+static bool SectorReadString(std::ifstream &file, std::streamoff size,
+                             std::string &str) {
+  std::vector<char> chars;
+  if (!SectorReadVector(file, size, chars))
+    return false;
+  str.assign(chars.begin(), chars.end());
+  return true;
+}
+
+static bool WriteSectorPayload(
+    const std::filesystem::path &path,
+    const std::vector<std::pair<std::string, int>> &meshes,
+    const std::unordered_map<std::string, std::shared_ptr<const PreparedMesh>>
+        &prepared) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return false;
+  uint32_t header[2] = {STREAMING_SECTOR_VERSION, (uint32_t)meshes.size()};
+  file.write(STREAMING_SECTOR_MAGIC, sizeof(STREAMING_SECTOR_MAGIC));
+  file.write(reinterpret_cast<const char *>(header), sizeof(header));
+  for (const auto &[modelPath, meshIndex] : meshes) {
+    const PreparedMesh &mesh = *prepared.at(CacheKey(modelPath, meshIndex));
+    SectorWriteString(file, modelPath);
+    file.write(reinterpret_cast<const char *>(&meshIndex), sizeof(meshIndex));
+    SectorWriteVector(file, mesh.data.vertices);
+    SectorWriteVector(file, mesh.data.indices);
+    uint32_t textureCount = (uint32_t)mesh.data.texturePaths.size();
+    file.write(reinterpret_cast<const char *>(&textureCount),
+               sizeof(textureCount));
+    for (const auto &texturePath : mesh.data.texturePaths)
+      SectorWriteString(file, texturePath);
+    uint32_t lodCount = (uint32_t)mesh.lods.size();
+    file.write(reinterpret_cast<const char *>(&lodCount), sizeof(lodCount));
+    for (const auto &lod : mesh.lods) {
+      SectorWriteVector(file, lod.vertices);
+      SectorWriteVector(file, lod.indices);
+      file.write(reinterpret_cast<const char *>(&lod.error),
+                 sizeof(lod.error));
+    }
+  }
+  return (bool)file;
+}
+
+static bool ReadSectorPayload(
+    const std::string &path,
+    std::unordered_map<std::string, std::shared_ptr<const PreparedMesh>>
+        &out) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open())
+    return false;
+  std::streamoff size = file.tellg();
+  file.seekg(0);
+
+  char magic[8];
+  uint32_t header[2] = {0, 0};
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char *>(header), sizeof(header));
+  if (!file ||
+      std::memcmp(magic, STREAMING_SECTOR_MAGIC, sizeof(magic)) != 0 ||
+      header[0] != STREAMING_SECTOR_VERSION)
+    return false;
+
+  for (uint32_t m = 0; m < header[1]; ++m) {
+    auto mesh = std::make_shared<PreparedMesh>();
+    std::string modelPath;
+    int meshIndex = 0;
+    uint32_t textureCount = 0;
+    if (!SectorReadString(file, size, modelPath))
+      return false;
+    file.read(reinterpret_cast<char *>(&meshIndex), sizeof(meshIndex));
+    if (!SectorReadVector(file, size, mesh->data.vertices) ||
+        !SectorReadVector(file, size, mesh->data.indices))
+      return false;
+    file.read(reinterpret_cast<char *>(&textureCount), sizeof(textureCount));
+    for (uint32_t t = 0; t < textureCount && file; ++t) {
+      mesh->data.texturePaths.emplace_back();
+      if (!SectorReadString(file, size, mesh->data.texturePaths.back()))
+        return false;
+    }
+    uint32_t lodCount = 0;
+    file.read(reinterpret_cast<char *>(&lodCount), sizeof(lodCount));
+    if (!file || lodCount > 16)
+      return false;
+    mesh->lods.resize(lodCount);
+    for (auto &lod : mesh->lods) {
+      if (!SectorReadVector(file, size, lod.vertices) ||
+          !SectorReadVector(file, size, lod.indices))
+        return false;
+      file.read(reinterpret_cast<char *>(&lod.error), sizeof(lod.error));
+    }
+    if (!file)
+      return false;
+
+    mesh->bytes = mesh->data.vertices.size() * sizeof(Vertex) +
+                  mesh->data.indices.size() * sizeof(GLuint);
+    for (const auto &lod : mesh->lods) {
+      mesh->bytes += lod.vertices.size() * sizeof(Vertex) +
+                     lod.indices.size() * sizeof(GLuint);
+    }
+    out[CacheKey(modelPath, meshIndex)] = std::move(mesh);
+  }
+  return true;
+}
+
+void StreamingManager::StartWorkers() {
+  if (!s_Workers.empty())
+    return;
+  s_Stop = false;
+  for (int i = 0; i < STREAMING_WORKERS; ++i) {
+    s_Workers.emplace_back(WorkerThread);
+  }
+}
+
+void StreamingManager::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Stop = true;
+    s_Queue.clear();
+    s_Completed.clear();
+    s_InFlight.clear();
+  }
+  s_Condition.notify_all();
+  for (auto &worker : s_Workers) {
+    if (worker.joinable())
+      worker.join();
+  }
+  s_Workers.clear();
+
+  s_FailedKeys.clear();
+  std::lock_guard<std::mutex> lock(s_CacheMutex);
+  s_PreparedCache.clear();
+  s_PreparedCacheBytes = 0;
+}
+
+void StreamingManager::Reset(Scene *scene) {
+  std::lock_guard<std::mutex> lock(s_Mutex);
+  s_Queue.clear();
+  s_Completed.clear();
+  s_InFlight.clear();
+  s_Generation++;
+  s_ActiveScene = scene;
+  s_FailedKeys.clear();
+}
+
+void StreamingManager::WorkerThread() {
+  PROFILE_THREAD("Streaming");
+  while (true) {
+    std::vector<StreamRequest> batch;
+    std::vector<std::string> sectorFiles;
+    unsigned int generation;
+    {
+      std::unique_lock<std::mutex> lock(s_Mutex);
+      s_Condition.wait(lock, [] { return s_Stop || !s_Queue.empty(); });
+      if (s_Stop)
+        return;
+
+      batch.push_back(std::move(s_Queue.back()));
+      s_Queue.pop_back();
+
+      // Everything else queued from the same file rides along so the file is
+      // parsed once.
+      std::string path = batch.front().modelPath;
+      for (auto it = s_Queue.begin(); it != s_Queue.end();) {
+        if (it->modelPath == path) {
+          batch.push_back(std::move(*it));
+          it = s_Queue.erase(it);
+        } else {
+          ++it;
+        }
+      }
+      for (const auto &req : batch) {
+        s_InFlight.insert(req.objectIndex);
+        auto sector =
+            s_SectorFiles.find(CacheKey(req.modelPath, req.meshIndex));
+        sectorFiles.push_back(sector != s_SectorFiles.end() ? sector->second
+                                                            : std::string());
+      }
+      generation = s_Generation;
+    }
+
+    PROFILE_SCOPE("StreamBatch");
+    std::unique_ptr<ImportResult> file;
+    std::unordered_map<int, std::shared_ptr<const PreparedMesh>> prepared;
+    std::unordered_map<std::string, std::shared_ptr<const PreparedMesh>>
+        fromSectors;
+    std::unordered_set<std::string> sectorsRead;
+    std::vector<StreamResult> results;
+
+    for (size_t r = 0; r < batch.size(); ++r) {
+      const StreamRequest &req = batch[r];
+      std::shared_ptr<const PreparedMesh> mesh;
+      auto found = prepared.find(req.meshIndex);
+      if (found != prepared.end()) {
+        mesh = found->second;
+      } else {
+        std::string key = CacheKey(req.modelPath, req.meshIndex);
+        mesh = FindPrepared(key);
+        // The whole sector comes in with its first mesh; the rest wait in
+        // the prepared cache for the requests that follow.
+        if (!mesh && !sectorFiles[r].empty() &&
+            sectorsRead.insert(sectorFiles[r]).second) {
+          PROFILE_SCOPE("StreamSector");
+          std::unordered_map<std::string, std::shared_ptr<const PreparedMesh>>
+              sector;
+          if (ReadSectorPayload(sectorFiles[r], sector)) {
+            for (auto &[sectorKey, sectorMesh] : sector) {
+              StorePrepared(sectorKey, sectorMesh);
+              fromSectors[sectorKey] = sectorMesh;
+            }
+          } else {
+            C3D_LOG_WARN(LogCategory::Streaming,
+                         "[Streaming] Sector payload %s is unreadable, "
+                         "importing its models instead",
+                         sectorFiles[r].c_str());
+          }
+        }
+        if (!mesh) {
+          auto fromSector = fromSectors.find(key);
+          if (fromSector != fromSectors.end())
+            mesh = fromSector->second;
+        }
+        if (!mesh) {
+          if (!file) {
+            file = std::make_unique<ImportResult>(
+                ModelImporter::Import(req.modelPath, false));
+          }
+          mesh = PrepareMesh(*file, req.meshIndex);
+          if (mesh)
+            StorePrepared(key, mesh);
+        }
+        prepared[req.meshIndex] = mesh;
+      }
+      results.push_back(
+          {req.objectIndex, req.modelPath, req.meshIndex, generation, mesh});
+    }
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    if (generation != s_Generation)
+      continue;
+    for (auto &res : results)
+      s_Completed.push_back(std::move(res));
+  }
+}
+
+
+bool StreamingManager::IsStreamable(const GameObject &obj) {
+  if (obj.modelPath.empty() || obj.meshType == MeshType::Cube ||
+      obj.meshType == MeshType::Sphere || obj.meshType == MeshType::Plane)
+    return false;
+  return obj.isStatic;
+}
+
+static int64_t CellKey(int x, int z) {
+  return ((int64_t)x << 32) | (uint32_t)z;
+}
+
+static float DistanceSqToCell(const glm::vec3 &p, const StreamingCell &cell) {
+  return glm::distance2(p, glm::clamp(p, cell.minBounds, cell.maxBounds));
+}
+
+static std::unordered_map<int64_t, StreamingCell>
+BuildCells(const std::vector<GameObject> &objects, float cellSize) {
+  std::unordered_map<int64_t, StreamingCell> cells;
+  for (int i = 0; i < (int)objects.size(); ++i) {
+    const auto &obj = objects[i];
+    if (!StreamingManager::IsStreamable(obj))
+      continue;
+
+    int x = (int)std::floor(obj.position.x / cellSize);
+    int z = (int)std::floor(obj.position.z / cellSize);
+    StreamingCell &cell = cells[CellKey(x, z)];
+    cell.x = x;
+    cell.z = z;
+
+    AABB world = PhysicsEngine::GetTransformedAABB(obj.collider, obj.position,
+                                                   obj.rotation, obj.scale);
+    cell.minBounds =
+        glm::min(cell.minBounds, glm::min(world.min, obj.position));
+    cell.maxBounds =
+        glm::max(cell.maxBounds, glm::max(world.max, obj.position));
+    cell.objects.push_back(i);
+  }
+  return cells;
+}
+
+void StreamingManager::MarkDirty() { s_GridDirty = true; }
+
+void StreamingManager::AdoptCells(
+    Scene &scene, std::unordered_map<int64_t, StreamingCell> cells) {
+  auto &objects = scene.GetObjects();
+  s_Cells = std::move(cells);
+  s_InRangeCells.clear();
+  s_OutCells.clear();
+  s_ObjectCell.assign(objects.size(), NO_CELL);
+  s_ObjectTransform.resize(objects.size());
+  for (size_t i = 0; i < objects.size(); ++i)
+    s_ObjectTransform[i] = {objects[i].position, objects[i].rotation,
+                            objects[i].scale};
+  s_VerifyCursor = 0;
+
+  s_Stats.residentObjects = 0;
+  s_Stats.placeholderObjects = 0;
+  s_Stats.bytesResident = 0;
+
+  for (auto &[key, cell] : s_Cells) {
+    for (int idx : cell.objects) {
+      const auto &obj = objects[idx];
+      s_ObjectCell[idx] = key;
+      cell.lastInRange = std::max(cell.lastInRange, obj.streamLastInRange);
+      if (!obj.isStreamedOut) {
+        cell.hasResident = true;
+        s_Stats.residentObjects++;
+        s_Stats.bytesResident += obj.mesh.GetMemoryBytes();
+      } else if (obj.mesh.indexCount > 0) {
+        s_Stats.placeholderObjects++;
+        s_Stats.bytesResident += obj.mesh.GetMemoryBytes();
+      }
+    }
+    if (cell.hasResident)
+      s_OutCells.insert(key);
+  }
+
+  s_GridScene = &scene;
+  s_GridObjectCount = objects.size();
+  s_GridDirty = false;
+  s_HasEvaluated = false;
+}
+
+void StreamingManager::EvaluateCells(const glm::vec3 &cameraPos, double now) {
+  float radiusSq = s_StreamingRadius * s_StreamingRadius;
+  float hysteresisSq = radiusSq * 0.81f;
+
+  // Only cells that can touch the radius from the new position, plus the
+  // ones that were in range before, can change state.
+  std::vector<int64_t> examine(s_InRangeCells.begin(), s_InRangeCells.end());
+  float reach = s_StreamingRadius + s_CellSize;
+  int x0 = (int)std::floor((cameraPos.x - reach) / s_CellSize);
+  int x1 = (int)std::floor((cameraPos.x + reach) / s_CellSize);
+  int z0 = (int)std::floor((cameraPos.z - reach) / s_CellSize);
+  int z1 = (int)std::floor((cameraPos.z + reach) / s_CellSize);
+  size_t span = (size_t)(x1 - x0 + 1) * (size_t)(z1 - z0 + 1);
+  if (span > s_Cells.size()) {
+    for (const auto &[key, cell] : s_Cells)
+      examine.push_back(key);
+  } else {
+    for (int x = x0; x <= x1; ++x) {
+      for (int z = z0; z <= z1; ++z) {
+        int64_t key = CellKey(x, z);
+        if (s_Cells.count(key))
+          examine.push_back(key);
+      }
+    }
+  }
+
+  auto &objects = s_GridScene->GetObjects();
+  for (int64_t key : examine) {
+    StreamingCell &cell = s_Cells[key];
+    float d2 = DistanceSqToCell(cameraPos, cell);
+    bool inRange = cell.inRange ? d2 <= radiusSq : d2 < hysteresisSq;
+    if (inRange == cell.inRange)
+      continue;
+
+    cell.inRange = inRange;
+    if (inRange) {
+      s_InRangeCells.insert(key);
+      s_OutCells.erase(key);
+      cell.pendingLoads = true;
+    } else {
+      s_InRangeCells.erase(key);
+      cell.lastInRange = now;
+      for (int idx : cell.objects)
+        objects[idx].streamLastInRange = now;
+      if (cell.hasResident)
+        s_OutCells.insert(key);
+    }
+  }
+
+  s_LastEvalPos = cameraPos;
+  s_LastEvalRadius = s_StreamingRadius;
+  s_HasEvaluated = true;
+}
 
 void StreamingManager::Update(const glm::vec3 &cameraPos, Scene &scene) {
+  Update(cameraPos, glm::vec3(0.0f), scene);
+}
+
+void StreamingManager::Update(const glm::vec3 &cameraPos,
+                              const glm::vec3 &cameraForward, Scene &scene) {
   if (!s_EnableStreaming)
     return;
 
+  StartWorkers();
+  if (s_ActiveScene != &scene)
+    Reset(&scene);
+
   auto &objects = scene.GetObjects();
-  float radiusSq = s_StreamingRadius * s_StreamingRadius;
-  float hysteresisSq = radiusSq * 0.81f; 
+  if (!s_GridDirty && s_GridScene == &scene &&
+      s_GridObjectCount == objects.size()) {
+    size_t count = std::min(STREAMING_VERIFY_PER_FRAME, objects.size());
+    for (size_t n = 0; n < count && !s_GridDirty; ++n) {
+      size_t i = s_VerifyCursor++ % objects.size();
+      const GameObject &obj = objects[i];
+      const StreamingTransform &built = s_ObjectTransform[i];
+      bool inGrid = s_ObjectCell[i] != NO_CELL;
+      if (IsStreamable(obj) != inGrid ||
+          (inGrid && (obj.position != built.position ||
+                      obj.rotation != built.rotation ||
+                      obj.scale != built.scale)))
+        s_GridDirty = true;
+    }
+  }
+  if (s_GridDirty || s_GridScene != &scene ||
+      s_GridObjectCount != objects.size() || s_GridCellSize != s_CellSize) {
+    s_GridCellSize = s_CellSize;
+    AdoptCells(scene, BuildCells(objects, s_CellSize));
+  }
+
+  double now = NowSeconds();
+  float moveThreshold = s_CellSize * 0.05f;
+  if (!s_HasEvaluated || s_LastEvalRadius != s_StreamingRadius ||
+      glm::distance2(cameraPos, s_LastEvalPos) > moveThreshold * moveThreshold)
+    EvaluateCells(cameraPos, now);
+
+  bool hasForward = glm::length2(cameraForward) > 1e-6f;
+  glm::vec3 forward = hasForward ? glm::normalize(cameraForward) : glm::vec3(0);
 
-  for (auto &obj : objects) {
-    if (obj.modelPath.empty() || obj.meshType == MeshType::Cube ||
-        obj.meshType == MeshType::Sphere || obj.meshType == MeshType::Plane)
+  s_Stats.sectors = (int)s_Cells.size();
+  s_Stats.sectorsInRange = (int)s_InRangeCells.size();
+  s_Stats.bytesUploadedLastFrame = 0;
+  s_Stats.uploadMsLastFrame = 0.0f;
+  s_Stats.loadsLastFrame = 0;
+  s_Stats.evictionsLastFrame = 0;
+
+  std::vector<StreamRequest> requests;
+  for (int64_t key : s_InRangeCells) {
+    StreamingCell &cell = s_Cells[key];
+    if (!cell.pendingLoads)
       continue;
-    if (obj.isStatic == false)
-      continue; 
 
-    float d2 = glm::distance2(cameraPos, obj.position);
+    glm::vec3 center = (cell.minBounds + cell.maxBounds) * 0.5f;
+    float dist = std::sqrt(DistanceSqToCell(cameraPos, cell));
+    float priority = dist;
+    float centerDist = glm::distance(cameraPos, center);
+    if (hasForward && centerDist > 1e-3f) {
+      float facing = glm::dot(forward, (center - cameraPos) / centerDist);
+      priority *= 1.0f - 0.5f * facing;
+    }
+
+    bool pending = false;
+    for (int idx : cell.objects) {
+      const auto &obj = objects[idx];
+      if (obj.isStreamedOut &&
+          !s_FailedKeys.count(CacheKey(obj.modelPath, obj.meshIndex))) {
+        pending = true;
+        requests.push_back({idx, obj.modelPath, obj.meshIndex, priority});
+      }
+    }
+    cell.pendingLoads = pending;
+  }
+
+  std::sort(requests.begin(), requests.end(),
+            [](const StreamRequest &a, const StreamRequest &b) {
+              return a.priority > b.priority;
+            });
+
+  {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    requests.erase(std::remove_if(requests.begin(), requests.end(),
+                                  [](const StreamRequest &r) {
+                                    return s_InFlight.count(r.objectIndex) > 0;
+                                  }),
+                   requests.end());
+    s_Queue = std::move(requests);
+    s_Stats.queueDepth = (int)s_Queue.size();
+    s_Stats.awaitingUpload = (int)s_Completed.size();
+    s_Stats.inFlight =
+        std::max(0, (int)s_InFlight.size() - s_Stats.awaitingUpload);
+  }
+  if (s_Stats.queueDepth > 0)
+    s_Condition.notify_all();
+
+  if (!s_OutCells.empty()) {
+    std::vector<int64_t> outCells(s_OutCells.begin(), s_OutCells.end());
+    std::sort(outCells.begin(), outCells.end(), [](int64_t a, int64_t b) {
+      return s_Cells[a].lastInRange < s_Cells[b].lastInRange;
+    });
+
+    for (int64_t key : outCells) {
+      StreamingCell &cell = s_Cells[key];
+      bool overBudget = s_Stats.bytesResident > s_MemoryBudgetBytes;
+      bool expired = now - cell.lastInRange >= s_UnloadDelaySeconds;
+      if (!overBudget && !expired)
+        break;
+
+      for (int idx : cell.objects) {
+        auto &obj = objects[idx];
+        if (obj.isStreamedOut)
+          continue;
+
+        size_t before = obj.mesh.GetMemoryBytes();
+        if (obj.mesh.DropToCoarsestLOD()) {
+          s_Stats.placeholderObjects++;
+        } else {
+          obj.mesh.Delete();
+        }
+        s_Stats.bytesResident -= before - obj.mesh.GetMemoryBytes();
+        s_Stats.residentObjects--;
+        s_Stats.evictionsLastFrame++;
+        obj.isStreamedOut = true;
+        C3D_LOG_RATE_LIMITED(10, LogLevel::Info, LogCategory::Streaming,
+                             "[Streaming] Unloaded: %s", obj.name.c_str());
+      }
+      cell.hasResident = false;
+      s_OutCells.erase(key);
+    }
+  }
+
+  auto uploadStart = std::chrono::steady_clock::now();
+  while (true) {
+    StreamResult res;
+    {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      if (s_Completed.empty())
+        break;
+      if (s_Stats.loadsLastFrame > 0) {
+        float elapsedMs = std::chrono::duration<float, std::milli>(
+                              std::chrono::steady_clock::now() - uploadStart)
+                              .count();
+        if (elapsedMs >= s_UploadBudgetMs ||
+            s_Stats.bytesUploadedLastFrame >= s_UploadBudgetBytes)
+          break;
+      }
+      res = std::move(s_Completed.front());
+      s_Completed.pop_front();
+      s_InFlight.erase(res.objectIndex);
+    }
+
+    if (res.generation != s_Generation)
+      continue;
+    if (!res.mesh) {
+      if (s_FailedKeys.insert(CacheKey(res.modelPath, res.meshIndex)).second)
+        C3D_LOG_WARN(LogCategory::Streaming,
+                     "[Streaming] Could not load mesh %d of %s, skipping it",
+                     res.meshIndex, res.modelPath.c_str());
+      continue;
+    }
+    if (res.objectIndex < 0 || res.objectIndex >= (int)objects.size())
+      continue;
+    auto &obj = objects[res.objectIndex];
+    if (!obj.isStreamedOut || obj.modelPath != res.modelPath ||
+        obj.meshIndex != res.meshIndex)
+      continue;
 
-    if (!obj.isStreamedOut && d2 > radiusSq) {
-      
-      obj.mesh.Delete();
-      obj.isStreamedOut = true;
-      Logger::AddLog("[Streaming] Unloaded: %s", obj.name.c_str());
-    } else if (obj.isStreamedOut && d2 < hysteresisSq) {
-      
-      ImportResult res = ModelImporter::Import(obj.modelPath);
-      if (res.success && obj.meshIndex >= 0 &&
-          obj.meshIndex < (int)res.meshes.size()) {
-        const auto &meshData = res.meshes[obj.meshIndex];
-        obj.mesh = Mesh(meshData.vertices, meshData.indices, meshData.textures);
-        obj.isStreamedOut = false;
-        Logger::AddLog("[Streaming] Reloaded: %s", obj.name.c_str());
+    const auto &meshData = res.mesh->data;
+    std::vector<Texture> textures = obj.mesh.textures;
+    if (textures.empty()) {
+      for (const auto &path : meshData.texturePaths) {
+        textures.push_back(
+            ResourceManager::LoadTexture(path, path.c_str(), "diffuse", 0));
       }
     }
+
+    size_t placeholderBytes = obj.mesh.GetMemoryBytes();
+    obj.mesh.Delete();
+    obj.mesh = Mesh(meshData.vertices, meshData.indices, std::move(textures),
+                    res.mesh->lods);
+    obj.isStreamedOut = false;
+    obj.streamLastInRange = now;
+
+    int64_t key = s_ObjectCell[res.objectIndex];
+    if (key != NO_CELL) {
+      StreamingCell &cell = s_Cells[key];
+      cell.hasResident = true;
+      if (!cell.inRange)
+        s_OutCells.insert(key);
+    }
+
+    s_Stats.bytesResident =
+        s_Stats.bytesResident - placeholderBytes + res.mesh->bytes;
+    s_Stats.bytesUploadedLastFrame += res.mesh->bytes;
+    s_Stats.residentObjects++;
+    if (placeholderBytes > 0)
+      s_Stats.placeholderObjects--;
+    s_Stats.loadsLastFrame++;
+    PERF_COUNT(PerfCounter::StreamingLoads, 1);
+    PERF_COUNT(PerfCounter::StreamingBytesLoaded, res.mesh->bytes);
+    C3D_LOG_RATE_LIMITED(10, LogLevel::Info, LogCategory::Streaming,
+                         "[Streaming] Reloaded: %s", obj.name.c_str());
+  }
+  auto uploadEnd = std::chrono::steady_clock::now();
+  s_Stats.uploadMsLastFrame =
+      std::chrono::duration<float, std::milli>(uploadEnd - uploadStart)
+          .count();
+}
+
+static std::string SectorDirectory(const std::string &scenePath) {
+  return scenePath + ".sectors";
+}
+
+static std::string SectorFileName(const StreamingCell &cell) {
+  return "sector_" + std::to_string(cell.x) + "_" + std::to_string(cell.z) +
+         ".bin";
+}
+
+// A payload from an earlier save is kept when it holds the same meshes and
+// none of their model files changed since it was written.
+static bool SectorPayloadCurrent(
+    const std::filesystem::path &path,
+    const std::vector<std::pair<std::string, int>> &meshes,
+    const nlohmann::json *previous) {
+  namespace fs = std::filesystem;
+  if (!previous || !previous->is_array() || previous->size() != meshes.size())
+    return false;
+  for (size_t i = 0; i < meshes.size(); ++i) {
+    const auto &entry = (*previous)[i];
+    if (entry.value("model", std::string()) != meshes[i].first ||
+        entry.value("mesh", -1) != meshes[i].second)
+      return false;
+  }
+  std::error_code ec;
+  auto written = fs::last_write_time(path, ec);
+  if (ec)
+    return false;
+  for (const auto &[modelPath, meshIndex] : meshes) {
+    auto modified = fs::last_write_time(modelPath, ec);
+    if (ec || modified > written)
+      return false;
+  }
+  return true;
+}
+
+void StreamingManager::SaveSectors(const std::string &scenePath,
+                                   const Scene &scene) {
+  namespace fs = std::filesystem;
+  const auto &objects = scene.GetObjects();
+  auto cells = BuildCells(objects, s_CellSize);
+  fs::path dir = SectorDirectory(scenePath);
+
+  std::error_code ec;
+  if (cells.empty()) {
+    fs::remove_all(dir, ec);
+    return;
+  }
+  fs::create_directories(dir, ec);
+
+  nlohmann::json previous;
+  {
+    std::ifstream file(dir / "manifest.json");
+    if (file.is_open())
+      previous = nlohmann::json::parse(file, nullptr, false);
+  }
+  std::unordered_map<std::string, const nlohmann::json *> previousMeshes;
+  if (previous.is_object() && previous.contains("sectors") &&
+      previous["sectors"].is_array()) {
+    for (const auto &jSector : previous["sectors"]) {
+      if (jSector.contains("file") && jSector.contains("meshes"))
+        previousMeshes[jSector["file"].get<std::string>()] =
+            &jSector["meshes"];
+    }
+  }
+
+  // Model meshes of the sectors whose payload has to be rewritten; each
+  // model is parsed once for the whole save.
+  std::vector<std::vector<std::pair<std::string, int>>> sectorMeshes;
+  std::vector<bool> rewrite;
+  std::map<std::string, std::set<int>> needed;
+  for (const auto &[key, cell] : cells) {
+    std::set<std::pair<std::string, int>> unique;
+    for (int idx : cell.objects)
+      unique.insert({objects[idx].modelPath, objects[idx].meshIndex});
+    sectorMeshes.emplace_back(unique.begin(), unique.end());
+    auto prev = previousMeshes.find(SectorFileName(cell));
+    bool current = SectorPayloadCurrent(
+        dir / SectorFileName(cell), sectorMeshes.back(),
+        prev != previousMeshes.end() ? prev->second : nullptr);
+    rewrite.push_back(!current);
+    if (!current) {
+      for (const auto &[modelPath, meshIndex] : sectorMeshes.back())
+        needed[modelPath].insert(meshIndex);
+    }
+  }
+
+  std::unordered_map<std::string, std::shared_ptr<const PreparedMesh>>
+      prepared;
+  for (const auto &[modelPath, meshIndices] : needed) {
+    std::unique_ptr<ImportResult> file;
+    for (int meshIndex : meshIndices) {
+      std::string meshKey = CacheKey(modelPath, meshIndex);
+      std::shared_ptr<const PreparedMesh> mesh = FindPrepared(meshKey);
+      if (!mesh) {
+        if (!file) {
+          file = std::make_unique<ImportResult>(
+              ModelImporter::Import(modelPath, false));
+        }
+        mesh = PrepareMesh(*file, meshIndex);
+      }
+      if (mesh)
+        prepared[meshKey] = mesh;
+    }
+  }
+
+  nlohmann::json manifest;
+  manifest["version"] = 2;
+  manifest["cellSize"] = s_CellSize;
+  manifest["objectCount"] = objects.size();
+  manifest["sectors"] = nlohmann::json::array();
+
+  std::unordered_set<std::string> files;
+  int written = 0;
+  size_t index = 0;
+  for (const auto &[key, cell] : cells) {
+    auto &meshes = sectorMeshes[index];
+    std::string name = SectorFileName(cell);
+    if (rewrite[index++]) {
+      meshes.erase(std::remove_if(meshes.begin(), meshes.end(),
+                                  [&](const std::pair<std::string, int> &m) {
+                                    return !prepared.count(
+                                        CacheKey(m.first, m.second));
+                                  }),
+                   meshes.end());
+      if (!WriteSectorPayload(dir / name, meshes, prepared))
+        meshes.clear();
+      written++;
+    }
+
+    nlohmann::json jSector = {
+        {"x", cell.x},
+        {"z", cell.z},
+        {"min", {cell.minBounds.x, cell.minBounds.y, cell.minBounds.z}},
+        {"max", {cell.maxBounds.x, cell.maxBounds.y, cell.maxBounds.z}},
+        {"objects", cell.objects},
+        {"meshes", nlohmann::json::array()}};
+    if (!meshes.empty()) {
+      jSector["file"] = name;
+      files.insert(name);
+      for (const auto &[modelPath, meshIndex] : meshes)
+        jSector["meshes"].push_back(
+            {{"model", modelPath}, {"mesh", meshIndex}});
+    }
+    manifest["sectors"].push_back(std::move(jSector));
+  }
+
+  std::vector<fs::path> stale;
+  for (const auto &entry : fs::directory_iterator(dir, ec)) {
+    std::string name = entry.path().filename().string();
+    if (name.rfind("sector_", 0) == 0 && !files.count(name))
+      stale.push_back(entry.path());
+  }
+  for (const auto &path : stale)
+    fs::remove(path, ec);
+
+  std::ofstream file(dir / "manifest.json");
+  if (file.is_open())
+    file << manifest.dump(4);
+  if (written > 0)
+    C3D_LOG_INFO(LogCategory::Streaming,
+                 "[Streaming] Wrote %d of %zu sector payloads to %s", written,
+                 cells.size(), dir.string().c_str());
+}
+
+bool StreamingManager::LoadSectors(const std::string &scenePath, Scene &scene) {
+  namespace fs = std::filesystem;
+  s_GridDirty = true;
+  {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_SectorFiles.clear();
+  }
+
+  fs::path dir = SectorDirectory(scenePath);
+  std::ifstream file(dir / "manifest.json");
+  if (!file.is_open())
+    return false;
+
+  try {
+    nlohmann::json manifest = nlohmann::json::parse(file);
+    auto &objects = scene.GetObjects();
+
+    // Payloads are keyed by model mesh, so they stay usable even when the
+    // grid below has to be rebuilt. Ones older than their models are stale.
+    std::unordered_map<std::string, std::string> sectorFiles;
+    std::unordered_map<std::string, fs::file_time_type> modelTimes;
+    std::error_code ec;
+    for (const auto &jSector : manifest["sectors"]) {
+      if (!jSector.contains("file"))
+        continue;
+      fs::path payload = dir / jSector["file"].get<std::string>();
+      auto written = fs::last_write_time(payload, ec);
+      if (ec)
+        continue;
+      for (const auto &jMesh : jSector["meshes"]) {
+        std::string modelPath = jMesh["model"];
+        auto time = modelTimes.find(modelPath);
+        if (time == modelTimes.end()) {
+          auto modified = fs::last_write_time(modelPath, ec);
+          time = modelTimes
+                     .emplace(modelPath,
+                              ec ? fs::file_time_type::max() : modified)
+                     .first;
+        }
+        if (time->second <= written)
+          sectorFiles[CacheKey(modelPath, jMesh["mesh"].get<int>())] =
+              payload.string();
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_SectorFiles = std::move(sectorFiles);
+    }
+
+    // A grid saved with another sector size is rebuilt with the current one
+    // rather than overriding the setting.
+    if (manifest.value("objectCount", (size_t)0) != objects.size() ||
+        manifest.value("cellSize", 0.0f) != s_CellSize)
+      return false;
+
+    std::unordered_map<int64_t, StreamingCell> cells;
+    for (const auto &jSector : manifest["sectors"]) {
+      StreamingCell cell;
+      cell.x = jSector["x"];
+      cell.z = jSector["z"];
+      auto mn = jSector["min"];
+      auto mx = jSector["max"];
+      cell.minBounds = glm::vec3(mn[0], mn[1], mn[2]);
+      cell.maxBounds = glm::vec3(mx[0], mx[1], mx[2]);
+      for (int idx : jSector["objects"]) {
+        if (idx < 0 || idx >= (int)objects.size() ||
+            !IsStreamable(objects[idx]))
+          return false;
+        cell.objects.push_back(idx);
+      }
+      cells[CellKey(cell.x, cell.z)] = std::move(cell);
+    }
+
+    s_GridCellSize = s_CellSize;
+    AdoptCells(scene, std::move(cells));
+    C3D_LOG_INFO(LogCategory::Streaming,
+                 "[Streaming] Loaded %zu sectors from %s", s_Cells.size(),
+                 dir.string().c_str());
+    return true;
+  } catch (const std::exception &e) {
+    C3D_LOG_WARN(LogCategory::Streaming,
+                 "[Streaming] Sector manifest ignored: %s", e.what());
+    return false;
   }
 }
@@ -1,17 +1,87 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 class Scene;
+struct GameObject;
 
+struct StreamingCell {
+  int x = 0;
+  int z = 0;
+  glm::vec3 minBounds = glm::vec3(std::numeric_limits<float>::max());
+  glm::vec3 maxBounds = glm::vec3(std::numeric_limits<float>::lowest());
+  std::vector<int> objects;
+  bool inRange = false;
+  bool hasResident = false;
+  bool pendingLoads = false;
+  double lastInRange = 0.0;
+};
+
+struct StreamingStats {
+  int sectors = 0;
+  int sectorsInRange = 0;
+  int queueDepth = 0;
+  int inFlight = 0;
+  int awaitingUpload = 0;
+  int residentObjects = 0;
+  int placeholderObjects = 0;
+  size_t bytesResident = 0;
+  size_t bytesUploadedLastFrame = 0;
+  float uploadMsLastFrame = 0.0f;
+  int loadsLastFrame = 0;
+  int evictionsLastFrame = 0;
+};
+
+// Static model objects are binned into fixed-size XZ sectors; sectors are
+// only re-tested when the camera has moved, and load/unload as a unit.
+// Objects are decoded (file IO, parsing and LOD simplification) on dedicated
+// streaming threads and uploaded on the render thread under a per-frame
+// budget. Objects that leave the radius are evicted least-recently-used
+// first, down to their coarsest LOD where one exists, which then doubles as
+// the placeholder shown while the full mesh streams back in.
 class StreamingManager {
 public:
   static void Update(const glm::vec3 &cameraPos, Scene &scene);
+  static void Update(const glm::vec3 &cameraPos, const glm::vec3 &cameraForward,
+                     Scene &scene);
+  static void Shutdown();
+  static void MarkDirty();
+
+  // Writes <scene>.sectors/ next to the scene: manifest.json with each
+  // sector's bounds, object indices and payload file, and per sector a
+  // sector_<x>_<z>.bin holding its prepared meshes. Loading adopts the grid
+  // when the sector size still matches, and the streaming threads read a
+  // sector's payload instead of importing its models.
+  static void SaveSectors(const std::string &scenePath, const Scene &scene);
+  static bool LoadSectors(const std::string &scenePath, Scene &scene);
+
   static void SetStreamingRadius(float radius) { s_StreamingRadius = radius; }
   static float GetStreamingRadius() { return s_StreamingRadius; }
 
+  static const StreamingStats &GetStats() { return s_Stats; }
+  // Whether obj goes into a sector when streaming is enabled.
+  static bool IsStreamable(const GameObject &obj);
+
   static bool s_EnableStreaming;
+  static float s_UploadBudgetMs;
+  static size_t s_UploadBudgetBytes;
+  static size_t s_MemoryBudgetBytes;
+  static float s_UnloadDelaySeconds;
+  static float s_CellSize;
 
 private:
+  static void StartWorkers();
+  static void WorkerThread();
+  static void Reset(Scene *scene);
+  static void AdoptCells(Scene &scene,
+                         std::unordered_map<int64_t, StreamingCell> cells);
+  static void EvaluateCells(const glm::vec3 &cameraPos, double now);
+
   static float s_StreamingRadius;
+  static StreamingStats s_Stats;
 };
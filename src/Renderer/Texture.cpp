@@ -67,6 +67,13 @@ Texture::Texture(const char *image, const char *texType, GLuint slot) {
 
   glGenerateMipmap(GL_TEXTURE_2D);
 
+  if (numColCh >= 1 && numColCh <= 4) {
+    int channels = type == "specular" ? 1 : numColCh;
+    gpuBytes = (size_t)widthImg * heightImg * channels * 4 / 3;
+  } else {
+    gpuBytes = 4;
+  }
+
   stbi_image_free(bytes);
 
   glBindTexture(GL_TEXTURE_2D, 0);
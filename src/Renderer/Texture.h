@@ -12,6 +12,8 @@ public:
   const char *type;
   GLuint unit;
   std::string path;
+  // Image plus mip chain as uploaded; what the driver allocates may differ.
+  size_t gpuBytes = 0;
 
   Texture(const char *image = "../Resource/default/texture/DefaultTex.png",
           const char *texType = "diffuse", GLuint slot = 0);
@@ -1,32 +1,83 @@
 #include "VideoPlayer.h"
+#include "../AudioEngine/AudioStream.h"
 #include "../Core/Logger.h"
+#include "ResourceManager.h"
 #include <glad/glad.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
 #include <iostream>
-#include <cstdlib>
-#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 #include <libswscale/swscale.h>
+#include <libswresample/swresample.h>
 #include <libavutil/imgutils.h>
 }
 
+// swr_alloc_set_opts2 and AVChannelLayout arrived in FFmpeg 5.1.
+#define C3D_FFMPEG_CH_LAYOUT (LIBSWRESAMPLE_VERSION_INT >= AV_VERSION_INT(4, 5, 100))
+
+// Decoded frames buffered ahead of presentation. Enough to absorb decode
+// jitter without holding many full-size frames per player.
+static constexpr int VIDEO_FRAME_RING = 4;
+
 struct VideoPlayer::FFmpegContext {
     AVFormatContext* formatCtx = nullptr;
     AVCodecContext* codecCtx = nullptr;
     const AVCodec* codec = nullptr;
-    AVFrame* frame = nullptr;
-    AVFrame* frameRGB = nullptr;
     AVPacket* packet = nullptr;
+    AVFrame* decoded = nullptr;
+    // Only used for pixel formats the GPU path does not handle.
     SwsContext* swsCtx = nullptr;
-    
+
     int videoStreamIndex = -1;
-    uint8_t* buffer = nullptr;
+    int width = 0;
+    int height = 0;
     double timeBase = 0.0;
-    double currentTime = 0.0;
+    double startTime = 0.0;
+    double frameDuration = 1.0 / 30.0;
+
+    int audioStreamIndex = -1;
+    AVCodecContext* audioCodecCtx = nullptr;
+    AVFrame* audioFrame = nullptr;
+    SwrContext* swrCtx = nullptr;
+    double audioTimeBase = 0.0;
+    std::vector<float> audioScratch;
+    std::shared_ptr<AudioStream> audio;
+
+    // Shared with the decode thread, guarded by mutex.
+    AVFrame* ring[VIDEO_FRAME_RING] = {};
+    double ringPts[VIDEO_FRAME_RING] = {};
+    int ringHead = 0;
+    int ringCount = 0;
+    bool stop = false;
+    bool eof = false;
+    std::atomic<bool> looping{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+
+    // Render thread only.
+    double clock = 0.0;
+    bool bt709 = false;
+    bool fullRange = false;
+    unsigned int planeTex[3] = {0, 0, 0};
+    unsigned int pbo[2] = {0, 0};
+    size_t pboSize[2] = {0, 0};
+    int pboIndex = 0;
+    unsigned int fbo = 0;
+    unsigned int vao = 0;
 };
 
+static bool IsPlanar420(int format) {
+    return format == AV_PIX_FMT_YUV420P || format == AV_PIX_FMT_YUVJ420P;
+}
+
 VideoPlayer::VideoPlayer() : m_TextureID(0), m_Playing(false), m_Looping(false), m_Ctx(nullptr) {}
 
 VideoPlayer::~VideoPlayer() {
@@ -36,14 +87,7 @@ VideoPlayer::~VideoPlayer() {
 bool VideoPlayer::Open(const std::string& path) {
     Close();
     m_Ctx = new FFmpegContext();
-    
-    
-    std::string audioPath = path + "_audio.wav";
-    if (!std::filesystem::exists(audioPath)) {
-        Logger::AddLog("Extracting audio from video: %s", path.c_str());
-        std::string cmd = "ffmpeg -y -i \"" + path + "\" -vn -acodec pcm_s16le -ar 44100 -ac 2 \"" + audioPath + "\" > /dev/null 2>&1";
-        system(cmd.c_str());
-    }
+    m_Ctx->looping = m_Looping;
 
     if (avformat_open_input(&m_Ctx->formatCtx, path.c_str(), nullptr, nullptr) != 0) {
         Logger::AddLog("[VideoPlayer] Failed to open video: %s", path.c_str());
@@ -70,7 +114,8 @@ bool VideoPlayer::Open(const std::string& path) {
         return false;
     }
 
-    AVCodecParameters* codecPar = m_Ctx->formatCtx->streams[m_Ctx->videoStreamIndex]->codecpar;
+    AVStream* stream = m_Ctx->formatCtx->streams[m_Ctx->videoStreamIndex];
+    AVCodecParameters* codecPar = stream->codecpar;
     m_Ctx->codec = avcodec_find_decoder(codecPar->codec_id);
     if (!m_Ctx->codec) {
         Logger::AddLog("[VideoPlayer] Unsupported codec.");
@@ -80,6 +125,9 @@ bool VideoPlayer::Open(const std::string& path) {
 
     m_Ctx->codecCtx = avcodec_alloc_context3(m_Ctx->codec);
     avcodec_parameters_to_context(m_Ctx->codecCtx, codecPar);
+    // Let libavcodec pick a thread count and decode several frames at once.
+    m_Ctx->codecCtx->thread_count = 0;
+    m_Ctx->codecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 
     if (avcodec_open2(m_Ctx->codecCtx, m_Ctx->codec, nullptr) < 0) {
         Logger::AddLog("[VideoPlayer] Failed to open codec.");
@@ -87,23 +135,23 @@ bool VideoPlayer::Open(const std::string& path) {
         return false;
     }
 
-    m_Ctx->frame = av_frame_alloc();
-    m_Ctx->frameRGB = av_frame_alloc();
+    m_Ctx->decoded = av_frame_alloc();
     m_Ctx->packet = av_packet_alloc();
 
-    int numBytes = av_image_get_buffer_size(AV_PIX_FMT_RGBA, m_Ctx->codecCtx->width, m_Ctx->codecCtx->height, 1);
-    m_Ctx->buffer = (uint8_t*)av_malloc(numBytes * sizeof(uint8_t));
-
-    av_image_fill_arrays(m_Ctx->frameRGB->data, m_Ctx->frameRGB->linesize, m_Ctx->buffer, AV_PIX_FMT_RGBA, m_Ctx->codecCtx->width, m_Ctx->codecCtx->height, 1);
+    OpenAudio();
 
-    m_Ctx->swsCtx = sws_getContext(
-        m_Ctx->codecCtx->width, m_Ctx->codecCtx->height, m_Ctx->codecCtx->pix_fmt,
-        m_Ctx->codecCtx->width, m_Ctx->codecCtx->height, AV_PIX_FMT_RGBA,
-        SWS_BILINEAR, nullptr, nullptr, nullptr
-    );
+    m_Ctx->width = m_Ctx->codecCtx->width;
+    m_Ctx->height = m_Ctx->codecCtx->height;
+    m_Ctx->timeBase = av_q2d(stream->time_base);
+    if (stream->start_time != AV_NOPTS_VALUE)
+        m_Ctx->startTime = stream->start_time * m_Ctx->timeBase;
+    if (stream->avg_frame_rate.num > 0 && stream->avg_frame_rate.den > 0)
+        m_Ctx->frameDuration = av_q2d(av_inv_q(stream->avg_frame_rate));
 
-    AVRational tb = m_Ctx->formatCtx->streams[m_Ctx->videoStreamIndex]->time_base;
-    m_Ctx->timeBase = av_q2d(tb);
+    m_Ctx->bt709 = m_Ctx->codecCtx->colorspace == AVCOL_SPC_BT709 ||
+                   (m_Ctx->codecCtx->colorspace == AVCOL_SPC_UNSPECIFIED && m_Ctx->height >= 720);
+    m_Ctx->fullRange = m_Ctx->codecCtx->color_range == AVCOL_RANGE_JPEG ||
+                       m_Ctx->codecCtx->pix_fmt == AV_PIX_FMT_YUVJ420P;
 
     glGenTextures(1, &m_TextureID);
     glBindTexture(GL_TEXTURE_2D, m_TextureID);
@@ -111,86 +159,396 @@ bool VideoPlayer::Open(const std::string& path) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_Ctx->codecCtx->width, m_Ctx->codecCtx->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_Ctx->width, m_Ctx->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    if (IsPlanar420(m_Ctx->codecCtx->pix_fmt)) {
+        glGenTextures(3, m_Ctx->planeTex);
+        for (int p = 0; p < 3; p++) {
+            int w = p == 0 ? m_Ctx->width : (m_Ctx->width + 1) / 2;
+            int h = p == 0 ? m_Ctx->height : (m_Ctx->height + 1) / 2;
+            glBindTexture(GL_TEXTURE_2D, m_Ctx->planeTex[p]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        }
+
+        // Players are opened from inside scene rendering; keep its target bound.
+        GLint prevFBO;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFBO);
+        glGenFramebuffers(1, &m_Ctx->fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_Ctx->fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_TextureID, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, prevFBO);
+        glGenVertexArrays(1, &m_Ctx->vao);
+
+        if (!ResourceManager::HasShader("video_yuv")) {
+            ResourceManager::LoadShader("video_yuv", "../shaders/passes/video/yuv_to_rgb.vert",
+                                        "../shaders/passes/video/yuv_to_rgb.frag");
+        }
+    }
     glBindTexture(GL_TEXTURE_2D, 0);
+    glGenBuffers(2, m_Ctx->pbo);
 
     m_Playing = true;
-    m_Ctx->currentTime = 0.0;
-    
+    m_Ctx->clock = 0.0;
+    m_Ctx->thread = std::thread(&VideoPlayer::DecodeLoop, this);
+
     return true;
 }
 
 void VideoPlayer::Close() {
+    if (m_Ctx && m_Ctx->thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_Ctx->mutex);
+            m_Ctx->stop = true;
+        }
+        m_Ctx->cv.notify_all();
+        m_Ctx->thread.join();
+    }
+
     if (m_TextureID != 0) {
         glDeleteTextures(1, &m_TextureID);
         m_TextureID = 0;
     }
-    
+
     if (m_Ctx) {
-        if (m_Ctx->buffer) av_freep(&m_Ctx->buffer);
-        if (m_Ctx->frameRGB) av_frame_free(&m_Ctx->frameRGB);
-        if (m_Ctx->frame) av_frame_free(&m_Ctx->frame);
+        for (int i = 0; i < VIDEO_FRAME_RING; i++) {
+            if (m_Ctx->ring[i]) av_frame_free(&m_Ctx->ring[i]);
+        }
+        if (m_Ctx->planeTex[0]) glDeleteTextures(3, m_Ctx->planeTex);
+        if (m_Ctx->pbo[0]) glDeleteBuffers(2, m_Ctx->pbo);
+        if (m_Ctx->fbo) glDeleteFramebuffers(1, &m_Ctx->fbo);
+        if (m_Ctx->vao) glDeleteVertexArrays(1, &m_Ctx->vao);
+
+        if (m_Ctx->audioFrame) av_frame_free(&m_Ctx->audioFrame);
+        if (m_Ctx->audioCodecCtx) avcodec_free_context(&m_Ctx->audioCodecCtx);
+        if (m_Ctx->swrCtx) swr_free(&m_Ctx->swrCtx);
+        if (m_Ctx->decoded) av_frame_free(&m_Ctx->decoded);
         if (m_Ctx->packet) av_packet_free(&m_Ctx->packet);
         if (m_Ctx->codecCtx) avcodec_free_context(&m_Ctx->codecCtx);
         if (m_Ctx->formatCtx) avformat_close_input(&m_Ctx->formatCtx);
         if (m_Ctx->swsCtx) sws_freeContext(m_Ctx->swsCtx);
-        
+
         delete m_Ctx;
         m_Ctx = nullptr;
     }
     m_Playing = false;
 }
 
+void VideoPlayer::SetLooping(bool looping) {
+    m_Looping = looping;
+    if (m_Ctx) m_Ctx->looping = looping;
+}
+
 int VideoPlayer::GetWidth() const {
-    return m_Ctx && m_Ctx->codecCtx ? m_Ctx->codecCtx->width : 0;
+    return m_Ctx ? m_Ctx->width : 0;
 }
 
 int VideoPlayer::GetHeight() const {
-    return m_Ctx && m_Ctx->codecCtx ? m_Ctx->codecCtx->height : 0;
+    return m_Ctx ? m_Ctx->height : 0;
+}
+
+std::shared_ptr<AudioStream> VideoPlayer::GetAudioStream() const {
+    return m_Ctx ? m_Ctx->audio : nullptr;
+}
+
+void VideoPlayer::OpenAudio() {
+    int index = av_find_best_stream(m_Ctx->formatCtx, AVMEDIA_TYPE_AUDIO, -1, m_Ctx->videoStreamIndex, nullptr, 0);
+    if (index < 0) return;
+
+    AVStream* stream = m_Ctx->formatCtx->streams[index];
+    const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec) {
+        Logger::AddLog("[VideoPlayer] Unsupported audio codec, playing without sound.");
+        return;
+    }
+
+    AVCodecContext* codecCtx = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(codecCtx, stream->codecpar);
+    if (avcodec_open2(codecCtx, codec, nullptr) < 0) {
+        Logger::AddLog("[VideoPlayer] Failed to open audio codec, playing without sound.");
+        avcodec_free_context(&codecCtx);
+        return;
+    }
+
+    // Convert to interleaved float stereo at the source rate; miniaudio
+    // resamples to the device rate.
+    int sampleRate = codecCtx->sample_rate;
+    SwrContext* swr = nullptr;
+#if C3D_FFMPEG_CH_LAYOUT
+    AVChannelLayout stereo;
+    av_channel_layout_default(&stereo, 2);
+    swr_alloc_set_opts2(&swr, &stereo, AV_SAMPLE_FMT_FLT, sampleRate, &codecCtx->ch_layout,
+                        codecCtx->sample_fmt, sampleRate, 0, nullptr);
+#else
+    int64_t inLayout = codecCtx->channel_layout ? (int64_t)codecCtx->channel_layout
+                                                : av_get_default_channel_layout(codecCtx->channels);
+    swr = swr_alloc_set_opts(nullptr, AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_FLT, sampleRate, inLayout,
+                             codecCtx->sample_fmt, sampleRate, 0, nullptr);
+#endif
+    if (!swr || swr_init(swr) < 0) {
+        Logger::AddLog("[VideoPlayer] Failed to set up audio conversion, playing without sound.");
+        if (swr) swr_free(&swr);
+        avcodec_free_context(&codecCtx);
+        return;
+    }
+
+    m_Ctx->audioStreamIndex = index;
+    m_Ctx->audioCodecCtx = codecCtx;
+    m_Ctx->swrCtx = swr;
+    m_Ctx->audioFrame = av_frame_alloc();
+    m_Ctx->audioTimeBase = av_q2d(stream->time_base);
+    m_Ctx->audio = std::make_shared<AudioStream>(2, sampleRate);
+}
+
+void VideoPlayer::DecodeLoop() {
+    FFmpegContext* ctx = m_Ctx;
+    // Each loop of the file continues the timeline so the presentation clock
+    // never has to jump backwards.
+    double ptsOffset = 0.0;
+    double lastPts = 0.0;
+    bool decodedAny = false;
+
+    double audioNextPts = 0.0;
+    auto receiveAudio = [&]() {
+        while (avcodec_receive_frame(ctx->audioCodecCtx, ctx->audioFrame) == 0) {
+            AVFrame* frame = ctx->audioFrame;
+            int64_t ts = frame->best_effort_timestamp;
+            double pts = ts != AV_NOPTS_VALUE ? ts * ctx->audioTimeBase - ctx->startTime : audioNextPts;
+
+            int capacity = swr_get_out_samples(ctx->swrCtx, frame->nb_samples);
+            ctx->audioScratch.resize((size_t)capacity * 2);
+            uint8_t* out = (uint8_t*)ctx->audioScratch.data();
+            int converted = swr_convert(ctx->swrCtx, &out, capacity, (const uint8_t**)frame->extended_data,
+                                        frame->nb_samples);
+            if (converted > 0) {
+                ctx->audio->Push(ctx->audioScratch.data(), converted, ptsOffset + pts);
+                audioNextPts = pts + (double)converted / ctx->audioCodecCtx->sample_rate;
+            }
+            av_frame_unref(frame);
+        }
+    };
+
+    auto receiveFrames = [&]() -> bool {
+        while (avcodec_receive_frame(ctx->codecCtx, ctx->decoded) == 0) {
+            int64_t ts = ctx->decoded->best_effort_timestamp;
+            double pts = ts != AV_NOPTS_VALUE ? ts * ctx->timeBase - ctx->startTime
+                                              : lastPts + ctx->frameDuration;
+            lastPts = pts;
+            decodedAny = true;
+
+            AVFrame* out = av_frame_alloc();
+            if (IsPlanar420(ctx->decoded->format)) {
+                av_frame_move_ref(out, ctx->decoded);
+            } else {
+                ctx->swsCtx = sws_getCachedContext(
+                    ctx->swsCtx, ctx->decoded->width, ctx->decoded->height,
+                    (AVPixelFormat)ctx->decoded->format, ctx->width, ctx->height,
+                    AV_PIX_FMT_RGBA, SWS_BILINEAR, nullptr, nullptr, nullptr);
+                out->format = AV_PIX_FMT_RGBA;
+                out->width = ctx->width;
+                out->height = ctx->height;
+                av_frame_get_buffer(out, 0);
+                sws_scale(ctx->swsCtx, (uint8_t const* const*)ctx->decoded->data,
+                          ctx->decoded->linesize, 0, ctx->decoded->height,
+                          out->data, out->linesize);
+                av_frame_unref(ctx->decoded);
+            }
+
+            std::unique_lock<std::mutex> lock(ctx->mutex);
+            ctx->cv.wait(lock, [ctx] { return ctx->stop || ctx->ringCount < VIDEO_FRAME_RING; });
+            if (ctx->stop) {
+                av_frame_free(&out);
+                return false;
+            }
+            int slot = (ctx->ringHead + ctx->ringCount) % VIDEO_FRAME_RING;
+            ctx->ring[slot] = out;
+            ctx->ringPts[slot] = ptsOffset + pts;
+            ctx->ringCount++;
+        }
+        return true;
+    };
+
+    while (true) {
+        if (av_read_frame(ctx->formatCtx, ctx->packet) >= 0) {
+            if (ctx->packet->stream_index == ctx->videoStreamIndex) {
+                avcodec_send_packet(ctx->codecCtx, ctx->packet);
+            } else if (ctx->packet->stream_index == ctx->audioStreamIndex) {
+                if (avcodec_send_packet(ctx->audioCodecCtx, ctx->packet) == 0) receiveAudio();
+            }
+            av_packet_unref(ctx->packet);
+            if (!receiveFrames()) return;
+            continue;
+        }
+
+        // End of file: drain the frames still inside the decoder.
+        avcodec_send_packet(ctx->codecCtx, nullptr);
+        if (!receiveFrames()) return;
+        if (ctx->audioCodecCtx) {
+            avcodec_send_packet(ctx->audioCodecCtx, nullptr);
+            receiveAudio();
+        }
+
+        if (!ctx->looping || !decodedAny) {
+            std::unique_lock<std::mutex> lock(ctx->mutex);
+            ctx->eof = true;
+            ctx->cv.wait(lock, [ctx] { return ctx->stop; });
+            return;
+        }
+
+        av_seek_frame(ctx->formatCtx, -1, 0, AVSEEK_FLAG_BACKWARD);
+        avcodec_flush_buffers(ctx->codecCtx);
+        if (ctx->audioCodecCtx) avcodec_flush_buffers(ctx->audioCodecCtx);
+        ptsOffset += lastPts + ctx->frameDuration;
+        lastPts = 0.0;
+        decodedAny = false;
+    }
 }
 
 void VideoPlayer::Update(float dt) {
     if (!m_Ctx || !m_Playing) return;
-    
-    m_Ctx->currentTime += dt;
-    bool frameReady = false;
-
-    
-    while (av_read_frame(m_Ctx->formatCtx, m_Ctx->packet) >= 0) {
-        if (m_Ctx->packet->stream_index == m_Ctx->videoStreamIndex) {
-            if (avcodec_send_packet(m_Ctx->codecCtx, m_Ctx->packet) == 0) {
-                while (avcodec_receive_frame(m_Ctx->codecCtx, m_Ctx->frame) == 0) {
-                    double pts = m_Ctx->frame->pts * m_Ctx->timeBase;
-                    
-                    if (pts >= m_Ctx->currentTime) {
-                        sws_scale(m_Ctx->swsCtx, (uint8_t const * const *)m_Ctx->frame->data,
-                                  m_Ctx->frame->linesize, 0, m_Ctx->codecCtx->height,
-                                  m_Ctx->frameRGB->data, m_Ctx->frameRGB->linesize);
-                        frameReady = true;
-                        av_packet_unref(m_Ctx->packet);
-                        break; 
-                    }
-                }
-            }
+
+    m_Ctx->clock += dt;
+    if (m_Ctx->audio) m_Ctx->audio->SetClock(m_Ctx->clock);
+
+    AVFrame* frame = nullptr;
+    bool finished = false;
+    {
+        std::lock_guard<std::mutex> lock(m_Ctx->mutex);
+        // Present the newest frame that is due; older due frames are dropped.
+        while (m_Ctx->ringCount > 0 && m_Ctx->ringPts[m_Ctx->ringHead] <= m_Ctx->clock) {
+            if (frame) av_frame_free(&frame);
+            frame = m_Ctx->ring[m_Ctx->ringHead];
+            m_Ctx->ring[m_Ctx->ringHead] = nullptr;
+            m_Ctx->ringHead = (m_Ctx->ringHead + 1) % VIDEO_FRAME_RING;
+            m_Ctx->ringCount--;
         }
-        av_packet_unref(m_Ctx->packet);
-        if (frameReady) break;
-    }
-    
-    
-    if (!frameReady) {
-        if (m_Looping) {
-            av_seek_frame(m_Ctx->formatCtx, -1, 0, AVSEEK_FLAG_BACKWARD);
-            avcodec_flush_buffers(m_Ctx->codecCtx);
-            m_Ctx->currentTime = 0.0;
-        } else {
-            m_Playing = false;
+        finished = !frame && m_Ctx->eof && m_Ctx->ringCount == 0;
+    }
+
+    if (finished) {
+        m_Playing = false;
+        return;
+    }
+
+    if (frame) {
+        m_Ctx->cv.notify_one();
+        if (m_TextureID != 0 && frame->width == m_Ctx->width && frame->height == m_Ctx->height)
+            UploadFrame(frame);
+        av_frame_free(&frame);
+    }
+}
+
+void VideoPlayer::UploadFrame(AVFrame* frame) {
+    bool planar = IsPlanar420(frame->format) && m_Ctx->planeTex[0] != 0;
+    if (!planar && frame->format != AV_PIX_FMT_RGBA) return;
+
+    int planeCount = planar ? 3 : 1;
+    int bytesPerPixel = planar ? 1 : 4;
+    int widths[3] = {frame->width, (frame->width + 1) / 2, (frame->width + 1) / 2};
+    int heights[3] = {frame->height, (frame->height + 1) / 2, (frame->height + 1) / 2};
+    size_t offsets[3] = {0, 0, 0};
+    size_t total = 0;
+    for (int p = 0; p < planeCount; p++) {
+        offsets[p] = total;
+        total += (size_t)widths[p] * bytesPerPixel * heights[p];
+    }
+
+    // Alternate between two PBOs so filling this frame never waits on the
+    // transfer still reading last frame's buffer.
+    m_Ctx->pboIndex ^= 1;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_Ctx->pbo[m_Ctx->pboIndex]);
+    if (m_Ctx->pboSize[m_Ctx->pboIndex] < total) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, total, nullptr, GL_STREAM_DRAW);
+        m_Ctx->pboSize[m_Ctx->pboIndex] = total;
+    }
+    uint8_t* dst = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, total,
+                                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!dst) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return;
+    }
+    for (int p = 0; p < planeCount; p++) {
+        size_t rowBytes = (size_t)widths[p] * bytesPerPixel;
+        for (int y = 0; y < heights[p]; y++) {
+            memcpy(dst + offsets[p] + y * rowBytes, frame->data[p] + y * frame->linesize[p], rowBytes);
         }
     }
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
 
-    if (frameReady && m_TextureID != 0) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (planar) {
+        for (int p = 0; p < 3; p++) {
+            glBindTexture(GL_TEXTURE_2D, m_Ctx->planeTex[p]);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, widths[p], heights[p], GL_RED, GL_UNSIGNED_BYTE,
+                            (void*)offsets[p]);
+        }
+    } else {
         glBindTexture(GL_TEXTURE_2D, m_TextureID);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_Ctx->codecCtx->width, m_Ctx->codecCtx->height, GL_RGBA, GL_UNSIGNED_BYTE, m_Ctx->frameRGB->data[0]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frame->width, frame->height, GL_RGBA, GL_UNSIGNED_BYTE,
+                        (void*)0);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (planar) ConvertPlanes(frame->width, frame->height);
+}
+
+void VideoPlayer::ConvertPlanes(int width, int height) {
+    // Called from inside scene rendering, so every piece of state touched
+    // here is put back afterwards.
+    GLint prevDrawFBO, prevReadFBO, prevProgram, prevVAO, prevActive;
+    GLint prevViewport[4], prevPolygonMode[2];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevDrawFBO);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prevReadFBO);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &prevProgram);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVAO);
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &prevActive);
+    glGetIntegerv(GL_VIEWPORT, prevViewport);
+    glGetIntegerv(GL_POLYGON_MODE, prevPolygonMode);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_Ctx->fbo);
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_SCISSOR_TEST);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    Shader& shader = ResourceManager::GetShader("video_yuv");
+    shader.use();
+    shader.setInt("planeY", 0);
+    shader.setInt("planeU", 1);
+    shader.setInt("planeV", 2);
+    shader.setBool("bt709", m_Ctx->bt709);
+    shader.setBool("fullRange", m_Ctx->fullRange);
+    for (int p = 0; p < 3; p++) {
+        glActiveTexture(GL_TEXTURE0 + p);
+        glBindTexture(GL_TEXTURE_2D, m_Ctx->planeTex[p]);
+    }
+    glBindVertexArray(m_Ctx->vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    for (int p = 2; p >= 0; p--) {
+        glActiveTexture(GL_TEXTURE0 + p);
         glBindTexture(GL_TEXTURE_2D, 0);
     }
+    glActiveTexture(prevActive);
+    glBindVertexArray(prevVAO);
+    glUseProgram(prevProgram);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, prevDrawFBO);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, prevReadFBO);
+    glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
+    glPolygonMode(GL_FRONT_AND_BACK, prevPolygonMode[0]);
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    if (blend) glEnable(GL_BLEND);
+    if (cullFace) glEnable(GL_CULL_FACE);
+    if (scissor) glEnable(GL_SCISSOR_TEST);
 }
@@ -1,8 +1,17 @@
 #ifndef VIDEOPLAYER_H
 #define VIDEOPLAYER_H
 
+#include <memory>
 #include <string>
 
+struct AVFrame;
+class AudioStream;
+
+// Demux and decode run on a thread per player that fills a small ring of
+// frames; Update() only presents the newest frame whose PTS has been reached.
+// YUV 4:2:0 planes are uploaded through PBOs and converted to RGBA on the GPU.
+// The soundtrack is decoded on the same thread into an AudioStream that
+// follows the presentation clock.
 class VideoPlayer {
 public:
     VideoPlayer();
@@ -11,20 +20,28 @@ public:
     bool Open(const std::string& path);
     void Close();
     void Update(float dt);
-    
+
     unsigned int GetTextureID() const { return m_TextureID; }
     bool IsPlaying() const { return m_Playing; }
     void SetPlaying(bool playing) { m_Playing = playing; }
-    
-    void SetLooping(bool looping) { m_Looping = looping; }
+
+    void SetLooping(bool looping);
     int GetWidth() const;
     int GetHeight() const;
 
+    // Null when the file has no audio track.
+    std::shared_ptr<AudioStream> GetAudioStream() const;
+
 private:
+    void OpenAudio();
+    void DecodeLoop();
+    void UploadFrame(AVFrame* frame);
+    void ConvertPlanes(int width, int height);
+
     unsigned int m_TextureID;
     bool m_Playing;
     bool m_Looping;
-    
+
     struct FFmpegContext;
     FFmpegContext* m_Ctx;
 };
@@ -4,10 +4,22 @@
 #include "BehaviorRegistry.h"
 #include "Builtin/SceneTransitionBehavior.h"
 #include "../Core/Logger.h"
+#include "../Core/MemoryTracker.h"
 #include "../Renderer/Camera.h"
 
 REGISTER_BEHAVIOR(SceneTransitionBehavior)
 
+void* Behavior::operator new(std::size_t size) {
+    void* ptr = ::operator new(size);
+    MemoryTracker::Track(MemoryTag::Scripts, (int64_t)size);
+    return ptr;
+}
+
+void Behavior::operator delete(void* ptr, std::size_t size) {
+    MemoryTracker::Track(MemoryTag::Scripts, -(int64_t)size);
+    ::operator delete(ptr);
+}
+
 
 Camera* Behavior::GetCamera() const {
     return SceneManager::Get().GetMainCamera();
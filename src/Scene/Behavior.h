@@ -1,6 +1,7 @@
 #ifndef BEHAVIOR_H
 #define BEHAVIOR_H
 
+#include <cstddef>
 #include <string>
 #include <any>
 #include <glm/glm.hpp>
@@ -15,6 +16,11 @@ class Behavior {
 public:
     virtual ~Behavior() = default;
 
+    // Counted under MemoryTag::Scripts. The sized delete gets the size of
+    // the most derived class through the virtual destructor.
+    static void* operator new(std::size_t size);
+    static void operator delete(void* ptr, std::size_t size);
+
     virtual void OnStart() {}
     virtual void OnUpdate(float dt) {}
     virtual void OnUI() {}
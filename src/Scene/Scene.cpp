@@ -1,10 +1,19 @@
 #include "Scene.h"
+#include "../Core/Logger.h"
 #include "../Core/ThreadManager.h"
+#include "../Renderer/BudgetGovernor.h"
+#include "../Renderer/HLODManager.h"
 #include "../Renderer/Renderer.h"
+#include "../Renderer/SDFGenerator.h"
+#include "../Renderer/StaticBatcher.h"
+#include "../Renderer/StreamingManager.h"
+#include "../ModelImport/ModelImporter.h"
 #include "../Tools/Profiler/Profiler.h"
+#include "ObjectFactory.h"
 #include "SceneManager.h"
 #include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
 
 Scene::Scene() {}
 
@@ -59,17 +68,24 @@ void Scene::Update(float dt, float time) {
     cameraPos = mainCam->Position;
   }
 
+  // The budget governor pulls the distances in, and throttles even when
+  // component throttling is off.
+  const float throttleScale = BudgetGovernor::GetQuality().scriptThrottleScale;
+  const bool throttle = Renderer::s_ComponentThrottling || throttleScale < 1.0f;
+  const float nearThrottle = 100.0f * throttleScale;
+  const float farThrottle = 250.0f * throttleScale;
+
   if (ThreadManager::IsEnabled()) {
     PROFILE_SCOPE("Scripts");
     ThreadManager::ParallelFor(0, (int)m_Objects.size(), [&](int i) {
       auto &obj = m_Objects[i];
 
       float threshold = 0.0f;
-      if (Renderer::s_ComponentThrottling) {
+      if (throttle) {
         float dist = glm::distance(cameraPos, obj.position);
-        if (dist > 250.0f)
+        if (dist > farThrottle)
           threshold = 0.5f;
-        else if (dist > 100.0f)
+        else if (dist > nearThrottle)
           threshold = 0.1f;
       }
 
@@ -91,11 +107,11 @@ void Scene::Update(float dt, float time) {
     PROFILE_SCOPE("Scripts");
     for (auto &obj : m_Objects) {
       float threshold = 0.0f;
-      if (Renderer::s_ComponentThrottling) {
+      if (throttle) {
         float dist = glm::distance(cameraPos, obj.position);
-        if (dist > 250.0f)
+        if (dist > farThrottle)
           threshold = 0.5f;
-        else if (dist > 100.0f)
+        else if (dist > nearThrottle)
           threshold = 0.1f;
       }
 
@@ -182,14 +198,24 @@ void Scene::DuplicateObjectTree(int index, int newParentIndex) {
     }
   }
 
-  for (int oldIdx : toCopy) {
-    GameObject &src = m_Objects[oldIdx];
-
-    Mesh newMesh(const_cast<std::vector<Vertex> &>(src.mesh.vertices),
-                 const_cast<std::vector<GLuint> &>(src.mesh.indices),
-                 src.mesh.textures);
+  std::vector<Mesh> meshes(toCopy.size());
+  for (size_t i = 0; i < toCopy.size(); ++i) {
+    if (CopyMesh(m_Objects[toCopy[i]], meshes[i]))
+      continue;
+    C3D_LOG_ERROR(LogCategory::Resource,
+                  "Cannot duplicate '%s': the CPU mesh data of '%s' was "
+                  "released and cannot be rebuilt",
+                  m_Objects[index].name.c_str(),
+                  m_Objects[toCopy[i]].name.c_str());
+    for (size_t j = 0; j < i; ++j)
+      meshes[j].Delete();
+    return;
+  }
 
-    GameObject newObj(std::move(newMesh),
+  for (size_t i = 0; i < toCopy.size(); ++i) {
+    int oldIdx = toCopy[i];
+    GameObject &src = m_Objects[oldIdx];
+    GameObject newObj(std::move(meshes[i]),
                       src.name + (oldIdx == index ? " (Copy)" : ""));
     newObj.position = src.position;
     newObj.rotation = src.rotation;
@@ -234,6 +260,76 @@ void Scene::Clear() {
   m_PointLights.clear();
   m_Flags.clear();
   m_Filepath = "";
+  SDFGenerator::ClearCache();
+}
+
+void Scene::ReleaseUnusedSDFs() {
+  std::unordered_set<unsigned int> inUse;
+  for (const auto &obj : m_Objects) {
+    if (obj.hasSDF && obj.sdf.textureID != 0)
+      inUse.insert(obj.sdf.textureID);
+  }
+  SDFGenerator::ReleaseUnused(inUse);
+}
+
+bool Scene::CopyMesh(const GameObject &obj, Mesh &out) {
+  if (!obj.mesh.cpuDataReleased) {
+    out = Mesh(obj.mesh.vertices, obj.mesh.indices, obj.mesh.textures);
+    return true;
+  }
+
+  switch (obj.meshType) {
+  case MeshType::Cube:
+    out = ObjectFactory::createCube();
+    return true;
+  case MeshType::Sphere:
+    out = ObjectFactory::createSphere(30, 30);
+    return true;
+  case MeshType::Plane:
+    out = obj.hasWater
+              ? ObjectFactory::createWaterGrid(obj.water.gridResolution)
+              : ObjectFactory::createPlane();
+    return true;
+  case MeshType::Model: {
+    // Same source the streamer reloads from; textures are still resident.
+    ImportResult result = ModelImporter::Import(obj.modelPath, false);
+    if (!result.success || obj.meshIndex < 0 ||
+        obj.meshIndex >= (int)result.meshes.size())
+      return false;
+    const auto &meshData = result.meshes[obj.meshIndex];
+    out = Mesh(meshData.vertices, meshData.indices, obj.mesh.textures);
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+bool Scene::CanReleaseCPUMesh(const GameObject &obj) {
+  if (!obj.isStatic || obj.hasSDF || obj.is2DSprite ||
+      obj.meshType == MeshType::None || obj.meshType == MeshType::Camera)
+    return false;
+  return !(StreamingManager::s_EnableStreaming &&
+           StreamingManager::IsStreamable(obj));
+}
+
+size_t Scene::ReleaseCPUMeshData() {
+  size_t bytes = 0;
+  int meshes = 0;
+  for (auto &obj : m_Objects) {
+    if (obj.mesh.cpuDataReleased || obj.mesh.indexCount == 0 ||
+        !CanReleaseCPUMesh(obj))
+      continue;
+    bytes += obj.mesh.ReleaseCPUData();
+    meshes++;
+  }
+  for (auto &proxy : HLODManager::GetProxies())
+    bytes += proxy.mesh.ReleaseCPUData();
+  bytes += StaticBatcher::ReleaseCPUData();
+
+  Logger::AddLog("Released CPU copies of %d meshes (%.1f MB)", meshes,
+                 bytes / (1024.0f * 1024.0f));
+  return bytes;
 }
 
 Scene::PointLight *Scene::CreatePointLight() {
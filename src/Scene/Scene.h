@@ -20,6 +20,8 @@
 #undef Status
 #endif
 
+class AudioStream;
+
 enum class ColliderShape { Box, Sphere };
 enum class MeshType { None, Cube, Sphere, Plane, Model, Camera, Water };
 enum class AudioType { Directional, Ambience };
@@ -55,6 +57,9 @@ struct AudioComponent {
 
   void *pSource = nullptr;
   void *pEchoSource = nullptr;
+
+  // Played instead of filePath when set, e.g. a video screen's soundtrack.
+  std::shared_ptr<AudioStream> stream;
 };
 
 struct CameraComponent {
@@ -118,6 +123,8 @@ struct SDFComponent {
   glm::vec3 minP;
   glm::vec3 maxP;
   int resolution = 32;
+  // Exact distances only near the surface, the rest by fast sweeping.
+  bool fastSweep = false;
 };
 
 struct SpriteComponent {
@@ -190,6 +197,7 @@ struct GameObject {
   int meshIndex = -1;
   MeshType meshType = MeshType::None;
   bool isStreamedOut = false;
+  double streamLastInRange = 0.0;
 
   void ApplyImpulse(const glm::vec3 &impulse) {
     if (!isStatic && mass > 0.0f) {
@@ -235,7 +243,22 @@ public:
   void DuplicateObjectTree(int index, int newParentIndex = -1);
   void Clear();
 
+  // Frees the CPU copies of meshes nothing reads once they are on the GPU,
+  // along with those of HLOD proxies and static batches. Returns the bytes
+  // freed.
+  size_t ReleaseCPUMeshData();
+  // Static objects, since dynamic ones may be batched every frame, that the
+  // streamer does not manage (it budgets in CPU bytes and rebuilds meshes on
+  // reload) and that have no SDF to bake.
+  static bool CanReleaseCPUMesh(const GameObject &obj);
+  // Geometry for a copy of obj. A mesh whose CPU data was released is rebuilt
+  // from its primitive type or model file; false when that is impossible.
+  static bool CopyMesh(const GameObject &obj, Mesh &out);
+  // Frees cached SDF volumes no object of this scene samples any more.
+  void ReleaseUnusedSDFs();
+
   std::vector<GameObject> &GetObjects() { return m_Objects; }
+  const std::vector<GameObject> &GetObjects() const { return m_Objects; }
 
   struct Light {
     glm::vec3 position;
@@ -260,7 +283,10 @@ public:
   void RemovePointLight(int index);
   std::vector<PointLight> &GetPointLights() { return m_PointLights; }
 
-  void Save(const std::string &path, bool silent = false);
+  // Temporary copies (the play mode backup) pass writeSectors = false so
+  // no streaming sector manifest is written next to them.
+  void Save(const std::string &path, bool silent = false,
+            bool writeSectors = true);
   void Load(const std::string &path);
 
   const std::string &GetFilepath() const { return m_Filepath; }
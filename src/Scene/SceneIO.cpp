@@ -1,6 +1,10 @@
 #include "SceneIO.h"
 #include "../Core/Logger.h"
 #include "../ModelImport/ModelImporter.h"
+#include "../Renderer/HLODManager.h"
+#include "../Renderer/Renderer.h"
+#include "../Renderer/SDFGenerator.h"
+#include "../Renderer/StreamingManager.h"
 #include "BehaviorRegistry.h"
 #include "ObjectFactory.h"
 #include "SceneManager.h"
@@ -101,7 +105,8 @@ json SceneIO::SerializeObject(const GameObject &obj) {
                    {"liquidDensity", obj.water.liquidDensity}};
 
   jObj["hasSDF"] = obj.hasSDF;
-  jObj["sdf"] = {{"resolution", obj.sdf.resolution}};
+  jObj["sdf"] = {{"resolution", obj.sdf.resolution},
+                 {"fastSweep", obj.sdf.fastSweep}};
 
   jObj["is2DSprite"] = obj.is2DSprite;
   jObj["sprite"] = {{"faceCamera", obj.sprite.faceCamera},
@@ -313,6 +318,8 @@ void SceneIO::DeserializeObject(const json &jObj, GameObject &obj) {
     auto &s = jObj["sdf"];
     if (s.contains("resolution"))
       obj.sdf.resolution = s["resolution"];
+    if (s.contains("fastSweep"))
+      obj.sdf.fastSweep = s["fastSweep"];
   }
 
   if (jObj.contains("is2DSprite"))
@@ -397,7 +404,7 @@ GameObject SceneIO::LoadPrefab(const std::string &path) {
   return obj;
 }
 
-void Scene::Save(const std::string &path, bool silent) {
+void Scene::Save(const std::string &path, bool silent, bool writeSectors) {
   m_Filepath = path;
   json data;
 
@@ -449,6 +456,9 @@ void Scene::Save(const std::string &path, bool silent) {
     if (!silent)
       Logger::AddLog("Scene saved to %s", path.c_str());
   }
+
+  if (writeSectors)
+    StreamingManager::SaveSectors(path, *this);
 }
 
 void Scene::Load(const std::string &path) {
@@ -645,6 +655,24 @@ void Scene::Load(const std::string &path) {
       }
     }
 
+    // Only the resolution is serialized; volumes come back from the SDF cache.
+    for (auto &obj : m_Objects) {
+      if (!obj.hasSDF || obj.mesh.indices.empty())
+        continue;
+      SDFBakeSettings settings;
+      settings.fastSweep = obj.sdf.fastSweep;
+      SDFVolume vol =
+          SDFGenerator::GenerateSDF(obj.mesh, obj.sdf.resolution, settings);
+      obj.sdf.textureID = vol.textureID;
+      obj.sdf.minP = vol.minAABB;
+      obj.sdf.maxP = vol.maxAABB;
+      obj.sdf.enabled = vol.textureID != 0;
+    }
+
+    StreamingManager::LoadSectors(path, *this);
+    HLODManager::LoadFromCache(*this);
+    if (Renderer::s_ReleaseCPUMeshData)
+      ReleaseCPUMeshData();
     Logger::AddLog("Scene loaded from %s", path.c_str());
   } catch (const std::exception &e) {
     Logger::AddLog("[ERROR] Scene load failed: %s", e.what());
@@ -0,0 +1,350 @@
+#include "BenchApplication.h"
+#include "AudioEngine/AudioEngine.h"
+#include "Core/Logger.h"
+#include "Core/MemoryTracker.h"
+#include "Renderer/BudgetGovernor.h"
+#include "Renderer/RenderDevice.h"
+#include "Renderer/StreamingManager.h"
+#include "Scene/SceneManager.h"
+#include "Tools/Profiler/FrameStats.h"
+#include "Tools/Profiler/PerfCounters.h"
+#include "Tools/Profiler/Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+#ifdef C3D_NO_PROFILER
+#error "calcium3d_bench reads its timings from the profiler"
+#endif
+
+BenchApplication::BenchApplication(const ApplicationSpecification &spec,
+                                   const BenchSettings &settings)
+    : Application(spec), m_Settings(settings) {}
+
+bool BenchApplication::Init() {
+  RenderDevice::s_Backend = RenderBackend::Null;
+  AudioEngine::s_DeviceConfig.headless = true;
+
+  if (!m_Settings.scenarioPath.empty()) {
+    std::string error;
+    if (!StressScenario::Load(m_Settings.scenarioPath, m_Scenario, error)) {
+      std::cerr << "[Bench] Bad scenario: " << error << "\n";
+      return false;
+    }
+    if (m_Settings.target.empty())
+      m_Settings.target = m_Scenario.scene;
+    m_Settings.dt = m_Scenario.dt;
+    // The bench writes the report itself, to --out.
+    m_Scenario.outputPath.clear();
+    m_RunScenario = true;
+  }
+
+  if (!Application::Init())
+    return false;
+
+  CreateViewportFramebuffer(m_Settings.width, m_Settings.height);
+  m_Camera->UpdateSize(m_Settings.width, m_Settings.height);
+  return LoadTarget();
+}
+
+bool BenchApplication::LoadTarget() {
+  // A scenario without a scene builds its whole workload on an empty one.
+  if (m_RunScenario && m_Settings.target.empty())
+    return true;
+
+  namespace fs = std::filesystem;
+  fs::path target(m_Settings.target);
+  std::error_code ec;
+
+  if (fs::is_directory(target, ec)) {
+    m_ProjectRoot = fs::absolute(target, ec).string();
+    fs::path config = target / "project.json";
+    if (fs::exists(config, ec)) {
+      try {
+        std::ifstream file(config);
+        nlohmann::json json = nlohmann::json::parse(file);
+        if (json.contains("start_scene"))
+          m_ScenePath = (target / "Scenes" /
+                         json["start_scene"].get<std::string>())
+                            .string();
+      } catch (const std::exception &e) {
+        std::cerr << "[Bench] Bad project.json: " << e.what() << "\n";
+      }
+    }
+    // Without a start scene, take the first scene by name so runs agree.
+    if (m_ScenePath.empty() && fs::is_directory(target / "Scenes", ec)) {
+      std::vector<std::string> scenes;
+      for (const auto &entry : fs::directory_iterator(target / "Scenes", ec))
+        if (entry.path().extension() == ".scene")
+          scenes.push_back(entry.path().string());
+      std::sort(scenes.begin(), scenes.end());
+      if (!scenes.empty())
+        m_ScenePath = scenes.front();
+    }
+  } else {
+    m_ScenePath = target.string();
+    fs::path root = target.parent_path();
+    if (root.filename() == "Scenes")
+      root = root.parent_path();
+    m_ProjectRoot = fs::absolute(root, ec).string();
+  }
+
+  if (m_ScenePath.empty() || !fs::exists(m_ScenePath, ec)) {
+    std::cerr << "[Bench] No scene found for " << m_Settings.target << "\n";
+    return false;
+  }
+  m_Scene->Load(m_ScenePath);
+
+  // View from the scene's first camera, if it has one.
+  for (const auto &obj : m_Scene->GetObjects()) {
+    if (!obj.hasCamera || obj.camera.isDebugCamera)
+      continue;
+    m_Camera->Position = obj.position;
+    m_Camera->Orientation = obj.rotation * glm::vec3(0, 0, -1);
+    m_Camera->Up = obj.rotation * glm::vec3(0, 1, 0);
+    m_Camera->FOV = obj.camera.fov;
+    m_Camera->nearPlane = obj.camera.nearPlane;
+    m_Camera->farPlane = obj.camera.farPlane;
+    break;
+  }
+  return true;
+}
+
+void BenchApplication::OnUpdate(float deltaTime) {
+  SceneManager::Get().Update(deltaTime);
+  m_Scene->Update(deltaTime, m_Time);
+
+  {
+    PROFILE_SCOPE("Transforms");
+    const auto &objects = m_Scene->GetObjects();
+    m_GlobalTransforms.resize(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i)
+      m_GlobalTransforms[i] = m_Scene->GetGlobalTransform((int)i);
+  }
+  {
+    PROFILE_SCOPE("Streaming");
+    StreamingManager::Update(m_Camera->Position, m_Camera->Orientation,
+                             *m_Scene);
+  }
+  {
+    PROFILE_SCOPE("Audio");
+    AudioEngine::Update(m_Scene.get(), m_Camera->Position,
+                        m_Camera->Orientation, m_Camera->Up, deltaTime);
+  }
+}
+
+void BenchApplication::OnRender() {
+  glViewport(0, 0, m_ViewportWidth, m_ViewportHeight);
+
+  m_RenderContext.width = m_ViewportWidth;
+  m_RenderContext.height = m_ViewportHeight;
+  m_RenderContext.camera = m_Camera.get();
+  m_RenderContext.scene = m_Scene.get();
+  m_RenderContext.cloud2d = m_Cloud2D.get();
+  m_RenderContext.volCloud = m_VolumetricCloud.get();
+  m_RenderContext.time = m_Time;
+  m_RenderContext.deltaTime = m_Settings.dt;
+  SyncRenderSettings();
+  m_RenderContext.showSkybox = m_ShowSkybox;
+  m_RenderContext.showGradientSky = m_ShowGradientSky;
+  m_RenderContext.showClouds = m_ShowClouds;
+  m_RenderContext.mainFBO = m_ViewportFBO;
+  m_RenderContext.msaaSamples = 0;
+
+  float angle =
+      (m_RenderContext.timeOfDay - 6.0f) / 24.0f * 2.0f * glm::pi<float>();
+  m_RenderContext.sunPosition =
+      glm::vec3(cos(angle) * 10.0f, sin(angle) * 10.0f, 0.0f);
+  m_RenderContext.moonPosition = glm::vec3(
+      -m_RenderContext.sunPosition.x, -m_RenderContext.sunPosition.y, 0.0f);
+
+  ProcessSceneCameras();
+  {
+    PROFILE_SCOPE("RenderPipeline");
+    m_RenderPipeline->Execute(m_RenderContext);
+  }
+}
+
+void BenchApplication::Run() {
+  PROFILE_THREAD("Main");
+  Profiler &profiler = Profiler::Get();
+  profiler.SetEnabled(true);
+
+  // A scenario decides its own warmup and length.
+  if (m_RunScenario)
+    StressRunner::Start(m_Scenario, *m_Scene, *m_Camera);
+  int totalFrames = m_Settings.warmupFrames + m_Settings.frames;
+  for (int frame = 0;
+       m_Running &&
+       (m_RunScenario ? StressRunner::IsRunning() : frame < totalFrames);
+       ++frame) {
+    int64_t start = Profiler::Now();
+    BudgetGovernor::BeginFrame();
+    profiler.BeginFrame();
+    RenderDevice::BeginFrame();
+    m_RenderContext.deltaTime = m_Settings.dt;
+
+    if (m_RunScenario)
+      StressRunner::Update(*m_Scene, *m_Camera);
+    OnUpdate(m_Settings.dt);
+    OnRender();
+    m_Time += m_Settings.dt;
+
+    const StreamingStats &streaming = StreamingManager::GetStats();
+    const RenderDeviceStats &device = RenderDevice::GetStats();
+    PROFILE_COUNTER("Buffer memory (MB)",
+                    (float)device.bufferBytes / (1024.0f * 1024.0f));
+    PROFILE_COUNTER("Texture memory (MB)",
+                    (float)(device.textureBytes + device.renderbufferBytes) /
+                        (1024.0f * 1024.0f));
+    PROFILE_COUNTER("Objects", (float)m_Scene->GetObjects().size());
+    PROFILE_COUNTER("Streaming resident objects",
+                    (float)streaming.residentObjects);
+
+    BudgetGovernor::EndFrame();
+    MemoryTracker::EndFrame(m_Scene.get());
+    PerfCounters::EndFrame();
+    profiler.EndFrame((float)(Profiler::Now() - start) * 1e-6f);
+    if (m_RunScenario)
+      StressRunner::EndFrame(profiler.GetLastFrame().totalMs);
+    else if (frame >= m_Settings.warmupFrames)
+      RecordFrame(profiler.GetLastFrame());
+  }
+
+  WriteReport();
+}
+
+void BenchApplication::RecordFrame(const ProfileFrame &frame) {
+  size_t index = m_FrameTimes.size();
+  m_FrameTimes.push_back(frame.totalMs);
+
+  // Depth 0 nodes are threads. A scope seen on several threads, or nested
+  // in itself, is summed.
+  for (const ProfileNode &node : frame.tree) {
+    if (node.depth == 0)
+      continue;
+    auto &times = m_ScopeTimes[node.name];
+    times.resize(index + 1, 0.0f);
+    times[index] += node.totalMs;
+  }
+  for (const ProfileCounter &counter : frame.counters) {
+    auto &values = m_CounterValues[counter.name];
+    values.resize(index + 1, 0.0f);
+    values[index] = counter.value;
+  }
+}
+
+nlohmann::json BenchApplication::BuildSceneReport() {
+  size_t frames = m_FrameTimes.size();
+  nlohmann::json report;
+  report["scene"] = m_ScenePath;
+  report["frames"] = frames;
+  report["warmupFrames"] = m_Settings.warmupFrames;
+  report["dt"] = m_Settings.dt;
+  report["resolution"] = {m_Settings.width, m_Settings.height};
+  report["frame"] = FrameTimingStats(m_FrameTimes);
+  report["subsystems"] = nlohmann::json::object();
+  for (auto &[name, times] : m_ScopeTimes) {
+    // Frames where the scope never ran count as 0 ms.
+    times.resize(frames, 0.0f);
+    report["subsystems"][name] = FrameTimingStats(times);
+  }
+  report["counters"] = nlohmann::json::object();
+  for (auto &[name, values] : m_CounterValues) {
+    values.resize(frames, 0.0f);
+    report["counters"][name] = FrameCounterStats(values);
+  }
+  return report;
+}
+
+void BenchApplication::WriteReport() {
+  nlohmann::json report;
+  if (m_RunScenario) {
+    report = StressRunner::GetLastReport();
+    if (!report.contains("variants") || report["variants"].empty()) {
+      std::cerr << "[Bench] The scenario produced no variants; no report "
+                   "written\n";
+      m_ExitCode = 2;
+      return;
+    }
+    report["scene"] = m_ScenePath;
+    report["resolution"] = {m_Settings.width, m_Settings.height};
+  } else {
+    if (m_FrameTimes.empty()) {
+      std::cerr << "[Bench] No frames were recorded; no report written\n";
+      m_ExitCode = 2;
+      return;
+    }
+    report = BuildSceneReport();
+  }
+
+  if (!m_Settings.baselinePath.empty()) {
+    nlohmann::json baseline;
+    try {
+      std::ifstream file(m_Settings.baselinePath);
+      baseline = nlohmann::json::parse(file);
+    } catch (const std::exception &e) {
+      std::cerr << "[Bench] Cannot read baseline " << m_Settings.baselinePath
+                << ": " << e.what() << "\n";
+      m_ExitCode = 2;
+    }
+
+    nlohmann::json regressions = nlohmann::json::array();
+    auto compare = [&](const std::string &name, const nlohmann::json &current,
+                       const nlohmann::json &previous) {
+      float was = previous.value("p95", 0.0f);
+      float now = current["p95"].get<float>();
+      // Differences under 0.05 ms are timer noise for short scopes.
+      if (now > was * (1.0f + m_Settings.tolerance) && now - was > 0.05f)
+        regressions.push_back(
+            {{"name", name}, {"baselineP95", was}, {"p95", now}});
+    };
+    if (baseline.contains("frame"))
+      compare("frame", report["frame"], baseline["frame"]);
+    if (baseline.contains("subsystems")) {
+      for (auto &[name, stats] : report["subsystems"].items())
+        if (baseline["subsystems"].contains(name))
+          compare(name, stats, baseline["subsystems"][name]);
+    }
+    // Scenario reports are compared variant by variant, matched by name.
+    if (report.contains("variants") && baseline.contains("variants")) {
+      for (const auto &variant : report["variants"]) {
+        std::string name = variant["name"].get<std::string>();
+        for (const auto &previous : baseline["variants"])
+          if (previous.value("name", "") == name)
+            compare(name, variant["frame"], previous["frame"]);
+      }
+    }
+    report["regressions"] = regressions;
+    for (const auto &r : regressions) {
+      std::cerr << "[Bench] Regression: " << r["name"].get<std::string>()
+                << " p95 " << r["baselineP95"].get<float>() << " -> "
+                << r["p95"].get<float>() << " ms\n";
+    }
+    if (!regressions.empty() && m_ExitCode == 0)
+      m_ExitCode = 1;
+  }
+
+  std::ofstream out(m_Settings.outputPath);
+  if (!out) {
+    std::cerr << "[Bench] Cannot write " << m_Settings.outputPath << "\n";
+    m_ExitCode = 2;
+    return;
+  }
+  out << report.dump(2) << "\n";
+
+  if (m_RunScenario) {
+    Logger::AddLog("[Bench] %zu scenario variants -> %s",
+                   report["variants"].size(), m_Settings.outputPath.c_str());
+    return;
+  }
+  const nlohmann::json &frame = report["frame"];
+  Logger::AddLog("[Bench] %zu frames: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms "
+                 "-> %s",
+                 m_FrameTimes.size(), frame["p50"].get<float>(),
+                 frame["p95"].get<float>(), frame["p99"].get<float>(),
+                 m_Settings.outputPath.c_str());
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "Core/Application.h"
+#include "Tools/Stress/StressScenario.h"
+#include <map>
+#include <string>
+#include <vector>
+
+struct ProfileFrame;
+
+struct BenchSettings {
+  // A .scene file, or a project directory whose start scene is loaded.
+  std::string target;
+  // A stress scenario (src/Tools/Stress/StressScenario.h) run on the target,
+  // or on its own scene when no target is given. It replaces frames,
+  // warmupFrames and dt, and the report holds one entry per variant.
+  std::string scenarioPath;
+  int frames = 600;
+  int warmupFrames = 60;
+  float dt = 1.0f / 60.0f;
+  int width = 1920;
+  int height = 1080;
+  std::string outputPath = "bench.json";
+  // A previous report. Subsystems whose p95 grew by more than tolerance
+  // (relative) fail the run.
+  std::string baselinePath;
+  float tolerance = 0.10f;
+};
+
+// Runs a scene for a fixed number of frames at a fixed step on the null render
+// device: scripts, physics, audio on miniaudio's null backend, streaming and
+// the whole render pipeline up to GL submission. Per-scope timings come from
+// the profiler and are written as p50/p95/p99 JSON together with the
+// profiler counters.
+class BenchApplication : public Application {
+public:
+  BenchApplication(const ApplicationSpecification &spec,
+                   const BenchSettings &settings);
+
+  bool Init() override;
+  void Run() override;
+  // 0 on success, 1 when the baseline comparison found a regression, 2 when
+  // the report or the baseline could not be read or written.
+  int GetExitCode() const { return m_ExitCode; }
+
+protected:
+  void OnUpdate(float deltaTime) override;
+  void OnRender() override;
+
+private:
+  bool LoadTarget();
+  void RecordFrame(const ProfileFrame &frame);
+  nlohmann::json BuildSceneReport();
+  void WriteReport();
+
+  BenchSettings m_Settings;
+  std::string m_ScenePath;
+  float m_Time = 0.0f;
+  int m_ExitCode = 0;
+  StressScenario m_Scenario;
+  bool m_RunScenario = false;
+  std::vector<glm::mat4> m_GlobalTransforms;
+
+  std::vector<float> m_FrameTimes;
+  std::map<std::string, std::vector<float>> m_ScopeTimes;
+  std::map<std::string, std::vector<float>> m_CounterValues;
+};
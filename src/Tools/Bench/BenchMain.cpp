@@ -0,0 +1,65 @@
+#include "BenchApplication.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void PrintBenchUsage() {
+  std::printf(
+      "Usage: calcium3d_bench <scene file | project dir> [options]\n"
+      "       calcium3d_bench --scenario FILE [scene | project] [options]\n"
+      "  --scenario FILE   run a stress scenario, one result per variant\n"
+      "  --frames N        measured frames (default 600)\n"
+      "  --warmup N        frames run before measuring (default 60)\n"
+      "  --dt S            fixed step in seconds (default 1/60)\n"
+      "  --size WxH        render size (default 1920x1080)\n"
+      "  --out FILE        JSON report (default bench.json)\n"
+      "  --baseline FILE   fail when a p95 regresses against this report\n"
+      "  --tolerance F     allowed relative p95 growth (default 0.10)\n");
+}
+
+int main(int argc, char **argv) {
+  BenchSettings settings;
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(arg, "--frames") == 0 && hasValue)
+      settings.frames = std::max(1, std::atoi(argv[++i]));
+    else if (std::strcmp(arg, "--warmup") == 0 && hasValue)
+      settings.warmupFrames = std::max(0, std::atoi(argv[++i]));
+    else if (std::strcmp(arg, "--dt") == 0 && hasValue)
+      settings.dt = (float)std::atof(argv[++i]);
+    else if (std::strcmp(arg, "--size") == 0 && hasValue)
+      std::sscanf(argv[++i], "%dx%d", &settings.width, &settings.height);
+    else if (std::strcmp(arg, "--out") == 0 && hasValue)
+      settings.outputPath = argv[++i];
+    else if (std::strcmp(arg, "--baseline") == 0 && hasValue)
+      settings.baselinePath = argv[++i];
+    else if (std::strcmp(arg, "--scenario") == 0 && hasValue)
+      settings.scenarioPath = argv[++i];
+    else if (std::strcmp(arg, "--tolerance") == 0 && hasValue)
+      settings.tolerance = (float)std::atof(argv[++i]);
+    else if (arg[0] != '-' && settings.target.empty())
+      settings.target = arg;
+    else {
+      PrintBenchUsage();
+      return 2;
+    }
+  }
+  if ((settings.target.empty() && settings.scenarioPath.empty()) ||
+      settings.width <= 0 || settings.height <= 0 || settings.dt <= 0.0f) {
+    PrintBenchUsage();
+    return 2;
+  }
+
+  ApplicationSpecification spec;
+  spec.Name = "Calcium3D Bench";
+  spec.Width = (uint32_t)settings.width;
+  spec.Height = (uint32_t)settings.height;
+
+  BenchApplication app(spec, settings);
+  if (!app.Init())
+    return 2;
+  app.Run();
+  return app.GetExitCode();
+}
@@ -0,0 +1,132 @@
+#include "MicroBench.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <thread>
+
+std::string MicroBench::s_Filter;
+double MicroBench::s_MinTime = 0.5;
+int MicroBench::s_Repetitions = 5;
+std::vector<MicroBenchResult> MicroBench::s_Results;
+volatile uint64_t MicroBench::s_Sink = 0;
+
+static double MicroBenchTimeBatch(const std::function<void()> &body,
+                                  const std::function<void()> &reset,
+                                  int64_t iterations) {
+  if (reset)
+    reset();
+  auto start = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < iterations; ++i)
+    body();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+bool MicroBench::IsSelected(const std::string &prefix) {
+  return s_Filter.empty() || prefix.find(s_Filter) != std::string::npos ||
+         s_Filter.compare(0, prefix.size(), prefix) == 0;
+}
+
+void MicroBench::Run(const std::string &name, int64_t itemsPerIteration,
+                     const std::function<void()> &body,
+                     const std::function<void()> &reset) {
+  if (!s_Filter.empty() && name.find(s_Filter) == std::string::npos)
+    return;
+
+  int repetitions = std::max(s_Repetitions, 1);
+  double target = s_MinTime / repetitions;
+
+  // The first batch is a warm-up. Grow the batch until it is long enough for
+  // the clock, aiming a little past the target like Google Benchmark does.
+  int64_t iterations = 1;
+  double seconds = MicroBenchTimeBatch(body, reset, iterations);
+  while (seconds < target && iterations < ((int64_t)1 << 40)) {
+    double scale = seconds > 0.0 ? target * 1.4 / seconds : 100.0;
+    scale = std::clamp(scale, 2.0, 100.0);
+    iterations = (int64_t)std::ceil((double)iterations * scale);
+    seconds = MicroBenchTimeBatch(body, reset, iterations);
+  }
+
+  std::vector<double> perIteration(repetitions);
+  for (int r = 0; r < repetitions; ++r) {
+    perIteration[r] = MicroBenchTimeBatch(body, reset, iterations) * 1e9 /
+                      (double)iterations;
+  }
+
+  MicroBenchResult result;
+  result.name = name;
+  result.iterations = iterations;
+  result.repetitions = repetitions;
+  double sum = 0.0;
+  for (double ns : perIteration)
+    sum += ns;
+  result.meanNs = sum / repetitions;
+  double variance = 0.0;
+  for (double ns : perIteration)
+    variance += (ns - result.meanNs) * (ns - result.meanNs);
+  result.stddevNs = repetitions > 1 ? std::sqrt(variance / (repetitions - 1))
+                                    : 0.0;
+  std::sort(perIteration.begin(), perIteration.end());
+  result.minNs = perIteration.front();
+  result.medianNs = repetitions % 2
+                        ? perIteration[repetitions / 2]
+                        : (perIteration[repetitions / 2 - 1] +
+                           perIteration[repetitions / 2]) *
+                              0.5;
+  if (itemsPerIteration > 0 && result.medianNs > 0.0)
+    result.itemsPerSecond = (double)itemsPerIteration * 1e9 / result.medianNs;
+
+  std::printf("%-48s %14.0f ns %14.0f ns %12.3g items/s %10lld\n",
+              name.c_str(), result.medianNs, result.stddevNs,
+              result.itemsPerSecond, (long long)iterations);
+  std::fflush(stdout);
+  s_Results.push_back(result);
+}
+
+bool MicroBench::WriteJson(const std::string &path) {
+  char date[32];
+  std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+  nlohmann::json context = {
+      {"date", date},
+      {"executable", "calcium3d_microbench"},
+      {"num_cpus", std::thread::hardware_concurrency()},
+      {"min_time", s_MinTime},
+      {"repetitions", s_Repetitions},
+#ifdef NDEBUG
+      {"library_build_type", "release"},
+#else
+      {"library_build_type", "debug"},
+#endif
+  };
+
+  nlohmann::json benchmarks = nlohmann::json::array();
+  for (const MicroBenchResult &r : s_Results) {
+    nlohmann::json entry = {{"name", r.name},
+                            {"run_type", "aggregate"},
+                            {"aggregate_name", "median"},
+                            {"iterations", r.iterations},
+                            {"repetitions", r.repetitions},
+                            {"real_time", r.medianNs},
+                            {"min_time", r.minNs},
+                            {"mean_time", r.meanNs},
+                            {"stddev_time", r.stddevNs},
+                            {"time_unit", "ns"}};
+    if (r.itemsPerSecond > 0.0)
+      entry["items_per_second"] = r.itemsPerSecond;
+    benchmarks.push_back(entry);
+  }
+
+  std::ofstream out(path);
+  if (!out)
+    return false;
+  out << nlohmann::json{{"context", context}, {"benchmarks", benchmarks}}
+             .dump(2)
+      << "\n";
+  return true;
+}
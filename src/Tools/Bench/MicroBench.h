@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct MicroBenchResult {
+  std::string name;
+  int64_t iterations = 0; // Per repetition.
+  int repetitions = 0;
+  // Nanoseconds per iteration across repetitions.
+  double medianNs = 0.0;
+  double minNs = 0.0;
+  double meanNs = 0.0;
+  double stddevNs = 0.0;
+  double itemsPerSecond = 0.0; // At the median.
+};
+
+// A small Google Benchmark style runner, so the suite builds without extra
+// dependencies. Each case is calibrated until one batch takes
+// s_MinTime / s_Repetitions, then timed s_Repetitions times.
+class MicroBench {
+public:
+  // reset, if given, runs untimed before every batch so each batch starts
+  // from the same state.
+  static void Run(const std::string &name, int64_t itemsPerIteration,
+                  const std::function<void()> &body,
+                  const std::function<void()> &reset = nullptr);
+  // Whether any case would run under the current filter. Lets a group skip
+  // its setup.
+  static bool IsSelected(const std::string &prefix);
+  // Folds a result into a sink the optimizer cannot remove.
+  static void Consume(uint64_t value) { s_Sink = s_Sink + value; }
+
+  // Same layout as Google Benchmark's --benchmark_format=json, times in ns.
+  static bool WriteJson(const std::string &path);
+
+  static std::string s_Filter; // Substring; empty runs everything.
+  static double s_MinTime;
+  static int s_Repetitions;
+  static std::vector<MicroBenchResult> s_Results;
+
+private:
+  static volatile uint64_t s_Sink;
+};
@@ -0,0 +1,459 @@
+#include "AudioEngine/AudioEngine.h"
+#include "Core/Application.h"
+#include "Core/ThreadManager.h"
+#include "MicroBench.h"
+#include "ModelImport/ModelImporter.h"
+#include "Physics/PhysicsEngine.h"
+#include "Renderer/ClusteredLighting.h"
+#include "Renderer/Frustum.h"
+#include "Renderer/LODGenerator.h"
+#include "Renderer/RenderDevice.h"
+#include "Renderer/StaticBatcher.h"
+#include "Scene/ObjectFactory.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <random>
+
+// Every case builds its inputs from a fixed seed, so runs on the same machine
+// compare like for like.
+static constexpr uint32_t MICROBENCH_SEED = 0xC3D;
+
+namespace fs = std::filesystem;
+
+// Application::Init brings up the subsystems the cases touch (thread pool,
+// null render device, resource paths); there is no frame loop.
+class MicroBenchApplication : public Application {
+public:
+  using Application::Application;
+
+protected:
+  void OnUpdate(float) override {}
+  void OnRender() override {}
+};
+
+static glm::quat MicroBenchRandomRotation(std::mt19937 &rng) {
+  std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+  std::uniform_real_distribution<float> axis(-1.0f, 1.0f);
+  glm::vec3 a(axis(rng), axis(rng), axis(rng));
+  if (glm::length(a) < 1e-3f)
+    a = glm::vec3(0.0f, 1.0f, 0.0f);
+  return glm::angleAxis(angle(rng), glm::normalize(a));
+}
+
+static void BenchPhysicsUpdate(int bodies) {
+  std::string name = "Physics/Update/" + std::to_string(bodies);
+  if (!MicroBench::IsSelected(name))
+    return;
+
+  std::mt19937 rng(MICROBENCH_SEED);
+  std::uniform_real_distribution<float> spread(-40.0f, 40.0f);
+  std::uniform_real_distribution<float> height(1.0f, 30.0f);
+
+  Mesh cube = ObjectFactory::createCube();
+  std::vector<GameObject> initial;
+  initial.reserve(bodies + 1);
+  GameObject ground(cube, "Ground");
+  ground.meshType = MeshType::Cube;
+  ground.isStatic = true;
+  ground.scale = glm::vec3(100.0f, 1.0f, 100.0f);
+  ground.position.y = -0.5f;
+  initial.push_back(ground);
+  for (int i = 0; i < bodies; ++i) {
+    GameObject body(cube, "Body");
+    body.meshType = MeshType::Cube;
+    body.useGravity = true;
+    body.position = glm::vec3(spread(rng), height(rng), spread(rng));
+    body.rotation = MicroBenchRandomRotation(rng);
+    initial.push_back(body);
+  }
+
+  std::vector<GameObject> objects;
+  float time = 0.0f;
+  MicroBench::Run(
+      name, bodies,
+      [&]() {
+        PhysicsEngine::Update(1.0f / 60.0f, time, objects);
+        time += 1.0f / 60.0f;
+      },
+      [&]() {
+        objects = initial;
+        time = 0.0f;
+      });
+}
+
+static void BenchOBBOBB() {
+  const std::string name = "Physics/TestOBBOBB";
+  if (!MicroBench::IsSelected(name))
+    return;
+
+  // Centers close enough that roughly half the pairs overlap, so both the
+  // early-out and the full 15-axis path are timed.
+  const int pairs = 4096;
+  std::mt19937 rng(MICROBENCH_SEED);
+  std::uniform_real_distribution<float> offset(-2.0f, 2.0f);
+  std::uniform_real_distribution<float> extent(0.25f, 1.5f);
+  std::vector<OBB> boxes(pairs * 2);
+  for (OBB &box : boxes) {
+    glm::mat3 rot = glm::mat3_cast(MicroBenchRandomRotation(rng));
+    box.center = glm::vec3(offset(rng), offset(rng), offset(rng));
+    box.axes[0] = rot[0];
+    box.axes[1] = rot[1];
+    box.axes[2] = rot[2];
+    box.halfExtents = glm::vec3(extent(rng), extent(rng), extent(rng));
+  }
+
+  MicroBench::Run(name, pairs, [&]() {
+    uint64_t hits = 0;
+    glm::vec3 normal;
+    float penetration;
+    for (int i = 0; i < pairs; ++i)
+      hits += TestOBBOBB(boxes[i * 2], boxes[i * 2 + 1], normal, penetration);
+    MicroBench::Consume(hits);
+  });
+}
+
+static void BenchFrustum() {
+  const std::string name = "Frustum/IsOnFrustum/100000";
+  if (!MicroBench::IsSelected(name))
+    return;
+
+  const int count = 100000;
+  std::mt19937 rng(MICROBENCH_SEED);
+  std::uniform_real_distribution<float> spread(-500.0f, 500.0f);
+  std::uniform_real_distribution<float> size(0.5f, 5.0f);
+  std::vector<glm::vec3> mins(count), maxs(count);
+  for (int i = 0; i < count; ++i) {
+    mins[i] = glm::vec3(spread(rng), spread(rng), spread(rng));
+    maxs[i] = mins[i] + glm::vec3(size(rng), size(rng), size(rng));
+  }
+
+  glm::mat4 projection =
+      glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, 0.0f),
+                               glm::vec3(0.0f, 10.0f, -1.0f),
+                               glm::vec3(0.0f, 1.0f, 0.0f));
+  Frustum frustum = Frustum::CreateFrustumFromCamera(projection * view);
+
+  MicroBench::Run(name, count, [&]() {
+    uint64_t visible = 0;
+    for (int i = 0; i < count; ++i)
+      visible += frustum.IsOnFrustum(mins[i], maxs[i]);
+    MicroBench::Consume(visible);
+  });
+}
+
+static const char *const s_MicroBenchModels[] = {
+    "Demos/Assets/model/theInn.FBX.fbx",
+    "Demos/4_WaterSimulation/Assets/j20/j20.fbx",
+    "Demos/4_WaterSimulation/Assets/kickelhahn_tower/scene.gltf",
+};
+
+static void BenchSimplifyMesh(const fs::path &resources) {
+  if (!MicroBench::IsSelected("LOD/SimplifyMesh/"))
+    return;
+
+  for (const char *model : s_MicroBenchModels) {
+    fs::path path = resources / model;
+    ImportResult result = ModelImporter::Import(path.string(), false);
+    if (!result.success || result.meshes.empty()) {
+      std::fprintf(stderr, "[MicroBench] Skipping %s: %s\n",
+                   path.string().c_str(), result.error.c_str());
+      continue;
+    }
+    // The largest mesh of the model is the one worth simplifying.
+    const ImportedMeshData *largest = &result.meshes.front();
+    for (const ImportedMeshData &mesh : result.meshes)
+      if (mesh.indices.size() > largest->indices.size())
+        largest = &mesh;
+
+    std::vector<Vertex> outVertices;
+    std::vector<GLuint> outIndices;
+    MicroBench::Run("LOD/SimplifyMesh/" + path.stem().string() + "/50%",
+                    (int64_t)largest->indices.size() / 3, [&]() {
+                      LODGenerator::SimplifyMesh(largest->vertices,
+                                                 largest->indices, 0.5f,
+                                                 outVertices, outIndices);
+                      MicroBench::Consume(outIndices.size());
+                    });
+  }
+}
+
+// A UV sphere written as OBJ, binary STL and ASCII PLY, so the formats the
+// demos do not ship are measured on the same geometry.
+static void WriteMicroBenchSphere(const fs::path &dir, int sectors,
+                                  int stacks) {
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec2> uvs;
+  for (int y = 0; y <= stacks; ++y) {
+    float phi = glm::pi<float>() * (float)y / (float)stacks;
+    for (int x = 0; x <= sectors; ++x) {
+      float theta = glm::two_pi<float>() * (float)x / (float)sectors;
+      positions.emplace_back(std::sin(phi) * std::cos(theta), std::cos(phi),
+                             std::sin(phi) * std::sin(theta));
+      uvs.emplace_back((float)x / sectors, (float)y / stacks);
+    }
+  }
+  std::vector<glm::uvec3> triangles;
+  for (int y = 0; y < stacks; ++y) {
+    for (int x = 0; x < sectors; ++x) {
+      uint32_t a = y * (sectors + 1) + x, b = a + sectors + 1;
+      triangles.emplace_back(a, b, a + 1);
+      triangles.emplace_back(a + 1, b, b + 1);
+    }
+  }
+
+  std::ofstream obj(dir / "sphere.obj");
+  for (const glm::vec3 &p : positions)
+    obj << "v " << p.x << " " << p.y << " " << p.z << "\n";
+  for (const glm::vec2 &uv : uvs)
+    obj << "vt " << uv.x << " " << uv.y << "\n";
+  for (const glm::vec3 &p : positions)
+    obj << "vn " << p.x << " " << p.y << " " << p.z << "\n";
+  for (const glm::uvec3 &t : triangles) {
+    obj << "f";
+    for (int k = 0; k < 3; ++k)
+      obj << " " << t[k] + 1 << "/" << t[k] + 1 << "/" << t[k] + 1;
+    obj << "\n";
+  }
+
+  std::ofstream stl(dir / "sphere.stl", std::ios::binary);
+  char header[80] = "calcium3d_microbench";
+  stl.write(header, sizeof(header));
+  uint32_t count = (uint32_t)triangles.size();
+  stl.write(reinterpret_cast<const char *>(&count), 4);
+  for (const glm::uvec3 &t : triangles) {
+    glm::vec3 n = glm::normalize(positions[t[0]] + positions[t[1]] +
+                                 positions[t[2]]);
+    stl.write(reinterpret_cast<const char *>(&n), 12);
+    for (int k = 0; k < 3; ++k)
+      stl.write(reinterpret_cast<const char *>(&positions[t[k]]), 12);
+    uint16_t attributes = 0;
+    stl.write(reinterpret_cast<const char *>(&attributes), 2);
+  }
+
+  std::ofstream ply(dir / "sphere.ply");
+  ply << "ply\nformat ascii 1.0\nelement vertex " << positions.size()
+      << "\nproperty float x\nproperty float y\nproperty float z\n"
+         "property float nx\nproperty float ny\nproperty float nz\n"
+         "element face "
+      << triangles.size()
+      << "\nproperty list uchar int vertex_indices\nend_header\n";
+  for (const glm::vec3 &p : positions)
+    ply << p.x << " " << p.y << " " << p.z << " " << p.x << " " << p.y << " "
+        << p.z << "\n";
+  for (const glm::uvec3 &t : triangles)
+    ply << "3 " << t.x << " " << t.y << " " << t.z << "\n";
+}
+
+static void BenchModelImport(const fs::path &resources) {
+  if (!MicroBench::IsSelected("ModelImporter/Import/"))
+    return;
+
+  fs::path dir = fs::temp_directory_path() / "calcium3d_microbench";
+  fs::create_directories(dir);
+  WriteMicroBenchSphere(dir, 256, 128);
+
+  const std::pair<const char *, fs::path> inputs[] = {
+      {"obj", dir / "sphere.obj"},
+      {"stl", dir / "sphere.stl"},
+      {"ply", dir / "sphere.ply"},
+      {"fbx", resources / s_MicroBenchModels[0]},
+      {"gltf", resources / s_MicroBenchModels[2]},
+  };
+  for (const auto &[format, path] : inputs) {
+    // Triangles imported, counted once up front.
+    ImportResult probe = ModelImporter::Import(path.string(), false);
+    if (!probe.success) {
+      std::fprintf(stderr, "[MicroBench] Skipping %s: %s\n",
+                   path.string().c_str(), probe.error.c_str());
+      continue;
+    }
+    int64_t triangles = 0;
+    for (const ImportedMeshData &mesh : probe.meshes)
+      triangles += (int64_t)mesh.indices.size() / 3;
+
+    std::string file = path.string();
+    MicroBench::Run(std::string("ModelImporter/Import/") + format, triangles,
+                    [&]() {
+                      ImportResult result = ModelImporter::Import(file, false);
+                      MicroBench::Consume(result.meshes.size());
+                    });
+  }
+}
+
+static void BenchSceneLoad(Application &app, const fs::path &resources) {
+  if (!MicroBench::IsSelected("Scene/Load/"))
+    return;
+
+  std::vector<fs::path> projects;
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator(resources / "Demos", ec))
+    if (fs::exists(entry.path() / "Scenes" / "main.scene", ec))
+      projects.push_back(entry.path());
+  std::sort(projects.begin(), projects.end());
+
+  for (const fs::path &project : projects) {
+    app.OpenProject(project.string());
+    std::string scenePath = (project / "Scenes" / "main.scene").string();
+    MicroBench::Run("Scene/Load/" + project.filename().string(), 0, [&]() {
+      Scene scene;
+      scene.Load(scenePath);
+      MicroBench::Consume(scene.GetObjects().size());
+    });
+  }
+}
+
+static void BenchClusteredLighting(int lights) {
+  std::string name = "ClusteredLighting/UpdateClusters/" +
+                     std::to_string(lights);
+  if (!MicroBench::IsSelected(name))
+    return;
+
+  std::mt19937 rng(MICROBENCH_SEED);
+  std::uniform_real_distribution<float> spread(-100.0f, 100.0f);
+  std::uniform_real_distribution<float> height(0.5f, 20.0f);
+  Scene scene;
+  for (int i = 0; i < lights; ++i) {
+    Scene::PointLight *light = scene.CreatePointLight();
+    light->position = glm::vec3(spread(rng), height(rng), spread(rng));
+    light->color = glm::vec4(1.0f);
+    light->intensity = 1.0f;
+    light->enabled = true;
+  }
+  Camera camera(1920, 1080, glm::vec3(0.0f, 10.0f, 60.0f));
+  camera.nearPlane = 0.1f;
+  camera.farPlane = 500.0f;
+
+  MicroBench::Run(name, lights,
+                  [&]() { ClusteredLighting::UpdateClusters(camera, scene); });
+}
+
+static void BenchStaticBatcher(int objects) {
+  std::string name = "StaticBatcher/Bake/" + std::to_string(objects);
+  if (!MicroBench::IsSelected(name))
+    return;
+
+  // A grid of static cubes and spheres in a handful of materials, spread
+  // over many chunks.
+  std::mt19937 rng(MICROBENCH_SEED);
+  std::uniform_int_distribution<int> materialIndex(0, 7);
+  Mesh cube = ObjectFactory::createCube();
+  Mesh sphere = ObjectFactory::createSphere(16, 8);
+  Scene scene;
+  int side = (int)std::ceil(std::sqrt((float)objects));
+  for (int i = 0; i < objects; ++i) {
+    bool isCube = i % 2 == 0;
+    GameObject obj(isCube ? cube : sphere, "Static");
+    obj.meshType = isCube ? MeshType::Cube : MeshType::Sphere;
+    obj.isStatic = true;
+    obj.position = glm::vec3((float)(i % side) * 3.0f, 0.0f,
+                             (float)(i / side) * 3.0f);
+    float shade = (float)materialIndex(rng) / 7.0f;
+    obj.material.albedo = glm::vec3(shade, 0.5f, 1.0f - shade);
+    scene.AddObject(std::move(obj));
+  }
+
+  MicroBench::Run(name, objects, [&]() { StaticBatcher::Bake(scene); });
+  StaticBatcher::Clear();
+}
+
+// Each index does `grain` rounds of integer mixing, so the pool's per-task
+// cost can be read off against the serial loop.
+static uint64_t MicroBenchWork(int index, int grain) {
+  uint64_t h = (uint64_t)index * 0x9E3779B97F4A7C15ull;
+  for (int i = 0; i < grain; ++i)
+    h = (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9ull;
+  return h;
+}
+
+static void BenchParallelFor() {
+  if (!MicroBench::IsSelected("ThreadManager/"))
+    return;
+
+  const int tasks = 1024;
+  std::vector<uint64_t> out(tasks);
+  for (int grain : {1, 100, 10000}) {
+    std::string suffix = "/grain:" + std::to_string(grain);
+    MicroBench::Run("ThreadManager/ParallelFor" + suffix, tasks, [&]() {
+      ThreadManager::ParallelFor(
+          0, tasks, [&](int i) { out[i] = MicroBenchWork(i, grain); });
+      MicroBench::Consume(out[tasks - 1]);
+    });
+    MicroBench::Run("ThreadManager/Serial" + suffix, tasks, [&]() {
+      for (int i = 0; i < tasks; ++i)
+        out[i] = MicroBenchWork(i, grain);
+      MicroBench::Consume(out[tasks - 1]);
+    });
+  }
+}
+
+static void PrintMicroBenchUsage() {
+  std::printf(
+      "Usage: calcium3d_microbench [options]\n"
+      "  --filter S         run cases whose name contains S\n"
+      "  --min-time S       seconds per case, split over repetitions "
+      "(default 0.5)\n"
+      "  --repetitions N    timed batches per case (default 5)\n"
+      "  --resources DIR    engine Resource folder (default ../Resource)\n"
+      "  --out FILE         JSON results (default microbench.json)\n");
+}
+
+int main(int argc, char **argv) {
+  std::string outputPath = "microbench.json";
+  fs::path resources = "../Resource";
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(arg, "--filter") == 0 && hasValue)
+      MicroBench::s_Filter = argv[++i];
+    else if (std::strcmp(arg, "--min-time") == 0 && hasValue)
+      MicroBench::s_MinTime = std::atof(argv[++i]);
+    else if (std::strcmp(arg, "--repetitions") == 0 && hasValue)
+      MicroBench::s_Repetitions = std::atoi(argv[++i]);
+    else if (std::strcmp(arg, "--resources") == 0 && hasValue)
+      resources = argv[++i];
+    else if (std::strcmp(arg, "--out") == 0 && hasValue)
+      outputPath = argv[++i];
+    else {
+      PrintMicroBenchUsage();
+      return 2;
+    }
+  }
+
+  // Mesh and batch uploads land on the null device; nothing needs a GPU.
+  RenderDevice::s_Backend = RenderBackend::Null;
+  AudioEngine::s_DeviceConfig.headless = true;
+  ApplicationSpecification spec;
+  spec.Name = "Calcium3D Microbench";
+  MicroBenchApplication app(spec);
+  if (!app.Init())
+    return 2;
+
+  std::printf("%-48s %17s %17s %20s %10s\n", "Benchmark", "Median",
+              "Stddev", "Throughput", "Iters");
+  BenchPhysicsUpdate(1000);
+  BenchPhysicsUpdate(10000);
+  BenchOBBOBB();
+  BenchFrustum();
+  BenchSimplifyMesh(resources);
+  BenchModelImport(resources);
+  BenchSceneLoad(app, resources);
+  BenchClusteredLighting(1000);
+  BenchStaticBatcher(4096);
+  BenchParallelFor();
+
+  if (!MicroBench::WriteJson(outputPath)) {
+    std::fprintf(stderr, "[MicroBench] Cannot write %s\n", outputPath.c_str());
+    return 2;
+  }
+  std::printf("%zu results written to %s\n", MicroBench::s_Results.size(),
+              outputPath.c_str());
+  return 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+// Summaries shared by the benchmark and stress reports so their numbers are
+// computed the same way. Both expect at least one value.
+
+// Nearest-rank percentiles of per-frame timings in ms.
+inline nlohmann::json FrameTimingStats(std::vector<float> values) {
+  std::sort(values.begin(), values.end());
+  auto percentile = [&](float q) {
+    size_t rank = (size_t)std::ceil(q * (float)values.size());
+    return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+  };
+  double sum = 0.0;
+  for (float v : values)
+    sum += v;
+  return {{"p50", percentile(0.50f)},
+          {"p95", percentile(0.95f)},
+          {"p99", percentile(0.99f)},
+          {"mean", sum / (double)values.size()},
+          {"max", values.back()}};
+}
+
+inline nlohmann::json FrameCounterStats(const std::vector<float> &values) {
+  double sum = 0.0;
+  for (float v : values)
+    sum += v;
+  return {{"mean", sum / (double)values.size()},
+          {"min", *std::min_element(values.begin(), values.end())},
+          {"max", *std::max_element(values.begin(), values.end())}};
+}
@@ -1,4 +1,4 @@
-#ifndef C3D_RUNTIME
+#ifndef C3D_NO_PROFILER
 #include "GpuProfiler.h"
 #include <algorithm>
 #include <cstring>
@@ -7,8 +7,10 @@ void GpuProfiler::SetEnabled(bool v) {
   if (v && !m_Initialized)
     InitQueries();
   m_Enabled = v;
-  if (!v)
+  if (!v) {
     m_FinishedSamples.clear();
+    m_FinishedEvents.clear();
+  }
 }
 
 void GpuProfiler::InitQueries() {
@@ -27,6 +29,7 @@ void GpuProfiler::BeginFrame() {
   if (!m_Initialized)
     InitQueries();
 
+  m_FinishedEvents.clear();
   if (m_TotalFrames >= GPU_FRAME_LAG) {
     int readIdx = (m_WriteIdx + 1) % GPU_FRAME_LAG;
     FrameBuffer &readFrame = m_Frames[readIdx];
@@ -49,6 +52,7 @@ void GpuProfiler::BeginFrame() {
       glGetQueryObjectui64v(slot.qs, GL_QUERY_RESULT, &t0);
       glGetQueryObjectui64v(slot.qe, GL_QUERY_RESULT, &t1);
       float ms = (t1 >= t0) ? (float)(t1 - t0) / 1e6f : 0.0f;
+      m_FinishedEvents.push_back({slot.name, t0, std::max(t0, t1)});
 
       bool found = false;
       for (auto &s : newSamples) {
@@ -1,6 +1,6 @@
 #pragma once
 
-#ifdef C3D_RUNTIME
+#ifdef C3D_NO_PROFILER
     #define GPU_PROFILE_SCOPE(name) ((void)0)
     #define GPU_PROFILE_BEGIN(name) ((void)0)
     #define GPU_PROFILE_END(name)   ((void)0)
@@ -9,6 +9,7 @@
 #include <string>
 #include <vector>
 #include <glad/glad.h>
+#include "Profiler.h"
 
 // ─────────────────────────────────────────────────────────────────────────────
 // GpuProfiler - OpenGL GL_TIMESTAMP based per-pass GPU timing
@@ -55,6 +56,8 @@ public:
     void SetPaused(bool v) { m_Paused = v; }
 
     const std::vector<GpuSample>& GetLastSamples() const { return m_FinishedSamples; }
+    // Every scope of the frame read this BeginFrame, in issue order.
+    const std::vector<ProfileGpuEvent>& GetLastEvents() const { return m_FinishedEvents; }
 
 private:
     GpuProfiler() = default;
@@ -81,6 +84,7 @@ private:
 
     FrameBuffer m_Frames[GPU_FRAME_LAG];
     std::vector<GpuSample> m_FinishedSamples;
+    std::vector<ProfileGpuEvent> m_FinishedEvents;
 };
 
 
@@ -0,0 +1,141 @@
+#include "PerfCounters.h"
+
+#ifndef C3D_NO_PROFILER
+#include "Profiler.h"
+#include <memory>
+#include <mutex>
+
+static constexpr int kPerfCounterCount = (int)PerfCounter::Count;
+
+struct PerfCounterInfo {
+  const char *name;
+  bool gauge;
+  bool bytes;
+};
+
+static const PerfCounterInfo s_PerfCounterInfo[kPerfCounterCount] = {
+    {"Draw calls", false, false},
+    {"Triangles submitted", false, false},
+    {"Shader binds", false, false},
+    {"Texture binds", false, false},
+    {"VAO binds", false, false},
+    {"Objects drawn", false, false},
+    {"Culled (frustum)", false, false},
+    {"Culled (occlusion)", false, false},
+    {"Culled (HLOD)", false, false},
+    {"Objects at LOD 0", false, false},
+    {"Objects at LOD 1", false, false},
+    {"Objects at LOD 2", false, false},
+    {"Objects at LOD 3+", false, false},
+    {"Shadow casters culled", false, false},
+    {"Physics pairs", false, false},
+    {"Physics contacts", false, false},
+    {"Audio voices", true, false},
+    {"Audio virtual voices", true, false},
+    {"Streaming loads", false, false},
+    {"Streaming loaded (MB)", false, true},
+    {"Resource loads", false, false},
+    {"Resource cache hits", false, false},
+    {"GPU memory (MB)", true, true},
+};
+
+std::atomic<int64_t> PerfCounters::s_Gauges[kPerfCounterCount];
+int64_t PerfCounters::s_Frame[kPerfCounterCount] = {};
+std::vector<std::pair<std::string, int64_t>> PerfCounters::s_PassPending;
+std::vector<std::pair<std::string, int64_t>> PerfCounters::s_PassFrame;
+
+// Totals only grow; EndFrame remembers what it has already folded in, so a
+// block can pass to a new thread once its owner exits.
+struct PerfCounterBlock {
+  std::atomic<int64_t> values[kPerfCounterCount] = {};
+  int64_t merged[kPerfCounterCount] = {};
+  std::atomic<bool> released{false};
+};
+
+static std::mutex s_PerfCounterMutex;
+static std::vector<std::unique_ptr<PerfCounterBlock>> s_PerfCounterBlocks;
+static thread_local PerfCounterBlock *t_PerfCounterBlock = nullptr;
+
+struct PerfCounterThreadHandle {
+  std::atomic<bool> *released = nullptr;
+  ~PerfCounterThreadHandle() {
+    if (released)
+      released->store(true, std::memory_order_release);
+  }
+};
+
+std::atomic<int64_t> *PerfCounters::ThreadValues() {
+  if (t_PerfCounterBlock)
+    return t_PerfCounterBlock->values;
+
+  static thread_local PerfCounterThreadHandle handle;
+  std::lock_guard<std::mutex> lock(s_PerfCounterMutex);
+  for (auto &candidate : s_PerfCounterBlocks) {
+    if (candidate->released.load(std::memory_order_acquire)) {
+      t_PerfCounterBlock = candidate.get();
+      break;
+    }
+  }
+  if (!t_PerfCounterBlock) {
+    s_PerfCounterBlocks.push_back(std::make_unique<PerfCounterBlock>());
+    t_PerfCounterBlock = s_PerfCounterBlocks.back().get();
+  }
+  t_PerfCounterBlock->released.store(false);
+  handle.released = &t_PerfCounterBlock->released;
+  return t_PerfCounterBlock->values;
+}
+
+void PerfCounters::AddPassDrawCalls(const std::string &pass,
+                                    int64_t drawCalls) {
+  for (auto &entry : s_PassPending) {
+    if (entry.first == pass) {
+      entry.second += drawCalls;
+      return;
+    }
+  }
+  s_PassPending.push_back({pass, drawCalls});
+}
+
+void PerfCounters::EndFrame() {
+  for (int c = 0; c < kPerfCounterCount; ++c)
+    s_Frame[c] = s_PerfCounterInfo[c].gauge ? s_Gauges[c].load() : 0;
+
+  {
+    std::lock_guard<std::mutex> lock(s_PerfCounterMutex);
+    for (auto &block : s_PerfCounterBlocks) {
+      for (int c = 0; c < kPerfCounterCount; ++c) {
+        if (s_PerfCounterInfo[c].gauge)
+          continue;
+        int64_t value = block->values[c].load(std::memory_order_relaxed);
+        s_Frame[c] += value - block->merged[c];
+        block->merged[c] = value;
+      }
+    }
+  }
+
+  s_PassFrame.swap(s_PassPending);
+  s_PassPending.clear();
+
+  Profiler &profiler = Profiler::Get();
+  for (int c = 0; c < kPerfCounterCount; ++c)
+    profiler.SetCounter(s_PerfCounterInfo[c].name,
+                        (float)GetDisplayValue((PerfCounter)c));
+  for (auto &[pass, drawCalls] : s_PassFrame)
+    profiler.SetCounter("Draw calls (" + pass + ")", (float)drawCalls);
+}
+
+const char *PerfCounters::GetName(PerfCounter counter) {
+  return s_PerfCounterInfo[(int)counter].name;
+}
+
+bool PerfCounters::IsGauge(PerfCounter counter) {
+  return s_PerfCounterInfo[(int)counter].gauge;
+}
+
+double PerfCounters::GetDisplayValue(PerfCounter counter) {
+  double value = (double)s_Frame[(int)counter];
+  return s_PerfCounterInfo[(int)counter].bytes ? value / (1024.0 * 1024.0)
+                                                : value;
+}
+
+#endif
@@ -0,0 +1,89 @@
+#pragma once
+
+// Engine-wide per-frame counters. Compiled out with the profiler.
+#ifdef C3D_NO_PROFILER
+#define PERF_COUNT(counter, n) ((void)0)
+#define PERF_GAUGE(counter, value) ((void)0)
+#else
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define PERF_COUNT(counter, n) PerfCounters::Add(counter, (int64_t)(n))
+#define PERF_GAUGE(counter, value) PerfCounters::Set(counter, (int64_t)(value))
+
+enum class PerfCounter : uint8_t {
+  DrawCalls,
+  Triangles,
+  ShaderBinds,
+  TextureBinds,
+  VAOBinds,
+  ObjectsDrawn,
+  CulledFrustum,
+  CulledOcclusion,
+  CulledHLOD,
+  ObjectsLOD0,
+  ObjectsLOD1,
+  ObjectsLOD2,
+  ObjectsLOD3Plus,
+  ShadowCastersCulled,
+  PhysicsPairs,
+  PhysicsContacts,
+  AudioVoices,
+  AudioVirtualVoices,
+  StreamingLoads,
+  StreamingBytesLoaded,
+  ResourceLoads,
+  ResourceCacheHits,
+  GpuMemoryBytes,
+  Count
+};
+
+// Adds go to an accumulator owned by the calling thread, so threads never
+// contend; EndFrame() folds every thread's change since the last call into
+// the frame totals. Gauges hold the last value set from any thread.
+class PerfCounters {
+public:
+  static void Add(PerfCounter counter, int64_t n) {
+    std::atomic<int64_t> &value = ThreadValues()[(int)counter];
+    // Only this thread writes, so no read-modify-write is needed.
+    value.store(value.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+  }
+  static void Set(PerfCounter counter, int64_t value) {
+    s_Gauges[(int)counter].store(value, std::memory_order_relaxed);
+  }
+  // Total the calling thread has added so far; for measuring a span of work.
+  static int64_t GetThreadTotal(PerfCounter counter) {
+    return ThreadValues()[(int)counter].load(std::memory_order_relaxed);
+  }
+  // Draw calls issued by one render pass this frame, main thread only.
+  static void AddPassDrawCalls(const std::string &pass, int64_t drawCalls);
+
+  // Main thread, once per frame before Profiler::EndFrame(). Also publishes
+  // the totals as profiler counters.
+  static void EndFrame();
+
+  // Values of the last finished frame.
+  static int64_t Get(PerfCounter counter) { return s_Frame[(int)counter]; }
+  static const std::vector<std::pair<std::string, int64_t>> &
+  GetPassDrawCalls() {
+    return s_PassFrame;
+  }
+  static const char *GetName(PerfCounter counter);
+  static bool IsGauge(PerfCounter counter);
+  // Last frame's value in display units: bytes become MB.
+  static double GetDisplayValue(PerfCounter counter);
+
+private:
+  static std::atomic<int64_t> *ThreadValues();
+
+  static std::atomic<int64_t> s_Gauges[(int)PerfCounter::Count];
+  static int64_t s_Frame[(int)PerfCounter::Count];
+  static std::vector<std::pair<std::string, int64_t>> s_PassPending;
+  static std::vector<std::pair<std::string, int64_t>> s_PassFrame;
+};
+
+#endif
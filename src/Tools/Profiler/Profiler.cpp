@@ -1,18 +1,223 @@
-#ifndef C3D_RUNTIME
+#ifndef C3D_NO_PROFILER
 #include "Profiler.h"
+#include "../../Core/Logger.h"
+#include "GpuProfiler.h"
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+
+std::atomic<bool> Profiler::s_Recording(false);
+
+// Name given through SetThreadName, applied when the thread's buffer is
+// created so threads that never record don't allocate one.
+static thread_local std::string t_ProfilerThreadName;
+static thread_local Profiler::ThreadBuffer *t_ProfilerBuffer = nullptr;
+
+struct ProfilerThreadHandle {
+  std::atomic<bool> *released = nullptr;
+  ~ProfilerThreadHandle() {
+    if (released)
+      released->store(true, std::memory_order_release);
+  }
+};
+
+int &Profiler::ThreadDepth() {
+  static thread_local int depth = 0;
+  return depth;
+}
+
+Profiler::ThreadBuffer &Profiler::GetThreadBuffer() {
+  static thread_local ProfilerThreadHandle handle;
+  ThreadBuffer *&buffer = t_ProfilerBuffer;
+  if (buffer)
+    return *buffer;
+
+  std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+  // Reuse the buffer of a thread that has exited once it is drained.
+  for (auto &candidate : m_Threads) {
+    if (candidate->released.load(std::memory_order_acquire) &&
+        candidate->head.load() == candidate->tail.load()) {
+      buffer = candidate.get();
+      break;
+    }
+  }
+  if (!buffer) {
+    auto owned = std::make_unique<ThreadBuffer>();
+    owned->events.reset(new RawEvent[PROFILER_THREAD_EVENTS]);
+    buffer = owned.get();
+    m_Threads.push_back(std::move(owned));
+  }
+  buffer->released.store(false);
+  buffer->name = t_ProfilerThreadName.empty()
+                     ? "Thread " + std::to_string(m_Threads.size() - 1)
+                     : t_ProfilerThreadName;
+  handle.released = &buffer->released;
+  return *buffer;
+}
+
+void Profiler::SetThreadName(const std::string &name) {
+  t_ProfilerThreadName = name;
+  if (t_ProfilerBuffer) {
+    std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+    t_ProfilerBuffer->name = name;
+  }
+}
+
+void Profiler::SetEnabled(bool v) {
+  if (v && !m_Enabled)
+    m_Discard = true;
+  m_Enabled = v;
+  UpdateRecording();
+}
+
+void Profiler::SetPaused(bool v) {
+  if (!v && m_Paused)
+    m_Discard = true;
+  m_Paused = v;
+  UpdateRecording();
+}
+
+void Profiler::UpdateRecording() {
+  bool recording = (m_Enabled && !m_Paused) || m_CaptureFramesLeft > 0 ||
+                   m_AutoCaptureMs > 0.0f;
+  s_Recording.store(recording, std::memory_order_relaxed);
+}
+
+bool Profiler::StartCapture(int frames, const std::string &path) {
+  if (frames <= 0 || m_CaptureFramesLeft > 0)
+    return false;
+  if (!IsRecording())
+    m_Discard = true;
+  m_Capture.clear();
+  m_Markers.clear();
+  m_CaptureFramesLeft = frames;
+  m_CapturePath = path;
+  UpdateRecording();
+  return true;
+}
+
+void Profiler::SetAutoCaptureThreshold(float ms) {
+  if (ms > 0.0f && !IsRecording())
+    m_Discard = true;
+  m_AutoCaptureMs = std::max(ms, 0.0f);
+  if (m_AutoCaptureMs <= 0.0f && m_CaptureFramesLeft == 0)
+    m_Capture.clear();
+  UpdateRecording();
+}
+
+void Profiler::RecordEvent(const char *name, int64_t start, int depth) {
+  int64_t end = Now();
+  ThreadBuffer &buffer = GetThreadBuffer();
+  uint32_t head = buffer.head.load(std::memory_order_relaxed);
+  uint32_t tail = buffer.tail.load(std::memory_order_acquire);
+  if (head - tail >= PROFILER_THREAD_EVENTS) {
+    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buffer.events[head % PROFILER_THREAD_EVENTS] = {name, start, end, depth};
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::BeginSample(const char *name) {
+  if (!IsRecording())
+    return;
+  int depth = ThreadDepth()++;
+  if (depth < PROFILER_MAX_DEPTH)
+    GetThreadBuffer().open[depth] = {name, Now()};
+}
+
+void Profiler::EndSample(const char *name) {
+  int &depth = ThreadDepth();
+  if (depth <= 0)
+    return;
+  --depth;
+  if (depth >= PROFILER_MAX_DEPTH)
+    return;
+  const ThreadBuffer::Open &open = GetThreadBuffer().open[depth];
+  RecordEvent(open.name ? open.name : name, open.start, depth);
+}
+
+void Profiler::DrainEvents(std::vector<std::vector<RawEvent>> &out,
+                           uint32_t &dropped) {
+  std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+  out.resize(m_Threads.size());
+  for (size_t t = 0; t < m_Threads.size(); ++t) {
+    ThreadBuffer &buffer = *m_Threads[t];
+    uint32_t head = buffer.head.load(std::memory_order_acquire);
+    uint32_t tail = buffer.tail.load(std::memory_order_relaxed);
+    out[t].clear();
+    for (uint32_t i = tail; i != head; ++i)
+      out[t].push_back(buffer.events[i % PROFILER_THREAD_EVENTS]);
+    buffer.tail.store(head, std::memory_order_release);
+    dropped += buffer.dropped.exchange(0, std::memory_order_relaxed);
+  }
+}
 
 void Profiler::BeginFrame() {
-  if (!m_Enabled || m_Paused)
+  if (!IsRecording())
     return;
   m_FrameStart = std::chrono::high_resolution_clock::now();
-  m_CurrentSamples.clear();
+  if (m_Discard || m_TimelineStart == 0) {
+    std::vector<std::vector<RawEvent>> stale;
+    uint32_t dropped = 0;
+    DrainEvents(stale, dropped);
+    m_Discard = false;
+    m_TimelineStart = Now();
+  }
+}
+
+namespace {
+struct ProfilerBuildNode {
+  const char *name;
+  int64_t total = 0;
+  int calls = 0;
+  std::vector<int> children;
+};
+} // namespace
+
+static int FindOrAddProfilerChild(std::vector<ProfilerBuildNode> &nodes,
+                                  int parent, const char *name) {
+  for (int child : nodes[parent].children) {
+    const char *other = nodes[child].name;
+    if (other == name || std::strcmp(other, name) == 0)
+      return child;
+  }
+  nodes.push_back({name});
+  int index = (int)nodes.size() - 1;
+  nodes[parent].children.push_back(index);
+  return index;
+}
+
+static void FlattenProfilerTree(std::vector<ProfilerBuildNode> &nodes,
+                                int index, int depth, const char *label,
+                                std::vector<ProfileNode> &out) {
+  ProfilerBuildNode &node = nodes[index];
+  std::sort(node.children.begin(), node.children.end(),
+            [&](int a, int b) { return nodes[a].total > nodes[b].total; });
+
+  int64_t childTotal = 0;
+  for (int child : node.children)
+    childTotal += nodes[child].total;
+
+  ProfileNode flat;
+  flat.name = label ? label : node.name;
+  flat.totalMs = (float)node.total * 1e-6f;
+  flat.selfMs = (float)std::max<int64_t>(node.total - childTotal, 0) * 1e-6f;
+  flat.calls = node.calls;
+  flat.depth = depth;
+  out.push_back(std::move(flat));
+
+  for (int child : node.children)
+    FlattenProfilerTree(nodes, child, depth + 1, nullptr, out);
 }
 
 void Profiler::EndFrame(float deltaTimeMs) {
-  if (!m_Enabled || m_Paused)
+  if (!IsRecording())
     return;
   auto now = std::chrono::high_resolution_clock::now();
+  int64_t frameEnd = Now();
 
   float totalMs =
       (deltaTimeMs > 0.0f)
@@ -23,52 +228,259 @@ void Profiler::EndFrame(float deltaTimeMs) {
   ProfileFrame frame;
   frame.totalMs = totalMs;
   frame.fps = (totalMs > 0.0f) ? (1000.0f / totalMs) : 0.0f;
-  frame.samples = m_CurrentSamples;
+  frame.counters = m_Counters;
 
-  m_FrameHistory[m_FrameIdx] = std::move(frame);
-  m_FrameIdx = (m_FrameIdx + 1) % PROFILER_HISTORY;
+  std::vector<std::vector<RawEvent>> perThread;
+  DrainEvents(perThread, frame.droppedEvents);
+  if (m_CaptureFramesLeft > 0 || m_AutoCaptureMs > 0.0f)
+    RecordCaptureFrame(perThread, frameEnd, totalMs);
+  if (m_Enabled && !m_Paused) {
+    BuildHistoryFrame(perThread, frame);
+    m_FrameHistory[m_FrameIdx] = std::move(frame);
+    m_FrameIdx = (m_FrameIdx + 1) % PROFILER_HISTORY;
 
-  float sum = 0.0f;
-  int count = 0;
-  for (auto &f : m_FrameHistory) {
-    if (f.fps > 0.0f) {
-      sum += f.fps;
-      count++;
+    float sum = 0.0f;
+    int count = 0;
+    for (auto &f : m_FrameHistory) {
+      if (f.fps > 0.0f) {
+        sum += f.fps;
+        count++;
+      }
     }
+    m_AvgFps = (count > 0) ? (sum / (float)count) : 0.0f;
   }
-  m_AvgFps = (count > 0) ? (sum / (float)count) : 0.0f;
+  m_TimelineStart = frameEnd;
 }
 
-void Profiler::BeginSample(const std::string &name) {
-  if (!m_Enabled || m_Paused)
+void Profiler::BuildHistoryFrame(std::vector<std::vector<RawEvent>> &perThread,
+                                 ProfileFrame &frame) {
+  {
+    std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+    for (auto &buffer : m_Threads)
+      frame.threadNames.push_back(buffer->name);
+  }
+
+  // Parents start no later than their children and sit one level up, so
+  // sorting by start (then depth) visits every parent before its children.
+  std::vector<ProfilerBuildNode> nodes;
+  std::vector<std::pair<int, size_t>> roots;
+  for (size_t t = 0; t < perThread.size(); ++t) {
+    auto &events = perThread[t];
+    if (events.empty())
+      continue;
+    std::sort(events.begin(), events.end(),
+              [](const RawEvent &a, const RawEvent &b) {
+                return a.start != b.start ? a.start < b.start
+                                          : a.depth < b.depth;
+              });
+
+    int root = (int)nodes.size();
+    nodes.push_back({nullptr});
+    roots.push_back({root, t});
+    int stack[PROFILER_MAX_DEPTH + 1];
+    std::fill(std::begin(stack), std::end(stack), root);
+
+    for (const RawEvent &e : events) {
+      int depth = std::clamp(e.depth, 0, PROFILER_MAX_DEPTH - 1);
+      int node = FindOrAddProfilerChild(nodes, stack[depth], e.name);
+      nodes[node].total += e.end - e.start;
+      nodes[node].calls++;
+      stack[depth + 1] = node;
+      if (depth == 0)
+        nodes[root].total += e.end - e.start;
+
+      ProfileTimelineEvent timeline;
+      timeline.name = e.name;
+      timeline.startMs = (float)(e.start - m_TimelineStart) * 1e-6f;
+      timeline.durationMs = (float)(e.end - e.start) * 1e-6f;
+      timeline.depth = (uint16_t)depth;
+      timeline.thread = (uint16_t)t;
+      frame.events.push_back(timeline);
+    }
+
+    // The outermost scopes of the thread driving the frame feed the
+    // stacked history graph.
+    if (frame.threadNames[t] == "Main") {
+      for (int child : nodes[root].children)
+        frame.samples.push_back(
+            {nodes[child].name, (float)nodes[child].total * 1e-6f});
+    }
+  }
+  for (const auto &root : roots)
+    FlattenProfilerTree(nodes, root.first, 0,
+                        frame.threadNames[root.second].c_str(), frame.tree);
+}
+
+void Profiler::RecordCaptureFrame(
+    const std::vector<std::vector<RawEvent>> &perThread, int64_t frameEnd,
+    float totalMs) {
+  CaptureFrame captured;
+  captured.start = m_TimelineStart;
+  captured.end = frameEnd;
+  captured.totalMs = totalMs;
+  for (size_t t = 0; t < perThread.size(); ++t)
+    for (const RawEvent &e : perThread[t])
+      captured.events.push_back({(uint16_t)t, e});
+  captured.gpu = GpuProfiler::Get().GetLastEvents();
+  captured.markers.swap(m_Markers);
+  m_Capture.push_back(std::move(captured));
+
+  if (m_CaptureCooldown > 0)
+    m_CaptureCooldown--;
+
+  if (m_CaptureFramesLeft > 0) {
+    if (--m_CaptureFramesLeft == 0) {
+      WriteCapture();
+      m_Capture.clear();
+      UpdateRecording();
+    }
     return;
-  m_Active[name] = {std::chrono::high_resolution_clock::now()};
+  }
+
+  // Auto capture: keep a rolling window and extend it past a slow frame.
+  while ((int)m_Capture.size() > PROFILER_SPIKE_PRE_FRAMES)
+    m_Capture.pop_front();
+  if (m_CaptureCooldown == 0 && totalMs > m_AutoCaptureMs) {
+    Logger::AddLog("[Profiler] %.2f ms frame, capturing", totalMs);
+    m_CaptureFramesLeft = PROFILER_SPIKE_POST_FRAMES;
+    m_CapturePath.clear();
+    // Let the window fill up again before the next spike is captured.
+    m_CaptureCooldown = PROFILER_SPIKE_POST_FRAMES + PROFILER_SPIKE_PRE_FRAMES;
+  }
 }
 
-void Profiler::EndSample(const std::string &name) {
-  if (!m_Enabled || m_Paused)
+static void WriteProfilerTraceName(FILE *file, const char *name) {
+  std::fputc('"', file);
+  for (const char *c = name; *c; ++c) {
+    if (*c == '"' || *c == '\\')
+      std::fputc('\\', file);
+    if ((unsigned char)*c >= 0x20)
+      std::fputc(*c, file);
+  }
+  std::fputc('"', file);
+}
+
+// Chrome trace event format: complete ("X") events with microsecond
+// timestamps on one process, one track per thread plus a frame track and a
+// GPU track. Markers are instant ("i") events on the frame track.
+void Profiler::WriteCapture() {
+  if (m_Capture.empty())
     return;
-  auto it = m_Active.find(name);
-  if (it == m_Active.end())
+
+  std::string path = m_CapturePath;
+  if (path.empty()) {
+    std::time_t t = std::time(nullptr);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&t));
+    path = std::string("Captures/trace_") + stamp + ".json";
+  }
+  std::error_code ec;
+  std::filesystem::path dir = std::filesystem::path(path).parent_path();
+  if (!dir.empty())
+    std::filesystem::create_directories(dir, ec);
+
+  FILE *file = std::fopen(path.c_str(), "w");
+  if (!file) {
+    Logger::AddLog("[Profiler] Failed to write capture to %s", path.c_str());
     return;
+  }
 
-  auto now = std::chrono::high_resolution_clock::now();
-  float ms =
-      std::chrono::duration<float, std::milli>(now - it->second.start).count();
-
-  bool found = false;
-  for (auto &s : m_CurrentSamples) {
-    if (s.name == name) {
-      s.durationMs += ms;
-      found = true;
-      break;
-    }
+  std::vector<std::string> threadNames;
+  {
+    std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+    for (auto &buffer : m_Threads)
+      threadNames.push_back(buffer->name);
   }
-  if (!found) {
-    m_CurrentSamples.push_back({name, ms});
+  const int frameTid = 0;
+  const int gpuTid = (int)threadNames.size() + 1;
+  const int64_t origin = m_Capture.front().start;
+  auto us = [origin](int64_t ns) { return (double)(ns - origin) * 1e-3; };
+
+  std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+                     "\"args\":{\"name\":\"Calcium3D\"}}");
+  auto threadMeta = [&](int tid, const char *name) {
+    std::fprintf(file,
+                 ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                 "\"tid\":%d,\"args\":{\"name\":",
+                 tid);
+    WriteProfilerTraceName(file, name);
+    std::fprintf(file,
+                 "}},\n{\"name\":\"thread_sort_index\",\"ph\":\"M\","
+                 "\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}",
+                 tid, tid);
+  };
+  threadMeta(frameTid, "Frames");
+  for (size_t t = 0; t < threadNames.size(); ++t)
+    threadMeta((int)t + 1, threadNames[t].c_str());
+  threadMeta(gpuTid, "GPU");
+
+  auto complete = [&](const char *name, int tid, double ts, double dur) {
+    std::fprintf(file, ",\n{\"name\":");
+    WriteProfilerTraceName(file, name);
+    std::fprintf(file,
+                 ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                 "\"dur\":%.3f}",
+                 tid, ts, dur);
+  };
+
+  for (size_t f = 0; f < m_Capture.size(); ++f) {
+    const CaptureFrame &frame = m_Capture[f];
+    char label[64];
+    std::snprintf(label, sizeof(label), "Frame %zu (%.2f ms)", f,
+                  frame.totalMs);
+    complete(label, frameTid, us(frame.start),
+             (double)(frame.end - frame.start) * 1e-3);
+    for (const auto &marker : frame.markers) {
+      std::fprintf(file, ",\n{\"name\":");
+      WriteProfilerTraceName(file, marker.second.c_str());
+      std::fprintf(file,
+                   ",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%d,"
+                   "\"ts\":%.3f}",
+                   frameTid, us(marker.first));
+    }
+    for (const auto &entry : frame.events) {
+      const RawEvent &e = entry.second;
+      complete(e.name, entry.first + 1, us(e.start),
+               (double)(e.end - e.start) * 1e-3);
+    }
+
+    // GPU results arrive GPU_FRAME_LAG - 1 frames after they were issued
+    // and use the GPU clock, so they are placed at the start of the frame
+    // that issued them, keeping their relative offsets.
+    if (frame.gpu.empty() || f < (size_t)(GPU_FRAME_LAG - 1))
+      continue;
+    uint64_t gpuOrigin = frame.gpu.front().startNs;
+    for (const ProfileGpuEvent &e : frame.gpu)
+      gpuOrigin = std::min(gpuOrigin, e.startNs);
+    double base = us(m_Capture[f - (GPU_FRAME_LAG - 1)].start);
+    for (const ProfileGpuEvent &e : frame.gpu)
+      complete(e.name.c_str(), gpuTid,
+               base + (double)(e.startNs - gpuOrigin) * 1e-3,
+               (double)(e.endNs - e.startNs) * 1e-3);
   }
+  std::fprintf(file, "\n]}\n");
+  std::fclose(file);
+
+  m_LastCapturePath = path;
+  Logger::AddLog("[Profiler] Wrote %zu frame capture to %s", m_Capture.size(),
+                 path.c_str());
+}
 
-  m_Active.erase(it);
+void Profiler::AddMarker(const std::string &text) {
+  if (m_CaptureFramesLeft == 0 && m_AutoCaptureMs <= 0.0f)
+    return;
+  m_Markers.push_back({Now(), text});
+}
+
+void Profiler::SetCounter(const std::string &name, float value) {
+  for (auto &c : m_Counters) {
+    if (c.name == name) {
+      c.value = value;
+      return;
+    }
+  }
+  m_Counters.push_back({name, value});
 }
 
 const char *Profiler::GetCategoryColor(const std::string &name) {
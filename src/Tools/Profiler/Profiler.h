@@ -1,35 +1,90 @@
 #pragma once
 
-#ifdef C3D_RUNTIME
+// Define C3D_NO_PROFILER to compile every profiling hook out.
+#ifdef C3D_NO_PROFILER
 #define PROFILE_SCOPE(name) ((void)0)
 #define PROFILE_BEGIN(name) ((void)0)
 #define PROFILE_END(name) ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
 #else
 
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #define PROFILE_CONCAT_IMPL(a, b) a##b
 #define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+// name must outlive the frame; string literals are the intended use.
 #define PROFILE_SCOPE(name)                                                    \
   PROFILE_CONCAT(ProfilerScope _prof_scope_, __LINE__)(name)
 #define PROFILE_BEGIN(name) Profiler::Get().BeginSample(name)
 #define PROFILE_END(name) Profiler::Get().EndSample(name)
+#define PROFILE_COUNTER(name, value) Profiler::Get().SetCounter(name, value)
+#define PROFILE_THREAD(name) Profiler::Get().SetThreadName(name)
 
 static constexpr int PROFILER_HISTORY = 256;
+// Events one thread can have in flight between two EndFrame calls; the rest
+// are dropped and counted.
+static constexpr uint32_t PROFILER_THREAD_EVENTS = 16384;
+static constexpr int PROFILER_MAX_DEPTH = 32;
+// Frames kept before and recorded after a spike that triggers a capture.
+static constexpr int PROFILER_SPIKE_PRE_FRAMES = 60;
+static constexpr int PROFILER_SPIKE_POST_FRAMES = 30;
 
 struct ProfileSample {
   std::string name;
   float durationMs = 0.0f;
 };
 
+struct ProfileCounter {
+  std::string name;
+  float value = 0.0f;
+};
+
+// One node of the merged call tree, stored depth-first. Depth 0 nodes are
+// threads; their children are that thread's outermost scopes.
+struct ProfileNode {
+  std::string name;
+  float totalMs = 0.0f;
+  float selfMs = 0.0f;
+  int calls = 0;
+  int depth = 0;
+};
+
+// A single scope instance, relative to the start of the frame.
+struct ProfileTimelineEvent {
+  const char *name = nullptr;
+  float startMs = 0.0f;
+  float durationMs = 0.0f;
+  uint16_t depth = 0;
+  uint16_t thread = 0;
+};
+
+// A GPU_PROFILE_SCOPE resolved from its timestamp queries, in GPU clock
+// nanoseconds.
+struct ProfileGpuEvent {
+  std::string name;
+  uint64_t startNs = 0;
+  uint64_t endNs = 0;
+};
+
 struct ProfileFrame {
   float totalMs = 0.0f;
   float fps = 0.0f;
+  // Outermost main thread scopes, merged by name.
   std::vector<ProfileSample> samples;
+  std::vector<ProfileCounter> counters;
+  std::vector<ProfileNode> tree;
+  std::vector<ProfileTimelineEvent> events;
+  std::vector<std::string> threadNames;
+  uint32_t droppedEvents = 0;
 };
 
 class Profiler {
@@ -39,15 +94,49 @@ public:
     return instance;
   }
 
-  void BeginSample(const std::string &name);
-  void EndSample(const std::string &name);
+  // True while enabled and not paused, or while a capture may need events.
+  // This is the only check a scope makes when profiling is off.
+  static bool IsRecording() {
+    return s_Recording.load(std::memory_order_relaxed);
+  }
+  static int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  // Manual pairs must nest like scopes on the calling thread.
+  void BeginSample(const char *name);
+  void EndSample(const char *name);
+  // Called by ProfilerScope when it closes.
+  void RecordEvent(const char *name, int64_t start, int depth);
+  // Counters keep their last value and are recorded with every frame, so
+  // they can be set from anywhere on the main thread, even between frames.
+  void SetCounter(const std::string &name, float value);
+  void SetThreadName(const std::string &name);
   void BeginFrame();
   void EndFrame(float deltaTimeMs = -1.0f);
 
   bool IsEnabled() const { return m_Enabled; }
-  void SetEnabled(bool v) { m_Enabled = v; }
+  void SetEnabled(bool v);
   bool IsPaused() const { return m_Paused; }
-  void SetPaused(bool v) { m_Paused = v; }
+  void SetPaused(bool v);
+
+  // Records every event of the next `frames` frames, including GPU passes,
+  // and writes them as Chrome trace JSON (chrome://tracing or
+  // ui.perfetto.dev). An empty path writes to Captures/ with a timestamp.
+  // Works whether or not the profiler window is recording.
+  bool StartCapture(int frames, const std::string &path = "");
+  bool IsCapturing() const { return m_CaptureFramesLeft > 0; }
+  // Frames slower than this trigger a capture of the surrounding frames.
+  // 0 disables; anything else keeps events recorded at all times.
+  void SetAutoCaptureThreshold(float ms);
+  float GetAutoCaptureThreshold() const { return m_AutoCaptureMs; }
+  const std::string &GetLastCapturePath() const { return m_LastCapturePath; }
+  // Main thread. Puts an instant event on the frame track of the capture
+  // being recorded, so decisions line up with the timings around them.
+  // Ignored when nothing can be captured.
+  void AddMarker(const std::string &text);
 
   const std::array<ProfileFrame, PROFILER_HISTORY> &GetFrameHistory() const {
     return m_FrameHistory;
@@ -61,19 +150,76 @@ public:
 
   static const char *GetCategoryColor(const std::string &name);
 
+  // Scope nesting depth of the calling thread.
+  static int &ThreadDepth();
+
+  struct RawEvent {
+    const char *name;
+    int64_t start;
+    int64_t end;
+    int depth;
+  };
+
+  // Single producer (the owning thread), single consumer (EndFrame). head
+  // only moves on the producer side and tail only on the consumer side.
+  struct ThreadBuffer {
+    std::string name;
+    std::unique_ptr<RawEvent[]> events;
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint32_t> dropped{0};
+    // Set once the owning thread has exited.
+    std::atomic<bool> released{false};
+    struct Open {
+      const char *name;
+      int64_t start;
+    };
+    Open open[PROFILER_MAX_DEPTH];
+  };
+
 private:
   Profiler() = default;
-  bool m_Enabled = false;
-  bool m_Paused = false;
 
-  struct ActiveSample {
-    std::chrono::high_resolution_clock::time_point start;
+  struct CaptureFrame {
+    int64_t start = 0;
+    int64_t end = 0;
+    float totalMs = 0.0f;
+    std::vector<std::pair<uint16_t, RawEvent>> events;
+    std::vector<ProfileGpuEvent> gpu;
+    std::vector<std::pair<int64_t, std::string>> markers;
   };
 
-  std::unordered_map<std::string, ActiveSample> m_Active;
-  std::vector<ProfileSample> m_CurrentSamples;
+  ThreadBuffer &GetThreadBuffer();
+  void UpdateRecording();
+  void DrainEvents(std::vector<std::vector<RawEvent>> &out, uint32_t &dropped);
+  void BuildHistoryFrame(std::vector<std::vector<RawEvent>> &perThread,
+                         ProfileFrame &frame);
+  void RecordCaptureFrame(const std::vector<std::vector<RawEvent>> &perThread,
+                          int64_t frameEnd, float totalMs);
+  void WriteCapture();
+
+  static std::atomic<bool> s_Recording;
+
+  bool m_Enabled = false;
+  bool m_Paused = false;
+  // Set when recording restarts, so stale events are thrown away.
+  bool m_Discard = false;
+
+  std::mutex m_ThreadsMutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> m_Threads;
+
+  std::deque<CaptureFrame> m_Capture;
+  int m_CaptureFramesLeft = 0;
+  int m_CaptureCooldown = 0;
+  float m_AutoCaptureMs = 0.0f;
+  std::string m_CapturePath;
+  std::string m_LastCapturePath;
+  // Added since the last recorded capture frame.
+  std::vector<std::pair<int64_t, std::string>> m_Markers;
+
+  std::vector<ProfileCounter> m_Counters;
   std::chrono::high_resolution_clock::time_point m_FrameStart;
-  float m_FrameStartMs = 0.0f;
+  int64_t m_TimelineStart = 0;
 
   std::array<ProfileFrame, PROFILER_HISTORY> m_FrameHistory{};
   int m_FrameIdx = 0;
@@ -81,13 +227,24 @@ private:
 };
 
 struct ProfilerScope {
-  explicit ProfilerScope(const char *name) : m_Name(name) {
-    Profiler::Get().BeginSample(m_Name);
+  explicit ProfilerScope(const char *name) {
+    if (!Profiler::IsRecording())
+      return;
+    m_Name = name;
+    m_Depth = Profiler::ThreadDepth()++;
+    m_Start = Profiler::Now();
+  }
+  ~ProfilerScope() {
+    if (!m_Name)
+      return;
+    --Profiler::ThreadDepth();
+    Profiler::Get().RecordEvent(m_Name, m_Start, m_Depth);
   }
-  ~ProfilerScope() { Profiler::Get().EndSample(m_Name); }
 
 private:
-  const char *m_Name;
+  const char *m_Name = nullptr;
+  int64_t m_Start = 0;
+  int m_Depth = 0;
 };
 
 #endif
@@ -7,6 +7,13 @@
 #include <string>
 #include <vector>
 
+#ifdef C3D_NO_PROFILER
+void ProfilerUI::Draw(bool *pOpen) {
+  if (ImGui::Begin("Profiler##C3D", pOpen))
+    ImGui::TextDisabled("The profiler is compiled out of this build.");
+  ImGui::End();
+}
+#else
 struct CatDef {
   const char *label;
   ImVec4 color;
@@ -35,6 +42,139 @@ static ImU32 GetU32(const std::string &name) {
 }
 
 static int s_SelFrame = -1;
+static float s_TimelineZoom = 1.0f;
+static int s_CaptureFrames = 300;
+
+// One lane per thread, scopes stacked by depth, time running left to right
+// from the end of the previous frame.
+static void DrawTimeline(const ProfileFrame &frame, const ImVec2 &size) {
+  const float labelW = 90.0f;
+  const float rowH = 16.0f;
+  const float laneGap = 6.0f;
+
+  float spanMs = std::max(frame.totalMs, 0.001f);
+  std::vector<int> laneDepth(frame.threadNames.size(), -1);
+  for (const auto &e : frame.events) {
+    spanMs = std::max(spanMs, e.startMs + e.durationMs);
+    if (e.thread < laneDepth.size())
+      laneDepth[e.thread] = std::max(laneDepth[e.thread], (int)e.depth);
+  }
+  std::vector<float> laneY(laneDepth.size(), 0.0f);
+  float totalH = 0.0f;
+  for (size_t t = 0; t < laneDepth.size(); ++t) {
+    if (laneDepth[t] < 0)
+      continue;
+    laneY[t] = totalH;
+    totalH += (laneDepth[t] + 1) * rowH + laneGap;
+  }
+
+  ImGui::BeginChild("##timeline", size, false,
+                    ImGuiWindowFlags_HorizontalScrollbar);
+  ImDrawList *draw = ImGui::GetWindowDrawList();
+  ImVec2 origin = ImGui::GetCursorScreenPos();
+  float width =
+      std::max(ImGui::GetContentRegionAvail().x - labelW, 50.0f) *
+      s_TimelineZoom;
+  float pxPerMs = width / spanMs;
+  ImVec2 mouse = ImGui::GetIO().MousePos;
+  bool hovered = ImGui::IsWindowHovered();
+
+  for (size_t t = 0; t < laneDepth.size(); ++t) {
+    if (laneDepth[t] < 0)
+      continue;
+    float y = origin.y + laneY[t];
+    draw->AddRectFilled(
+        ImVec2(origin.x, y),
+        ImVec2(origin.x + labelW + width, y + (laneDepth[t] + 1) * rowH),
+        IM_COL32(20, 20, 26, 255));
+    draw->AddText(ImVec2(origin.x + 4, y + 1), IM_COL32(200, 200, 210, 255),
+                  frame.threadNames[t].c_str());
+  }
+
+  for (const auto &e : frame.events) {
+    if (e.thread >= laneDepth.size())
+      continue;
+    float x0 = origin.x + labelW + std::max(e.startMs, 0.0f) * pxPerMs;
+    float x1 = std::max(origin.x + labelW + (e.startMs + e.durationMs) *
+                                                pxPerMs,
+                        x0 + 1.0f);
+    float y0 = origin.y + laneY[e.thread] + e.depth * rowH;
+    float y1 = y0 + rowH - 1.0f;
+    draw->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), GetU32(e.name));
+    if (x1 - x0 > 30.0f) {
+      ImVec4 clip(x0 + 2, y0, x1 - 2, y1);
+      draw->AddText(nullptr, 0.0f, ImVec2(x0 + 3, y0 + 1),
+                    IM_COL32(255, 255, 255, 220), e.name, nullptr, 0.0f,
+                    &clip);
+    }
+    if (hovered && mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 &&
+        mouse.y < y1) {
+      ImGui::BeginTooltip();
+      ImGui::Text("%s", e.name);
+      ImGui::TextDisabled("%s  @ %.3f ms  %.3f ms",
+                          frame.threadNames[e.thread].c_str(), e.startMs,
+                          e.durationMs);
+      ImGui::EndTooltip();
+    }
+  }
+
+  ImGui::Dummy(ImVec2(labelW + width, totalH));
+  ImGui::EndChild();
+}
+
+// Counters keep their slot from frame to frame, so a counter's history is
+// read at the same index while the name still matches.
+static void
+DrawCounters(const std::array<ProfileFrame, PROFILER_HISTORY> &history,
+             int curIdx, const ProfileFrame &frame, const ImVec2 &size) {
+  ImGui::BeginChild("##counters", size);
+  if (!ImGui::BeginTable("##counterTable", 4,
+                         ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV |
+                             ImGuiTableFlags_SizingStretchProp)) {
+    ImGui::EndChild();
+    return;
+  }
+  ImGui::TableSetupColumn("Counter", ImGuiTableColumnFlags_WidthStretch, 2.0f);
+  ImGui::TableSetupColumn("Value", ImGuiTableColumnFlags_WidthStretch, 1.0f);
+  ImGui::TableSetupColumn("Avg / Max", ImGuiTableColumnFlags_WidthStretch,
+                          1.4f);
+  ImGui::TableSetupColumn("History", ImGuiTableColumnFlags_WidthStretch, 2.5f);
+  ImGui::TableHeadersRow();
+
+  float values[PROFILER_HISTORY];
+  for (size_t k = 0; k < frame.counters.size(); ++k) {
+    const ProfileCounter &counter = frame.counters[k];
+    float sum = 0.0f;
+    float maxValue = 0.0f;
+    int count = 0;
+    for (int i = 0; i < PROFILER_HISTORY; ++i) {
+      const ProfileFrame &f = history[(curIdx + i) % PROFILER_HISTORY];
+      bool match = k < f.counters.size() && f.counters[k].name == counter.name;
+      values[i] = match ? f.counters[k].value : 0.0f;
+      if (match) {
+        sum += values[i];
+        maxValue = std::max(maxValue, values[i]);
+        ++count;
+      }
+    }
+
+    ImGui::TableNextRow();
+    ImGui::TableSetColumnIndex(0);
+    ImGui::TextUnformatted(counter.name.c_str());
+    ImGui::TableSetColumnIndex(1);
+    ImGui::Text("%.6g", counter.value);
+    ImGui::TableSetColumnIndex(2);
+    ImGui::TextDisabled("%.4g / %.4g", count ? sum / count : 0.0f, maxValue);
+    ImGui::TableSetColumnIndex(3);
+    ImGui::PushID((int)k);
+    ImGui::SetNextItemWidth(-1);
+    ImGui::PlotLines("##history", values, PROFILER_HISTORY, 0, nullptr, 0.0f,
+                     std::max(maxValue, 1.0f), ImVec2(0, 18));
+    ImGui::PopID();
+  }
+  ImGui::EndTable();
+  ImGui::EndChild();
+}
 
 void ProfilerUI::Draw(bool* pOpen) {
     auto& prof = Profiler::Get();
@@ -96,6 +236,31 @@ void ProfilerUI::Draw(bool* pOpen) {
   ImGui::Text(gpuHasData ? " GPU Queries Active"
                          : "  GPU Queries (waiting...)");
   ImGui::PopStyleColor();
+
+  bool capturing = prof.IsCapturing();
+  ImGui::PushStyleColor(ImGuiCol_Button, capturing
+                                             ? ImVec4(0.8f, 0.2f, 0.2f, 1.0f)
+                                             : ImVec4(0.3f, 0.3f, 0.35f, 1.0f));
+  if (ImGui::Button(capturing ? "  ● Capturing  " : "  Capture Trace  ") &&
+      !capturing)
+    prof.StartCapture(s_CaptureFrames);
+  ImGui::PopStyleColor();
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(70);
+  if (ImGui::InputInt("frames", &s_CaptureFrames, 0))
+    s_CaptureFrames = std::clamp(s_CaptureFrames, 1, 10000);
+  ImGui::SameLine(0, 16);
+  float spikeMs = prof.GetAutoCaptureThreshold();
+  ImGui::SetNextItemWidth(70);
+  if (ImGui::InputFloat("spike ms", &spikeMs, 0.0f, 0.0f, "%.1f"))
+    prof.SetAutoCaptureThreshold(spikeMs);
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Capture the frames around any frame slower than this. "
+                      "0 disables.");
+  if (!prof.GetLastCapturePath().empty()) {
+    ImGui::SameLine(0, 16);
+    ImGui::TextDisabled("Last: %s", prof.GetLastCapturePath().c_str());
+  }
   ImGui::Separator();
 
   float maxFrameMs = 20.0f;
@@ -107,7 +272,7 @@ void ProfilerUI::Draw(bool* pOpen) {
   float sideW = 150.0f;
   float innerH = ImGui::GetContentRegionAvail().y;
   float graphH = 95.0f;
-  float tableH = innerH - graphH - 90.0f;
+  float tableH = innerH - graphH - 120.0f;
 
   ImGui::BeginChild("##sidebar", ImVec2(sideW, innerH), false);
   ImGui::TextDisabled("CPU & GPU Usage");
@@ -213,121 +378,144 @@ void ProfilerUI::Draw(bool* pOpen) {
     return -1.f;
   };
 
-  const auto &sorted =
-      frame.samples; 
-
   ImGui::TextDisabled("Frame: %.2f ms  |  %.1f FPS   |   GPU data: 1-frame "
                       "delayed (OpenGL async)",
                       frameMs, frame.fps);
   ImGui::Spacing();
 
-  ImGui::PushStyleColor(ImGuiCol_TableRowBg, ImVec4(0.10f, 0.10f, 0.12f, 1.0f));
-  ImGui::PushStyleColor(ImGuiCol_TableRowBgAlt,
-                        ImVec4(0.12f, 0.12f, 0.15f, 1.0f));
-
-  if (ImGui::BeginTable("##ptable", 5,
-                        ImGuiTableFlags_BordersInnerH | ImGuiTableFlags_RowBg |
-                            ImGuiTableFlags_SizingStretchProp,
-                        ImVec2(0, tableH))) {
-
-    ImGui::TableSetupColumn("Pass", ImGuiTableColumnFlags_WidthStretch, 0.22f);
-    ImGui::TableSetupColumn("CPU ms", ImGuiTableColumnFlags_WidthFixed, 62.0f);
-    ImGui::TableSetupColumn("CPU Bar", ImGuiTableColumnFlags_WidthStretch,
-                            0.25f);
-    ImGui::TableSetupColumn("GPU ms", ImGuiTableColumnFlags_WidthFixed, 62.0f);
-    ImGui::TableSetupColumn("GPU Bar", ImGuiTableColumnFlags_WidthStretch,
-                            0.30f);
-    ImGui::TableHeadersRow();
-
-    auto drawBar = [&](float ms, float maxForBar, ImU32 col, bool dimmed) {
-      float ratio = std::min(ms / std::max(maxForBar, 0.001f), 1.f);
-      ImVec2 rMin = ImGui::GetCursorScreenPos();
-      float rW = ratio * (ImGui::GetContentRegionAvail().x - 4.f);
-      ImU32 col2 =
-          dimmed
-              ? ImGui::ColorConvertFloat4ToU32(ImVec4(0.4f, 0.4f, 0.45f, 0.6f))
-              : col;
-      if (rW > 0)
-        draw->AddRectFilled(rMin, ImVec2(rMin.x + rW, rMin.y + 15.f), col2,
-                            2.f);
-      if (rW > 28) {
-        char pct[10];
-        snprintf(pct, sizeof(pct), "%.1f%%", ratio * 100.f);
-        draw->AddText(ImVec2(rMin.x + 4, rMin.y + 1),
-                      IM_COL32(255, 255, 255, 180), pct);
-      }
-      ImGui::Dummy(ImVec2(0, 16));
-    };
+  auto drawBar = [&](float ms, float maxForBar, ImU32 col) {
+    float ratio = std::min(ms / std::max(maxForBar, 0.001f), 1.f);
+    ImVec2 rMin = ImGui::GetCursorScreenPos();
+    float rW = ratio * (ImGui::GetContentRegionAvail().x - 4.f);
+    if (rW > 0)
+      draw->AddRectFilled(rMin, ImVec2(rMin.x + rW, rMin.y + 15.f), col, 2.f);
+    if (rW > 28) {
+      char pct[10];
+      snprintf(pct, sizeof(pct), "%.1f%%", ratio * 100.f);
+      draw->AddText(ImVec2(rMin.x + 4, rMin.y + 1),
+                    IM_COL32(255, 255, 255, 180), pct);
+    }
+    ImGui::Dummy(ImVec2(0, 16));
+  };
 
-    float maxGpuMs = 1.0f;
-    for (auto &g : gpuSamples)
-      if (g.durationMs > maxGpuMs)
-        maxGpuMs = g.durationMs;
-
-    for (auto &s : sorted) {
-      float gMs = gpuMs(s.name);
-      ImVec4 col = GetColor(s.name);
-      ImU32 u32 = ImGui::ColorConvertFloat4ToU32(col);
-
-      ImGui::TableNextRow(0, 22.0f);
-
-      ImGui::TableSetColumnIndex(0);
-      ImGui::PushStyleColor(ImGuiCol_Text, col);
-      ImGui::Text("  %s", s.name.c_str());
-      ImGui::PopStyleColor();
-
-      ImGui::TableSetColumnIndex(1);
-      ImGui::Text("%.3f", s.durationMs);
-
-      ImGui::TableSetColumnIndex(2);
-      drawBar(s.durationMs, frameMs, u32, false);
-
-      ImGui::TableSetColumnIndex(3);
-      if (gMs >= 0.f)
-        ImGui::Text("%.3f", gMs);
-      else
-        ImGui::TextDisabled("--");
-
-      ImGui::TableSetColumnIndex(4);
-      if (gMs >= 0.f)
-        drawBar(gMs, maxGpuMs, u32, false);
-      else {
-        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.4f, 0.4f, 0.4f, 1));
-        ImGui::TextUnformatted("  (no GPU query)");
-        ImGui::PopStyleColor();
+  float maxGpuMs = 1.0f;
+  for (auto &g : gpuSamples)
+    if (g.durationMs > maxGpuMs)
+      maxGpuMs = g.durationMs;
+
+  if (ImGui::BeginTabBar("##profilerViews")) {
+    if (ImGui::BeginTabItem("Call Tree")) {
+      ImGui::PushStyleColor(ImGuiCol_TableRowBg,
+                            ImVec4(0.10f, 0.10f, 0.12f, 1.0f));
+      ImGui::PushStyleColor(ImGuiCol_TableRowBgAlt,
+                            ImVec4(0.12f, 0.12f, 0.15f, 1.0f));
+      if (ImGui::BeginTable("##ptree", 6,
+                            ImGuiTableFlags_BordersInnerH |
+                                ImGuiTableFlags_RowBg |
+                                ImGuiTableFlags_SizingStretchProp |
+                                ImGuiTableFlags_ScrollY,
+                            ImVec2(0, tableH))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_WidthStretch,
+                                0.34f);
+        ImGui::TableSetupColumn("Total ms", ImGuiTableColumnFlags_WidthFixed,
+                                62.0f);
+        ImGui::TableSetupColumn("Self ms", ImGuiTableColumnFlags_WidthFixed,
+                                62.0f);
+        ImGui::TableSetupColumn("Calls", ImGuiTableColumnFlags_WidthFixed,
+                                44.0f);
+        ImGui::TableSetupColumn("CPU Bar", ImGuiTableColumnFlags_WidthStretch,
+                                0.30f);
+        ImGui::TableSetupColumn("GPU ms", ImGuiTableColumnFlags_WidthFixed,
+                                62.0f);
+        ImGui::TableHeadersRow();
+
+        const auto &tree = frame.tree;
+        for (size_t n = 0; n < tree.size(); ++n) {
+          const ProfileNode &node = tree[n];
+          bool leaf = n + 1 >= tree.size() || tree[n + 1].depth <= node.depth;
+          ImVec4 col = node.depth == 0 ? ImVec4(0.85f, 0.85f, 0.9f, 1.0f)
+                                       : GetColor(node.name);
+
+          ImGui::TableNextRow(0, 22.0f);
+          ImGui::TableSetColumnIndex(0);
+          ImGui::SetCursorPosX(ImGui::GetCursorPosX() + node.depth * 12.0f);
+          ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_NoTreePushOnOpen |
+                                     ImGuiTreeNodeFlags_SpanAvailWidth;
+          if (leaf)
+            flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_Bullet;
+          if (node.depth < 2)
+            flags |= ImGuiTreeNodeFlags_DefaultOpen;
+          ImGui::PushID(node.depth);
+          ImGui::PushStyleColor(ImGuiCol_Text, col);
+          bool open = ImGui::TreeNodeEx(node.name.c_str(), flags);
+          ImGui::PopStyleColor();
+          ImGui::PopID();
+
+          ImGui::TableSetColumnIndex(1);
+          ImGui::Text("%.3f", node.totalMs);
+          ImGui::TableSetColumnIndex(2);
+          ImGui::Text("%.3f", node.selfMs);
+          ImGui::TableSetColumnIndex(3);
+          if (node.depth > 0)
+            ImGui::Text("%d", node.calls);
+          ImGui::TableSetColumnIndex(4);
+          drawBar(node.totalMs, frameMs,
+                  ImGui::ColorConvertFloat4ToU32(col));
+          ImGui::TableSetColumnIndex(5);
+          float gMs = node.depth > 0 ? gpuMs(node.name) : -1.f;
+          if (gMs >= 0.f)
+            ImGui::Text("%.3f", gMs);
+          else
+            ImGui::TextDisabled("--");
+
+          if (!open && !leaf)
+            while (n + 1 < tree.size() && tree[n + 1].depth > node.depth)
+              ++n;
+        }
+
+        for (auto &g : gpuSamples) {
+          bool found = false;
+          for (auto &node : frame.tree)
+            if (node.depth > 0 && node.name == g.name) {
+              found = true;
+              break;
+            }
+          if (found)
+            continue;
+
+          ImVec4 col = GetColor(g.name);
+          ImGui::TableNextRow(0, 22.0f);
+          ImGui::TableSetColumnIndex(0);
+          ImGui::PushStyleColor(ImGuiCol_Text, col);
+          ImGui::Text("  %s  (GPU only)", g.name.c_str());
+          ImGui::PopStyleColor();
+          ImGui::TableSetColumnIndex(4);
+          drawBar(g.durationMs, maxGpuMs,
+                  ImGui::ColorConvertFloat4ToU32(col));
+          ImGui::TableSetColumnIndex(5);
+          ImGui::Text("%.3f", g.durationMs);
+        }
+        ImGui::EndTable();
       }
+      ImGui::PopStyleColor(2);
+      ImGui::EndTabItem();
     }
 
-    for (auto &g : gpuSamples) {
-      bool found = false;
-      for (auto &s : sorted)
-        if (s.name == g.name) {
-          found = true;
-          break;
-        }
-      if (found)
-        continue;
-
-      ImVec4 col = GetColor(g.name);
-      ImU32 u32 = ImGui::ColorConvertFloat4ToU32(col);
-      ImGui::TableNextRow(0, 22.0f);
-      ImGui::TableSetColumnIndex(0);
-      ImGui::PushStyleColor(ImGuiCol_Text, col);
-      ImGui::Text("  %s  (GPU only)", g.name.c_str());
-      ImGui::PopStyleColor();
-      ImGui::TableSetColumnIndex(1);
-      ImGui::TextDisabled("--");
-      ImGui::TableSetColumnIndex(2);
-      ImGui::Dummy(ImVec2(0, 16));
-      ImGui::TableSetColumnIndex(3);
-      ImGui::Text("%.3f", g.durationMs);
-      ImGui::TableSetColumnIndex(4);
-      drawBar(g.durationMs, maxGpuMs, u32, false);
+    if (ImGui::BeginTabItem("Timeline")) {
+      ImGui::SetNextItemWidth(160.0f);
+      ImGui::SliderFloat("Zoom", &s_TimelineZoom, 1.0f, 32.0f, "%.1fx",
+                         ImGuiSliderFlags_Logarithmic);
+      DrawTimeline(frame, ImVec2(0, tableH - 26.0f));
+      ImGui::EndTabItem();
     }
 
-    ImGui::EndTable();
+    if (ImGui::BeginTabItem("Counters")) {
+      DrawCounters(history, curIdx, frame, ImVec2(0, tableH));
+      ImGui::EndTabItem();
+    }
+    ImGui::EndTabBar();
   }
-  ImGui::PopStyleColor(2);
 
   ImGui::Spacing();
   ImGui::Separator();
@@ -340,7 +528,11 @@ void ProfilerUI::Draw(bool* pOpen) {
   ImGui::TextDisabled("CPU sampled: %.2f ms  |  GPU sampled: %.2f ms  |  Frame "
                       "total: %.2f ms  [GL_TIMESTAMP queries]",
                       cpuTotal, gpuTotal, frameMs);
+  if (frame.droppedEvents > 0)
+    ImGui::TextDisabled("%u events dropped (thread buffers full)",
+                        frame.droppedEvents);
   ImGui::EndChild();
   ImGui::End();
 }
 #endif
+#endif
@@ -0,0 +1,609 @@
+#include "StressScenario.h"
+#include "../../Core/Logger.h"
+#include "../../Core/MemoryTracker.h"
+#include "../../Renderer/BudgetGovernor.h"
+#include "../../Renderer/Camera.h"
+#include "../../Renderer/HLODManager.h"
+#include "../../Renderer/Renderer.h"
+#include "../../Renderer/StaticBatcher.h"
+#include "../../Scene/ObjectFactory.h"
+#include "../../Scene/Scene.h"
+#include "../Profiler/FrameStats.h"
+#include "../Profiler/PerfCounters.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+
+StressScenario StressRunner::s_Scenario;
+std::string StressRunner::s_Requested;
+bool StressRunner::s_Running = false;
+bool StressRunner::s_StopRequested = false;
+StressRunner::Phase StressRunner::s_Phase = StressRunner::Phase::Setup;
+size_t StressRunner::s_Variant = 0;
+int StressRunner::s_Frame = 0;
+std::string StressRunner::s_Status;
+nlohmann::json StressRunner::s_LastReport;
+
+// State of the run in progress that the header has no need to show.
+struct StressRunState {
+  nlohmann::json savedSettings;
+  glm::vec3 cameraPosition, cameraOrientation, cameraUp;
+  float cameraYaw = 0.0f, cameraPitch = 0.0f;
+  size_t lightCount = 0;
+  bool hadStaticBatches = false;
+  bool hadHLOD = false;
+  // [first, end) object ranges of spawns that spin.
+  std::vector<std::pair<std::pair<int, int>, float>> spinners;
+  int objects = 0;
+  int lights = 0;
+  std::vector<float> frameTimes;
+  std::map<std::string, std::vector<float>> counters;
+  nlohmann::json report;
+};
+static StressRunState s_StressRun;
+
+const std::vector<StressSetting> &StressRunner::GetSettings() {
+  using T = StressSetting::Type;
+  static const std::vector<StressSetting> settings = {
+      {"backfaceCulling", T::Bool, &Renderer::s_BackfaceCulling},
+      {"frustumCulling", T::Bool, &Renderer::s_ObjFrustumCulling},
+      {"lightCulling", T::Bool, &Renderer::s_LightFrustumCulling},
+      {"shadowCulling", T::Bool, &Renderer::s_ShadowFrustumCulling},
+      {"occlusionCulling", T::Bool, &Renderer::s_EnableOcclusionCulling},
+      {"zPrepass", T::Bool, &Renderer::s_ZPrepass},
+      {"materialOptimisation", T::Bool, &Renderer::s_MaterialOptimisation},
+      {"vrs", T::Bool, &Renderer::s_VRS},
+      {"sdfShadows", T::Bool, &Renderer::s_EnableSDFShadows},
+      {"hlod", T::Bool, &Renderer::s_EnableHLOD},
+      {"staticBatching", T::Bool, &Renderer::s_StaticBatching},
+      {"dynamicBatching", T::Bool, &Renderer::s_DynamicBatching},
+      {"clusteredShading", T::Bool, &Renderer::s_ClusteredShading},
+      {"autoLOD", T::Bool, &Renderer::s_AutoLOD},
+      {"lodCrossFade", T::Bool, &Renderer::s_LODCrossFade},
+      {"lodPixelTolerance", T::Float, &Renderer::s_LODPixelTolerance},
+      {"lodQualityScale", T::Float, &Renderer::s_LODQualityScale},
+      {"lodTriangleBudget", T::Int, &Renderer::s_LODTriangleBudget},
+      {"adaptiveShadows", T::Bool, &Renderer::s_AdaptiveShadowRes},
+      {"shadowCaching", T::Bool, &Renderer::s_ShadowCaching},
+      {"shadowCascadeCount", T::Int, &Renderer::s_ShadowCascadeCount},
+      {"shadowDistance", T::Float, &Renderer::s_ShadowDistance},
+      {"componentThrottling", T::Bool, &Renderer::s_ComponentThrottling},
+      {"governor", T::Bool, &BudgetGovernor::s_Enabled,
+       &BudgetGovernor::SetEnabled},
+      {"governorTargetMs", T::Float, &BudgetGovernor::s_TargetMs},
+  };
+  return settings;
+}
+
+static const StressSetting *StressFindSetting(const std::string &name) {
+  for (const StressSetting &setting : StressRunner::GetSettings())
+    if (name == setting.name)
+      return &setting;
+  return nullptr;
+}
+
+static nlohmann::json StressReadSetting(const StressSetting &setting) {
+  switch (setting.type) {
+  case StressSetting::Type::Bool:
+    return *(bool *)setting.value;
+  case StressSetting::Type::Int:
+    return *(int *)setting.value;
+  case StressSetting::Type::Float:
+    return *(float *)setting.value;
+  }
+  return nullptr;
+}
+
+static void StressApplySettings(const nlohmann::json &settings) {
+  for (auto &[name, value] : settings.items()) {
+    const StressSetting *setting = StressFindSetting(name);
+    if (!setting)
+      continue;
+    if (setting->setBool)
+      setting->setBool(value.get<bool>());
+    else if (setting->type == StressSetting::Type::Bool)
+      *(bool *)setting->value = value.get<bool>();
+    else if (setting->type == StressSetting::Type::Int)
+      *(int *)setting->value = value.get<int>();
+    else
+      *(float *)setting->value = value.get<float>();
+  }
+}
+
+static bool StressCheckSettings(const nlohmann::json &settings,
+                                std::string &error) {
+  if (!settings.is_object()) {
+    error = "settings must be an object";
+    return false;
+  }
+  for (auto &[name, value] : settings.items()) {
+    const StressSetting *setting = StressFindSetting(name);
+    bool typeOk = setting && (setting->type == StressSetting::Type::Bool
+                                  ? value.is_boolean()
+                                  : value.is_number());
+    if (!typeOk) {
+      error = setting ? "wrong type for setting '" + name + "'"
+                      : "unknown setting '" + name + "'";
+      return false;
+    }
+  }
+  return true;
+}
+
+static glm::vec3 StressReadVec3(const nlohmann::json &json, const char *key,
+                                glm::vec3 fallback) {
+  if (!json.contains(key))
+    return fallback;
+  const nlohmann::json &v = json[key];
+  return glm::vec3(v.at(0).get<float>(), v.at(1).get<float>(),
+                   v.at(2).get<float>());
+}
+
+// std::uniform_real_distribution differs between standard libraries; this
+// gives the same numbers everywhere for a given seed.
+static float StressRandom(std::mt19937 &gen, float lo, float hi) {
+  return lo + (hi - lo) * (float)(gen() >> 8) * (1.0f / 16777216.0f);
+}
+
+bool StressScenario::Load(const std::string &path, StressScenario &out,
+                          std::string &error) {
+  namespace fs = std::filesystem;
+  nlohmann::json json;
+  try {
+    std::ifstream file(path);
+    if (!file) {
+      error = "cannot open " + path;
+      return false;
+    }
+    json = nlohmann::json::parse(file);
+
+    StressScenario s;
+    s.path = path;
+    fs::path dir = fs::path(path).parent_path();
+    s.name = json.value("name", fs::path(path).stem().string());
+    if (json.contains("scene"))
+      s.scene = (dir / json["scene"].get<std::string>()).string();
+    s.outputPath = json.contains("output")
+                       ? (dir / json["output"].get<std::string>()).string()
+                       : (dir / (fs::path(path).stem().string() +
+                                 ".report.json"))
+                             .string();
+    s.seed = json.value("seed", s.seed);
+    s.dt = json.value("dt", s.dt);
+    s.duration = json.value("duration", s.duration);
+    s.warmupFrames = std::max(0, json.value("warmupFrames", s.warmupFrames));
+    if (s.dt <= 0.0f || s.duration <= 0.0f) {
+      error = "dt and duration must be positive";
+      return false;
+    }
+
+    for (const auto &j : json.value("spawns", nlohmann::json::array())) {
+      StressSpawn spawn;
+      std::string pattern = j.value("pattern", "grid");
+      if (pattern == "random")
+        spawn.pattern = StressSpawn::Pattern::Random;
+      else if (pattern != "grid") {
+        error = "unknown spawn pattern '" + pattern + "'";
+        return false;
+      }
+      spawn.shape = j.value("shape", spawn.shape);
+      if (spawn.shape != "cube" && spawn.shape != "sphere") {
+        error = "unknown spawn shape '" + spawn.shape + "'";
+        return false;
+      }
+      if (j.contains("grid"))
+        spawn.grid = glm::ivec3(j["grid"].at(0).get<int>(),
+                                j["grid"].at(1).get<int>(),
+                                j["grid"].at(2).get<int>());
+      spawn.spacing = j.value("spacing", spawn.spacing);
+      spawn.count = j.value("count", spawn.count);
+      spawn.radius = j.value("radius", spawn.radius);
+      spawn.center = StressReadVec3(j, "center", spawn.center);
+      spawn.isStatic = j.value("static", spawn.isStatic);
+      spawn.spin = j.value("spin", spawn.spin);
+      s.spawns.push_back(spawn);
+    }
+
+    if (json.contains("lights")) {
+      const nlohmann::json &j = json["lights"];
+      s.lights.count = j.value("count", s.lights.count);
+      s.lights.radius = j.value("radius", s.lights.radius);
+      s.lights.height = j.value("height", s.lights.height);
+      s.lights.castShadows = j.value("castShadows", s.lights.castShadows);
+    }
+
+    if (json.contains("camera")) {
+      const nlohmann::json &j = json["camera"];
+      s.loopCamera = j.value("loop", false);
+      for (const auto &k : j.value("keys", nlohmann::json::array())) {
+        StressCameraKey key;
+        key.time = k.value("time", 0.0f);
+        key.position = StressReadVec3(k, "position", key.position);
+        key.target = StressReadVec3(k, "target", key.target);
+        s.camera.push_back(key);
+      }
+      std::stable_sort(s.camera.begin(), s.camera.end(),
+                       [](const StressCameraKey &a, const StressCameraKey &b) {
+                         return a.time < b.time;
+                       });
+    }
+
+    s.settings = json.value("settings", nlohmann::json::object());
+    if (!StressCheckSettings(s.settings, error))
+      return false;
+    for (const auto &j : json.value("variants", nlohmann::json::array())) {
+      StressVariant variant;
+      variant.name =
+          j.value("name", "variant " + std::to_string(s.variants.size() + 1));
+      variant.settings = j.value("settings", nlohmann::json::object());
+      if (!StressCheckSettings(variant.settings, error)) {
+        error = variant.name + ": " + error;
+        return false;
+      }
+      s.variants.push_back(variant);
+    }
+    if (s.variants.empty())
+      s.variants.push_back({"default", nlohmann::json::object()});
+
+    out = std::move(s);
+  } catch (const std::exception &e) {
+    error = e.what();
+    return false;
+  }
+  return true;
+}
+
+void StressScenario::Spawn(Scene &scene, const StressSpawn &spawn,
+                           uint32_t seed) {
+  bool sphere = spawn.shape == "sphere";
+  auto add = [&](const glm::vec3 &position, float yaw) {
+    GameObject obj(sphere ? ObjectFactory::createSphere(32, 16)
+                          : ObjectFactory::createCube(),
+                   sphere ? "Stress_Sphere" : "Stress_Cube");
+    obj.meshType = sphere ? MeshType::Sphere : MeshType::Cube;
+    obj.position = position;
+    obj.rotation = glm::angleAxis(glm::radians(yaw), glm::vec3(0, 1, 0));
+    obj.isStatic = spawn.isStatic;
+    scene.AddObject(std::move(obj));
+  };
+
+  if (spawn.pattern == StressSpawn::Pattern::Grid) {
+    for (int x = 0; x < spawn.grid.x; x++)
+      for (int y = 0; y < spawn.grid.y; y++)
+        for (int z = 0; z < spawn.grid.z; z++)
+          add(spawn.center + glm::vec3(x, y, z) * spawn.spacing, 0.0f);
+    return;
+  }
+
+  std::mt19937 gen(seed);
+  for (int i = 0; i < spawn.count; i++) {
+    glm::vec3 offset;
+    offset.x = StressRandom(gen, -spawn.radius, spawn.radius);
+    offset.y = StressRandom(gen, -spawn.radius, spawn.radius);
+    offset.z = StressRandom(gen, -spawn.radius, spawn.radius);
+    add(spawn.center + offset, StressRandom(gen, 0.0f, 360.0f));
+  }
+}
+
+void StressScenario::SpawnLights(Scene &scene, const StressLights &lights,
+                                 uint32_t seed) {
+  std::mt19937 gen(seed);
+  for (int i = 0; i < lights.count; i++) {
+    Scene::PointLight *pl = scene.CreatePointLight();
+    if (!pl)
+      break;
+    float x = StressRandom(gen, -lights.radius, lights.radius);
+    float y = StressRandom(gen, -lights.radius, lights.radius);
+    float z = StressRandom(gen, -lights.radius, lights.radius);
+    pl->position = glm::vec3(x, y + lights.height, z);
+    float r = StressRandom(gen, 0.5f, 1.0f);
+    float g = StressRandom(gen, 0.5f, 1.0f);
+    float b = StressRandom(gen, 0.5f, 1.0f);
+    pl->color = glm::vec4(r, g, b, 1.0f);
+    pl->intensity = 1.0f;
+    pl->castShadows = lights.castShadows;
+  }
+}
+
+void StressScenario::ClearSpawned(Scene &scene) {
+  auto &objects = scene.GetObjects();
+  for (int i = (int)objects.size() - 1; i >= 0; i--) {
+    if (objects[i].name.find("Stress_") == 0) {
+      objects[i].mesh.Delete();
+      scene.RemoveObject(i);
+    }
+  }
+}
+
+void StressRunner::Request(const std::string &path) { s_Requested = path; }
+
+void StressRunner::Stop() {
+  if (s_Running)
+    s_StopRequested = true;
+}
+
+bool StressRunner::Start(const StressScenario &scenario, Scene &scene,
+                         Camera &camera) {
+  if (s_Running)
+    return false;
+
+  s_Scenario = scenario;
+  StressRunState &run = s_StressRun;
+  run = StressRunState();
+  for (const StressSetting &setting : GetSettings())
+    run.savedSettings[setting.name] = StressReadSetting(setting);
+  run.cameraPosition = camera.Position;
+  run.cameraOrientation = camera.Orientation;
+  run.cameraUp = camera.Up;
+  run.cameraYaw = camera.yaw;
+  run.cameraPitch = camera.pitch;
+  run.lightCount = scene.GetPointLights().size();
+  run.hadStaticBatches = StaticBatcher::HasBatches();
+  run.hadHLOD = !HLODManager::GetProxies().empty();
+
+  int frames = std::max(1, (int)std::lround(s_Scenario.duration /
+                                            s_Scenario.dt));
+  run.report = {{"scenario", s_Scenario.name},
+                {"path", s_Scenario.path},
+                {"seed", s_Scenario.seed},
+                {"dt", s_Scenario.dt},
+                {"warmupFrames", s_Scenario.warmupFrames},
+                {"frames", frames},
+                {"variants", nlohmann::json::array()}};
+
+  s_Running = true;
+  s_StopRequested = false;
+  s_Phase = Phase::Setup;
+  s_Variant = 0;
+  s_Frame = 0;
+  Logger::AddLog("[Stress] Running '%s': %d variant(s) x %d frames",
+                 s_Scenario.name.c_str(), (int)s_Scenario.variants.size(),
+                 frames);
+  return true;
+}
+
+void StressRunner::BeginVariant(Scene &scene) {
+  StressRunState &run = s_StressRun;
+  const StressVariant &variant = s_Scenario.variants[s_Variant];
+
+  StressScenario::ClearSpawned(scene);
+  StaticBatcher::Clear();
+  HLODManager::Clear();
+  scene.GetPointLights().resize(run.lightCount);
+
+  StressApplySettings(run.savedSettings);
+  StressApplySettings(s_Scenario.settings);
+  StressApplySettings(variant.settings);
+  // Every variant starts the governor from full quality.
+  if (BudgetGovernor::s_Enabled)
+    BudgetGovernor::SetLevel(0, "stress variant");
+
+  run.spinners.clear();
+  for (size_t i = 0; i < s_Scenario.spawns.size(); ++i) {
+    const StressSpawn &spawn = s_Scenario.spawns[i];
+    int first = (int)scene.GetObjects().size();
+    StressScenario::Spawn(scene, spawn,
+                          s_Scenario.seed ^ (0x9E3779B9u * (uint32_t)(i + 1)));
+    if (!spawn.isStatic && spawn.spin != 0.0f)
+      run.spinners.push_back(
+          {{first, (int)scene.GetObjects().size()}, spawn.spin});
+  }
+  StressScenario::SpawnLights(scene, s_Scenario.lights,
+                              s_Scenario.seed ^ 0x85EBCA6Bu);
+  run.objects = (int)scene.GetObjects().size();
+  run.lights = (int)scene.GetPointLights().size();
+
+  if (Renderer::s_StaticBatching)
+    StaticBatcher::Bake(scene);
+  if (Renderer::s_EnableHLOD)
+    HLODManager::BakeHLOD(scene);
+
+  run.frameTimes.clear();
+  run.counters.clear();
+  s_Phase = Phase::Warmup;
+  s_Frame = 0;
+}
+
+static void StressCameraAt(const std::vector<StressCameraKey> &keys, float t,
+                           bool loop, glm::vec3 &position, glm::vec3 &target) {
+  if (loop && keys.back().time > 0.0f)
+    t = std::fmod(t, keys.back().time);
+  size_t next = 0;
+  while (next < keys.size() && keys[next].time <= t)
+    next++;
+  if (next == 0 || next == keys.size()) {
+    const StressCameraKey &key = keys[next == 0 ? 0 : keys.size() - 1];
+    position = key.position;
+    target = key.target;
+    return;
+  }
+  const StressCameraKey &a = keys[next - 1];
+  const StressCameraKey &b = keys[next];
+  float f = (t - a.time) / std::max(b.time - a.time, 1e-6f);
+  position = glm::mix(a.position, b.position, f);
+  target = glm::mix(a.target, b.target, f);
+}
+
+void StressRunner::ApplyCamera(Camera &camera) {
+  if (s_Scenario.camera.empty())
+    return;
+  float t = s_Phase == Phase::Measure ? (float)s_Frame * s_Scenario.dt : 0.0f;
+  glm::vec3 position, target;
+  StressCameraAt(s_Scenario.camera, t, s_Scenario.loopCamera, position,
+                 target);
+  glm::vec3 dir = target - position;
+  if (glm::dot(dir, dir) < 1e-8f)
+    return;
+  dir = glm::normalize(dir);
+  camera.Position = position;
+  camera.Orientation = dir;
+  camera.Up = glm::vec3(0.0f, 1.0f, 0.0f);
+  camera.pitch = glm::degrees(asin(dir.y));
+  camera.yaw = glm::degrees(atan2(dir.z, dir.x));
+}
+
+void StressRunner::Update(Scene &scene, Camera &camera) {
+  if (!s_Requested.empty() && !s_Running) {
+    StressScenario scenario;
+    std::string error;
+    if (StressScenario::Load(s_Requested, scenario, error))
+      Start(scenario, scene, camera);
+    else
+      C3D_LOG_ERROR(LogCategory::General, "[Stress] %s: %s",
+                    s_Requested.c_str(), error.c_str());
+    s_Requested.clear();
+  }
+  if (!s_Running)
+    return;
+
+  StressRunState &run = s_StressRun;
+  if (s_StopRequested || s_Variant >= s_Scenario.variants.size()) {
+    camera.Position = run.cameraPosition;
+    camera.Orientation = run.cameraOrientation;
+    camera.Up = run.cameraUp;
+    camera.yaw = run.cameraYaw;
+    camera.pitch = run.cameraPitch;
+    Finish(scene, s_StopRequested);
+    return;
+  }
+  if (s_Phase == Phase::Setup)
+    BeginVariant(scene);
+
+  ApplyCamera(camera);
+  auto &objects = scene.GetObjects();
+  for (const auto &[range, spin] : run.spinners) {
+    glm::quat step = glm::angleAxis(glm::radians(spin * s_Scenario.dt),
+                                    glm::vec3(0.0f, 1.0f, 0.0f));
+    for (int i = range.first; i < range.second && i < (int)objects.size(); i++)
+      objects[i].rotation = step * objects[i].rotation;
+  }
+
+  const StressVariant &variant = s_Scenario.variants[s_Variant];
+  int frames = s_StressRun.report["frames"].get<int>();
+  char status[160];
+  std::snprintf(status, sizeof(status), "%s %d/%d '%s': %s %d/%d",
+                s_Scenario.name.c_str(), (int)s_Variant + 1,
+                (int)s_Scenario.variants.size(), variant.name.c_str(),
+                s_Phase == Phase::Measure ? "measuring" : "warming up",
+                s_Frame, s_Phase == Phase::Measure ? frames
+                                                   : s_Scenario.warmupFrames);
+  s_Status = status;
+}
+
+void StressRunner::EndFrame(float frameMs) {
+  if (!s_Running || s_Phase == Phase::Setup || s_StopRequested)
+    return;
+
+  StressRunState &run = s_StressRun;
+  if (s_Phase == Phase::Warmup) {
+    if (++s_Frame >= s_Scenario.warmupFrames) {
+      s_Phase = Phase::Measure;
+      s_Frame = 0;
+    }
+    return;
+  }
+
+  run.frameTimes.push_back(frameMs);
+#ifndef C3D_NO_PROFILER
+  for (int c = 0; c < (int)PerfCounter::Count; ++c)
+    run.counters[PerfCounters::GetName((PerfCounter)c)].push_back(
+        (float)PerfCounters::GetDisplayValue((PerfCounter)c));
+#endif
+  MemoryTagStats memory = MemoryTracker::GetTotal();
+  run.counters["Memory (MB)"].push_back(
+      (float)(memory.cpuBytes + memory.gpuBytes) / (1024.0f * 1024.0f));
+
+  if (++s_Frame >= run.report["frames"].get<int>())
+    FinishVariant();
+}
+
+void StressRunner::FinishVariant() {
+  StressRunState &run = s_StressRun;
+  const StressVariant &variant = s_Scenario.variants[s_Variant];
+
+  nlohmann::json settings = s_Scenario.settings;
+  settings.update(variant.settings);
+  nlohmann::json result = {{"name", variant.name},
+                           {"settings", settings},
+                           {"objects", run.objects},
+                           {"lights", run.lights},
+                           {"frame", FrameTimingStats(run.frameTimes)},
+                           {"counters", nlohmann::json::object()}};
+  for (const auto &[name, values] : run.counters)
+    result["counters"][name] = FrameCounterStats(values);
+
+  // Ratios against the first variant; below 1 is faster.
+  nlohmann::json &variants = run.report["variants"];
+  if (!variants.empty()) {
+    const nlohmann::json &first = variants[0]["frame"];
+    nlohmann::json relative;
+    for (const char *key : {"p50", "p95", "p99"}) {
+      float was = first[key].get<float>();
+      relative[key] = was > 0.0f ? result["frame"][key].get<float>() / was
+                                 : 0.0f;
+    }
+    result["relativeToFirst"] = relative;
+  }
+
+  const nlohmann::json &frame = result["frame"];
+  Logger::AddLog("[Stress] %s: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms",
+                 variant.name.c_str(), frame["p50"].get<float>(),
+                 frame["p95"].get<float>(), frame["p99"].get<float>());
+  variants.push_back(std::move(result));
+
+  s_Variant++;
+  s_Phase = Phase::Setup;
+  s_Frame = 0;
+}
+
+void StressRunner::Finish(Scene &scene, bool aborted) {
+  StressRunState &run = s_StressRun;
+  StressScenario::ClearSpawned(scene);
+  scene.GetPointLights().resize(run.lightCount);
+  StaticBatcher::Clear();
+  HLODManager::Clear();
+  StressApplySettings(run.savedSettings);
+  if (run.hadStaticBatches)
+    StaticBatcher::Bake(scene);
+  // BakeHLOD takes every proxy the cache still has and only bakes the
+  // clusters whose entries are missing or rejected, so the user's proxies
+  // come back even without a usable cache.
+  if (run.hadHLOD)
+    HLODManager::BakeHLOD(scene);
+
+  run.report["aborted"] = aborted;
+  s_LastReport = std::move(run.report);
+  run = StressRunState();
+  s_Running = false;
+  s_StopRequested = false;
+  s_Status = aborted ? "stopped" : "done";
+
+  const std::string &out = s_Scenario.outputPath;
+  if (out.empty())
+    return;
+  std::ofstream file(out);
+  if (!file) {
+    C3D_LOG_ERROR(LogCategory::General, "[Stress] Cannot write %s",
+                  out.c_str());
+    return;
+  }
+  file << s_LastReport.dump(2) << "\n";
+  Logger::AddLog("[Stress] '%s' %s -> %s", s_Scenario.name.c_str(),
+                 aborted ? "stopped" : "finished", out.c_str());
+}
+
+float StressRunner::GetProgress() {
+  if (!s_Running || s_Scenario.variants.empty())
+    return s_LastReport.is_null() ? 0.0f : 1.0f;
+  int frames = s_StressRun.report["frames"].get<int>();
+  int perVariant = s_Scenario.warmupFrames + frames;
+  int done = s_Phase == Phase::Measure ? s_Scenario.warmupFrames + s_Frame
+             : s_Phase == Phase::Warmup ? s_Frame
+                                        : 0;
+  return ((float)s_Variant + (float)done / (float)std::max(perVariant, 1)) /
+         (float)s_Scenario.variants.size();
+}
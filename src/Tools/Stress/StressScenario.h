@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+class Camera;
+class Scene;
+
+struct StressSpawn {
+  enum class Pattern { Grid, Random };
+  Pattern pattern = Pattern::Grid;
+  // "cube" or "sphere"; spheres are dense enough to get LOD levels.
+  std::string shape = "cube";
+  glm::ivec3 grid = glm::ivec3(10, 1, 10);
+  float spacing = 2.0f;
+  int count = 100;
+  float radius = 50.0f;
+  glm::vec3 center = glm::vec3(0.0f);
+  bool isStatic = true;
+  // Degrees per second around Y, for non-static objects.
+  float spin = 0.0f;
+};
+
+struct StressLights {
+  int count = 0;
+  float radius = 30.0f;
+  float height = 5.0f;
+  bool castShadows = false;
+};
+
+struct StressCameraKey {
+  float time = 0.0f;
+  glm::vec3 position = glm::vec3(0.0f, 10.0f, 30.0f);
+  glm::vec3 target = glm::vec3(0.0f);
+};
+
+// One configuration of renderer settings to run the workload under.
+struct StressVariant {
+  std::string name;
+  nlohmann::json settings = nlohmann::json::object();
+};
+
+// A reproducible workload: everything random is drawn from seed, and the
+// camera follows keys indexed by simulated time (frame * dt), so every
+// variant sees the same frames in the same order.
+struct StressScenario {
+  std::string name = "stress";
+  std::string path;
+  // Scene the headless benchmark loads first; the editor and runtime run
+  // against whatever scene is open.
+  std::string scene;
+  std::string outputPath;
+  uint32_t seed = 1;
+  float dt = 1.0f / 60.0f;
+  float duration = 10.0f;
+  int warmupFrames = 30;
+  std::vector<StressSpawn> spawns;
+  StressLights lights;
+  std::vector<StressCameraKey> camera;
+  bool loopCamera = false;
+  // Applied under every variant; a variant's own settings win.
+  nlohmann::json settings = nlohmann::json::object();
+  std::vector<StressVariant> variants;
+
+  // False with a message in error for unreadable files, unknown patterns or
+  // shapes and unknown renderer settings.
+  static bool Load(const std::string &path, StressScenario &out,
+                   std::string &error);
+  // Objects are named "Stress_..." so ClearSpawned() can find them.
+  static void Spawn(Scene &scene, const StressSpawn &spawn, uint32_t seed);
+  static void SpawnLights(Scene &scene, const StressLights &lights,
+                          uint32_t seed);
+  static void ClearSpawned(Scene &scene);
+};
+
+// Renderer::s_* values a scenario can set, by their JSON names.
+struct StressSetting {
+  const char *name;
+  enum class Type { Bool, Int, Float } type;
+  // Read through value; written through setBool instead when it is set, for
+  // flags whose setter has side effects.
+  void *value;
+  void (*setBool)(bool) = nullptr;
+};
+
+// Drives one scenario at a time through the host's frame loop: for each
+// variant it rebuilds the workload, applies the settings, warms up, then
+// records frame times and engine counters. Settings, camera and scene are
+// restored afterwards and a JSON report is written.
+class StressRunner {
+public:
+  // Start at the next Update(); safe to call from console commands.
+  static void Request(const std::string &path);
+  static bool Start(const StressScenario &scenario, Scene &scene,
+                    Camera &camera);
+  static void Stop();
+
+  // Main thread, after the host's own camera input and before rendering.
+  static void Update(Scene &scene, Camera &camera);
+  // Main thread, after PerfCounters::EndFrame().
+  static void EndFrame(float frameMs);
+
+  static bool IsRunning() { return s_Running; }
+  // 0..1 over all variants.
+  static float GetProgress();
+  static const std::string &GetStatus() { return s_Status; }
+  static const nlohmann::json &GetLastReport() { return s_LastReport; }
+
+  static const std::vector<StressSetting> &GetSettings();
+
+private:
+  enum class Phase { Setup, Warmup, Measure };
+
+  static void BeginVariant(Scene &scene);
+  static void FinishVariant();
+  static void Finish(Scene &scene, bool aborted);
+  static void ApplyCamera(Camera &camera);
+
+  static StressScenario s_Scenario;
+  static std::string s_Requested;
+  static bool s_Running;
+  static bool s_StopRequested;
+  static Phase s_Phase;
+  static size_t s_Variant;
+  static int s_Frame;
+  static std::string s_Status;
+  static nlohmann::json s_LastReport;
+};
@@ -1,8 +1,7 @@
 #include "StressUI.h"
 #ifndef C3D_RUNTIME
-#include "../../Scene/ObjectFactory.h"
+#include "StressScenario.h"
 #include <imgui.h>
-#include <random>
 
 void StressUI::Draw(bool *pOpen, Scene &scene) {
   if (!ImGui::Begin("Stress Test", pOpen)) {
@@ -10,6 +9,54 @@ void StressUI::Draw(bool *pOpen, Scene &scene) {
     return;
   }
 
+  static char scenarioPath[512] = "Resource/Stress/batching_lod.json";
+  static int seed = 1;
+
+  if (ImGui::CollapsingHeader("Scenario", ImGuiTreeNodeFlags_DefaultOpen)) {
+    ImGui::InputText("File", scenarioPath, sizeof(scenarioPath));
+    if (StressRunner::IsRunning()) {
+      if (ImGui::Button("Stop"))
+        StressRunner::Stop();
+      ImGui::SameLine();
+      ImGui::ProgressBar(StressRunner::GetProgress(), ImVec2(-FLT_MIN, 0),
+                         StressRunner::GetStatus().c_str());
+    } else if (ImGui::Button("Run Scenario")) {
+      StressRunner::Request(scenarioPath);
+    }
+
+    const nlohmann::json &report = StressRunner::GetLastReport();
+    if (report.contains("variants") && !report["variants"].empty() &&
+        ImGui::BeginTable("StressReport", 5,
+                          ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+      ImGui::TableSetupColumn("Variant");
+      ImGui::TableSetupColumn("p50 (ms)");
+      ImGui::TableSetupColumn("p95 (ms)");
+      ImGui::TableSetupColumn("vs first");
+      ImGui::TableSetupColumn("Draw calls");
+      ImGui::TableHeadersRow();
+      for (const auto &variant : report["variants"]) {
+        const nlohmann::json &frame = variant["frame"];
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(variant["name"].get<std::string>().c_str());
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", frame["p50"].get<float>());
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", frame["p95"].get<float>());
+        ImGui::TableNextColumn();
+        if (variant.contains("relativeToFirst"))
+          ImGui::Text("%.2fx", variant["relativeToFirst"]["p95"].get<float>());
+        ImGui::TableNextColumn();
+        const nlohmann::json &counters = variant["counters"];
+        if (counters.contains("Draw calls"))
+          ImGui::Text("%.0f", counters["Draw calls"]["mean"].get<float>());
+      }
+      ImGui::EndTable();
+    }
+  }
+
+  ImGui::Separator();
+
   static int gridX = 10;
   static int gridY = 1;
   static int gridZ = 10;
@@ -22,16 +69,11 @@ void StressUI::Draw(bool *pOpen, Scene &scene) {
     ImGui::DragFloat("Spacing", &spacing, 0.1f, 0.1f, 10.0f);
 
     if (ImGui::Button("Spawn Cube Grid")) {
-      for (int x = 0; x < gridX; x++) {
-        for (int y = 0; y < gridY; y++) {
-          for (int z = 0; z < gridZ; z++) {
-            GameObject obj(ObjectFactory::createCube(), "Stress_Cube");
-            obj.position = glm::vec3(x * spacing, y * spacing, z * spacing);
-            obj.meshType = MeshType::Cube;
-            scene.AddObject(std::move(obj));
-          }
-        }
-      }
+      StressSpawn spawn;
+      spawn.grid = glm::ivec3(gridX, gridY, gridZ);
+      spawn.spacing = spacing;
+      spawn.isStatic = false;
+      StressScenario::Spawn(scene, spawn, (uint32_t)seed);
     }
   }
 
@@ -42,20 +84,17 @@ void StressUI::Draw(bool *pOpen, Scene &scene) {
 
   if (ImGui::CollapsingHeader("Random Spawner",
                               ImGuiTreeNodeFlags_DefaultOpen)) {
+    ImGui::InputInt("Seed", &seed);
     ImGui::InputInt("Count", &randomCount);
     ImGui::DragFloat("Radius", &randomRadius, 1.0f, 1.0f, 500.0f);
 
     if (ImGui::Button("Spawn Random Cubes")) {
-      std::random_device rd;
-      std::mt19937 gen(rd());
-      std::uniform_real_distribution<float> dis(-randomRadius, randomRadius);
-
-      for (int i = 0; i < randomCount; i++) {
-        GameObject obj(ObjectFactory::createCube(), "Stress_Cube_Random");
-        obj.position = glm::vec3(dis(gen), dis(gen), dis(gen));
-        obj.meshType = MeshType::Cube;
-        scene.AddObject(std::move(obj));
-      }
+      StressSpawn spawn;
+      spawn.pattern = StressSpawn::Pattern::Random;
+      spawn.count = randomCount;
+      spawn.radius = randomRadius;
+      spawn.isStatic = false;
+      StressScenario::Spawn(scene, spawn, (uint32_t)seed);
     }
   }
 
@@ -70,20 +109,10 @@ void StressUI::Draw(bool *pOpen, Scene &scene) {
     ImGui::DragFloat("Light Radius", &lightRadius, 1.0f, 1.0f, 200.0f);
 
     if (ImGui::Button("Spawn Point Lights")) {
-      std::random_device rd;
-      std::mt19937 gen(rd());
-      std::uniform_real_distribution<float> posDis(-lightRadius, lightRadius);
-      std::uniform_real_distribution<float> colDis(0.5f, 1.0f);
-
-      for (int i = 0; i < lightCount; i++) {
-        Scene::PointLight *pl = scene.CreatePointLight();
-        if (pl) {
-          pl->position =
-              glm::vec3(posDis(gen), posDis(gen) + 5.0f, posDis(gen));
-          pl->color = glm::vec4(colDis(gen), colDis(gen), colDis(gen), 1.0f);
-          pl->intensity = 1.0f;
-        }
-      }
+      StressLights lights;
+      lights.count = lightCount;
+      lights.radius = lightRadius;
+      StressScenario::SpawnLights(scene, lights, (uint32_t)seed);
     }
   }
 
@@ -92,12 +121,7 @@ void StressUI::Draw(bool *pOpen, Scene &scene) {
   float halfWidth = ImGui::GetContentRegionAvail().x * 0.5f - 4.0f;
 
   if (ImGui::Button("Clear Stress Objects", ImVec2(halfWidth, 0))) {
-    auto &objects = scene.GetObjects();
-    for (int i = (int)objects.size() - 1; i >= 0; i--) {
-      if (objects[i].name.find("Stress_") == 0) {
-        scene.RemoveObject(i);
-      }
-    }
+    StressScenario::ClearSpawned(scene);
   }
   ImGui::SameLine();
   if (ImGui::Button("Clear ALL Lights", ImVec2(-FLT_MIN, 0))) {
@@ -105,12 +129,7 @@ void StressUI::Draw(bool *pOpen, Scene &scene) {
   }
 
   if (ImGui::Button("Clear ALL Stress Content", ImVec2(-FLT_MIN, 0))) {
-    auto &objects = scene.GetObjects();
-    for (int i = (int)objects.size() - 1; i >= 0; i--) {
-      if (objects[i].name.find("Stress_") == 0) {
-        scene.RemoveObject(i);
-      }
-    }
+    StressScenario::ClearSpawned(scene);
     scene.GetPointLights().clear();
   }
 